@@ -2,6 +2,7 @@
 
 # Build Script for Radio Benziger ESP32 Project
 # Usage: ./build.sh
+#        AUDIO_IRAM=1 ./build.sh   (place the audio hot path in IRAM, see radiobenziger/AudioHot.h)
 # This script only builds the firmware, use flash.sh to upload or build_flash.sh for both
 
 set -e  # Exit on any error
@@ -19,6 +20,7 @@ SKETCH_NAME="radiobenziger.ino"
 BOARD_FQBN="esp32:esp32:esp32"
 BUILD_DIR="$PWD/build"
 FIRMWARE_NAME="radiobenziger_firmware.bin"
+AUDIO_IRAM="${AUDIO_IRAM:-0}"
 
 # Detect number of CPU cores for parallel compilation
 CPU_CORES=$(nproc)
@@ -83,17 +85,38 @@ fi
 
 # Install required libraries (add more as needed)
 print_status "Checking required libraries..."
+# Async web server (control plane runs on AsyncTCP callbacks, not in loop())
+arduino-cli lib install "Async TCP"
+arduino-cli lib install "ESP Async WebServer"
 # Uncomment and modify as needed when you add libraries
 # arduino-cli lib install "WiFi"
 # arduino-cli lib install "HTTPClient"
 # arduino-cli lib install "ArduinoJson"
 
+# Regenerate the embedded (gzipped) web UI from web/
+print_status "Embedding web assets..."
+python3 "$PWD/embed_web_assets.py"
+
 # Navigate to project directory
 cd "$PROJECT_DIR"
 
+# Optional build flags
+EXTRA_BUILD_ARGS=()
+if [ "$AUDIO_IRAM" = "1" ]; then
+    print_status "Placing the audio hot path in IRAM (RADIOBENZIGER_AUDIO_IRAM=1)"
+    EXTRA_BUILD_ARGS+=(--build-property "compiler.cpp.extra_flags=-DRADIOBENZIGER_AUDIO_IRAM=1")
+fi
+
+# The largest possible /metrics body must fit a web response slot
+print_status "Checking the /metrics size budget..."
+if ! python3 "$(dirname "$PROJECT_DIR")/tools/metrics_budget.py" "$PROJECT_DIR"; then
+    print_error "/metrics can outgrow REPORT_RESPONSE_SLOT_BYTES"
+    exit 1
+fi
+
 # Compile the sketch with parallel jobs
 print_status "Compiling sketch with $PARALLEL_JOBS parallel jobs..."
-arduino-cli compile --fqbn "$BOARD_FQBN" "$SKETCH_NAME" --build-path "$BUILD_DIR" --jobs $PARALLEL_JOBS --verbose
+arduino-cli compile --fqbn "$BOARD_FQBN" "$SKETCH_NAME" --build-path "$BUILD_DIR" --jobs $PARALLEL_JOBS --verbose "${EXTRA_BUILD_ARGS[@]}"
 
 if [ $? -eq 0 ]; then
     print_success "Compilation successful!"
@@ -116,6 +139,21 @@ else
     exit 1
 fi
 
+# Report where the audio hot path was linked (IRAM vs flash)
+MAP_FILE="$BUILD_DIR/$SKETCH_NAME.map"
+if [ -f "$MAP_FILE" ]; then
+    print_status "Audio hot path placement:"
+    if [ "$AUDIO_IRAM" = "1" ]; then
+        # The IRAM build promises the hot path never runs from flash
+        if ! python3 "$(dirname "$PROJECT_DIR")/tools/iram_report.py" --strict "$MAP_FILE"; then
+            print_error "Audio hot path functions are still in flash with AUDIO_IRAM=1"
+            exit 1
+        fi
+    else
+        python3 "$(dirname "$PROJECT_DIR")/tools/iram_report.py" "$MAP_FILE" || print_warning "IRAM report failed"
+    fi
+fi
+
 print_success "Build completed successfully!"
 print_status "To flash the firmware, use:"
 echo "./flash.sh /dev/ttyUSB0 $BUILD_DIR/$FIRMWARE_NAME"
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Compress the web UI in web/ into radiobenziger/WebAssets.h
+
+Each file is gzipped (deterministically, so unchanged sources produce an
+unchanged header) and emitted as a PROGMEM byte array with its URL path,
+content type and a content-hash ETag. The firmware serves these arrays
+straight from flash with Content-Encoding: gzip.
+
+Usage: python3 embed_web_assets.py [--check]
+"""
+
+import gzip
+import hashlib
+import os
+import sys
+
+ROOT_DIR = os.path.dirname(os.path.abspath(__file__))
+WEB_DIR = os.path.join(ROOT_DIR, "web")
+OUTPUT_FILE = os.path.join(ROOT_DIR, "radiobenziger", "WebAssets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+def url_path(relative_path):
+    """Map a file under web/ to the URL it is served at"""
+    path = "/" + relative_path.replace(os.sep, "/")
+    if path.endswith("/index.html"):
+        path = path[:-len("index.html")]
+    return path
+
+def symbol_name(relative_path):
+    """C identifier for a file's byte array"""
+    name = "".join(c if c.isalnum() else "_" for c in relative_path)
+    return "WEB_ASSET_" + name.upper()
+
+def collect_assets():
+    """Gzip every file under web/ (sorted for stable output)"""
+    assets = []
+    for directory, _, files in os.walk(WEB_DIR):
+        for filename in sorted(files):
+            full_path = os.path.join(directory, filename)
+            relative_path = os.path.relpath(full_path, WEB_DIR)
+            extension = os.path.splitext(filename)[1].lower()
+            if extension not in CONTENT_TYPES:
+                print(f"Skipping {relative_path}: unknown content type")
+                continue
+
+            with open(full_path, "rb") as f:
+                source = f.read()
+
+            # mtime=0 keeps the gzip header (and so the header file) reproducible
+            compressed = gzip.compress(source, compresslevel=9, mtime=0)
+            etag = hashlib.sha1(source).hexdigest()[:16]
+
+            assets.append({
+                "relative_path": relative_path,
+                "path": url_path(relative_path),
+                "symbol": symbol_name(relative_path),
+                "content_type": CONTENT_TYPES[extension],
+                "data": compressed,
+                "etag": etag,
+                "source_size": len(source),
+            })
+    assets.sort(key=lambda asset: asset["path"])
+    return assets
+
+def render_header(assets):
+    lines = [
+        "// Generated by embed_web_assets.py from web/ - do not edit by hand",
+        "#ifndef WEBASSETS_H",
+        "#define WEBASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "/**",
+        " * Pre-gzipped web UI asset stored in flash",
+        " */",
+        "struct WebAsset {",
+        "    const char* path;              // URL path",
+        "    const char* contentType;       // MIME type of the uncompressed content",
+        "    const uint8_t* data;           // Gzip-compressed content (PROGMEM)",
+        "    size_t length;                 // Compressed length in bytes",
+        "    const char* etag;              // Quoted content hash",
+        "};",
+        "",
+    ]
+
+    for asset in assets:
+        data = asset["data"]
+        lines.append(f"// {asset['relative_path']}: {asset['source_size']} bytes, "
+                     f"{len(data)} gzipped")
+        lines.append(f"static const uint8_t {asset['symbol']}[] PROGMEM = {{")
+        for offset in range(0, len(data), 16):
+            row = ", ".join(f"0x{b:02x}" for b in data[offset:offset + 16])
+            lines.append(f"    {row},")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    for asset in assets:
+        lines.append(f"    {{ \"{asset['path']}\", \"{asset['content_type']}\", "
+                     f"{asset['symbol']}, sizeof({asset['symbol']}), "
+                     f"\"\\\"{asset['etag']}\\\"\" }},")
+    lines.append("};")
+    lines.append("static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    lines.append("")
+    lines.append("#endif // WEBASSETS_H")
+    lines.append("")
+    return "\n".join(lines)
+
+def main():
+    check_only = "--check" in sys.argv[1:]
+
+    assets = collect_assets()
+    if not assets:
+        print(f"No web assets found in {WEB_DIR}")
+        return 1
+
+    header = render_header(assets)
+    existing = None
+    if os.path.exists(OUTPUT_FILE):
+        with open(OUTPUT_FILE, "r") as f:
+            existing = f.read()
+
+    if existing == header:
+        print(f"{os.path.relpath(OUTPUT_FILE, ROOT_DIR)} is up to date")
+        return 0
+
+    if check_only:
+        print(f"{os.path.relpath(OUTPUT_FILE, ROOT_DIR)} is out of date - run embed_web_assets.py")
+        return 1
+
+    with open(OUTPUT_FILE, "w") as f:
+        f.write(header)
+
+    for asset in assets:
+        print(f"  {asset['path']:<20} {asset['source_size']:>6} -> {len(asset['data']):>6} bytes "
+              f"({asset['content_type']}, etag {asset['etag']})")
+    print(f"Wrote {os.path.relpath(OUTPUT_FILE, ROOT_DIR)}")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
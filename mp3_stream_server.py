@@ -2,23 +2,30 @@
 """
 MP3 to PCM Streaming Server for Radio Benziger ESP32
 Converts MP3 file to mono 32kHz PCM and streams over HTTP
+
+One ffmpeg decode is shared by every connected receiver (see relay_broadcast.py)
 """
 
+import logging
 import os
 import sys
-import threading
 import time
 from http.server import HTTPServer, BaseHTTPRequestHandler
 from socketserver import ThreadingMixIn
 import subprocess
 import signal
 
+from relay_broadcast import (CHUNK_SIZE, DEFAULT_LEAD_SECONDS, STEREO_TO_MONO, Pacer, Station,
+                             pcm_transcode_cmd, send_queue_bytes)
+
 class ThreadedHTTPServer(ThreadingMixIn, HTTPServer):
     daemon_threads = True
+    pace_lead = None   # Seconds of lead when pacing (--pace), None to send as fast as read
 
 class MP3StreamHandler(BaseHTTPRequestHandler):
-    def __init__(self, *args, mp3_file=None, **kwargs):
+    def __init__(self, *args, mp3_file=None, station=None, **kwargs):
         self.mp3_file = mp3_file
+        self.station = station
         super().__init__(*args, **kwargs)
     
     def do_GET(self):
@@ -42,71 +49,55 @@ class MP3StreamHandler(BaseHTTPRequestHandler):
             self.send_header('Connection', 'keep-alive')
             self.end_headers()
             
-            # Use ffmpeg to convert MP3 to PCM with explicit left channel mono
-            # -i: input file
-            # -f s16le: 16-bit signed little-endian PCM
-            # -acodec pcm_s16le: PCM 16-bit codec
-            # -ar 32000: 32kHz sample rate
-            # -ac 1: mono (1 channel)
-            # -af pan=mono|c0=0.5*c0+0.5*c1: mix stereo to mono properly
-            # -map_channel 0.0.0: use only left channel as fallback
-            # -: output to stdout
-            ffmpeg_cmd = [
-                'ffmpeg',
-                '-i', self.mp3_file,
-                '-f', 's16le',
-                '-acodec', 'pcm_s16le',
-                '-ar', '32000',
-                '-ac', '1',
-                '-af', 'pan=mono|c0=0.5*c0+0.5*c1',  # Proper stereo to mono mix
-                '-loglevel', 'error',  # Suppress verbose output
-                '-'
-            ]
-            
-            # Start ffmpeg process
-            process = subprocess.Popen(
-                ffmpeg_cmd,
-                stdout=subprocess.PIPE,
-                stderr=subprocess.PIPE,
-                bufsize=0
-            )
-            
-            # Stream PCM data in chunks - ESP32 controls the rate via intelligent flow control
-            chunk_size = 3200  # 100ms of audio at 32kHz mono 16-bit (32000 * 0.1 * 2)
-            
+            # Join the shared decode; the transcoder runs at real-time rate
+            # and a receiver that falls behind is skipped forward
             start_time = time.time()
             chunks_sent = 0
             
-            while True:
-                chunk = process.stdout.read(chunk_size)
-                if not chunk:
-                    break
-                
-                try:
-                    self.wfile.write(chunk)
-                    self.wfile.flush()
-                    chunks_sent += 1
+            # With --pace, at most the lead ahead of the receiver's clock
+            pacer = Pacer(self.server.pace_lead) if self.server.pace_lead else None
+            
+            with self.station.subscribe() as subscription:
+                while True:
+                    if pacer:
+                        wait = pacer.delay(CHUNK_SIZE)
+                        if wait:
+                            time.sleep(wait)
+                    chunk = subscription.read()
+                    if chunk is None:
+                        break
                     
-                    # Log progress every 10 seconds of audio
-                    if chunks_sent % 100 == 0:  # Every 10 seconds (100 * 0.1s)
-                        elapsed = time.time() - start_time
-                        audio_seconds = chunks_sent / 10.0
-                        rate = audio_seconds / elapsed if elapsed > 0 else 0
-                        print(f"Streaming to {client_ip}: {audio_seconds:.1f}s audio sent, {elapsed:.1f}s elapsed (rate: {rate:.1f}x)")
+                    try:
+                        self.wfile.write(chunk)
+                        self.wfile.flush()
+                        chunks_sent += 1
+                        if pacer:
+                            pacer.sent(len(chunk))
                         
-                except (BrokenPipeError, ConnectionResetError):
-                    print(f"Client {client_ip} disconnected")
-                    break
-            
-            # Clean up process
-            process.terminate()
-            process.wait()
+                        # Log progress every 10 seconds of audio
+                        if chunks_sent % 100 == 0:  # Every 10 seconds (100 * 0.1s)
+                            elapsed = time.time() - start_time
+                            audio_seconds = chunks_sent / 10.0
+                            rate = audio_seconds / elapsed if elapsed > 0 else 0
+                            print(f"Streaming to {client_ip}: {audio_seconds:.1f}s audio sent, {elapsed:.1f}s elapsed (rate: {rate:.1f}x, skipped: {subscription.chunks_skipped} chunks, {self.describe_queue(pacer)})")
+                            
+                    except (BrokenPipeError, ConnectionResetError):
+                        print(f"Client {client_ip} disconnected")
+                        break
             
         except Exception as e:
             print(f"Error streaming to {client_ip}: {e}")
         finally:
             print(f"MP3 PCM stream ended for {client_ip}")
     
+    def describe_queue(self, pacer) -> str:
+        """Audio queued towards this client: send-buffer bytes, and lead when pacing"""
+        queued = send_queue_bytes(self.connection)
+        text = f"send queue: {queued} B" if queued is not None else "send queue: n/a"
+        if pacer:
+            text += f", ahead: {pacer.ahead_seconds():.2f}s"
+        return text
+    
     def serve_info_page(self):
         """Serve information page"""
         html = f"""
@@ -127,6 +118,7 @@ class MP3StreamHandler(BaseHTTPRequestHandler):
                 <div class="status">
                     <h3>Server Status: Running</h3>
                     <p><strong>MP3 File:</strong> {self.mp3_file}</p>
+                    <p><strong>Listeners:</strong> {self.station.listeners} (one shared decode)</p>
                     <p><strong>Stream URL:</strong> <a href="/stream">http://localhost:8080/stream</a></p>
                     <p><strong>Format:</strong> PCM 32kHz, 16-bit, mono</p>
                 </div>
@@ -163,12 +155,18 @@ def check_dependencies():
         return False
 
 def main():
-    if len(sys.argv) != 2:
-        print("Usage: python3 mp3_stream_server.py <mp3_file>")
-        print("Example: python3 mp3_stream_server.py /home/user/music.mp3")
-        sys.exit(1)
+    import argparse
     
-    mp3_file = sys.argv[1]
+    parser = argparse.ArgumentParser(description="MP3 to PCM Streaming Server for Radio Benziger ESP32",
+                                     epilog="Example: python3 mp3_stream_server.py /home/user/music.mp3")
+    parser.add_argument("mp3_file", help="MP3 file to stream")
+    parser.add_argument("--pace", action="store_true",
+                        help="Send at the audio clock instead of as fast as each receiver reads")
+    parser.add_argument("--lead-ms", type=int, default=int(DEFAULT_LEAD_SECONDS * 1000),
+                        help="Audio a paced receiver may be sent ahead of playback (default: %(default)s)")
+    args = parser.parse_args()
+    
+    mp3_file = args.mp3_file
     
     # Check if MP3 file exists
     if not os.path.exists(mp3_file):
@@ -188,15 +186,28 @@ def main():
     print("Format: PCM 32kHz, 16-bit, mono")
     print("Stream URL: http://localhost:8080/stream")
     print("Web Interface: http://localhost:8080/")
-    print("Mode: Pull-based streaming (ESP32 controls rate)")
+    print("Mode: Real-time broadcast (one decode shared by all receivers)")
+    if args.pace:
+        print(f"Pacing: {args.lead_ms} ms lead")
     print("=" * 50)
     
+    logging.basicConfig(level=logging.INFO)
+    
+    # One transcoder for every receiver: -f s16le/-ar 32000/-ac 1 with a proper
+    # stereo to mono mix, paced at real time so listeners share one timeline.
+    # The file plays once per run; the next receiver after the end starts over.
+    station = Station(os.path.basename(mp3_file),
+                      pcm_transcode_cmd(mp3_file, realtime=True, audio_filter=STEREO_TO_MONO),
+                      restart=False)
+    
     # Create handler with MP3 file
     def handler(*args, **kwargs):
-        return MP3StreamHandler(*args, mp3_file=mp3_file, **kwargs)
+        return MP3StreamHandler(*args, mp3_file=mp3_file, station=station, **kwargs)
     
     # Start server
     server = ThreadedHTTPServer(('0.0.0.0', 8080), handler)
+    if args.pace:
+        server.pace_lead = args.lead_ms / 1000.0
     
     def signal_handler(sig, frame):
         print("\nServer stopping...")
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Content-addressed cache of device-format PCM for the relay
+
+A source file is converted once to raw receiver PCM (32kHz, 16-bit, mono)
+and stored under the SHA-256 of its contents plus the conversion format, so
+renamed or re-uploaded copies share one entry and a changed file gets a new
+one. Cached files are memory-mapped and shared by every listener: playback
+is a cursor into the page cache, with no decoder running, and looping is an
+offset wrap with no restart gap.
+
+Used by wav_server.py.
+"""
+
+import hashlib
+import logging
+import mmap
+import os
+import threading
+from typing import Callable, Dict, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+# Bump when the conversion changes so old entries are not reused
+FORMAT_TAG = b's16le-32000-mono-v1'
+SAMPLE_BYTES = 2
+
+
+class PcmLoop:
+    """A cached PCM file mapped read-only; reads wrap around at the end"""
+
+    def __init__(self, path: str):
+        self.path = path
+        with open(path, 'rb') as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        # Never split a sample at the loop point
+        self.size = len(self._map) - len(self._map) % SAMPLE_BYTES
+
+    def read(self, offset: int, length: int) -> Tuple[bytes, int]:
+        """`length` bytes starting at `offset`, continuing from the start past the end"""
+        offset %= self.size
+        end = offset + length
+        if end <= self.size:
+            return self._map[offset:end], end % self.size
+        tail = self._map[offset:self.size]
+        head_length = min(end - self.size, self.size)
+        return tail + self._map[0:head_length], head_length
+
+    def close(self):
+        self._map.close()
+
+
+class PcmCache:
+    """Converted files by content hash, plus the open mappings shared by listeners"""
+
+    def __init__(self, cache_dir: str):
+        self.cache_dir = cache_dir
+        os.makedirs(cache_dir, exist_ok=True)
+        self._lock = threading.Lock()
+        self._digests: Dict[Tuple[str, int, int], str] = {}   # (path, size, mtime) -> digest
+        self._loops: Dict[str, PcmLoop] = {}
+
+    def digest(self, source: str) -> str:
+        """Content hash of `source`, memoised while its size and mtime are unchanged"""
+        st = os.stat(source)
+        memo_key = (os.path.realpath(source), st.st_size, st.st_mtime_ns)
+        with self._lock:
+            cached = self._digests.get(memo_key)
+        if cached:
+            return cached
+
+        h = hashlib.sha256(FORMAT_TAG)
+        with open(source, 'rb') as f:
+            for block in iter(lambda: f.read(1 << 20), b''):
+                h.update(block)
+        digest = h.hexdigest()
+        with self._lock:
+            self._digests[memo_key] = digest
+        return digest
+
+    def path_for(self, source: str) -> str:
+        return os.path.join(self.cache_dir, self.digest(source) + '.pcm')
+
+    def lookup(self, source: str) -> Optional[str]:
+        """Cached PCM for `source`, or None if it has not been converted yet"""
+        path = self.path_for(source)
+        return path if os.path.exists(path) else None
+
+    def ensure(self, source: str, converter: Callable[[str, str], bool]) -> Optional[str]:
+        """
+        Convert `source` into the cache unless it is already there (blocking)
+
+        converter(source, output_path) writes device-format PCM and returns
+        success; it writes to a temporary name that is renamed into place, so
+        readers never see a partial file.
+        """
+        path = self.lookup(source)
+        if path:
+            return path
+
+        path = self.path_for(source)
+        tmp_path = f"{path}.{os.getpid()}.{threading.get_ident()}.tmp"
+        try:
+            if not converter(source, tmp_path) or os.path.getsize(tmp_path) < SAMPLE_BYTES:
+                logger.error(f"Caching {source} failed")
+                return None
+            os.replace(tmp_path, path)
+        finally:
+            if os.path.exists(tmp_path):
+                os.remove(tmp_path)
+
+        logger.info(f"Cached {source} as {os.path.basename(path)} ({os.path.getsize(path)} bytes)")
+        return path
+
+    def open(self, path: str) -> PcmLoop:
+        """Shared read-only mapping of a cached file"""
+        with self._lock:
+            loop = self._loops.get(path)
+            if loop is None:
+                loop = PcmLoop(path)
+                self._loops[path] = loop
+            return loop
+
+    def status(self) -> dict:
+        with self._lock:
+            open_files = len(self._loops)
+        entries = [name for name in os.listdir(self.cache_dir) if name.endswith('.pcm')]
+        return {
+            'cache_dir': self.cache_dir,
+            'entries': len(entries),
+            'bytes': sum(os.path.getsize(os.path.join(self.cache_dir, name)) for name in entries),
+            'mapped': open_files,
+        }
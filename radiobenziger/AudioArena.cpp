@@ -0,0 +1,83 @@
+#include "AudioArena.h"
+
+// Sized for: PCMStreamer, 2 x 3.2KB staging slots, 12KB + 16KB audio task
+// stacks, 4KB RelayClock and StandbyRelay stacks, task control blocks and
+// mutexes, with some headroom
+const size_t AudioArena::ARENA_SIZE = 48 * 1024;
+
+// Static member definitions (.bss lives in internal, DMA-capable DRAM)
+alignas(16) uint8_t AudioArena::pool[AudioArena::ARENA_SIZE];
+size_t AudioArena::used = 0;
+AudioArena::Entry AudioArena::entries[AudioArena::MAX_ENTRIES];
+size_t AudioArena::entryCount = 0;
+
+void* AudioArena::allocate(size_t size, size_t alignment, const char* tag) {
+    if (alignment == 0) {
+        alignment = 1;
+    }
+
+    size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if (offset + size > ARENA_SIZE) {
+        Serial.printf("AudioArena: ERROR - Out of space for %s (%u bytes, %u/%u used)\n",
+                      tag, (unsigned)size, (unsigned)used, (unsigned)ARENA_SIZE);
+        return nullptr;
+    }
+
+    used = offset + size;
+    addEntry(tag, offset, size, nullptr);
+    return pool + offset;
+}
+
+SemaphoreHandle_t AudioArena::createMutex(const char* tag) {
+    StaticSemaphore_t* storage = (StaticSemaphore_t*)allocate(sizeof(StaticSemaphore_t),
+                                                              alignof(StaticSemaphore_t), tag);
+    return storage ? xSemaphoreCreateMutexStatic(storage) : nullptr;
+}
+
+TaskHandle_t AudioArena::createTask(TaskFunction_t function, const char* name, uint32_t stackBytes,
+                                    void* parameter, UBaseType_t priority, BaseType_t core) {
+    StackType_t* stack = (StackType_t*)allocate(stackBytes, 16, name);
+    StaticTask_t* tcb = (StaticTask_t*)allocate(sizeof(StaticTask_t), alignof(StaticTask_t), name);
+    if (!stack || !tcb) {
+        return nullptr;
+    }
+
+    return xTaskCreateStaticPinnedToCore(function, name, stackBytes / sizeof(StackType_t),
+                                         parameter, priority, stack, tcb, core);
+}
+
+size_t AudioArena::getUsedBytes() {
+    return used;
+}
+
+size_t AudioArena::getCapacity() {
+    return ARENA_SIZE;
+}
+
+void AudioArena::recordExternal(const char* tag, size_t size, const char* region) {
+    addEntry(tag, 0, size, region);
+}
+
+void AudioArena::printLayout() {
+    Serial.println("=== Audio Arena Layout ===");
+    Serial.printf("  Base: %p, Used: %u/%u bytes (%u free)\n", pool, (unsigned)used,
+                  (unsigned)ARENA_SIZE, (unsigned)(ARENA_SIZE - used));
+    for (size_t i = 0; i < entryCount; i++) {
+        const Entry& entry = entries[i];
+        if (entry.region) {
+            Serial.printf("  %-16s %7u bytes  [%s, boot-time]\n", entry.tag,
+                          (unsigned)entry.size, entry.region);
+        } else {
+            Serial.printf("  %-16s %7u bytes  @ +0x%05x\n", entry.tag,
+                          (unsigned)entry.size, (unsigned)entry.offset);
+        }
+    }
+    Serial.println("==========================");
+}
+
+void AudioArena::addEntry(const char* tag, size_t offset, size_t size, const char* region) {
+    if (entryCount >= MAX_ENTRIES) {
+        return;
+    }
+    entries[entryCount++] = { tag, offset, size, region };
+}
@@ -0,0 +1,63 @@
+#ifndef AUDIOARENA_H
+#define AUDIOARENA_H
+
+#include <Arduino.h>
+#include <new>
+#include <utility>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+/**
+ * AudioArena - Boot-time static arena for long-lived audio objects
+ *
+ * All audio memory (streamer object, DMA staging ring, task stacks and
+ * control blocks, mutexes), and the stacks of the long-lived tasks that
+ * feed it (RelayClock, StandbyRelay), is carved out of a single statically allocated
+ * pool in internal RAM during setup(). Nothing is ever freed, so the audio
+ * path is deterministic and unaffected by heap fragmentation caused by the
+ * web server.
+ */
+class AudioArena {
+public:
+    // Core functions
+    static void* allocate(size_t size, size_t alignment, const char* tag);
+    static SemaphoreHandle_t createMutex(const char* tag);
+    static TaskHandle_t createTask(TaskFunction_t function, const char* name, uint32_t stackBytes,
+                                   void* parameter, UBaseType_t priority, BaseType_t core);
+
+    /**
+     * Construct an object in the arena (never destroyed)
+     */
+    template <typename T, typename... Args>
+    static T* create(const char* tag, Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T), tag);
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Diagnostics
+    static size_t getUsedBytes();
+    static size_t getCapacity();
+    static void recordExternal(const char* tag, size_t size, const char* region);
+    static void printLayout();
+
+private:
+    struct Entry {
+        const char* tag;
+        size_t offset;
+        size_t size;
+        const char* region;            // nullptr for arena entries
+    };
+
+    static const size_t ARENA_SIZE;
+    static const size_t MAX_ENTRIES = 24;
+
+    alignas(16) static uint8_t pool[];
+    static size_t used;
+    static Entry entries[MAX_ENTRIES];
+    static size_t entryCount;
+
+    static void addEntry(const char* tag, size_t offset, size_t size, const char* region);
+};
+
+#endif // AUDIOARENA_H
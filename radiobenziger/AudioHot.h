@@ -0,0 +1,33 @@
+#ifndef AUDIOHOT_H
+#define AUDIOHOT_H
+
+#include <Arduino.h>
+
+/**
+ * AUDIO_HOT_ATTR - Placement of the playback hot path
+ *
+ * Functions executed for every audio chunk (ring buffer operations, the
+ * I2S write path, the playback loop and its counters) are tagged with
+ * AUDIO_HOT_ATTR. Building with RADIOBENZIGER_AUDIO_IRAM=1 (AUDIO_IRAM=1
+ * ./build.sh) places them in IRAM so their instruction fetches never miss
+ * the flash cache while WiFi or NVS traffic is evicting it. The default
+ * build leaves them in flash to keep IRAM free for the WiFi stack.
+ *
+ * AUDIO_HOT_DATA does the same for constant tables those functions read,
+ * moving them from flash-mapped rodata into DRAM.
+ *
+ * tools/iram_report.py lists which hot-path symbols ended up where.
+ */
+#ifndef RADIOBENZIGER_AUDIO_IRAM
+#define RADIOBENZIGER_AUDIO_IRAM 0
+#endif
+
+#if RADIOBENZIGER_AUDIO_IRAM
+#define AUDIO_HOT_ATTR IRAM_ATTR
+#define AUDIO_HOT_DATA DRAM_ATTR
+#else
+#define AUDIO_HOT_ATTR
+#define AUDIO_HOT_DATA
+#endif
+
+#endif // AUDIOHOT_H
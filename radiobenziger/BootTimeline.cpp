@@ -0,0 +1,89 @@
+#include "BootTimeline.h"
+#include "BufferPrintf.h"
+#include "JsonWriter.h"
+
+// Milestone names, used as Prometheus labels and in the boot log
+const char* const BootTimeline::NAMES[BootTimeline::MILESTONE_COUNT] = {
+    "setup_start",
+    "audio_ready",
+    "web_ready",
+    "ip_acquired",
+    "stream_connected",
+    "first_audio"
+};
+
+// Static member definitions (0 = not reached)
+std::atomic<uint32_t> BootTimeline::timestamps[BootTimeline::MILESTONE_COUNT] = {};
+
+void BootTimeline::mark(Milestone milestone) {
+    if (milestone >= MILESTONE_COUNT) {
+        return;
+    }
+
+    // millis() can still read 0 this early; keep 0 meaning "not reached"
+    uint32_t now = millis();
+    uint32_t expected = 0;
+    if (!timestamps[milestone].compare_exchange_strong(expected, now ? now : 1,
+                                                       std::memory_order_relaxed)) {
+        return;
+    }
+
+    if (milestone == FIRST_AUDIO) {
+        printSummary();
+    }
+}
+
+bool BootTimeline::reached(Milestone milestone) {
+    return getMs(milestone) != 0;
+}
+
+uint32_t BootTimeline::getMs(Milestone milestone) {
+    return milestone < MILESTONE_COUNT ? timestamps[milestone].load(std::memory_order_relaxed) : 0;
+}
+
+void BootTimeline::writeJson(JsonWriter& json) {
+    // Only reached milestones are present
+    static const JsonKey KEYS[MILESTONE_COUNT] = {
+        JSON_KEY("setup_start_ms"),
+        JSON_KEY("audio_ready_ms"),
+        JSON_KEY("web_ready_ms"),
+        JSON_KEY("ip_acquired_ms"),
+        JSON_KEY("stream_connected_ms"),
+        JSON_KEY("first_audio_ms")
+    };
+
+    json.beginObject(JSON_KEY("boot"));
+    for (size_t i = 0; i < MILESTONE_COUNT; i++) {
+        uint32_t ms = getMs((Milestone)i);
+        if (ms) {
+            json.field(KEYS[i], ms);
+        }
+    }
+    json.endObject();
+}
+
+size_t BootTimeline::renderMetrics(char* buffer, size_t size) {
+    size_t used = bufferPrintf(buffer, size, 0,
+        "# HELP radiobenziger_boot_milestone_seconds Time after boot at which each startup stage completed\n"
+        "# TYPE radiobenziger_boot_milestone_seconds gauge\n");
+    for (size_t i = 0; i < MILESTONE_COUNT; i++) {
+        uint32_t ms = getMs((Milestone)i);
+        if (ms) {
+            used = bufferPrintf(buffer, size, used, "radiobenziger_boot_milestone_seconds{stage=\"%s\"} %.3f\n",
+                                NAMES[i], ms / 1000.0f);
+        }
+    }
+    return used;
+}
+
+// Private methods implementation
+
+void BootTimeline::printSummary() {
+    Serial.printf("BootTimeline: First audio %lu ms after boot\n", (unsigned long)getMs(FIRST_AUDIO));
+    for (size_t i = 0; i < FIRST_AUDIO; i++) {
+        uint32_t ms = getMs((Milestone)i);
+        if (ms) {
+            Serial.printf("BootTimeline:   %-16s %6lu ms\n", NAMES[i], (unsigned long)ms);
+        }
+    }
+}
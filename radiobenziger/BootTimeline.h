@@ -0,0 +1,55 @@
+#ifndef BOOTTIMELINE_H
+#define BOOTTIMELINE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+class JsonWriter;
+
+/**
+ * BootTimeline - Milestones from power-on to the first audible sample
+ *
+ * Each stage of the boot (audio subsystem up, web server up, IP acquired,
+ * stream connected, first chunk handed to I2S) records the millis() at
+ * which it first happened. Stages run in parallel - audio starts before
+ * WiFi has associated - so the timeline shows which one gated playback.
+ *
+ * mark() is safe from any task and only the first call per milestone
+ * counts. Reported in /status (JSON) and /metrics (Prometheus text), and
+ * logged once when the first audio is played.
+ */
+class BootTimeline {
+public:
+    enum Milestone {
+        SETUP_START,        // setup() entered
+        AUDIO_READY,        // I2S configured and audio tasks running
+        WEB_READY,          // HTTP server listening
+        IP_ACQUIRED,        // Station got an IP address
+        STREAM_CONNECTED,   // Relay answered the stream request
+        FIRST_AUDIO,        // First stream chunk written to I2S
+        MILESTONE_COUNT
+    };
+
+    /**
+     * Record a milestone (no-op if it was already recorded)
+     */
+    static void mark(Milestone milestone);
+
+    static bool reached(Milestone milestone);
+
+    /**
+     * @return millis() at the milestone, 0 if not reached yet
+     */
+    static uint32_t getMs(Milestone milestone);
+
+    static void writeJson(JsonWriter& json);
+    static size_t renderMetrics(char* buffer, size_t size);
+
+private:
+    static const char* const NAMES[MILESTONE_COUNT];
+    static std::atomic<uint32_t> timestamps[MILESTONE_COUNT];
+
+    static void printSummary();
+};
+
+#endif // BOOTTIMELINE_H
@@ -0,0 +1,35 @@
+#ifndef BUFFERPRINTF_H
+#define BUFFERPRINTF_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+/**
+ * Append formatted text to a fixed buffer at offset 'used'
+ *
+ * Used by the diagnostics renderers so responses are built in preallocated
+ * memory instead of String concatenation. On truncation the buffer stays
+ * NUL-terminated and the returned length stops at the end of the buffer.
+ *
+ * @return New used length
+ */
+inline size_t bufferPrintf(char* buffer, size_t size, size_t used, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+inline size_t bufferPrintf(char* buffer, size_t size, size_t used, const char* format, ...) {
+    if (size == 0 || used >= size - 1) {
+        return used;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + used, size - used, format, args);
+    va_end(args);
+
+    if (written < 0) {
+        return used;
+    }
+    return (used + written < size) ? used + written : size - 1;
+}
+
+#endif // BUFFERPRINTF_H
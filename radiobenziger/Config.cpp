@@ -1,18 +1,35 @@
 #include "Config.h"
+#include "StreamEndpoint.h"
+#include <esp_rom_crc.h>
 
 // Static member definitions
 Config::Settings Config::settings;
+portMUX_TYPE Config::settingsLock = portMUX_INITIALIZER_UNLOCKED;
 Preferences Config::prefs;
 bool Config::initialized = false;
+uint32_t Config::storedCrc = 0;
+bool Config::storedValid = false;
+Config::Blob Config::scratch;
+std::atomic<bool> Config::savePending(false);
+std::atomic<uint32_t> Config::lastSaveRequest(0);
+uint32_t Config::firstSaveRequest = 0;
 
-const char* Config::DEFAULT_STREAM_URL = "https://icecast.octosignals.com/benziger";  // Changed to HTTP (or use your proxy URL)
+const char* Config::DEFAULT_STREAM_URL = "http://192.168.1.189:8080/stream";  // Your relay (find with: ip addr show), or POST /stream-url
+const char* Config::LEGACY_STREAM_URL = "https://icecast.octosignals.com/benziger";  // Schema 1 default, never played
 const char* Config::DEFAULT_DEVICE_NAME = "Radio Benziger";
-const int Config::EEPROM_SIZE = 512;
+const uint16_t Config::DEFAULT_TELEMETRY_PORT = 5600;
+const uint32_t Config::DEFAULT_TELEMETRY_INTERVAL_MS = 5000;
+const uint32_t Config::BLOB_MAGIC = 0x47464352;  // "RCFG"
+const char* Config::BLOB_KEY = "settings";
+const uint32_t Config::SAVE_SETTLE_MS = 2000;       // Coalesce bursts of changes
+const uint32_t Config::SAVE_MAX_DEFER_MS = 60000;   // Commit even without a quiet period
 const int Config::EEPROM_CONFIG_ADDR = 0;
 
 bool Config::begin() {
     if (initialized) return true;
     
+    static_assert(sizeof(Blob) <= EEPROM_SIZE, "Settings blob no longer fits the EEPROM backup");
+    
     // Initialize EEPROM
     EEPROM.begin(EEPROM_SIZE);
     
@@ -37,8 +54,12 @@ bool Config::begin() {
     
     // Try to load from NVS first
     if (load()) {
-        // Also save to EEPROM as backup
-        saveToEEPROM();
+        // Refresh the EEPROM copy only here, and only if it differs: it
+        // lives in the same NVS partition, so mirroring every save would
+        // double the flash writes
+        if (!validateEEPROM()) {
+            saveToEEPROM();
+        }
         return true;
     }
     
@@ -52,26 +73,32 @@ bool Config::begin() {
     // If both fail, use defaults
     setDefaults();
     save();
-    saveToEEPROM();
     return true;
 }
 
 bool Config::load() {
     if (!initialized) return false;
     
-    // Load settings from NVS
-    prefs.getString("wifiSSID", settings.wifiSSID, sizeof(settings.wifiSSID));
-    prefs.getString("wifiPassword", settings.wifiPassword, sizeof(settings.wifiPassword));
-    prefs.getString("streamURL", settings.streamURL, sizeof(settings.streamURL));
-    prefs.getString("deviceName", settings.deviceName, sizeof(settings.deviceName));
-    settings.autoStart = prefs.getBool("autoStart", true);
+    size_t length = prefs.getBytesLength(BLOB_KEY);
+    if (length == 0) {
+        // Firmware before the blob stored one NVS key per field
+        return importLegacyKeys();
+    }
     
-    // Set defaults if values are empty
-    if (strlen(settings.streamURL) == 0) {
-        strcpy(settings.streamURL, DEFAULT_STREAM_URL);
+    Blob& blob = scratch;
+    memset(&blob, 0, sizeof(blob));
+    length = prefs.getBlob(BLOB_KEY, &blob, length < sizeof(blob) ? length : sizeof(blob));
+    if (!applyBlob(blob, length, "NVS")) {
+        return false;
     }
-    if (strlen(settings.deviceName) == 0) {
-        strcpy(settings.deviceName, DEFAULT_DEVICE_NAME);
+    
+    storedCrc = blob.crc;
+    storedValid = true;
+    
+    // Persist the upgraded layout so migration runs once
+    if (blob.version != SCHEMA_VERSION) {
+        storedValid = false;
+        save();
     }
     
     Serial.println("Configuration loaded from NVS:");
@@ -83,26 +110,73 @@ bool Config::load() {
 bool Config::save() {
     if (!initialized) return false;
     
-    // Save to NVS
-    prefs.putString("wifiSSID", settings.wifiSSID);
-    prefs.putString("wifiPassword", settings.wifiPassword);
-    prefs.putString("streamURL", settings.streamURL);
-    prefs.putString("deviceName", settings.deviceName);
-    prefs.putBool("autoStart", settings.autoStart);
+    Blob& blob = scratch;
+    buildBlob(blob);
+    
+    // Nothing changed since the last load/save: no flash writes at all
+    if (storedValid && blob.crc == storedCrc) {
+        Serial.println("Configuration unchanged, skipping save");
+        return true;
+    }
     
-    // Also save to EEPROM as backup
-    saveToEEPROM();
+    // Save to NVS (one key, one write)
+    if (prefs.putBlob(BLOB_KEY, &blob, sizeof(blob)) != sizeof(blob)) {
+        Serial.println("Failed to save configuration to NVS");
+        return false;
+    }
+    storedCrc = blob.crc;
+    storedValid = true;
     
-    Serial.println("Configuration saved to NVS and EEPROM backup");
+    Serial.println("Configuration saved to NVS");
     return true;
 }
 
+void Config::copy(void* out, const void* field, size_t length) {
+    portENTER_CRITICAL(&settingsLock);
+    memcpy(out, field, length);
+    portEXIT_CRITICAL(&settingsLock);
+}
+
+void Config::requestSave() {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&settingsLock);
+    lastSaveRequest = now;
+    if (!savePending.exchange(true)) {
+        firstSaveRequest = now;
+    }
+    portEXIT_CRITICAL(&settingsLock);
+}
+
+void Config::update(bool quiet) {
+    if (!savePending.load()) {
+        return;
+    }
+    
+    uint32_t now = millis();
+    portENTER_CRITICAL(&settingsLock);
+    bool settled = (now - lastSaveRequest.load()) >= SAVE_SETTLE_MS;
+    bool overdue = (now - firstSaveRequest) >= SAVE_MAX_DEFER_MS;
+    portEXIT_CRITICAL(&settingsLock);
+    if (settled && (quiet || overdue)) {
+        if (!quiet) {
+            Serial.println("Config: No quiet period within deferral limit, saving anyway");
+        }
+        flush();
+    }
+}
+
+bool Config::flush() {
+    // Cleared first so a change made during the write queues another save
+    savePending = false;
+    return save();
+}
+
 bool Config::saveToEEPROM() {
-    // Calculate checksum for validation
-    settings.checksum = calculateChecksum();
+    Blob& blob = scratch;
+    buildBlob(blob);
     
     // Write settings to EEPROM
-    EEPROM.put(EEPROM_CONFIG_ADDR, settings);
+    EEPROM.put(EEPROM_CONFIG_ADDR, blob);
     EEPROM.commit();
     
     Serial.println("Configuration saved to EEPROM backup");
@@ -110,31 +184,15 @@ bool Config::saveToEEPROM() {
 }
 
 bool Config::loadFromEEPROM() {
-    Settings tempSettings;
+    Blob& blob = scratch;
     
     // Read from EEPROM
-    EEPROM.get(EEPROM_CONFIG_ADDR, tempSettings);
-    
-    // Validate checksum
-    uint32_t savedChecksum = tempSettings.checksum;
-    tempSettings.checksum = 0; // Clear for calculation
-    uint32_t calculatedChecksum = 0;
+    EEPROM.get(EEPROM_CONFIG_ADDR, blob);
     
-    // Calculate checksum
-    uint8_t* data = (uint8_t*)&tempSettings;
-    for (size_t i = 0; i < sizeof(Settings) - sizeof(uint32_t); i++) {
-        calculatedChecksum += data[i];
-    }
-    
-    if (savedChecksum != calculatedChecksum) {
-        Serial.println("EEPROM checksum mismatch, data may be corrupted");
+    if (!applyBlob(blob, sizeof(blob), "EEPROM")) {
         return false;
     }
     
-    // Restore checksum and copy settings
-    tempSettings.checksum = savedChecksum;
-    memcpy(&settings, &tempSettings, sizeof(Settings));
-    
     Serial.println("Configuration loaded from EEPROM:");
     printStatus();
     
@@ -142,25 +200,17 @@ bool Config::loadFromEEPROM() {
 }
 
 bool Config::validateEEPROM() {
-    Settings tempSettings;
-    EEPROM.get(EEPROM_CONFIG_ADDR, tempSettings);
+    Blob& stored = scratch;
+    EEPROM.get(EEPROM_CONFIG_ADDR, stored);
     
-    uint32_t savedChecksum = tempSettings.checksum;
-    tempSettings.checksum = 0;
-    
-    return savedChecksum == calculateChecksum();
+    return stored.magic == BLOB_MAGIC && stored.crc == blobCrc(stored) && stored.crc == calculateChecksum();
 }
 
 uint32_t Config::calculateChecksum() {
-    uint32_t checksum = 0;
-    uint8_t* data = (uint8_t*)&settings;
-    
-    // Calculate checksum excluding the checksum field itself
-    for (size_t i = 0; i < sizeof(Settings) - sizeof(uint32_t); i++) {
-        checksum += data[i];
-    }
-    
-    return checksum;
+    // Same byte sequence as blobCrc() for a blob of the current settings
+    uint16_t header[2] = { SCHEMA_VERSION, (uint16_t)sizeof(Settings) };
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)header, sizeof(header));
+    return esp_rom_crc32_le(crc, (const uint8_t*)&settings, sizeof(Settings));
 }
 
 void Config::printStatus() {
@@ -168,10 +218,18 @@ void Config::printStatus() {
     Serial.printf("  WiFi SSID: %s\n", strlen(settings.wifiSSID) > 0 ? settings.wifiSSID : "(not set)");
     Serial.printf("  WiFi Password: %s\n", strlen(settings.wifiPassword) > 0 ? "***set***" : "(not set)");
     Serial.printf("  Stream URL: %s\n", settings.streamURL);
+    Serial.printf("  Standby URL: %s\n", strlen(settings.standbyURL) > 0 ? settings.standbyURL : "(none)");
     Serial.printf("  Device Name: %s\n", settings.deviceName);
     Serial.printf("  Auto Start: %s\n", settings.autoStart ? "true" : "false");
+    if (strlen(settings.telemetryHost) > 0) {
+        Serial.printf("  Telemetry: %s:%u every %ums\n", settings.telemetryHost,
+                      (unsigned)settings.telemetryPort, (unsigned)settings.telemetryIntervalMs);
+    } else {
+        Serial.println("  Telemetry: disabled");
+    }
     Serial.printf("  Has WiFi Credentials: %s\n", hasWiFiCredentials() ? "yes" : "no");
     Serial.printf("  Configuration Valid: %s\n", isValid() ? "yes" : "no");
+    Serial.printf("  Schema Version: %u\n", (unsigned)SCHEMA_VERSION);
     Serial.println("============================");
 }
 
@@ -189,6 +247,7 @@ void Config::reset() {
     
     // Clear NVS
     prefs.clear();
+    storedValid = false;
     
     // Clear EEPROM
     for (int i = 0; i < EEPROM_SIZE; i++) {
@@ -202,9 +261,131 @@ void Config::reset() {
 }
 
 void Config::setDefaults() {
+    // memset also zeroes padding, keeping the blob CRC deterministic
     memset(&settings, 0, sizeof(settings));
     strcpy(settings.streamURL, DEFAULT_STREAM_URL);
     strcpy(settings.deviceName, DEFAULT_DEVICE_NAME);
     settings.autoStart = true;
-    settings.checksum = 0;
-} 
\ No newline at end of file
+    settings.telemetryPort = DEFAULT_TELEMETRY_PORT;
+    settings.telemetryIntervalMs = DEFAULT_TELEMETRY_INTERVAL_MS;
+}
+
+// Private methods implementation
+
+void Config::buildBlob(Blob& blob) {
+    memset(&blob, 0, sizeof(blob));
+    blob.magic = BLOB_MAGIC;
+    blob.version = SCHEMA_VERSION;
+    blob.payloadSize = sizeof(Settings);
+    // One consistent snapshot, even while a web handler is changing settings
+    portENTER_CRITICAL(&settingsLock);
+    memcpy(&blob.payload, &settings, sizeof(Settings));
+    portEXIT_CRITICAL(&settingsLock);
+    blob.crc = blobCrc(blob);
+}
+
+uint32_t Config::blobCrc(const Blob& blob) {
+    size_t payloadSize = blob.payloadSize < sizeof(Settings) ? blob.payloadSize : sizeof(Settings);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)&blob.version, sizeof(blob.version) + sizeof(blob.payloadSize));
+    return esp_rom_crc32_le(crc, (const uint8_t*)&blob.payload, payloadSize);
+}
+
+bool Config::applyBlob(const Blob& blob, size_t length, const char* source) {
+    size_t headerSize = offsetof(Blob, payload);
+    if (length < headerSize || blob.magic != BLOB_MAGIC) {
+        Serial.printf("Config: No settings blob in %s\n", source);
+        return false;
+    }
+    
+    if (blob.version > SCHEMA_VERSION || blob.payloadSize > sizeof(Settings) ||
+        length < headerSize + blob.payloadSize) {
+        Serial.printf("Config: Unsupported settings blob in %s (version %u, %u bytes)\n",
+                      source, (unsigned)blob.version, (unsigned)blob.payloadSize);
+        return false;
+    }
+    
+    if (blob.crc != blobCrc(blob)) {
+        Serial.printf("Config: CRC mismatch in %s, data is corrupted\n", source);
+        return false;
+    }
+    
+    // Older (shorter) payloads leave appended fields at their defaults
+    setDefaults();
+    memcpy(&settings, &blob.payload, blob.payloadSize);
+    
+    if (blob.version < SCHEMA_VERSION && !migrate(blob.version)) {
+        setDefaults();
+        return false;
+    }
+    return true;
+}
+
+bool Config::migrate(uint16_t fromVersion) {
+    Serial.printf("Config: Migrating settings from schema %u to %u\n",
+                  (unsigned)fromVersion, (unsigned)SCHEMA_VERSION);
+    
+    // One step per version; a step fixes up fields whose meaning changed.
+    // Fields appended by a version already hold defaults (see applyBlob).
+    for (uint16_t version = fromVersion; version < SCHEMA_VERSION; version++) {
+        switch (version) {
+            case 1:
+                // Schema 1 stored a stream URL but streamed from a compiled-in
+                // relay address; the untouched default was never playable
+                if (strcmp(settings.streamURL, LEGACY_STREAM_URL) == 0) {
+                    strcpy(settings.streamURL, DEFAULT_STREAM_URL);
+                }
+                // Schema 2 streams from streamURL itself, so it has to parse
+                // (schema 1 also accepted https:// and other unplayable URLs)
+                if (!StreamEndpoint().parse(settings.streamURL)) {
+                    Serial.printf("Config: Stream URL \"%s\" is not supported, using %s\n",
+                                  settings.streamURL, DEFAULT_STREAM_URL);
+                    strcpy(settings.streamURL, DEFAULT_STREAM_URL);
+                }
+                break;
+            case 2:
+                // Schema 3 appended standbyURL; the default (none) is right
+                break;
+            default:
+                Serial.printf("Config: No migration from schema %u\n", (unsigned)version);
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Config::importLegacyKeys() {
+    if (!prefs.isKey("streamURL") && !prefs.isKey("wifiSSID")) {
+        return false;
+    }
+    
+    setDefaults();
+    importLegacySettings(prefs, settings);
+    
+    // Set defaults if values are empty (or the never-used stream default)
+    if (strlen(settings.streamURL) == 0 || strcmp(settings.streamURL, LEGACY_STREAM_URL) == 0) {
+        strcpy(settings.streamURL, DEFAULT_STREAM_URL);
+    } else if (!StreamEndpoint().parse(settings.streamURL)) {
+        Serial.printf("Config: Stream URL \"%s\" is not supported, using %s\n",
+                      settings.streamURL, DEFAULT_STREAM_URL);
+        strcpy(settings.streamURL, DEFAULT_STREAM_URL);
+    }
+    if (strlen(settings.deviceName) == 0) {
+        strcpy(settings.deviceName, DEFAULT_DEVICE_NAME);
+    }
+    if (settings.telemetryPort == 0) {
+        settings.telemetryPort = DEFAULT_TELEMETRY_PORT;
+    }
+    
+    // Store as a blob, then drop the per-field keys
+    storedValid = false;
+    if (!save()) {
+        return false;
+    }
+    for (size_t i = 0; i < LEGACY_SETTING_KEY_COUNT; i++) {
+        prefs.remove(LEGACY_SETTING_KEYS[i]);
+    }
+    
+    Serial.println("Configuration migrated from per-key NVS storage:");
+    printStatus();
+    return true;
+}
@@ -4,19 +4,37 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include <EEPROM.h>
+#include <atomic>
+#include "ConfigSettings.h"
 
+/**
+ * Config - Persistent device settings
+ *
+ * Settings are stored as a single versioned binary blob (one NVS key) with
+ * a CRC32. Saves are skipped when nothing changed, so repeated saves cost
+ * no flash writes. The EEPROM copy (emulated in the same NVS partition, so
+ * not an independent backup) is refreshed at boot only, never per save. Blobs written by older
+ * schema versions are migrated on load; settings stored by firmware that
+ * predates the blob (separate NVS keys) are imported once and the old keys
+ * removed.
+ *
+ * Flash writes stall code running from flash on both cores, so runtime
+ * changes go through requestSave(): requests are coalesced and committed by
+ * update() once they have settled and the caller reports a quiet period
+ * (e.g. audio idle or well buffered).
+ *
+ * Other tasks (web handlers) change settings only through modify() and
+ * read them through copy(); both hold settingsLock, which save() also
+ * takes while it snapshots the settings into the blob.
+ */
 class Config {
 public:
-    struct Settings {
-        char wifiSSID[64];
-        char wifiPassword[64];
-        char streamURL[256];
-        char deviceName[32];
-        bool autoStart;
-        uint32_t checksum;  // For EEPROM validation
-    };
+    typedef ConfigSettings Settings;   // Layout and schema rules in ConfigSettings.h
+    
+    static const uint16_t SCHEMA_VERSION = 3;
     
     static Settings settings;
+    static portMUX_TYPE settingsLock;
     
     // Core functions
     static bool begin();
@@ -25,6 +43,33 @@ public:
     static void reset();
     static void setDefaults();
     
+    /**
+     * Change settings from any task and queue a save
+     *
+     * @param change Callable taking Settings&; runs under settingsLock, so it
+     *               should only copy values in
+     */
+    template <typename Change>
+    static void modify(Change change) {
+        portENTER_CRITICAL(&settingsLock);
+        change(settings);
+        portEXIT_CRITICAL(&settingsLock);
+        requestSave();
+    }
+    
+    /**
+     * Copy `length` bytes of a settings field from any task
+     *
+     * @param field Address of a member of `settings`
+     */
+    static void copy(void* out, const void* field, size_t length);
+    
+    // Write-behind saving
+    static void requestSave();
+    static void update(bool quiet);
+    static bool flush();
+    static bool hasPendingSave() { return savePending.load(); }
+    
     // Enhanced persistence functions
     static bool saveToEEPROM();
     static bool loadFromEEPROM();
@@ -37,12 +82,43 @@ public:
     static bool hasWiFiCredentials();
     
 private:
+    /**
+     * Stored record: header followed by the Settings payload. The CRC covers
+     * version, payload size and payload.
+     */
+    struct Blob {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t payloadSize;
+        uint32_t crc;
+        Settings payload;
+    };
+    
     static Preferences prefs;
     static bool initialized;
+    static uint32_t storedCrc;       // CRC of the blob last written to / read from NVS
+    static bool storedValid;
+    static Blob scratch;             // Shared serialisation buffer (keeps it off the stack)
+    static std::atomic<bool> savePending;
+    static std::atomic<uint32_t> lastSaveRequest;
+    static uint32_t firstSaveRequest;   // Guarded by settingsLock
+    static const uint32_t SAVE_SETTLE_MS;
+    static const uint32_t SAVE_MAX_DEFER_MS;
     static const char* DEFAULT_STREAM_URL;
+    static const char* LEGACY_STREAM_URL;
     static const char* DEFAULT_DEVICE_NAME;
-    static const int EEPROM_SIZE;
+    static const uint16_t DEFAULT_TELEMETRY_PORT;
+    static const uint32_t DEFAULT_TELEMETRY_INTERVAL_MS;
+    static const uint32_t BLOB_MAGIC;
+    static const char* BLOB_KEY;
+    static constexpr int EEPROM_SIZE = 1024;      // Emulated in NVS; grown with schema 3 (standbyURL)
     static const int EEPROM_CONFIG_ADDR;
+    
+    static void buildBlob(Blob& blob);
+    static uint32_t blobCrc(const Blob& blob);
+    static bool applyBlob(const Blob& blob, size_t length, const char* source);
+    static bool migrate(uint16_t fromVersion);
+    static bool importLegacyKeys();
 };
 
-#endif 
\ No newline at end of file
+#endif 
@@ -0,0 +1,62 @@
+#ifndef CONFIGSETTINGS_H
+#define CONFIGSETTINGS_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * ConfigSettings - Payload of the persisted settings blob (Config::Settings)
+ *
+ * Append new fields at the end and bump Config::SCHEMA_VERSION (see
+ * Config::migrate()).
+ */
+struct ConfigSettings {
+    char wifiSSID[64];
+    char wifiPassword[64];
+    char streamURL[256];         // http://relay[:port]/path, rtp://group[:port] or dnssd:// (StreamEndpoint)
+    char deviceName[32];
+    bool autoStart;
+    char telemetryHost[64];      // UDP telemetry collector ("" = disabled)
+    uint16_t telemetryPort;
+    uint32_t telemetryIntervalMs;
+    char standbyURL[256];        // Warm second relay, http:// only ("" = none, StandbyRelay)
+};
+
+/**
+ * NVS keys written by firmware that predates the settings blob, one per
+ * field. Config removes exactly these once importLegacySettings() has read
+ * them, so a key added here must be imported there.
+ */
+static const char* const LEGACY_SETTING_KEYS[] = {
+    "wifiSSID",
+    "wifiPassword",
+    "streamURL",
+    "deviceName",
+    "autoStart",
+    "telemHost",
+    "telemPort",
+    "telemInterval"
+};
+static const size_t LEGACY_SETTING_KEY_COUNT = sizeof(LEGACY_SETTING_KEYS) / sizeof(LEGACY_SETTING_KEYS[0]);
+
+/**
+ * Read the per-field keys into `settings`
+ *
+ * Keys that are missing keep the value already in `settings` (the
+ * defaults). Store has the Preferences getters, so the firmware passes its
+ * NVS namespace and host tools a stand-in.
+ */
+template <typename Store>
+void importLegacySettings(Store& store, ConfigSettings& settings) {
+    store.getString("wifiSSID", settings.wifiSSID, sizeof(settings.wifiSSID));
+    store.getString("wifiPassword", settings.wifiPassword, sizeof(settings.wifiPassword));
+    store.getString("streamURL", settings.streamURL, sizeof(settings.streamURL));
+    store.getString("deviceName", settings.deviceName, sizeof(settings.deviceName));
+    settings.autoStart = store.getBool("autoStart", settings.autoStart);
+    store.getString("telemHost", settings.telemetryHost, sizeof(settings.telemetryHost));
+    settings.telemetryPort = store.getUShort("telemPort", settings.telemetryPort);
+    settings.telemetryIntervalMs = store.getUInt("telemInterval", settings.telemetryIntervalMs);
+}
+
+#endif // CONFIGSETTINGS_H
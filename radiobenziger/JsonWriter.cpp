@@ -0,0 +1,175 @@
+#include "JsonWriter.h"
+#include <stdarg.h>
+
+JsonWriter::JsonWriter(char* target, size_t capacity) {
+    buffer = target;
+    size = capacity;
+    used = 0;
+    needComma = false;
+    overflow = (capacity == 0);
+    if (capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    beginValue(nullptr);
+    appendChar('{');
+    needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginObject(const JsonKey& key) {
+    beginValue(&key);
+    appendChar('{');
+    needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    appendChar('}');
+    needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    beginValue(nullptr);
+    appendChar('[');
+    needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const JsonKey& key) {
+    beginValue(&key);
+    appendChar('[');
+    needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    appendChar(']');
+    needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, bool value) {
+    beginValue(&key);
+    if (value) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, int32_t value) {
+    beginValue(&key);
+    appendf("%d", (int)value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, uint32_t value) {
+    beginValue(&key);
+    appendf("%u", (unsigned)value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, uint64_t value) {
+    beginValue(&key);
+    appendf("%llu", (unsigned long long)value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, float value, uint8_t decimals) {
+    beginValue(&key);
+    appendf("%.*f", (int)decimals, value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const JsonKey& key, const char* value) {
+    beginValue(&key);
+    appendEscaped(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(uint32_t number) {
+    beginValue(nullptr);
+    appendf("%u", (unsigned)number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(float number, uint8_t decimals) {
+    beginValue(nullptr);
+    appendf("%.*f", (int)decimals, number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    beginValue(nullptr);
+    appendEscaped(text);
+    return *this;
+}
+
+// Private methods implementation
+
+void JsonWriter::append(const char* text, size_t length) {
+    if (overflow) {
+        return;
+    }
+    if (used + length >= size) {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+    buffer[used] = '\0';
+}
+
+void JsonWriter::appendChar(char c) {
+    append(&c, 1);
+}
+
+void JsonWriter::appendf(const char* format, ...) {
+    if (overflow) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + used, size - used, format, args);
+    va_end(args);
+
+    if (written < 0 || used + written >= size) {
+        // Drop the partial value so the output ends on a token boundary
+        buffer[used] = '\0';
+        overflow = true;
+        return;
+    }
+    used += written;
+}
+
+void JsonWriter::beginValue(const JsonKey* key) {
+    if (needComma) {
+        appendChar(',');
+    }
+    if (key) {
+        append(key->text, key->length);
+    }
+    needComma = true;
+}
+
+void JsonWriter::appendEscaped(const char* text) {
+    appendChar('"');
+    for (const char* p = text ? text : ""; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            char escaped[2] = { '\\', c };
+            append(escaped, 2);
+        } else if ((unsigned char)c < 0x20) {
+            appendf("\\u%04x", (unsigned)c);
+        } else {
+            appendChar(c);
+        }
+    }
+    appendChar('"');
+}
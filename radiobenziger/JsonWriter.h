@@ -0,0 +1,97 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <Arduino.h>
+
+/**
+ * Pre-quoted JSON object key ("name":), built by JSON_KEY at compile time
+ */
+struct JsonKey {
+    const char* text;
+    size_t length;
+};
+
+/**
+ * True if a key literal can be emitted without escaping
+ */
+constexpr bool jsonKeyIsSafe(const char* name) {
+    return *name == '\0' ||
+           (*name != '"' && *name != '\\' && (unsigned char)*name >= 0x20 && jsonKeyIsSafe(name + 1));
+}
+
+template <bool Safe>
+struct JsonKeyCheck {
+    static_assert(Safe, "JSON key contains characters that need escaping");
+    static constexpr JsonKey make(const char* text, size_t length) { return JsonKey{ text, length }; }
+};
+
+/**
+ * Quote a key literal at compile time; keys that would need escaping are
+ * rejected by the compiler instead of being escaped on every request.
+ */
+#define JSON_KEY(name) \
+    JsonKeyCheck<jsonKeyIsSafe(name)>::make("\"" name "\":", sizeof("\"" name "\":") - 1)
+
+/**
+ * JsonWriter - Streaming JSON serialiser into a caller-supplied buffer
+ *
+ * Writes directly into a fixed buffer (a web response slot, a frame
+ * buffer or the stack) without heap allocation. Separators are inserted
+ * automatically. String values are escaped at runtime; keys come from
+ * JSON_KEY and are never escaped at runtime.
+ *
+ * If the buffer fills up, further output is dropped and overflowed()
+ * returns true; the buffer always stays NUL-terminated.
+ */
+class JsonWriter {
+private:
+    char* buffer;
+    size_t size;
+    size_t used;
+    bool needComma;
+    bool overflow;
+
+    void append(const char* text, size_t length);
+    void appendChar(char c);
+    void appendf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void beginValue(const JsonKey* key);
+    void appendEscaped(const char* text);
+
+public:
+    JsonWriter(char* target, size_t capacity);
+
+    // Containers (the keyed forms open a member of the enclosing object)
+    JsonWriter& beginObject();
+    JsonWriter& beginObject(const JsonKey& key);
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& beginArray(const JsonKey& key);
+    JsonWriter& endArray();
+
+    // Object members
+    JsonWriter& field(const JsonKey& key, bool value);
+    JsonWriter& field(const JsonKey& key, int32_t value);
+    JsonWriter& field(const JsonKey& key, uint32_t value);
+    JsonWriter& field(const JsonKey& key, uint64_t value);
+    JsonWriter& field(const JsonKey& key, float value, uint8_t decimals = 1);
+    JsonWriter& field(const JsonKey& key, const char* value);
+
+    // Array elements
+    JsonWriter& value(uint32_t number);
+    JsonWriter& value(float number, uint8_t decimals = 1);
+    JsonWriter& value(const char* text);
+
+    /**
+     * Get the number of bytes written (excluding the terminator)
+     */
+    size_t length() const { return used; }
+
+    /**
+     * Check whether output was dropped because the buffer was full
+     */
+    bool overflowed() const { return overflow; }
+
+    const char* c_str() const { return buffer; }
+};
+
+#endif // JSONWRITER_H
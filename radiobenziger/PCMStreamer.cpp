@@ -1,5 +1,6 @@
 #include "PCMStreamer.h"
 #include <esp_log.h>
+#include "AudioHot.h"
 
 static const char* TAG = "PCMStreamer";
 
@@ -16,14 +17,11 @@ PCMStreamer::PCMStreamer(const AudioConfig& config, const PinConfig& pins, i2s_p
     maxBufferSize = audioConfig.bufferSize * audioConfig.bufferCount * 4; // 4x for safety
     
     // Initialize statistics
-    totalBytesWritten = 0;
-    totalPacketsProcessed = 0;
-    bufferOverflows = 0;
-    bufferUnderruns = 0;
-    lastWriteTime = 0;
+    stats = {};
+    statsSequence.store(0, std::memory_order_relaxed);
     
-    // Pre-allocate internal buffer
-    internalBuffer.reserve(maxBufferSize);
+    // No internal buffer pre-allocation: the I2S driver's DMA ring does the
+    // buffering, and callers stage chunks in their own memory
     
     ESP_LOGI(TAG, "PCMStreamer created: %dHz, %d-bit, %d-channel", 
              audioConfig.sampleRate, audioConfig.bitsPerSample, audioConfig.channels);
@@ -129,7 +127,7 @@ size_t PCMStreamer::write(const std::vector<uint8_t>& data, uint32_t timeoutMs)
 }
 
 // Write PCM data from a raw buffer
-size_t PCMStreamer::write(const uint8_t* data, size_t size, uint32_t timeoutMs) {
+size_t AUDIO_HOT_ATTR PCMStreamer::write(const uint8_t* data, size_t size, uint32_t timeoutMs) {
     if (!isReady() || !data || size == 0) {
         return 0;
     }
@@ -159,13 +157,17 @@ size_t PCMStreamer::write(const uint8_t* data, size_t size, uint32_t timeoutMs)
     }
     
     // Update statistics
-    totalBytesWritten += bytesWritten;
-    totalPacketsProcessed++;
-    lastWriteTime = millis();
+    beginStatsUpdate();
+    stats.totalBytesWritten += bytesWritten;
+    stats.totalPacketsProcessed++;
+    stats.lastWriteTime = millis();
+    if (bytesWritten < size) {
+        stats.bufferOverflows++;
+    }
+    endStatsUpdate();
     
     // Check for buffer issues
     if (bytesWritten < size) {
-        bufferOverflows++;
         ESP_LOGW(TAG, "Buffer overflow: wrote %d/%d bytes", bytesWritten, size);
     }
     
@@ -264,12 +266,13 @@ void PCMStreamer::printDiagnostics() const {
     ESP_LOGI(TAG, "  Available Space: %d bytes", getAvailableBufferSpace());
     ESP_LOGI(TAG, "  Utilization: %.1f%%", getBufferUtilization());
     
+    StatsSnapshot snapshot = getStatsSnapshot();
     ESP_LOGI(TAG, "Statistics:");
-    ESP_LOGI(TAG, "  Total Bytes Written: %d", totalBytesWritten);
-    ESP_LOGI(TAG, "  Total Packets: %d", totalPacketsProcessed);
-    ESP_LOGI(TAG, "  Buffer Overflows: %d", bufferOverflows);
-    ESP_LOGI(TAG, "  Buffer Underruns: %d", bufferUnderruns);
-    ESP_LOGI(TAG, "  Time Since Last Write: %dms", getTimeSinceLastWrite());
+    ESP_LOGI(TAG, "  Total Bytes Written: %llu", (unsigned long long)snapshot.totalBytesWritten);
+    ESP_LOGI(TAG, "  Total Packets: %llu", (unsigned long long)snapshot.totalPacketsProcessed);
+    ESP_LOGI(TAG, "  Buffer Overflows: %d", snapshot.bufferOverflows);
+    ESP_LOGI(TAG, "  Buffer Underruns: %d", snapshot.bufferUnderruns);
+    ESP_LOGI(TAG, "  Time Since Last Write: %dms", millis() - snapshot.lastWriteTime);
     ESP_LOGI(TAG, "  Bytes Per Second: %d", getBytesPerSecond());
     ESP_LOGI(TAG, "  Buffer Duration: %dms", getBufferDurationMs());
     
@@ -278,11 +281,32 @@ void PCMStreamer::printDiagnostics() const {
 
 // Reset statistics counters
 void PCMStreamer::resetStatistics() {
-    totalBytesWritten = 0;
-    totalPacketsProcessed = 0;
-    bufferOverflows = 0;
-    bufferUnderruns = 0;
-    lastWriteTime = millis();
+    beginStatsUpdate();
+    stats = {};
+    stats.lastWriteTime = millis();
+    endStatsUpdate();
+}
+
+// Get a consistent copy of the statistics (seqlock reader)
+PCMStreamer::StatsSnapshot PCMStreamer::getStatsSnapshot() const {
+    StatsSnapshot snapshot;
+    uint32_t before;
+    uint32_t after;
+    
+    for (;;) {
+        before = statsSequence.load(std::memory_order_acquire);
+        snapshot = stats;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = statsSequence.load(std::memory_order_relaxed);
+        if (!(before & 1) && before == after) {
+            break;
+        }
+        // A higher-priority reader (web handlers) may have preempted the
+        // writer mid-update on this core: block so the writer can finish
+        vTaskDelay(1);
+    }
+    
+    return snapshot;
 }
 
 // Calculate bytes per second based on current configuration
@@ -317,6 +341,19 @@ bool PCMStreamer::isDataAligned(size_t bytes) const {
 
 // Private methods implementation
 
+// Seqlock writer side: only the task calling write() updates statistics,
+// so the sequence needs no read-modify-write
+void AUDIO_HOT_ATTR PCMStreamer::beginStatsUpdate() {
+    uint32_t sequence = statsSequence.load(std::memory_order_relaxed);
+    statsSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void AUDIO_HOT_ATTR PCMStreamer::endStatsUpdate() {
+    uint32_t sequence = statsSequence.load(std::memory_order_relaxed);
+    statsSequence.store(sequence + 1, std::memory_order_release);
+}
+
 // Configure I2S
 bool PCMStreamer::configureI2S() {
     ESP_LOGI(TAG, "Configuring I2S...");
@@ -333,6 +370,14 @@ bool PCMStreamer::configureI2S() {
             return false;
     }
     
+    // With an IRAM-safe driver ISR, DMA descriptors keep being serviced while
+    // a flash write has the cache disabled
+#if CONFIG_I2S_ISR_IRAM_SAFE
+    const int intrFlags = ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_IRAM;
+#else
+    const int intrFlags = ESP_INTR_FLAG_LEVEL1;
+#endif
+    
     // Configure I2S
     i2s_config_t i2sConfig = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
@@ -340,7 +385,7 @@ bool PCMStreamer::configureI2S() {
         .bits_per_sample = i2sBits,
         .channel_format = audioConfig.channels == 1 ? I2S_CHANNEL_FMT_ONLY_LEFT : I2S_CHANNEL_FMT_RIGHT_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .intr_alloc_flags = intrFlags,
         .dma_buf_count = audioConfig.bufferCount,
         .dma_buf_len = audioConfig.bufferSize,
         .use_apll = audioConfig.useAPLL,
@@ -348,6 +393,8 @@ bool PCMStreamer::configureI2S() {
         .fixed_mclk = 0
     };
     
+    ESP_LOGI(TAG, "I2S ISR IRAM-safe: %s", (intrFlags & ESP_INTR_FLAG_IRAM) ? "yes" : "no");
+    
     // Install I2S driver
     esp_err_t result = i2s_driver_install(i2sPort, &i2sConfig, 0, NULL);
     if (result != ESP_OK) {
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <atomic>
 #include "driver/i2s.h"
 
 /**
@@ -65,6 +66,20 @@ public:
         ERROR_BUFFER_OVERFLOW,
         ERROR_UNDERRUN
     };
+    
+    /**
+     * Consistent copy of the streaming statistics
+     * 
+     * Byte and packet counters are 64-bit so they do not wrap during
+     * long-running playback (32-bit byte counts wrap after ~18h at 64KB/s).
+     */
+    struct StatsSnapshot {
+        uint64_t totalBytesWritten;    // Bytes accepted by the I2S driver
+        uint64_t totalPacketsProcessed; // Successful write() calls
+        uint32_t bufferOverflows;      // Writes the driver only partially accepted
+        uint32_t bufferUnderruns;      // Reported underruns
+        uint32_t lastWriteTime;        // millis() of the last successful write
+    };
 
 private:
     // Configuration
@@ -83,12 +98,9 @@ private:
     size_t bufferReadPos;
     size_t maxBufferSize;
     
-    // Statistics
-    uint32_t totalBytesWritten;
-    uint32_t totalPacketsProcessed;
-    uint32_t bufferOverflows;
-    uint32_t bufferUnderruns;
-    uint32_t lastWriteTime;
+    // Statistics (seqlock: odd sequence = update in progress)
+    StatsSnapshot stats;
+    std::atomic<uint32_t> statsSequence;
     
     // Internal methods
     bool configureI2S();
@@ -96,6 +108,8 @@ private:
     size_t getAvailableBufferSpace() const;
     size_t getBufferedDataSize() const;
     void updateStatistics();
+    void beginStatsUpdate();
+    void endStatsUpdate();
     
 public:
     /**
@@ -238,30 +252,39 @@ public:
     bool isBufferNearlyEmpty() const { return getBufferUtilization() < 20.0f; }
     
     // Statistics and diagnostics
+    /**
+     * Get a consistent copy of all statistics
+     * 
+     * Safe to call from any task or core, but not from an ISR or a
+     * critical section. Never blocks the audio writer: a reader that raced
+     * with an update sleeps a tick and retries.
+     */
+    StatsSnapshot getStatsSnapshot() const;
+    
     /**
      * Get total bytes written since initialization
      */
-    uint32_t getTotalBytesWritten() const { return totalBytesWritten; }
+    uint64_t getTotalBytesWritten() const { return getStatsSnapshot().totalBytesWritten; }
     
     /**
      * Get total packets processed
      */
-    uint32_t getTotalPacketsProcessed() const { return totalPacketsProcessed; }
+    uint64_t getTotalPacketsProcessed() const { return getStatsSnapshot().totalPacketsProcessed; }
     
     /**
      * Get number of buffer overflows
      */
-    uint32_t getBufferOverflows() const { return bufferOverflows; }
+    uint32_t getBufferOverflows() const { return getStatsSnapshot().bufferOverflows; }
     
     /**
      * Get number of buffer underruns
      */
-    uint32_t getBufferUnderruns() const { return bufferUnderruns; }
+    uint32_t getBufferUnderruns() const { return getStatsSnapshot().bufferUnderruns; }
     
     /**
      * Get time since last write operation (milliseconds)
      */
-    uint32_t getTimeSinceLastWrite() const { return millis() - lastWriteTime; }
+    uint32_t getTimeSinceLastWrite() const { return millis() - getStatsSnapshot().lastWriteTime; }
     
     /**
      * Print detailed diagnostics to Serial
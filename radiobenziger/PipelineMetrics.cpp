@@ -0,0 +1,181 @@
+#include "PipelineMetrics.h"
+#include "PCMStreamer.h"
+#include "BufferPrintf.h"
+#include "AudioHot.h"
+
+// Read latency bucket upper bounds: 1ms .. 2s
+AUDIO_HOT_DATA const uint32_t PipelineMetrics::LATENCY_BUCKETS_US[PipelineMetrics::LATENCY_BUCKET_COUNT] = {
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2000000
+};
+
+// Static member definitions
+portMUX_TYPE PipelineMetrics::lock = portMUX_INITIALIZER_UNLOCKED;
+PipelineMetrics::Counters PipelineMetrics::counters = {};
+
+void AUDIO_HOT_ATTR PipelineMetrics::recordBytesIn(size_t bytes) {
+    portENTER_CRITICAL(&lock);
+    counters.bytesIn += bytes;
+    portEXIT_CRITICAL(&lock);
+}
+
+void AUDIO_HOT_ATTR PipelineMetrics::recordReadLatency(uint32_t latencyUs) {
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKET_COUNT && latencyUs > LATENCY_BUCKETS_US[bucket]) {
+        bucket++;
+    }
+
+    portENTER_CRITICAL(&lock);
+    counters.readLatencyBuckets[bucket]++;
+    counters.readLatencySumUs += latencyUs;
+    counters.readCount++;
+    portEXIT_CRITICAL(&lock);
+}
+
+void AUDIO_HOT_ATTR PipelineMetrics::recordSilence(size_t frames) {
+    portENTER_CRITICAL(&lock);
+    counters.silenceFrames += frames;
+    portEXIT_CRITICAL(&lock);
+}
+
+void AUDIO_HOT_ATTR PipelineMetrics::recordUnderrun() {
+    portENTER_CRITICAL(&lock);
+    counters.underruns++;
+    portEXIT_CRITICAL(&lock);
+}
+
+void AUDIO_HOT_ATTR PipelineMetrics::recordOverflow(size_t droppedBytes) {
+    portENTER_CRITICAL(&lock);
+    counters.overflows++;
+    counters.overflowBytes += droppedBytes;
+    portEXIT_CRITICAL(&lock);
+}
+
+void PipelineMetrics::recordReconnect() {
+    portENTER_CRITICAL(&lock);
+    counters.reconnects++;
+    portEXIT_CRITICAL(&lock);
+}
+
+PipelineMetrics::Totals PipelineMetrics::getTotals() {
+    Totals totals;
+    portENTER_CRITICAL(&lock);
+    totals.bytesIn = counters.bytesIn;
+    totals.underruns = counters.underruns;
+    totals.overflows = counters.overflows;
+    totals.reconnects = counters.reconnects;
+    portEXIT_CRITICAL(&lock);
+    return totals;
+}
+
+size_t PipelineMetrics::render(char* buffer, size_t size, const Gauges& gauges, const PCMStreamer* streamer) {
+    // Copy under the lock, format outside it
+    Counters snapshot;
+    portENTER_CRITICAL(&lock);
+    snapshot = counters;
+    portEXIT_CRITICAL(&lock);
+
+    size_t used = 0;
+
+    // Counters
+    used = bufferPrintf(buffer, size, used,
+        "# HELP radiobenziger_network_bytes_total PCM bytes received from the relay\n"
+        "# TYPE radiobenziger_network_bytes_total counter\n"
+        "radiobenziger_network_bytes_total %llu\n",
+        (unsigned long long)snapshot.bytesIn);
+
+    // One consistent read of the streamer's statistics for the whole scrape
+    PCMStreamer::StatsSnapshot i2sStats = {};
+    if (streamer) {
+        i2sStats = streamer->getStatsSnapshot();
+        used = bufferPrintf(buffer, size, used,
+            "# HELP radiobenziger_i2s_bytes_total PCM bytes written to I2S\n"
+            "# TYPE radiobenziger_i2s_bytes_total counter\n"
+            "radiobenziger_i2s_bytes_total %llu\n"
+            "# HELP radiobenziger_i2s_writes_total I2S write calls\n"
+            "# TYPE radiobenziger_i2s_writes_total counter\n"
+            "radiobenziger_i2s_writes_total %llu\n",
+            (unsigned long long)i2sStats.totalBytesWritten,
+            (unsigned long long)i2sStats.totalPacketsProcessed);
+    }
+
+    used = bufferPrintf(buffer, size, used,
+        "# HELP radiobenziger_silence_frames_total Silence frames inserted while starved\n"
+        "# TYPE radiobenziger_silence_frames_total counter\n"
+        "radiobenziger_silence_frames_total %llu\n"
+        "# HELP radiobenziger_underruns_total Times playback ran out of buffered audio\n"
+        "# TYPE radiobenziger_underruns_total counter\n"
+        "radiobenziger_underruns_total %u\n"
+        "# HELP radiobenziger_overflows_total Writes that did not fit into the next stage\n"
+        "# TYPE radiobenziger_overflows_total counter\n"
+        "radiobenziger_overflows_total{stage=\"reservoir\"} %u\n",
+        (unsigned long long)snapshot.silenceFrames,
+        (unsigned)snapshot.underruns,
+        (unsigned)snapshot.overflows);
+
+    if (streamer) {
+        used = bufferPrintf(buffer, size, used, "radiobenziger_overflows_total{stage=\"i2s\"} %u\n",
+                            (unsigned)i2sStats.bufferOverflows);
+    }
+
+    used = bufferPrintf(buffer, size, used,
+        "# HELP radiobenziger_reconnects_total Stream reconnections after a dropped session\n"
+        "# TYPE radiobenziger_reconnects_total counter\n"
+        "radiobenziger_reconnects_total %u\n",
+        (unsigned)snapshot.reconnects);
+
+    // Read latency histogram (Prometheus buckets are cumulative)
+    used = bufferPrintf(buffer, size, used,
+        "# HELP radiobenziger_stream_read_latency_seconds Time spent in each network read\n"
+        "# TYPE radiobenziger_stream_read_latency_seconds histogram\n");
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        cumulative += snapshot.readLatencyBuckets[i];
+        used = bufferPrintf(buffer, size, used,
+                            "radiobenziger_stream_read_latency_seconds_bucket{le=\"%.3f\"} %u\n",
+                            LATENCY_BUCKETS_US[i] / 1000000.0, (unsigned)cumulative);
+    }
+    used = bufferPrintf(buffer, size, used,
+        "radiobenziger_stream_read_latency_seconds_bucket{le=\"+Inf\"} %u\n"
+        "radiobenziger_stream_read_latency_seconds_sum %.6f\n"
+        "radiobenziger_stream_read_latency_seconds_count %u\n",
+        (unsigned)snapshot.readCount,
+        snapshot.readLatencySumUs / 1000000.0,
+        (unsigned)snapshot.readCount);
+
+    // Gauges
+    used = bufferPrintf(buffer, size, used,
+        "# HELP radiobenziger_buffered_bytes Audio waiting in the reservoir\n"
+        "# TYPE radiobenziger_buffered_bytes gauge\n"
+        "radiobenziger_buffered_bytes %u\n"
+        "# HELP radiobenziger_buffer_capacity_bytes Reservoir capacity\n"
+        "# TYPE radiobenziger_buffer_capacity_bytes gauge\n"
+        "radiobenziger_buffer_capacity_bytes %u\n"
+        "# HELP radiobenziger_streaming_active Playback running (1) or stopped (0)\n"
+        "# TYPE radiobenziger_streaming_active gauge\n"
+        "radiobenziger_streaming_active %d\n"
+        "# HELP radiobenziger_wifi_rssi_dbm WiFi signal strength\n"
+        "# TYPE radiobenziger_wifi_rssi_dbm gauge\n"
+        "radiobenziger_wifi_rssi_dbm %d\n"
+        "# HELP radiobenziger_heap_free_bytes Free internal heap\n"
+        "# TYPE radiobenziger_heap_free_bytes gauge\n"
+        "radiobenziger_heap_free_bytes %u\n"
+        "# HELP radiobenziger_heap_min_free_bytes Lowest free heap since boot\n"
+        "# TYPE radiobenziger_heap_min_free_bytes gauge\n"
+        "radiobenziger_heap_min_free_bytes %u\n"
+        "# HELP radiobenziger_psram_free_bytes Free PSRAM\n"
+        "# TYPE radiobenziger_psram_free_bytes gauge\n"
+        "radiobenziger_psram_free_bytes %u\n"
+        "# HELP radiobenziger_uptime_seconds Time since boot\n"
+        "# TYPE radiobenziger_uptime_seconds gauge\n"
+        "radiobenziger_uptime_seconds %lu\n",
+        (unsigned)gauges.bufferedBytes,
+        (unsigned)gauges.bufferCapacity,
+        gauges.streamingActive ? 1 : 0,
+        (int)gauges.rssi,
+        (unsigned)gauges.freeHeap,
+        (unsigned)gauges.minFreeHeap,
+        (unsigned)gauges.freePsram,
+        (unsigned long)(millis() / 1000));
+
+    return used;
+}
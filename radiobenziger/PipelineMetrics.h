@@ -0,0 +1,78 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+class PCMStreamer;
+
+/**
+ * PipelineMetrics - Monotonic counters and histograms for the audio pipeline
+ *
+ * The streaming and playback tasks record events here; the web server
+ * renders them (together with PCMStreamer statistics and point-in-time
+ * gauges) as Prometheus text into a caller-supplied buffer.
+ *
+ * Updates take a short spinlock so 64-bit counters never tear when read
+ * from the other core.
+ */
+class PipelineMetrics {
+public:
+    /**
+     * Point-in-time values sampled by the caller at render time
+     */
+    struct Gauges {
+        size_t bufferedBytes;          // Audio waiting in the reservoir
+        size_t bufferCapacity;         // Reservoir capacity
+        int32_t rssi;                  // WiFi signal strength (dBm, 0 = not connected)
+        uint32_t freeHeap;             // Current free heap
+        uint32_t minFreeHeap;          // Lowest free heap since boot
+        uint32_t freePsram;            // Current free PSRAM (0 without PSRAM)
+        bool streamingActive;          // Playback running
+    };
+
+    /**
+     * Headline counters for live status displays
+     */
+    struct Totals {
+        uint64_t bytesIn;              // PCM bytes received from the relay
+        uint32_t underruns;            // Starvation episodes
+        uint32_t overflows;            // Reservoir writes that did not fit
+        uint32_t reconnects;           // Reconnections after a dropped session
+    };
+
+    // Recording (called from the audio tasks)
+    static void recordBytesIn(size_t bytes);
+    static void recordReadLatency(uint32_t latencyUs);
+    static void recordSilence(size_t frames);
+    static void recordUnderrun();
+    static void recordOverflow(size_t droppedBytes);
+    static void recordReconnect();
+
+    // Reading
+    static Totals getTotals();
+
+    // Rendering
+    static size_t render(char* buffer, size_t size, const Gauges& gauges, const PCMStreamer* streamer);
+
+private:
+    static const size_t LATENCY_BUCKET_COUNT = 10;
+    static const uint32_t LATENCY_BUCKETS_US[LATENCY_BUCKET_COUNT];
+
+    struct Counters {
+        uint64_t bytesIn;
+        uint64_t silenceFrames;
+        uint64_t overflowBytes;
+        uint32_t underruns;
+        uint32_t overflows;
+        uint32_t reconnects;
+        uint32_t readCount;
+        uint64_t readLatencySumUs;
+        uint32_t readLatencyBuckets[LATENCY_BUCKET_COUNT + 1];  // Last bucket is +Inf
+    };
+
+    static portMUX_TYPE lock;
+    static Counters counters;
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,386 @@
+#ifndef PLAYOUTSCHEDULER_H
+#define PLAYOUTSCHEDULER_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * Synchronized playback: clock estimation and the playout decision
+ *
+ * Three clocks are involved. The relay stamps every frame with the relay
+ * time at which its first sample must play (PTS). ClockEstimator maps relay
+ * time to the receiver's local clock (esp_timer on the device). OutputClock
+ * maps a sample handed to I2S to the local time it will leave the DAC.
+ * PlayoutScheduler compares the two for the next sample in the buffer and
+ * decides whether to play it, skip ahead (late) or insert silence (early).
+ *
+ * All times are microseconds. Kept free of Arduino/FreeRTOS so that
+ * tools/sync_receiver_sim.cpp runs the same code on the host.
+ *
+ * The firmware's audio task calls some of these for every chunk. They are
+ * PLAYOUT_HOT: forced inline into their AUDIO_HOT_ATTR callers, so they run
+ * from wherever those are placed (this header cannot use AudioHot.h).
+ */
+
+#if defined(__GNUC__)
+#define PLAYOUT_HOT inline __attribute__((always_inline))
+#else
+#define PLAYOUT_HOT inline
+#endif
+
+/**
+ * ClockEstimator - Relay clock offset from NTP-style exchanges
+ *
+ * Keeps the last WINDOW exchanges and trusts the one with the smallest
+ * round trip: queueing delay only ever makes a sample worse, so the
+ * fastest exchange has the least asymmetric error.
+ */
+class ClockEstimator {
+public:
+    static const size_t WINDOW = 8;
+
+    ClockEstimator() { reset(); }
+
+    void reset() {
+        count = 0;
+        next = 0;
+        offsetUs = 0;
+        rttUs = 0;
+    }
+
+    /**
+     * Add one exchange
+     *
+     * @param t1 Local time the request was sent
+     * @param t2 Relay time the request arrived
+     * @param t3 Relay time the reply was sent
+     * @param t4 Local time the reply arrived
+     * @return false if the timestamps are inconsistent (ignored)
+     */
+    bool addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+        int64_t rtt = (t4 - t1) - (t3 - t2);
+        if (t4 < t1 || t3 < t2 || rtt < 0) {
+            return false;
+        }
+
+        Sample& sample = samples[next];
+        sample.offsetUs = ((t2 - t1) + (t3 - t4)) / 2;
+        sample.rttUs = rtt;
+        next = (next + 1) % WINDOW;
+        if (count < WINDOW) {
+            count++;
+        }
+
+        // Best (fastest) exchange in the window
+        size_t best = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (samples[i].rttUs < samples[best].rttUs) {
+                best = i;
+            }
+        }
+        offsetUs = samples[best].offsetUs;
+        rttUs = samples[best].rttUs;
+        return true;
+    }
+
+    PLAYOUT_HOT bool isValid() const { return count > 0; }
+    size_t getSampleCount() const { return count; }
+
+    /**
+     * @return Relay clock minus local clock
+     */
+    PLAYOUT_HOT int64_t getOffsetUs() const { return offsetUs; }
+
+    /**
+     * @return Round trip of the exchange the offset came from
+     */
+    int64_t getRttUs() const { return rttUs; }
+
+private:
+    struct Sample {
+        int64_t offsetUs;
+        int64_t rttUs;
+    };
+
+    Sample samples[WINDOW];
+    size_t count;
+    size_t next;
+    int64_t offsetUs;
+    int64_t rttUs;
+};
+
+/**
+ * OutputClock - Local time at which a sample written to I2S is heard
+ *
+ * I2S takes samples from a ring of DMA buffers. A write that has to wait
+ * for space returns right after the DMA engine released a buffer; at that
+ * moment every other buffer is queued ahead of the one being filled, so
+ * its first sample plays `queuedSamples` later. Writing in small pieces
+ * pins the start of that buffer to within one piece.
+ *
+ * Each observation says "sample N plays at time T". Wake-up latency and
+ * piece granularity can only make T too late, so the earliest estimate
+ * over the last WINDOW observations is kept.
+ */
+class OutputClock {
+public:
+    static const size_t WINDOW = 16;
+
+    OutputClock() : sampleRate(32000), queuedUs(0) { reset(); }
+
+    /**
+     * @param rate Output sample rate
+     * @param queuedSamples Audio queued ahead of a freshly released DMA
+     *        buffer: (buffer count - 1) * buffer length
+     */
+    void begin(uint32_t rate, uint32_t queuedSamples) {
+        sampleRate = rate;
+        queuedUs = (int64_t)queuedSamples * 1000000 / rate;
+        reset();
+    }
+
+    /**
+     * Forget all observations (the DMA ring was cleared or underran)
+     */
+    void reset() {
+        count = 0;
+        next = 0;
+    }
+
+    /**
+     * A write of the piece starting at `sample` blocked until `returnedUs`
+     */
+    PLAYOUT_HOT void addObservation(uint64_t sample, int64_t returnedUs) {
+        bases[next] = returnedUs + queuedUs - samplesToUs(sample);
+        next = (next + 1) % WINDOW;
+        if (count < WINDOW) {
+            count++;
+        }
+    }
+
+    PLAYOUT_HOT bool isValid() const { return count > 0; }
+
+    /**
+     * @return Local time at which `sample` (counted from the last reset) plays
+     */
+    PLAYOUT_HOT int64_t playTimeUs(uint64_t sample) const {
+        int64_t base = bases[0];
+        for (size_t i = 1; i < count; i++) {
+            if (bases[i] < base) {
+                base = bases[i];
+            }
+        }
+        return base + samplesToUs(sample);
+    }
+
+private:
+    PLAYOUT_HOT int64_t samplesToUs(uint64_t samples) const {
+        return (int64_t)(samples * 1000000ULL / sampleRate);
+    }
+
+    uint32_t sampleRate;
+    int64_t queuedUs;
+    int64_t bases[WINDOW];             // Local time at which sample 0 would have played
+    size_t count;
+    size_t next;
+};
+
+/**
+ * PlayoutScheduler - Plays each buffered sample at its presentation time
+ *
+ * The producer (streaming task) reports the PTS of each frame together
+ * with the reservoir write position it was stored at; frames that simply
+ * continue the previous one's timeline are not queued. The consumer
+ * (playback task) asks plan() before fetching each chunk.
+ *
+ * Positions are the reservoir's free-running byte counters, compared by
+ * signed difference so they may wrap.
+ */
+class PlayoutScheduler {
+public:
+    static const size_t ANCHOR_SLOTS = 16;
+    static const uint32_t DEFAULT_TOLERANCE_US = 1000;
+
+    struct Plan {
+        enum Action {
+            PLAY,       // On time (or no timing yet): play the next chunk
+            SKIP,       // Late: drop `bytes` from the buffer first
+            SILENCE     // Early: write `bytes` of silence first
+        };
+        Action action;
+        uint32_t bytes;
+        int32_t errorUs;               // Output time minus target time (positive = late)
+    };
+
+    struct Stats {
+        uint32_t skippedBytes;
+        uint32_t silenceBytes;
+        uint32_t corrections;
+        int32_t lastErrorUs;
+        bool locked;                   // Last plan had timing information
+    };
+
+    PlayoutScheduler() :
+        bytesPerSecond(64000),
+        toleranceUs(DEFAULT_TOLERANCE_US),
+        head(0),
+        tail(0) {
+        beginSession();
+        resetConsumer();
+    }
+
+    /**
+     * @param rate PCM bytes per second
+     * @param tolerance Largest error left uncorrected
+     */
+    void configure(uint32_t rate, uint32_t tolerance) {
+        bytesPerSecond = rate;
+        toleranceUs = tolerance;
+    }
+
+    // Producer side
+
+    /**
+     * Start of a new stream: the next frame is always queued
+     */
+    void beginSession() {
+        haveLastAnchor = false;
+    }
+
+    /**
+     * A frame with PTS `ptsUs` was stored starting at reservoir `position`
+     *
+     * @return false if the anchor queue was full (timing of that frame lost)
+     */
+    bool addFrame(uint32_t position, int64_t ptsUs) {
+        // Contiguous audio needs no new anchor
+        if (haveLastAnchor) {
+            int64_t expected = lastAnchorPts + bytesToUs(position - lastAnchorPosition);
+            int64_t drift = ptsUs - expected;
+            if (drift > -ANCHOR_SLACK_US && drift < ANCHOR_SLACK_US) {
+                return true;
+            }
+        }
+
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= ANCHOR_SLOTS) {
+            return false;
+        }
+        anchors[h % ANCHOR_SLOTS].position = position;
+        anchors[h % ANCHOR_SLOTS].ptsUs = ptsUs;
+        head.store(h + 1, std::memory_order_release);
+
+        haveLastAnchor = true;
+        lastAnchorPosition = position;
+        lastAnchorPts = ptsUs;
+        return true;
+    }
+
+    // Consumer side
+
+    /**
+     * Forget the current timing (playback stopped)
+     */
+    void resetConsumer() {
+        haveCurrent = false;
+        stats.locked = false;
+    }
+
+    /**
+     * Decide what to do before the next chunk
+     *
+     * @param readPosition Reservoir position of the next sample to play
+     * @param outputUs Local time at which the next written sample will play
+     * @param relayOffsetUs Relay clock minus local clock
+     * @param maxSilenceBytes Largest silence insert per call
+     */
+    PLAYOUT_HOT Plan plan(uint32_t readPosition, int64_t outputUs, int64_t relayOffsetUs, uint32_t maxSilenceBytes) {
+        Plan result = { Plan::PLAY, 0, 0 };
+
+        // Adopt every anchor the read position has reached
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        while (t != head.load(std::memory_order_acquire)) {
+            const Anchor& anchor = anchors[t % ANCHOR_SLOTS];
+            if ((int32_t)(readPosition - anchor.position) < 0) {
+                break;
+            }
+            current = anchor;
+            haveCurrent = true;
+            t++;
+        }
+        tail.store(t, std::memory_order_release);
+
+        if (!haveCurrent || (int32_t)(readPosition - current.position) < 0) {
+            stats.locked = false;
+            return result;
+        }
+        stats.locked = true;
+
+        int64_t ptsUs = current.ptsUs + bytesToUs(readPosition - current.position);
+        int64_t targetUs = ptsUs - relayOffsetUs;
+        int64_t errorUs = outputUs - targetUs;
+        result.errorUs = errorUs > INT32_MAX ? INT32_MAX : (errorUs < INT32_MIN ? INT32_MIN : (int32_t)errorUs);
+        stats.lastErrorUs = result.errorUs;
+
+        if (errorUs > (int64_t)toleranceUs) {
+            result.action = Plan::SKIP;
+            result.bytes = usToBytes(errorUs);
+            stats.skippedBytes += result.bytes;
+            stats.corrections++;
+        } else if (errorUs < -(int64_t)toleranceUs) {
+            result.action = Plan::SILENCE;
+            result.bytes = usToBytes(-errorUs);
+            if (result.bytes > maxSilenceBytes) {
+                result.bytes = maxSilenceBytes & ~1u;
+            }
+            stats.silenceBytes += result.bytes;
+            stats.corrections++;
+        }
+        return result;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    static const int64_t ANCHOR_SLACK_US = 200;
+
+    struct Anchor {
+        uint32_t position;
+        int64_t ptsUs;
+    };
+
+    PLAYOUT_HOT int64_t bytesToUs(uint32_t bytes) const {
+        return (int64_t)bytes * 1000000 / bytesPerSecond;
+    }
+
+    // Whole 16-bit samples
+    PLAYOUT_HOT uint32_t usToBytes(int64_t us) const {
+        uint64_t bytes = (uint64_t)us * bytesPerSecond / 1000000;
+        if (bytes > 0x7FFFFFFF) {
+            bytes = 0x7FFFFFFF;
+        }
+        return (uint32_t)bytes & ~1u;
+    }
+
+    uint32_t bytesPerSecond;
+    uint32_t toleranceUs;
+
+    // Anchor queue: single producer / single consumer
+    Anchor anchors[ANCHOR_SLOTS];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    // Producer state
+    bool haveLastAnchor;
+    uint32_t lastAnchorPosition;
+    int64_t lastAnchorPts;
+
+    // Consumer state
+    Anchor current;
+    bool haveCurrent;
+    Stats stats = {};
+};
+
+#endif // PLAYOUTSCHEDULER_H
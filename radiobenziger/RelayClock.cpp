@@ -0,0 +1,217 @@
+#include "RelayClock.h"
+#include "AudioArena.h"
+#include "AudioHot.h"
+#include "JsonWriter.h"
+#include "SyncProtocol.h"
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#include <unistd.h>
+
+// Static member definitions
+TaskHandle_t RelayClock::task = nullptr;
+int RelayClock::sock = -1;
+portMUX_TYPE RelayClock::lock = portMUX_INITIALIZER_UNLOCKED;
+char RelayClock::host[64] = "";
+uint16_t RelayClock::port = 0;
+bool RelayClock::active = false;
+uint32_t RelayClock::generation = 0;
+uint32_t RelayClock::openedGeneration = 0;
+ClockEstimator RelayClock::estimator;
+uint32_t RelayClock::sequence = 0;
+uint32_t RelayClock::exchanges = 0;
+uint32_t RelayClock::timeouts = 0;
+
+void RelayClock::begin() {
+    if (task) {
+        return;
+    }
+    task = AudioArena::createTask(taskMain, "RelayClock", TASK_STACK_BYTES, nullptr, TASK_PRIORITY, 1);
+    if (!task) {
+        Serial.println("RelayClock: Failed to create task");
+    }
+}
+
+void RelayClock::start(const char* relayHost, uint16_t relayPort) {
+    portENTER_CRITICAL(&lock);
+    strlcpy(host, relayHost ? relayHost : "", sizeof(host));
+    port = relayPort;
+    active = host[0] != '\0' && port != 0;
+    generation++;
+    estimator.reset();
+    portEXIT_CRITICAL(&lock);
+
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    Serial.printf("RelayClock: Tracking %s:%u\n", relayHost, (unsigned)relayPort);
+}
+
+void RelayClock::stop() {
+    portENTER_CRITICAL(&lock);
+    active = false;
+    generation++;
+    estimator.reset();
+    portEXIT_CRITICAL(&lock);
+
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+bool AUDIO_HOT_ATTR RelayClock::getOffset(int64_t& offsetUs) {
+    portENTER_CRITICAL(&lock);
+    bool valid = active && estimator.isValid();
+    offsetUs = estimator.getOffsetUs();
+    portEXIT_CRITICAL(&lock);
+    return valid;
+}
+
+void RelayClock::writeJson(JsonWriter& json) {
+    portENTER_CRITICAL(&lock);
+    bool tracking = active;
+    bool valid = active && estimator.isValid();
+    uint32_t rttUs = (uint32_t)estimator.getRttUs();
+    uint32_t exchangeCount = exchanges;
+    uint32_t timeoutCount = timeouts;
+    portEXIT_CRITICAL(&lock);
+
+    json.beginObject(JSON_KEY("clock"))
+        .field(JSON_KEY("active"), tracking)
+        .field(JSON_KEY("valid"), valid)
+        .field(JSON_KEY("rtt_us"), rttUs)
+        .field(JSON_KEY("exchanges"), exchangeCount)
+        .field(JSON_KEY("timeouts"), timeoutCount)
+        .endObject();
+}
+
+// Private methods implementation
+
+void RelayClock::taskMain(void* parameter) {
+    for (;;) {
+        char relayHost[sizeof(host)];
+        portENTER_CRITICAL(&lock);
+        bool wanted = active;
+        uint32_t current = generation;
+        memcpy(relayHost, host, sizeof(relayHost));
+        uint16_t relayPort = port;
+        portEXIT_CRITICAL(&lock);
+
+        // (Re)open the socket for a new relay, close it when stopped
+        if (current != openedGeneration) {
+            closeSocket();
+            if (wanted && !openSocket(relayHost, relayPort)) {
+                // The name may resolve once the network is up; start()/stop() wake us early
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RESOLVE_RETRY_MS));
+                continue;
+            }
+            portENTER_CRITICAL(&lock);
+            exchanges = 0;
+            portEXIT_CRITICAL(&lock);
+            openedGeneration = current;
+        }
+
+        if (!wanted) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        uint32_t waitMs = INTERVAL_MS;
+        if (sock >= 0 && WiFi.status() == WL_CONNECTED) {
+            bool completed = exchange(current);
+            portENTER_CRITICAL(&lock);
+            if (generation != current) {
+                // Superseded mid-exchange; counts for neither relay
+            } else if (completed) {
+                exchanges++;
+            } else {
+                timeouts++;
+            }
+            waitMs = exchanges < BURST_EXCHANGES ? BURST_INTERVAL_MS : INTERVAL_MS;
+            portEXIT_CRITICAL(&lock);
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+bool RelayClock::openSocket(const char* relayHost, uint16_t relayPort) {
+    IPAddress address;
+    if (!address.fromString(relayHost) && WiFi.hostByName(relayHost, address) != 1) {
+        return false;
+    }
+
+    struct sockaddr_in relay = {};
+    relay.sin_family = AF_INET;
+    relay.sin_port = htons(relayPort);
+    relay.sin_addr.s_addr = htonl(((uint32_t)address[0] << 24) | ((uint32_t)address[1] << 16) |
+                                  ((uint32_t)address[2] << 8) | address[3]);
+
+    // Connected, so only the relay's datagrams are delivered
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+    if (connect(sock, (struct sockaddr*)&relay, sizeof(relay)) != 0) {
+        closeSocket();
+        return false;
+    }
+    return true;
+}
+
+void RelayClock::closeSocket() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+bool RelayClock::exchange(uint32_t forGeneration) {
+    uint8_t datagram[ClockSyncPacket::WIRE_SIZE];
+
+    // Drop late replies to earlier requests
+    while (recv(sock, datagram, sizeof(datagram), MSG_DONTWAIT) > 0) {
+    }
+
+    ClockSyncPacket request = {};
+    request.type = ClockSyncPacket::REQUEST;
+    request.sequence = ++sequence;
+
+    request.t1 = (uint64_t)esp_timer_get_time();
+    request.encode(datagram, sizeof(datagram));
+    if (send(sock, datagram, sizeof(datagram), 0) != (int)sizeof(datagram)) {
+        return false;
+    }
+
+    // The task sleeps in recv() and is woken by the reply, so t4 is taken
+    // as it arrives; any delay here would read as clock offset
+    int64_t deadline = (int64_t)request.t1 + REPLY_TIMEOUT_US;
+    for (;;) {
+        int64_t remainingUs = deadline - esp_timer_get_time();
+        if (remainingUs <= 0) {
+            return false;
+        }
+        // lwIP counts whole milliseconds, and 0 would mean no timeout
+        struct timeval timeout = {};
+        timeout.tv_usec = (long)((remainingUs + 999) / 1000) * 1000;
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        int length = recv(sock, datagram, sizeof(datagram), 0);
+        int64_t t4 = esp_timer_get_time();
+        if (length < 0) {
+            return false;
+        }
+
+        ClockSyncPacket reply;
+        if (length != (int)sizeof(datagram) || !reply.decode(datagram, length) ||
+            reply.type != ClockSyncPacket::REPLY || reply.sequence != request.sequence) {
+            continue;
+        }
+
+        // start()/stop() during the exchange: the reply is from the old relay
+        // and must not seed the new relay's estimate
+        portENTER_CRITICAL(&lock);
+        bool accepted = generation == forGeneration &&
+                        estimator.addSample((int64_t)reply.t1, (int64_t)reply.t2, (int64_t)reply.t3, t4);
+        portEXIT_CRITICAL(&lock);
+        return accepted;
+    }
+}
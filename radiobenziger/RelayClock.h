@@ -0,0 +1,79 @@
+#ifndef RELAYCLOCK_H
+#define RELAYCLOCK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "PlayoutScheduler.h"
+
+class JsonWriter;
+
+/**
+ * RelayClock - Tracks the relay's clock for synchronized playback
+ *
+ * While a synchronized stream is playing, exchanges ClockSyncPacket
+ * datagrams with the relay (a quick burst at start, then every
+ * INTERVAL_MS) and keeps a ClockEstimator of the relay clock relative to
+ * esp_timer_get_time(). Receivers in different rooms that track the same
+ * relay clock play each frame at the same moment.
+ *
+ * The exchanges run on a task of their own (begin()). It resolves the
+ * relay, and it sleeps in recv() until each reply is delivered, so t4 is
+ * taken as the reply arrives and loop() never waits on the network.
+ * start()/stop(), getOffset() and writeJson() are safe from any task.
+ */
+class RelayClock {
+public:
+    static const uint32_t BURST_EXCHANGES = 8;
+    static const uint32_t BURST_INTERVAL_MS = 100;
+    static const uint32_t INTERVAL_MS = 500;
+    static const uint32_t REPLY_TIMEOUT_US = 20000;
+    static const uint32_t RESOLVE_RETRY_MS = 2000;     // Relay name did not resolve
+    static const uint32_t TASK_STACK_BYTES = 4096;
+    static const UBaseType_t TASK_PRIORITY = 2;        // Above loop(), below PCMStreaming
+
+    /**
+     * Create the exchange task (idle until start())
+     */
+    static void begin();
+
+    /**
+     * Begin tracking the clock of the relay at host:port
+     */
+    static void start(const char* host, uint16_t port);
+
+    /**
+     * Stop exchanging; the estimate is discarded
+     */
+    static void stop();
+
+    /**
+     * @param offsetUs Set to relay clock minus esp_timer_get_time()
+     * @return false until the first exchange has completed
+     */
+    static bool getOffset(int64_t& offsetUs);
+
+    static bool isActive() { return active; }
+
+    static void writeJson(JsonWriter& json);
+
+private:
+    static TaskHandle_t task;
+    static int sock;                   // Connected to the relay while tracking, else -1
+    static portMUX_TYPE lock;
+    static char host[64];
+    static uint16_t port;
+    static bool active;
+    static uint32_t generation;        // Bumped by start()/stop(); the task reopens on change
+    static uint32_t openedGeneration;
+    static ClockEstimator estimator;
+    static uint32_t sequence;
+    static uint32_t exchanges;
+    static uint32_t timeouts;
+
+    static void taskMain(void* parameter);
+    static bool openSocket(const char* relayHost, uint16_t relayPort);
+    static void closeSocket();
+    static bool exchange(uint32_t forGeneration);
+};
+
+#endif // RELAYCLOCK_H
@@ -0,0 +1,345 @@
+#include "RelayDirectory.h"
+#include "JsonWriter.h"
+#include <ESPmDNS.h>
+#include <mdns.h>
+
+// Static member definitions
+portMUX_TYPE RelayDirectory::lock = portMUX_INITIALIZER_UNLOCKED;
+RelayDirectory::Relay RelayDirectory::relays[RelayDirectory::MAX_RELAYS] = {};
+bool RelayDirectory::enabled = false;
+bool RelayDirectory::started = false;
+bool RelayDirectory::refreshRequested = false;
+void* RelayDirectory::search = nullptr;
+uint32_t RelayDirectory::lastQueryMs = 0;
+uint32_t RelayDirectory::queries = 0;
+uint32_t RelayDirectory::answers = 0;
+
+// Scores are the expected milliseconds until audio plays: connect time
+// plus the time to fill the default pre-buffer at the measured rate
+static const uint32_t SCORE_PREBUFFER_BYTES = 48000;     // 750 ms of 32 kHz mono
+static const uint32_t UNMEASURED_CONNECT_MS = 200;
+static const uint32_t UNMEASURED_BYTES_PER_SECOND = 128000;  // Twice real time
+static const uint32_t FAILURE_PENALTY_MS = 2000;
+
+void RelayDirectory::setEnabled(bool enable) {
+    portENTER_CRITICAL(&lock);
+    bool changed = enabled != enable;
+    enabled = enable;
+    refreshRequested = refreshRequested || (enable && changed);
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::update() {
+    // Answers are collected whether or not browsing is still wanted
+    if (search) {
+        collect();
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool wanted = enabled;
+    bool refreshNow = refreshRequested;
+    bool empty = true;
+    for (size_t i = 0; i < MAX_RELAYS; i++) {
+        empty = empty && !relays[i].used;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (!wanted || WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+
+    uint32_t now = millis();
+    uint32_t interval = empty ? EMPTY_QUERY_INTERVAL_MS : QUERY_INTERVAL_MS;
+    if (!refreshNow && lastQueryMs != 0 && now - lastQueryMs < interval) {
+        return;
+    }
+    lastQueryMs = now ? now : 1;
+
+    if (!started && !(started = startResponder())) {
+        return;
+    }
+
+    search = mdns_query_async_new(nullptr, "_pcmradio", "_tcp", MDNS_TYPE_PTR, QUERY_TIMEOUT_MS,
+                                  MAX_RELAYS, nullptr);
+    portENTER_CRITICAL(&lock);
+    refreshRequested = false;
+    queries++;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool RelayDirectory::select(StreamEndpoint& endpoint, const StreamEndpoint* exclude) {
+    uint32_t now = millis();
+    const Relay* best = nullptr;
+    uint32_t bestScore = 0;
+    bool bestWaiting = false;
+
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < MAX_RELAYS; i++) {
+        const Relay& relay = relays[i];
+        if (!relay.used || (exclude && exclude->resolved && relay.port == exclude->port &&
+                            memcmp(relay.address, exclude->address, sizeof(relay.address)) == 0)) {
+            continue;
+        }
+        // Relays backing off only count when every relay is
+        bool waiting = relay.failures > 0 && (int32_t)(relay.retryAtMs - now) > 0;
+        uint32_t relayScore = score(relay);
+        if (!best || (bestWaiting && !waiting) || (bestWaiting == waiting && relayScore < bestScore)) {
+            best = &relay;
+            bestScore = relayScore;
+            bestWaiting = waiting;
+        }
+    }
+    if (best) {
+        endpoint.clear();
+        endpoint.scheme = StreamEndpoint::HTTP;
+        if (best->host[0]) {
+            strlcpy(endpoint.host, best->host, sizeof(endpoint.host));
+        } else {
+            snprintf(endpoint.host, sizeof(endpoint.host), "%u.%u.%u.%u",
+                     best->address[0], best->address[1], best->address[2], best->address[3]);
+        }
+        endpoint.port = best->port;
+        strlcpy(endpoint.path, best->path, sizeof(endpoint.path));
+        // The address came with the answer: no lookup, and kept after a failure
+        endpoint.setAddress(best->address);
+        endpoint.literal = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    return best != nullptr;
+}
+
+void RelayDirectory::refresh() {
+    portENTER_CRITICAL(&lock);
+    refreshRequested = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::recordConnect(const StreamEndpoint& endpoint, uint32_t connectMs) {
+    portENTER_CRITICAL(&lock);
+    Relay* relay = find(endpoint);
+    if (relay) {
+        relay->connectMs = relay->connectMs ? (relay->connectMs * 3 + connectMs) / 4 : (connectMs ? connectMs : 1);
+        relay->failures = 0;
+        relay->sessions++;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::recordThroughput(const StreamEndpoint& endpoint, uint32_t bytesPerSecond) {
+    portENTER_CRITICAL(&lock);
+    Relay* relay = find(endpoint);
+    if (relay && bytesPerSecond > 0) {
+        relay->bytesPerSecond = relay->bytesPerSecond
+            ? (uint32_t)(((uint64_t)relay->bytesPerSecond * 3 + bytesPerSecond) / 4)
+            : bytesPerSecond;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::recordFailure(const StreamEndpoint& endpoint) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&lock);
+    Relay* relay = find(endpoint);
+    if (relay) {
+        if (relay->failures < 255) {
+            relay->failures++;
+        }
+        uint32_t backoff = BACKOFF_MS << (relay->failures < 5 ? relay->failures - 1 : 4);
+        relay->retryAtMs = now + (backoff < MAX_BACKOFF_MS ? backoff : MAX_BACKOFF_MS);
+    }
+    // It may have moved or gone: ask again rather than wait for the refresh
+    refreshRequested = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::writeJson(JsonWriter& json) {
+    portENTER_CRITICAL(&lock);
+    bool browsing = enabled;
+    uint32_t queryCount = queries;
+    uint32_t answerCount = answers;
+    portEXIT_CRITICAL(&lock);
+
+    json.beginObject(JSON_KEY("relays"))
+        .field(JSON_KEY("discovery"), browsing)
+        .field(JSON_KEY("queries"), queryCount)
+        .field(JSON_KEY("answers"), answerCount)
+        .beginArray(JSON_KEY("ranked"));
+
+    // Best first: repeatedly take the lowest score not listed yet
+    uint32_t now = millis();
+    bool listed[MAX_RELAYS] = {};
+    for (size_t rank = 0; rank < MAX_RELAYS; rank++) {
+        Relay relay;
+        uint32_t relayScore = 0;
+        size_t pick = MAX_RELAYS;
+        portENTER_CRITICAL(&lock);
+        for (size_t i = 0; i < MAX_RELAYS; i++) {
+            if (relays[i].used && !listed[i] && (pick == MAX_RELAYS || score(relays[i]) < relayScore)) {
+                pick = i;
+                relayScore = score(relays[i]);
+            }
+        }
+        if (pick < MAX_RELAYS) {
+            relay = relays[pick];
+        }
+        portEXIT_CRITICAL(&lock);
+        if (pick == MAX_RELAYS) {
+            break;
+        }
+        listed[pick] = true;
+
+        char address[16];
+        snprintf(address, sizeof(address), "%u.%u.%u.%u",
+                 relay.address[0], relay.address[1], relay.address[2], relay.address[3]);
+        json.beginObject()
+            .field(JSON_KEY("name"), relay.name)
+            .field(JSON_KEY("address"), address)
+            .field(JSON_KEY("port"), (uint32_t)relay.port)
+            .field(JSON_KEY("path"), relay.path)
+            .field(JSON_KEY("score_ms"), relayScore)
+            .field(JSON_KEY("connect_ms"), relay.connectMs)
+            .field(JSON_KEY("fill_bytes_per_s"), relay.bytesPerSecond)
+            .field(JSON_KEY("failures"), (uint32_t)relay.failures)
+            .field(JSON_KEY("sessions"), relay.sessions)
+            .field(JSON_KEY("seen_s_ago"), (now - relay.lastSeenMs) / 1000)
+            .endObject();
+    }
+    json.endArray().endObject();
+}
+
+// Private methods implementation
+
+bool RelayDirectory::startResponder() {
+    // Unique per device, so a fleet does not fight over one name
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    char hostname[24];
+    snprintf(hostname, sizeof(hostname), "radiobenziger-%02x%02x", mac[4], mac[5]);
+
+    if (!MDNS.begin(hostname)) {
+        Serial.println("RelayDirectory: Failed to start mDNS");
+        return false;
+    }
+    MDNS.addService("http", "tcp", 80);
+    Serial.printf("RelayDirectory: mDNS up as %s.local, browsing _pcmradio._tcp\n", hostname);
+    return true;
+}
+
+void RelayDirectory::collect() {
+    mdns_result_t* results = nullptr;
+    uint8_t count = 0;
+    if (!mdns_query_async_get_results((mdns_search_once_t*)search, 0, &results, &count)) {
+        return;                                    // Still listening
+    }
+
+    uint32_t now = millis();
+    for (mdns_result_t* result = results; result; result = result->next) {
+        if (!result->instance_name || result->port == 0) {
+            continue;
+        }
+        const mdns_ip_addr_t* ip = result->addr;
+        while (ip && ip->addr.type != ESP_IPADDR_TYPE_V4) {
+            ip = ip->next;
+        }
+        if (!ip) {
+            continue;
+        }
+        const esp_ip4_addr_t* ip4 = &ip->addr.u_addr.ip4;
+        uint8_t address[4] = { esp_ip4_addr1(ip4), esp_ip4_addr2(ip4), esp_ip4_addr3(ip4), esp_ip4_addr4(ip4) };
+
+        // TXT "path" names the stream; relays without it serve /stream
+        char path[64] = "/stream";
+        for (size_t i = 0; i < result->txt_count; i++) {
+            const mdns_txt_item_t& item = result->txt[i];
+            if (item.key && item.value && strcmp(item.key, "path") == 0 && item.value[0] == '/') {
+                size_t length = result->txt_value_len[i] < sizeof(path) - 1 ? result->txt_value_len[i]
+                                                                              : sizeof(path) - 1;
+                memcpy(path, item.value, length);
+                path[length] = '\0';
+            }
+        }
+
+        char host[48] = "";
+        if (result->hostname) {
+            snprintf(host, sizeof(host), "%s.local", result->hostname);
+        }
+        learn(result->instance_name, host, address, result->port, path, now);
+    }
+    mdns_query_results_free(results);
+    mdns_query_async_delete((mdns_search_once_t*)search);
+    search = nullptr;
+
+    // Drop relays that stopped answering
+    portENTER_CRITICAL(&lock);
+    answers += count;
+    for (size_t i = 0; i < MAX_RELAYS; i++) {
+        if (relays[i].used && now - relays[i].lastSeenMs > EXPIRY_MS) {
+            relays[i].used = false;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void RelayDirectory::learn(const char* name, const char* host, const uint8_t address[4], uint16_t port,
+                           const char* path, uint32_t nowMs) {
+    bool added = false;
+    portENTER_CRITICAL(&lock);
+    // Same instance, else a free slot, else the one unheard from longest
+    Relay* slot = nullptr;
+    for (size_t i = 0; i < MAX_RELAYS && !slot; i++) {
+        if (relays[i].used && strncmp(relays[i].name, name, sizeof(relays[i].name) - 1) == 0) {
+            slot = &relays[i];
+        }
+    }
+    if (!slot) {
+        for (size_t i = 0; i < MAX_RELAYS; i++) {
+            if (!relays[i].used) {
+                slot = &relays[i];
+                break;
+            }
+            if (!slot || nowMs - relays[i].lastSeenMs > nowMs - slot->lastSeenMs) {
+                slot = &relays[i];
+            }
+        }
+        memset(slot, 0, sizeof(*slot));
+        slot->used = true;
+        strlcpy(slot->name, name, sizeof(slot->name));
+        added = true;
+    }
+
+    // A relay that moved starts its measurements over
+    if (memcmp(slot->address, address, sizeof(slot->address)) != 0 || slot->port != port) {
+        slot->connectMs = 0;
+        slot->bytesPerSecond = 0;
+        slot->failures = 0;
+    }
+    memcpy(slot->address, address, sizeof(slot->address));
+    slot->port = port;
+    strlcpy(slot->host, host, sizeof(slot->host));
+    strlcpy(slot->path, path, sizeof(slot->path));
+    slot->lastSeenMs = nowMs;
+    portEXIT_CRITICAL(&lock);
+
+    if (added) {
+        Serial.printf("RelayDirectory: Found \"%s\" at %u.%u.%u.%u:%u%s\n", name,
+                      address[0], address[1], address[2], address[3], (unsigned)port, path);
+    }
+}
+
+RelayDirectory::Relay* RelayDirectory::find(const StreamEndpoint& endpoint) {
+    for (size_t i = 0; i < MAX_RELAYS; i++) {
+        if (relays[i].used && relays[i].port == endpoint.port &&
+            memcmp(relays[i].address, endpoint.address, sizeof(relays[i].address)) == 0) {
+            return &relays[i];
+        }
+    }
+    return nullptr;
+}
+
+uint32_t RelayDirectory::score(const Relay& relay) {
+    uint32_t connect = relay.connectMs ? relay.connectMs : UNMEASURED_CONNECT_MS;
+    uint32_t rate = relay.bytesPerSecond ? relay.bytesPerSecond : UNMEASURED_BYTES_PER_SECOND;
+    uint32_t fill = (uint32_t)((uint64_t)SCORE_PREBUFFER_BYTES * 1000 / rate);
+    return connect + fill + relay.failures * FAILURE_PENALTY_MS;
+}
@@ -0,0 +1,99 @@
+#ifndef RELAYDIRECTORY_H
+#define RELAYDIRECTORY_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "StreamEndpoint.h"
+
+class JsonWriter;
+
+/**
+ * RelayDirectory - Relays found by DNS-SD, ranked for failover
+ *
+ * While the stream URL is dnssd:// the directory browses for
+ * _pcmradio._tcp services (wav_server.py advertises one) and keeps their
+ * addresses, ports and stream paths from the answers, so connecting never
+ * waits for a lookup. Each relay is scored by what the streaming task
+ * measured on it: connect time (to the response headers), fill rate while
+ * pre-buffering, and recent failures. select() returns the best relay that
+ * is not backing off after a failure, so a reconnect after a dead relay
+ * goes straight to the next one.
+ *
+ * Queries are asynchronous: update() (from loop()) starts one and
+ * collects the answers on a later pass. select() and the record*() calls
+ * belong to the streaming task; writeJson() may be called from any task.
+ */
+class RelayDirectory {
+public:
+    static const size_t MAX_RELAYS = 8;
+    static const uint32_t QUERY_TIMEOUT_MS = 2000;
+    static const uint32_t QUERY_INTERVAL_MS = 60000;   // Refresh while in use
+    static const uint32_t EMPTY_QUERY_INTERVAL_MS = 5000;  // Until the first relay answers
+    static const uint32_t EXPIRY_MS = 180000;          // Unanswered for three refreshes
+    static const uint32_t BACKOFF_MS = 5000;           // Doubles per consecutive failure
+    static const uint32_t MAX_BACKOFF_MS = 60000;
+
+    /**
+     * Browse while `enabled` (the stream URL is dnssd://); the table is kept
+     */
+    static void setEnabled(bool enabled);
+
+    static void update();
+
+    /**
+     * Best relay to connect to, as an http endpoint with its address filled in
+     *
+     * @param exclude Relay to leave out (the one streaming, when choosing a standby)
+     * @return false if no relay is known yet
+     */
+    static bool select(StreamEndpoint& endpoint, const StreamEndpoint* exclude = nullptr);
+
+    /**
+     * Ask for a fresh query on the next update(), e.g. after a failure
+     */
+    static void refresh();
+
+    /**
+     * Measurements of a session with the relay at `endpoint`'s address
+     */
+    static void recordConnect(const StreamEndpoint& endpoint, uint32_t connectMs);
+    static void recordThroughput(const StreamEndpoint& endpoint, uint32_t bytesPerSecond);
+    static void recordFailure(const StreamEndpoint& endpoint);
+
+    static void writeJson(JsonWriter& json);
+
+private:
+    struct Relay {
+        bool used;
+        char name[48];                 // DNS-SD instance name
+        char host[48];                 // SRV target, used for the Host header
+        uint8_t address[4];
+        uint16_t port;
+        char path[64];
+        uint32_t lastSeenMs;
+        uint32_t connectMs;            // Smoothed, 0 = not measured yet
+        uint32_t bytesPerSecond;       // Smoothed pre-buffer fill rate, 0 = not measured yet
+        uint8_t failures;              // Consecutive
+        uint32_t retryAtMs;            // Backing off until then
+        uint32_t sessions;
+    };
+
+    static portMUX_TYPE lock;
+    static Relay relays[MAX_RELAYS];
+    static bool enabled;
+    static bool started;
+    static bool refreshRequested;
+    static void* search;               // mdns_search_once_t in flight
+    static uint32_t lastQueryMs;
+    static uint32_t queries;
+    static uint32_t answers;
+
+    static bool startResponder();
+    static void collect();
+    static void learn(const char* name, const char* host, const uint8_t address[4], uint16_t port,
+                      const char* path, uint32_t nowMs);
+    static Relay* find(const StreamEndpoint& endpoint);
+    static uint32_t score(const Relay& relay);
+};
+
+#endif // RELAYDIRECTORY_H
@@ -0,0 +1,298 @@
+#ifndef RTPFEC_H
+#define RTPFEC_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "RtpProtocol.h"
+
+/**
+ * RtpFec - XOR parity for the RTP multicast stream
+ *
+ * After every `count` audio packets the relay sends one parity packet
+ * (payload type 97, same SSRC, its own sequence numbers) holding the XOR
+ * of their payloads, lengths and timestamps. A receiver that is missing
+ * exactly one packet of the group rebuilds it from the parity and the
+ * others, with no retransmission round trip. Overhead is 1/count
+ * (e.g. 25% for groups of 4); two losses in one group stay lost.
+ *
+ * Parity payload: FecHeader, then the XOR of the group's payloads, each
+ * zero-padded to the longest.
+ *   0  base sequence (u16)   2  count (u8)    3  reserved
+ *   4  length XOR (u16)      6  reserved (u16)
+ *   8  timestamp XOR (u32)
+ */
+struct FecHeader {
+    static const size_t WIRE_SIZE = 12;
+    static const uint8_t PAYLOAD_TYPE = 97;
+    static const uint8_t MAX_COUNT = RtpJitterBuffer::SLOTS / 2;  // Group fits the reorder window
+
+    uint16_t baseSequence;             // First audio packet protected
+    uint8_t count;                     // Audio packets protected
+    uint16_t lengthRecovery;
+    uint32_t timestampRecovery;
+
+    size_t encode(uint8_t* out, size_t size) const {
+        if (size < WIRE_SIZE) {
+            return 0;
+        }
+        memset(out, 0, WIRE_SIZE);
+        RtpHeader::put16(out + 0, baseSequence);
+        out[2] = count;
+        RtpHeader::put16(out + 4, lengthRecovery);
+        RtpHeader::put32(out + 8, timestampRecovery);
+        return WIRE_SIZE;
+    }
+
+    bool decode(const uint8_t* in, size_t size) {
+        if (size < WIRE_SIZE) {
+            return false;
+        }
+        baseSequence = RtpHeader::get16(in + 0);
+        count = in[2];
+        lengthRecovery = RtpHeader::get16(in + 4);
+        timestampRecovery = RtpHeader::get32(in + 8);
+        return count >= 2 && count <= MAX_COUNT;
+    }
+};
+
+/**
+ * dst ^= src, a word at a time (buffers need not be aligned)
+ */
+inline void fecXor(uint8_t* dst, const uint8_t* src, size_t size) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        uint32_t a, b;
+        memcpy(&a, dst + i, 4);
+        memcpy(&b, src + i, 4);
+        a ^= b;
+        memcpy(dst + i, &a, 4);
+    }
+    for (; i < size; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+/**
+ * FecEncoder - Builds parity payloads (reference for relay_multicast.py)
+ */
+class FecEncoder {
+public:
+    explicit FecEncoder(uint8_t groupSize) : count(groupSize) { reset(); }
+
+    void reset() {
+        added = 0;
+    }
+
+    /**
+     * Add an audio packet
+     *
+     * @param out Receives the parity payload when this packet completes a group
+     * @return Parity payload size, or 0 if the group is not complete yet
+     */
+    size_t add(uint16_t sequence, uint32_t timestamp, const uint8_t* payload, size_t size,
+               uint8_t* out, size_t outSize) {
+        if (size > RtpJitterBuffer::MAX_PAYLOAD) {
+            return 0;
+        }
+        if (added == 0) {
+            header.baseSequence = sequence;
+            header.count = count;
+            header.lengthRecovery = 0;
+            header.timestampRecovery = 0;
+            maxSize = 0;
+            memset(parity, 0, sizeof(parity));
+        }
+        header.lengthRecovery ^= (uint16_t)size;
+        header.timestampRecovery ^= timestamp;
+        fecXor(parity, payload, size);
+        if (size > maxSize) {
+            maxSize = size;
+        }
+
+        if (++added < count) {
+            return 0;
+        }
+        added = 0;
+        if (outSize < FecHeader::WIRE_SIZE + maxSize) {
+            return 0;
+        }
+        header.encode(out, outSize);
+        memcpy(out + FecHeader::WIRE_SIZE, parity, maxSize);
+        return FecHeader::WIRE_SIZE + maxSize;
+    }
+
+private:
+    uint8_t count;
+    uint8_t added;
+    FecHeader header;
+    size_t maxSize;
+    uint8_t parity[RtpJitterBuffer::MAX_PAYLOAD];
+};
+
+/**
+ * FecDecoder - Rebuilds single losses into the jitter buffer
+ *
+ * Parity packets are kept until their group is complete, rebuilt or past
+ * the jitter buffer's release point, so a parity packet that overtakes a
+ * reordered audio packet can still be used once that packet arrives.
+ * The group's other packets are read back from the jitter buffer's slots,
+ * which keep their payload for a while after release.
+ */
+class FecDecoder {
+public:
+    static const size_t PARITY_SLOTS = 4;
+
+    struct Stats {
+        uint32_t parity;               // Parity packets accepted
+        uint32_t recovered;            // Audio packets rebuilt
+        uint32_t expired;              // Parity dropped with two or more of its group missing
+    };
+
+    FecDecoder() { reset(); }
+
+    void reset() {
+        for (size_t i = 0; i < PARITY_SLOTS; i++) {
+            slots[i].used = false;
+        }
+        groupSize = 0;
+    }
+
+    /**
+     * Keep a parity packet
+     *
+     * @param data Payload after the RTP header (FecHeader + parity)
+     * @return false if malformed
+     */
+    bool addParity(const RtpHeader& rtp, const uint8_t* data, size_t size) {
+        FecHeader header;
+        if (!header.decode(data, size) || size - FecHeader::WIRE_SIZE > RtpJitterBuffer::MAX_PAYLOAD) {
+            return false;
+        }
+
+        // Free slot, else replace the oldest group
+        Slot* slot = &slots[0];
+        for (size_t i = 0; i < PARITY_SLOTS; i++) {
+            if (!slots[i].used) {
+                slot = &slots[i];
+                break;
+            }
+            if ((int16_t)(slots[i].header.baseSequence - slot->header.baseSequence) < 0) {
+                slot = &slots[i];
+            }
+        }
+        slot->used = true;
+        slot->header = header;
+        slot->ssrc = rtp.ssrc;
+        slot->size = size - FecHeader::WIRE_SIZE;
+        memcpy(slot->parity, data + FecHeader::WIRE_SIZE, slot->size);
+        groupSize = header.count;
+        stats.parity++;
+        return true;
+    }
+
+    /**
+     * Rebuild what the kept parity allows and push it into `jitter`
+     *
+     * @param ssrc Current audio sender (parity from another one is dropped)
+     * @return Packets rebuilt
+     */
+    size_t recover(RtpJitterBuffer& jitter, uint32_t ssrc, int64_t nowUs) {
+        size_t rebuilt = 0;
+        for (size_t i = 0; i < PARITY_SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (!slot.used) {
+                continue;
+            }
+            if (slot.ssrc != ssrc) {
+                slot.used = false;
+                continue;
+            }
+
+            // Which of the group are still wanted?
+            uint8_t wanted = 0;
+            uint8_t available = 0;
+            uint16_t missing = 0;
+            for (uint8_t k = 0; k < slot.header.count; k++) {
+                uint16_t sequence = (uint16_t)(slot.header.baseSequence + k);
+                const uint8_t* data;
+                size_t size;
+                uint32_t timestamp;
+                if (jitter.lookup(sequence, data, size, timestamp)) {
+                    available++;
+                } else if (jitter.isWanted(sequence)) {
+                    wanted++;
+                    missing = sequence;
+                }
+            }
+
+            if (wanted == 0) {
+                slot.used = false;                     // Complete, or too late to help
+            } else if (wanted == 1 && available == slot.header.count - 1) {
+                if (rebuild(slot, missing, jitter, nowUs)) {
+                    rebuilt++;
+                    stats.recovered++;
+                }
+                slot.used = false;
+            } else if (wanted + available < slot.header.count) {
+                slot.used = false;                     // Another member is gone for good
+                stats.expired++;
+            }
+            // Otherwise two or more are outstanding: wait for reordered arrivals
+        }
+        return rebuilt;
+    }
+
+    /**
+     * @return Packets per group of the last parity seen (0 = no FEC)
+     */
+    uint8_t getGroupSize() const { return groupSize; }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Slot {
+        bool used;
+        FecHeader header;
+        uint32_t ssrc;
+        size_t size;
+        uint8_t parity[RtpJitterBuffer::MAX_PAYLOAD];
+    };
+
+    bool rebuild(const Slot& slot, uint16_t missing, RtpJitterBuffer& jitter, int64_t nowUs) {
+        memcpy(scratch, slot.parity, slot.size);
+        uint16_t length = slot.header.lengthRecovery;
+        uint32_t timestamp = slot.header.timestampRecovery;
+        for (uint8_t k = 0; k < slot.header.count; k++) {
+            uint16_t sequence = (uint16_t)(slot.header.baseSequence + k);
+            const uint8_t* data;
+            size_t size;
+            uint32_t memberTimestamp;
+            if (sequence == missing || !jitter.lookup(sequence, data, size, memberTimestamp)) {
+                continue;
+            }
+            fecXor(scratch, data, size < slot.size ? size : slot.size);
+            length ^= (uint16_t)size;
+            timestamp ^= memberTimestamp;
+        }
+        if (length > slot.size) {
+            return false;
+        }
+
+        RtpHeader header;
+        header.payloadType = RtpHeader::PAYLOAD_TYPE_PCM;
+        header.marker = false;
+        header.sequence = missing;
+        header.timestamp = timestamp;
+        header.ssrc = slot.ssrc;
+        return jitter.push(header, scratch, length, nowUs, true);
+    }
+
+    Slot slots[PARITY_SLOTS];
+    uint8_t scratch[RtpJitterBuffer::MAX_PAYLOAD];
+    uint8_t groupSize;
+    Stats stats = {};
+};
+
+#endif // RTPFEC_H
@@ -0,0 +1,491 @@
+#ifndef RTPPROTOCOL_H
+#define RTPPROTOCOL_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * RtpProtocol - RTP multicast receive path (RFC 3550)
+ *
+ * The relay multicasts the station as RTP: one 20 ms packet of device
+ * format PCM (32 kHz mono, 16-bit little-endian, dynamic payload type 96)
+ * per datagram. Every receiver joins the group, so airtime does not grow
+ * with the number of receivers, but there is no retransmission and WiFi
+ * delivers multicast late, out of order or not at all.
+ *
+ * RtpJitterBuffer puts packets back into sequence order and decides when a
+ * missing one is lost; LossConcealer fills the gap. The reservoir behind
+ * them absorbs the remaining timing jitter.
+ */
+struct RtpHeader {
+    static const size_t MIN_SIZE = 12;
+    static const uint8_t VERSION = 2;
+    static const uint8_t PAYLOAD_TYPE_PCM = 96;
+
+    uint8_t payloadType;
+    bool marker;
+    uint16_t sequence;
+    uint32_t timestamp;                // Sample clock (32 kHz)
+    uint32_t ssrc;                     // Changes when the sender restarts
+
+    size_t encode(uint8_t* out, size_t size) const {
+        if (size < MIN_SIZE) {
+            return 0;
+        }
+        out[0] = VERSION << 6;
+        out[1] = (uint8_t)((marker ? 0x80 : 0) | (payloadType & 0x7F));
+        put16(out + 2, sequence);
+        put32(out + 4, timestamp);
+        put32(out + 8, ssrc);
+        return MIN_SIZE;
+    }
+
+    /**
+     * Parse a datagram
+     *
+     * @param payloadSize Set to the payload length (after CSRCs, extension
+     *        and padding are removed)
+     * @return Offset of the payload, or 0 if this is not an RTP packet
+     */
+    size_t decode(const uint8_t* in, size_t size, size_t& payloadSize) {
+        if (size < MIN_SIZE || (in[0] >> 6) != VERSION) {
+            return 0;
+        }
+        bool padding = in[0] & 0x20;
+        bool extension = in[0] & 0x10;
+        size_t offset = MIN_SIZE + (in[0] & 0x0F) * 4;
+        marker = in[1] & 0x80;
+        payloadType = in[1] & 0x7F;
+        sequence = get16(in + 2);
+        timestamp = get32(in + 4);
+        ssrc = get32(in + 8);
+
+        if (extension) {
+            if (size < offset + 4) {
+                return 0;
+            }
+            offset += 4 + get16(in + offset + 2) * 4;
+        }
+        size_t end = size;
+        if (padding) {
+            uint8_t pad = in[size - 1];
+            if (pad == 0 || pad > size) {
+                return 0;
+            }
+            end -= pad;
+        }
+        if (offset > end) {
+            return 0;
+        }
+        payloadSize = end - offset;
+        return offset;
+    }
+
+    // Network byte order
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)(v >> 8);
+        p[1] = (uint8_t)v;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, (uint16_t)(v >> 16));
+        put16(p + 2, (uint16_t)v);
+    }
+
+    static uint16_t get16(const uint8_t* p) {
+        return (uint16_t)((p[0] << 8) | p[1]);
+    }
+
+    static uint32_t get32(const uint8_t* p) {
+        return ((uint32_t)get16(p) << 16) | get16(p + 2);
+    }
+};
+
+/**
+ * RtpJitterBuffer - Reorders packets and declares losses
+ *
+ * Packets are released strictly in sequence order. When the next one is
+ * missing but later ones have arrived, it is waited for for the hold time
+ * (measured from the arrival of the first packet after the gap) and then
+ * reported lost. The hold adapts to the RFC 3550 interarrival jitter:
+ * on a clean link a loss costs one packet time, on a jittery one the
+ * buffer waits longer before giving up on a late packet.
+ *
+ * A timestamp jump between consecutive packets (the sender paused but kept
+ * its clock running) is released as silence, so the pause is not lost from
+ * the timeline. Pauses over MAX_GAP_US are skipped: playout has already
+ * run dry and filled them itself.
+ *
+ * Single-threaded: push() and pop() are called from the same task.
+ */
+class RtpJitterBuffer {
+public:
+    static const size_t SLOTS = 16;                // 320 ms of 20 ms packets
+    static const size_t MAX_PAYLOAD = 1280;        // 20 ms of 32 kHz mono PCM
+    static const int64_t MIN_HOLD_US = 20000;
+    static const int64_t MAX_HOLD_US = 120000;
+    static const int64_t MAX_GAP_US = 320000;     // Longer sender pauses already drained playout
+
+    enum Result {
+        NOTHING,    // Next packet not available yet
+        PACKET,     // `data`/`size`: the next packet's payload
+        LOST,       // The next packet will not come: conceal `samples`
+        GAP         // The sender skipped `samples` of timestamp: play silence
+    };
+
+    struct Output {
+        Result type;
+        const uint8_t* data;           // Valid until the next push()
+        size_t size;
+        uint32_t samples;
+    };
+
+    struct Stats {
+        uint32_t received;             // Packets accepted
+        uint32_t lost;                 // Packets declared lost
+        uint32_t reordered;            // Arrived after a later packet, still in time
+        uint32_t late;                 // Arrived after being declared lost, or duplicates
+        uint32_t resyncs;              // Sender restarted or jumped beyond the window
+        uint32_t recovered;            // Rebuilt from parity (RtpFec.h) before being declared lost
+        uint32_t jitterUs;             // RFC 3550 interarrival jitter
+        uint32_t holdUs;               // Current wait for a missing packet
+        uint32_t gapSamples;           // Silence for timestamps the sender skipped
+    };
+
+    RtpJitterBuffer() : sampleRate(32000), minHoldUs(MIN_HOLD_US) { reset(); }
+
+    /**
+     * @param rate RTP timestamp clock (samples per second)
+     */
+    void configure(uint32_t rate) {
+        sampleRate = rate;
+    }
+
+    /**
+     * Wait at least this long for a missing packet, e.g. long enough for
+     * the parity packet that could rebuild it to arrive
+     */
+    void setMinHoldUs(int64_t holdUs) {
+        minHoldUs = holdUs > MIN_HOLD_US ? holdUs : MIN_HOLD_US;
+    }
+
+    /**
+     * Forget all packets and the sender (keeps statistics)
+     */
+    void reset() {
+        started = false;
+        for (size_t i = 0; i < SLOTS; i++) {
+            slots[i].held = false;
+            slots[i].valid = false;
+        }
+        haveTransit = false;
+        jitterUs = 0;
+        stats.jitterUs = 0;
+        stats.holdUs = (uint32_t)minHoldUs;
+    }
+
+    /**
+     * Add a received packet
+     *
+     * @param nowUs Arrival time (any monotonic microsecond clock)
+     * @param recovered Rebuilt locally rather than received (not counted
+     *        as received, and its arrival time says nothing about jitter)
+     * @return false if the packet was dropped (late, duplicate or oversized)
+     */
+    bool push(const RtpHeader& header, const uint8_t* payload, size_t size, int64_t nowUs,
+              bool recovered = false) {
+        if (size > MAX_PAYLOAD || (size & 1)) {
+            return false;
+        }
+        if (started && header.ssrc != ssrc) {
+            // Sender restarted: its sequence space is unrelated to the old one
+            reset();
+            stats.resyncs++;
+        }
+        if (!started) {
+            started = true;
+            ssrc = header.ssrc;
+            nextSequence = header.sequence;
+            highestSequence = header.sequence;
+            lastTimestampEnd = header.timestamp;
+        }
+
+        int16_t ahead = (int16_t)(header.sequence - nextSequence);
+        if (ahead < 0) {
+            stats.late++;
+            return false;
+        }
+        if (ahead >= (int16_t)SLOTS) {
+            // A gap longer than the window: whatever is held is too old to wait for
+            stats.lost += (uint32_t)ahead;
+            stats.resyncs++;
+            for (size_t i = 0; i < SLOTS; i++) {
+                slots[i].held = false;
+                slots[i].valid = false;
+            }
+            nextSequence = header.sequence;
+            highestSequence = header.sequence;
+            lastTimestampEnd = header.timestamp;
+        }
+
+        Slot& slot = slots[header.sequence % SLOTS];
+        if (slot.held) {
+            stats.late++;
+            return false;
+        }
+        memcpy(slot.payload, payload, size);
+        slot.size = size;
+        slot.sequence = header.sequence;
+        slot.timestamp = header.timestamp;
+        slot.arrivalUs = nowUs;
+        slot.held = true;
+        slot.valid = true;
+
+        if (recovered) {
+            stats.recovered++;
+            return true;
+        }
+        if ((int16_t)(header.sequence - highestSequence) < 0) {
+            stats.reordered++;
+        } else {
+            highestSequence = header.sequence;
+        }
+        stats.received++;
+        updateJitter(header.timestamp, nowUs);
+        return true;
+    }
+
+    /**
+     * Payload of packet `sequence` if it is still in its slot (held, or
+     * released but not yet overwritten)
+     */
+    bool lookup(uint16_t sequence, const uint8_t*& data, size_t& size, uint32_t& timestamp) const {
+        const Slot& slot = slots[sequence % SLOTS];
+        if (!started || !slot.valid || slot.sequence != sequence) {
+            return false;
+        }
+        data = slot.payload;
+        size = slot.size;
+        timestamp = slot.timestamp;
+        return true;
+    }
+
+    /**
+     * Whether packet `sequence` is still missing and not yet given up on
+     */
+    bool isWanted(uint16_t sequence) const {
+        int16_t ahead = (int16_t)(sequence - nextSequence);
+        if (!started || ahead < 0 || ahead >= (int16_t)SLOTS) {
+            return false;
+        }
+        const Slot& slot = slots[sequence % SLOTS];
+        return !(slot.held && slot.sequence == sequence);
+    }
+
+    /**
+     * Take the next packet in sequence order, if it is due
+     *
+     * @return false if out.type is NOTHING
+     */
+    bool pop(int64_t nowUs, Output& out) {
+        out.type = NOTHING;
+        out.data = nullptr;
+        out.size = 0;
+        out.samples = 0;
+        if (!started) {
+            return false;
+        }
+
+        Slot& slot = slots[nextSequence % SLOTS];
+        if (slot.held && slot.sequence == nextSequence) {
+            // The sender kept its clock running while it had nothing to send:
+            // fill the skipped time before the packet, a chunk per call
+            int32_t gap = (int32_t)(slot.timestamp - lastTimestampEnd);
+            if (gap > 0 && (int64_t)gap * 1000000 <= MAX_GAP_US * sampleRate) {
+                out.type = GAP;
+                out.samples = (uint32_t)gap < MAX_PAYLOAD / 2 ? (uint32_t)gap : MAX_PAYLOAD / 2;
+                lastTimestampEnd += out.samples;
+                stats.gapSamples += out.samples;
+                return true;
+            }
+
+            slot.held = false;
+            out.type = PACKET;
+            out.data = slot.payload;
+            out.size = slot.size;
+            out.samples = (uint32_t)(slot.size / 2);
+            lastTimestampEnd = slot.timestamp + out.samples;
+            nextSequence++;
+            return true;
+        }
+
+        // Missing: wait for it until the earliest later arrival has been held
+        // long enough (a rebuilt packet arrives late, so it need not be the
+        // next one in sequence)
+        const Slot* following = nullptr;
+        int64_t firstArrivalUs = 0;
+        for (size_t i = 1; i < SLOTS; i++) {
+            const Slot& candidate = slots[(uint16_t)(nextSequence + i) % SLOTS];
+            if (!candidate.held || candidate.sequence != (uint16_t)(nextSequence + i)) {
+                continue;
+            }
+            if (!following || candidate.arrivalUs < firstArrivalUs) {
+                firstArrivalUs = candidate.arrivalUs;
+            }
+            if (!following) {
+                following = &candidate;
+            }
+        }
+        if (!following || nowUs - firstArrivalUs < (int64_t)stats.holdUs) {
+            return false;
+        }
+
+        // Spread the timestamp gap over the missing packets
+        uint16_t missing = (uint16_t)(following->sequence - nextSequence);
+        uint32_t samples = (following->timestamp - lastTimestampEnd) / missing;
+        if (samples == 0 || samples > MAX_PAYLOAD / 2) {
+            samples = MAX_PAYLOAD / 2;
+        }
+        out.type = LOST;
+        out.samples = samples;
+        lastTimestampEnd += samples;
+        nextSequence++;
+        stats.lost++;
+        return true;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Slot {
+        uint8_t payload[MAX_PAYLOAD];
+        size_t size;
+        uint16_t sequence;
+        uint32_t timestamp;
+        int64_t arrivalUs;
+        bool held;                     // Waiting to be released
+        bool valid;                    // Payload intact (kept after release for parity recovery)
+    };
+
+    // RFC 3550 A.8, in microseconds
+    void updateJitter(uint32_t timestamp, int64_t arrivalUs) {
+        int64_t transit = arrivalUs - (int64_t)timestamp * 1000000 / sampleRate;
+        if (haveTransit) {
+            int64_t d = transit - lastTransit;
+            if (d < 0) {
+                d = -d;
+            }
+            jitterUs += (d - jitterUs) / 16;
+        }
+        lastTransit = transit;
+        haveTransit = true;
+
+        int64_t hold = minHoldUs + 3 * jitterUs;
+        int64_t limit = minHoldUs > MAX_HOLD_US ? minHoldUs : MAX_HOLD_US;
+        stats.jitterUs = (uint32_t)jitterUs;
+        stats.holdUs = (uint32_t)(hold > limit ? limit : hold);
+    }
+
+    uint32_t sampleRate;
+    int64_t minHoldUs;
+    Slot slots[SLOTS];
+    bool started;
+    uint32_t ssrc;
+    uint16_t nextSequence;
+    uint16_t highestSequence;
+    uint32_t lastTimestampEnd;         // Timestamp just after the last released packet
+    bool haveTransit;
+    int64_t lastTransit;
+    int64_t jitterUs;
+    Stats stats = {};
+};
+
+/**
+ * LossConcealer - Fills lost packets from the last good audio
+ *
+ * A lost packet is replaced by a repeat of the previous packet's waveform,
+ * faded out over FADE_PACKETS consecutive losses so a single loss is
+ * barely audible and a longer outage decays to silence instead of
+ * buzzing. The first packet after a loss fades back in so the splice does
+ * not click.
+ */
+class LossConcealer {
+public:
+    static const size_t MAX_SAMPLES = RtpJitterBuffer::MAX_PAYLOAD / 2;
+    static const uint32_t FADE_PACKETS = 3;
+    static const size_t FADE_IN_SAMPLES = 64;
+
+    LossConcealer() { reset(); }
+
+    void reset() {
+        historySamples = 0;
+        consecutive = 0;
+        concealedSamples = 0;
+    }
+
+    /**
+     * Copy a received packet to `out`, smoothing the splice after a loss
+     *
+     * @return Bytes written (== size)
+     */
+    size_t received(const uint8_t* data, size_t size, uint8_t* out) {
+        size_t samples = size / 2;
+        if (samples > MAX_SAMPLES) {
+            samples = MAX_SAMPLES;
+        }
+        memcpy(history, data, samples * 2);
+        historySamples = samples;
+        memcpy(out, data, samples * 2);
+
+        if (consecutive > 0) {
+            size_t fade = samples < FADE_IN_SAMPLES ? samples : FADE_IN_SAMPLES;
+            for (size_t i = 0; i < fade; i++) {
+                int16_t value = (int16_t)((int32_t)history[i] * (int32_t)i / (int32_t)fade);
+                memcpy(out + i * 2, &value, sizeof(value));
+            }
+            consecutive = 0;
+        }
+        return samples * 2;
+    }
+
+    /**
+     * Write `samples` of replacement audio to `out`
+     *
+     * @return Bytes written
+     */
+    size_t conceal(uint32_t samples, uint8_t* out) {
+        if (samples > MAX_SAMPLES) {
+            samples = MAX_SAMPLES;
+        }
+        concealedSamples += samples;
+
+        if (historySamples == 0 || consecutive >= FADE_PACKETS) {
+            memset(out, 0, samples * 2);
+            consecutive++;
+            return samples * 2;
+        }
+
+        // Gain falls linearly across the run of losses (Q15)
+        int32_t from = (int32_t)(32768 * (FADE_PACKETS - consecutive) / FADE_PACKETS);
+        int32_t to = (int32_t)(32768 * (FADE_PACKETS - consecutive - 1) / FADE_PACKETS);
+        for (uint32_t i = 0; i < samples; i++) {
+            int32_t gain = from + (to - from) * (int32_t)i / (int32_t)samples;
+            int16_t value = (int16_t)(((int32_t)history[i % historySamples] * gain) >> 15);
+            memcpy(out + i * 2, &value, sizeof(value));
+        }
+        consecutive++;
+        return samples * 2;
+    }
+
+    uint64_t getConcealedSamples() const { return concealedSamples; }
+
+private:
+    int16_t history[MAX_SAMPLES];
+    size_t historySamples;
+    uint32_t consecutive;              // Losses since the last received packet
+    uint64_t concealedSamples;
+};
+
+#endif // RTPPROTOCOL_H
@@ -0,0 +1,237 @@
+#include "RtpReceiver.h"
+#include "JsonWriter.h"
+#include "BufferPrintf.h"
+#include "PipelineMetrics.h"
+#include "TieredAudioBuffer.h"
+#include "AudioArena.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <new>
+
+// Static member definitions
+WiFiUDP RtpReceiver::udp;
+bool RtpReceiver::joined = false;
+char RtpReceiver::group[16] = "";
+uint16_t RtpReceiver::port = 0;
+RtpJitterBuffer* RtpReceiver::jitter = nullptr;
+FecDecoder* RtpReceiver::fec = nullptr;
+LossConcealer RtpReceiver::concealer;
+uint8_t RtpReceiver::datagram[RtpReceiver::MAX_DATAGRAM];
+uint8_t RtpReceiver::pcm[RtpJitterBuffer::MAX_PAYLOAD];
+uint32_t RtpReceiver::ssrc = 0;
+int64_t RtpReceiver::packetUs = 20000;
+unsigned long RtpReceiver::lastPacketTime = 0;
+portMUX_TYPE RtpReceiver::lock = portMUX_INITIALIZER_UNLOCKED;
+RtpReceiver::Counters RtpReceiver::counters = {};
+uint32_t RtpReceiver::droppedPackets = 0;
+uint32_t RtpReceiver::ignored = 0;
+
+bool RtpReceiver::begin(const char* groupAddress, uint16_t groupPort) {
+    IPAddress address;
+    if (!groupAddress || !address.fromString(groupAddress) || address[0] < 224 || address[0] > 239) {
+        Serial.printf("RtpReceiver: %s is not a multicast group\n", groupAddress ? groupAddress : "(none)");
+        return false;
+    }
+
+    // ~27 KB of packet and parity slots, only for devices that use multicast
+    if (!jitter) {
+        void* memory = allocate(sizeof(RtpJitterBuffer), "rtpJitter");
+        jitter = memory ? new (memory) RtpJitterBuffer() : nullptr;
+    }
+    if (!fec) {
+        void* memory = allocate(sizeof(FecDecoder), "rtpFec");
+        fec = memory ? new (memory) FecDecoder() : nullptr;
+    }
+    if (!jitter || !fec) {
+        Serial.println("RtpReceiver: Failed to allocate the jitter buffer");
+        return false;
+    }
+
+    end();
+    if (udp.beginMulticast(address, groupPort) != 1) {
+        Serial.printf("RtpReceiver: Failed to join %s:%u\n", groupAddress, (unsigned)groupPort);
+        return false;
+    }
+    joined = true;
+    strlcpy(group, groupAddress, sizeof(group));
+    port = groupPort;
+    jitter->reset();
+    jitter->setMinHoldUs(0);
+    fec->reset();
+    concealer.reset();
+    lastPacketTime = millis();
+
+    Serial.printf("RtpReceiver: Joined %s:%u\n", group, (unsigned)port);
+    return true;
+}
+
+void RtpReceiver::end() {
+    if (joined) {
+        udp.stop();
+        joined = false;
+        Serial.printf("RtpReceiver: Left %s:%u\n", group, (unsigned)port);
+    }
+}
+
+size_t RtpReceiver::poll(TieredAudioBuffer& buffer, bool accept) {
+    if (!joined) {
+        return 0;
+    }
+
+    int64_t now = esp_timer_get_time();
+    while (udp.parsePacket() > 0) {
+        int length = udp.read(datagram, sizeof(datagram));
+        RtpHeader header;
+        size_t payloadSize = 0;
+        size_t offset = length > 0 ? header.decode(datagram, length, payloadSize) : 0;
+        if (offset != 0 && header.payloadType == FecHeader::PAYLOAD_TYPE) {
+            fec->addParity(header, datagram + offset, payloadSize);
+            continue;
+        }
+        if (offset == 0 || header.payloadType != RtpHeader::PAYLOAD_TYPE_PCM) {
+            ignored++;
+            continue;
+        }
+        lastPacketTime = millis();
+        ssrc = header.ssrc;
+        if (payloadSize > 0) {
+            packetUs = (int64_t)payloadSize * 1000000 / (2 * 32000);
+        }
+        if (jitter->push(header, datagram + offset, payloadSize, now)) {
+            PipelineMetrics::recordBytesIn(payloadSize);
+        }
+    }
+
+    // Parity follows the last packet of its group: a loss early in the
+    // group must be waited for until then
+    if (fec->getGroupSize() > 0) {
+        jitter->setMinHoldUs((fec->getGroupSize() - 1) * packetUs + RtpJitterBuffer::MIN_HOLD_US / 2);
+        fec->recover(*jitter, ssrc, now);
+    }
+
+    size_t stored = 0;
+    RtpJitterBuffer::Output out;
+    while (jitter->pop(now, out)) {
+        // Conceal even when dropping, so the concealer's history stays current
+        size_t bytes;
+        if (out.type == RtpJitterBuffer::PACKET) {
+            bytes = concealer.received(out.data, out.size, pcm);
+        } else if (out.type == RtpJitterBuffer::LOST) {
+            bytes = concealer.conceal(out.samples, pcm);
+        } else {
+            bytes = out.samples * 2;
+            memset(pcm, 0, bytes);
+        }
+        if (!accept) {
+            droppedPackets++;
+            continue;
+        }
+        size_t buffered = buffer.write(pcm, bytes);
+        if (buffered < bytes) {
+            PipelineMetrics::recordOverflow(bytes - buffered);
+        }
+        stored += buffered;
+    }
+
+    portENTER_CRITICAL(&lock);
+    counters.jitter = jitter->getStats();
+    counters.fec = fec->getStats();
+    counters.fecGroupSize = fec->getGroupSize();
+    counters.concealedSamples = concealer.getConcealedSamples();
+    counters.droppedPackets = droppedPackets;
+    counters.ignored = ignored;
+    portEXIT_CRITICAL(&lock);
+    return stored;
+}
+
+uint32_t RtpReceiver::getIdleMs() {
+    return millis() - lastPacketTime;
+}
+
+void RtpReceiver::writeJson(JsonWriter& json) {
+    Counters snapshot;
+    portENTER_CRITICAL(&lock);
+    snapshot = counters;
+    portEXIT_CRITICAL(&lock);
+
+    json.beginObject(JSON_KEY("multicast"))
+        .field(JSON_KEY("joined"), joined)
+        .field(JSON_KEY("group"), group)
+        .field(JSON_KEY("port"), (uint32_t)port)
+        .field(JSON_KEY("packets"), snapshot.jitter.received)
+        .field(JSON_KEY("lost"), snapshot.jitter.lost)
+        .field(JSON_KEY("recovered"), snapshot.jitter.recovered)
+        .field(JSON_KEY("fec_group"), (uint32_t)snapshot.fecGroupSize)
+        .field(JSON_KEY("parity"), snapshot.fec.parity)
+        .field(JSON_KEY("reordered"), snapshot.jitter.reordered)
+        .field(JSON_KEY("late"), snapshot.jitter.late)
+        .field(JSON_KEY("resyncs"), snapshot.jitter.resyncs)
+        .field(JSON_KEY("dropped"), snapshot.droppedPackets)
+        .field(JSON_KEY("concealed_samples"), snapshot.concealedSamples)
+        .field(JSON_KEY("gap_samples"), snapshot.jitter.gapSamples)
+        .field(JSON_KEY("jitter_us"), snapshot.jitter.jitterUs)
+        .field(JSON_KEY("hold_us"), snapshot.jitter.holdUs)
+        .endObject();
+}
+
+size_t RtpReceiver::renderMetrics(char* buffer, size_t size) {
+    // Nothing to report on devices that never joined a group
+    if (!jitter) {
+        return 0;
+    }
+
+    Counters snapshot;
+    portENTER_CRITICAL(&lock);
+    snapshot = counters;
+    portEXIT_CRITICAL(&lock);
+
+    return bufferPrintf(buffer, size, 0,
+        "# HELP radiobenziger_rtp_packets_total RTP packets by outcome\n"
+        "# TYPE radiobenziger_rtp_packets_total counter\n"
+        "radiobenziger_rtp_packets_total{outcome=\"received\"} %u\n"
+        "radiobenziger_rtp_packets_total{outcome=\"reordered\"} %u\n"
+        "radiobenziger_rtp_packets_total{outcome=\"late\"} %u\n"
+        "radiobenziger_rtp_packets_total{outcome=\"dropped\"} %u\n"
+        "radiobenziger_rtp_packets_total{outcome=\"parity\"} %u\n"
+        "# HELP radiobenziger_rtp_losses_total Missing packets, rebuilt from parity or concealed\n"
+        "# TYPE radiobenziger_rtp_losses_total counter\n"
+        "radiobenziger_rtp_losses_total{result=\"recovered\"} %u\n"
+        "radiobenziger_rtp_losses_total{result=\"unrecoverable\"} %u\n"
+        "# HELP radiobenziger_rtp_concealed_samples_total Samples synthesised for lost packets\n"
+        "# TYPE radiobenziger_rtp_concealed_samples_total counter\n"
+        "radiobenziger_rtp_concealed_samples_total %llu\n"
+        "# HELP radiobenziger_rtp_gap_samples_total Silence played for sender pauses\n"
+        "# TYPE radiobenziger_rtp_gap_samples_total counter\n"
+        "radiobenziger_rtp_gap_samples_total %u\n"
+        "# HELP radiobenziger_rtp_jitter_seconds RFC 3550 interarrival jitter\n"
+        "# TYPE radiobenziger_rtp_jitter_seconds gauge\n"
+        "radiobenziger_rtp_jitter_seconds %.6f\n",
+        (unsigned)snapshot.jitter.received,
+        (unsigned)snapshot.jitter.reordered,
+        (unsigned)snapshot.jitter.late,
+        (unsigned)snapshot.droppedPackets,
+        (unsigned)snapshot.fec.parity,
+        (unsigned)snapshot.jitter.recovered,
+        (unsigned)snapshot.jitter.lost,
+        (unsigned long long)snapshot.concealedSamples,
+        (unsigned)snapshot.jitter.gapSamples,
+        snapshot.jitter.jitterUs / 1000000.0);
+}
+
+// Private methods implementation
+
+// PSRAM when present, otherwise internal RAM; never freed. Not carved from
+// the arena: that would reserve ~27 KB of internal RAM on every device,
+// multicast or not. Listed in the arena layout like the reservoir.
+void* RtpReceiver::allocate(size_t size, const char* tag) {
+    const char* region = "PSRAM";
+    void* memory = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!memory) {
+        region = "internal heap";
+        memory = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (memory) {
+        AudioArena::recordExternal(tag, size, region);
+    }
+    return memory;
+}
@@ -0,0 +1,95 @@
+#ifndef RTPRECEIVER_H
+#define RTPRECEIVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "RtpProtocol.h"
+#include "RtpFec.h"
+
+class JsonWriter;
+class TieredAudioBuffer;
+
+/**
+ * RtpReceiver - Receives a station from an RTP multicast group
+ *
+ * Joins the group the relay multicasts to (relay_multicast.py) and moves
+ * the audio, reordered and with losses concealed, into the reservoir. One
+ * multicast stream serves every receiver in range, so airtime stays the
+ * same however many devices are listening. When the relay sends parity
+ * (--multicast-fec), single losses per group are rebuilt before they
+ * would be concealed; the jitter buffer then waits long enough for the
+ * group's parity to arrive.
+ *
+ * begin()/end()/poll() belong to the streaming task; writeJson() and
+ * renderMetrics() may be called from any task.
+ */
+class RtpReceiver {
+public:
+    static const uint16_t DEFAULT_PORT = 5004;
+    static const uint32_t IDLE_TIMEOUT_MS = 5000;  // Silence on the group before rejoining
+
+    /**
+     * Join `group` (dotted IPv4) on `port`
+     *
+     * @return false if the address is not multicast or the buffers or
+     *         socket could not be set up
+     */
+    static bool begin(const char* group, uint16_t port);
+
+    /**
+     * Leave the group
+     */
+    static void end();
+
+    /**
+     * Receive pending datagrams and store the audio that is due
+     *
+     * @param buffer Reservoir to store into; with `accept` false released
+     *        audio is discarded instead (the reservoir is over its high-water
+     *        mark because the relay's clock runs faster than the DAC)
+     * @return PCM bytes stored
+     */
+    static size_t poll(TieredAudioBuffer& buffer, bool accept);
+
+    /**
+     * @return Milliseconds since the last packet (or since begin())
+     */
+    static uint32_t getIdleMs();
+
+    static void writeJson(JsonWriter& json);
+    static size_t renderMetrics(char* buffer, size_t size);
+
+private:
+    static const size_t MAX_DATAGRAM = 1500;
+
+    struct Counters {
+        RtpJitterBuffer::Stats jitter;
+        FecDecoder::Stats fec;
+        uint8_t fecGroupSize;
+        uint64_t concealedSamples;
+        uint32_t droppedPackets;       // Released over the high-water mark
+        uint32_t ignored;              // Not RTP, or another payload type
+    };
+
+    static WiFiUDP udp;
+    static bool joined;
+    static char group[16];
+    static uint16_t port;
+    static RtpJitterBuffer* jitter;    // Allocated on first begin() and kept
+    static FecDecoder* fec;
+    static LossConcealer concealer;
+    static uint8_t datagram[MAX_DATAGRAM];
+    static uint8_t pcm[RtpJitterBuffer::MAX_PAYLOAD];
+    static uint32_t ssrc;              // Current audio sender
+    static int64_t packetUs;           // Duration of the last audio packet
+    static unsigned long lastPacketTime;
+    static portMUX_TYPE lock;
+    static Counters counters;
+    static uint32_t droppedPackets;
+    static uint32_t ignored;
+
+    static void* allocate(size_t size, const char* tag);
+};
+
+#endif // RTPRECEIVER_H
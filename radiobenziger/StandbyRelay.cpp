@@ -0,0 +1,354 @@
+#include "StandbyRelay.h"
+#include "AudioArena.h"
+#include "Config.h"
+#include "RelayDirectory.h"
+#include "JsonWriter.h"
+#include "BufferPrintf.h"
+#include <HTTPClient.h>
+#include <lwip/sockets.h>
+#include <errno.h>
+
+// Static member definitions
+portMUX_TYPE StandbyRelay::lock = portMUX_INITIALIZER_UNLOCKED;
+StreamEndpoint StandbyRelay::configured;
+StandbyRelay::Counters StandbyRelay::counters = {};
+char StandbyRelay::armedRelay[64] = "";
+StreamEndpoint StandbyRelay::wanted;
+uint32_t StandbyRelay::wantedGeneration = 0;
+uint32_t StandbyRelay::nextCheckMs = 0;
+TaskHandle_t StandbyRelay::task = nullptr;
+SemaphoreHandle_t StandbyRelay::connectionMutex = nullptr;
+StreamEndpoint StandbyRelay::standby;
+WiFiClient StandbyRelay::connection;
+std::atomic<bool> StandbyRelay::armed(false);
+char StandbyRelay::streamId[24] = "";
+uint32_t StandbyRelay::position = 0;
+uint32_t StandbyRelay::loopBytes = 0;
+bool StandbyRelay::takeoverPending = false;
+char StandbyRelay::resumeId[24] = "";
+uint32_t StandbyRelay::resumePosition = 0;
+uint32_t StandbyRelay::takeoverStartMs = 0;
+
+void StandbyRelay::begin() {
+    if (task) {
+        return;
+    }
+    connectionMutex = AudioArena::createMutex("standbyMutex");
+    task = connectionMutex ? AudioArena::createTask(taskMain, "StandbyRelay", TASK_STACK_BYTES, nullptr,
+                                                    TASK_PRIORITY, 0)
+                           : nullptr;
+    if (!task) {
+        Serial.println("StandbyRelay: Failed to create task");
+    }
+}
+
+void StandbyRelay::configure(const StreamEndpoint& endpoint) {
+    portENTER_CRITICAL(&lock);
+    configured = endpoint;
+    if (configured.scheme != StreamEndpoint::HTTP) {
+        configured.clear();
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void StandbyRelay::getConfigured(StreamEndpoint& endpoint) {
+    portENTER_CRITICAL(&lock);
+    endpoint = configured;
+    portEXIT_CRITICAL(&lock);
+}
+
+void StandbyRelay::beginSession(const char* id, const char* start, const char* loop) {
+    uint32_t size = (uint32_t)strtoul(loop, nullptr, 10);
+    uint32_t offset = (uint32_t)strtoul(start, nullptr, 10);
+    bool known = id[0] != '\0' && size > 0;
+
+    strlcpy(streamId, known ? id : "", sizeof(streamId));
+    loopBytes = known ? size : 0;
+    position = known ? offset % size : 0;
+
+    if (takeoverPending) {
+        takeoverPending = false;
+        bool aligned = known && resumeId[0] != '\0' && strcmp(resumeId, streamId) == 0 &&
+                       position == resumePosition;
+        portENTER_CRITICAL(&lock);
+        if (aligned) {
+            counters.aligned++;
+        } else {
+            counters.unaligned++;
+        }
+        counters.lastTakeoverMs = millis() - takeoverStartMs;
+        portEXIT_CRITICAL(&lock);
+        Serial.printf("StandbyRelay: Took over in %u ms%s\n", (unsigned)(millis() - takeoverStartMs),
+                      aligned ? ", resuming at the same byte" : " (stream position not shared)");
+    }
+}
+
+void StandbyRelay::advance(size_t bytes) {
+    if (loopBytes) {
+        position = (uint32_t)(((uint64_t)position + bytes) % loopBytes);
+    }
+}
+
+void StandbyRelay::maintain(const StreamEndpoint& active, const StreamEndpoint& primary) {
+    uint32_t now = millis();
+    if ((int32_t)(now - nextCheckMs) < 0) {
+        return;
+    }
+    nextCheckMs = now + CHECK_INTERVAL_MS;
+
+    StreamEndpoint candidate;
+    if (!pickStandby(active, primary, candidate)) {
+        candidate.clear();
+    }
+    want(candidate);
+}
+
+bool StandbyRelay::isArmed() {
+    return armed;
+}
+
+bool StandbyRelay::takeOver(WiFiClient& client, StreamEndpoint& target) {
+    if (!armed || !connectionMutex) {
+        return false;
+    }
+
+    // Held only while the connection changes hands, never across network waits
+    xSemaphoreTake(connectionMutex, portMAX_DELAY);
+    bool open = armed && isOpen(connection);
+    if (open) {
+        // The client copy shares the socket; the standby slot lets go of it
+        client.stop();
+        client = connection;
+        target = standby;
+    }
+    connection = WiFiClient();
+    standby.clear();
+    armed = false;
+    publish();
+    xSemaphoreGive(connectionMutex);
+
+    // Warm up a standby for the new relay next
+    nextCheckMs = 0;
+    StreamEndpoint none;
+    none.clear();
+    want(none);
+    if (!open) {
+        return false;
+    }
+
+    strlcpy(resumeId, streamId, sizeof(resumeId));
+    resumePosition = position;
+    takeoverPending = true;
+    takeoverStartMs = millis();
+    portENTER_CRITICAL(&lock);
+    counters.takeovers++;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+void StandbyRelay::addResumeHeaders(HTTPClient& http) {
+    if (!takeoverPending || resumeId[0] == '\0') {
+        return;
+    }
+    char value[12];
+    snprintf(value, sizeof(value), "%u", (unsigned)resumePosition);
+    http.addHeader("X-RB-Stream", resumeId);
+    http.addHeader("X-RB-Position", value);
+}
+
+void StandbyRelay::abandonTakeover() {
+    if (!takeoverPending) {
+        return;
+    }
+    takeoverPending = false;
+    portENTER_CRITICAL(&lock);
+    counters.abandoned++;
+    portEXIT_CRITICAL(&lock);
+}
+
+void StandbyRelay::end() {
+    StreamEndpoint none;
+    none.clear();
+    want(none);
+}
+
+void StandbyRelay::writeJson(JsonWriter& json) {
+    StreamEndpoint endpoint;
+    Counters snapshot;
+    char relay[sizeof(armedRelay)];
+    portENTER_CRITICAL(&lock);
+    endpoint = configured;
+    snapshot = counters;
+    memcpy(relay, armedRelay, sizeof(relay));
+    portEXIT_CRITICAL(&lock);
+
+    char url[sizeof(Config::Settings::streamURL)];
+    endpoint.format(url, sizeof(url));
+    json.beginObject(JSON_KEY("standby"))
+        .field(JSON_KEY("url"), url)
+        .field(JSON_KEY("armed"), relay[0] != '\0')
+        .field(JSON_KEY("relay"), relay)
+        .field(JSON_KEY("connects"), snapshot.connects)
+        .field(JSON_KEY("connect_failures"), snapshot.connectFailures)
+        .field(JSON_KEY("takeovers"), snapshot.takeovers)
+        .field(JSON_KEY("aligned"), snapshot.aligned)
+        .field(JSON_KEY("unaligned"), snapshot.unaligned)
+        .field(JSON_KEY("abandoned"), snapshot.abandoned)
+        .field(JSON_KEY("last_takeover_ms"), snapshot.lastTakeoverMs)
+        .endObject();
+}
+
+size_t StandbyRelay::renderMetrics(char* buffer, size_t size) {
+    Counters snapshot;
+    portENTER_CRITICAL(&lock);
+    snapshot = counters;
+    bool standing = armedRelay[0] != '\0';
+    portEXIT_CRITICAL(&lock);
+
+    return bufferPrintf(buffer, size, 0,
+        "# HELP radiobenziger_standby_armed Whether a standby relay connection is open\n"
+        "# TYPE radiobenziger_standby_armed gauge\n"
+        "radiobenziger_standby_armed %u\n"
+        "# HELP radiobenziger_standby_takeovers_total Sessions handed to the standby relay, by outcome\n"
+        "# TYPE radiobenziger_standby_takeovers_total counter\n"
+        "radiobenziger_standby_takeovers_total{result=\"aligned\"} %u\n"
+        "radiobenziger_standby_takeovers_total{result=\"unaligned\"} %u\n"
+        "radiobenziger_standby_takeovers_total{result=\"abandoned\"} %u\n",
+        standing ? 1u : 0u,
+        (unsigned)snapshot.aligned,
+        (unsigned)snapshot.unaligned,
+        (unsigned)snapshot.abandoned);
+}
+
+// Private methods implementation
+
+// Opens and watches the connection for whatever relay the streaming task wants
+void StandbyRelay::taskMain(void* parameter) {
+    for (;;) {
+        StreamEndpoint target;
+        portENTER_CRITICAL(&lock);
+        target = wanted;
+        uint32_t generation = wantedGeneration;
+        portEXIT_CRITICAL(&lock);
+
+        // Keep an open connection to the right relay; drop anything else,
+        // including a connection the relay closed for being idle
+        xSemaphoreTake(connectionMutex, portMAX_DELAY);
+        bool keep = armed && target.scheme == StreamEndpoint::HTTP && sameRelay(target, standby) &&
+                    isOpen(connection);
+        if (!keep) {
+            connection.stop();
+            connection = WiFiClient();
+            standby.clear();
+            armed = false;
+            publish();
+        }
+        xSemaphoreGive(connectionMutex);
+
+        TickType_t wait = pdMS_TO_TICKS(CHECK_INTERVAL_MS);
+        if (target.scheme != StreamEndpoint::HTTP) {
+            wait = portMAX_DELAY;
+        } else if (!keep) {
+            // Lookup and connect block this task only
+            WiFiClient fresh;
+            bool connected = WiFi.status() == WL_CONNECTED && resolve(target) &&
+                             fresh.connect(IPAddress(target.address[0], target.address[1],
+                                                     target.address[2], target.address[3]),
+                                           target.port, CONNECT_TIMEOUT_MS);
+            portENTER_CRITICAL(&lock);
+            if (connected) {
+                counters.connects++;
+            } else {
+                counters.connectFailures++;
+            }
+            // The streaming task may have moved on while we connected
+            bool current = generation == wantedGeneration;
+            portEXIT_CRITICAL(&lock);
+
+            if (connected && current) {
+                xSemaphoreTake(connectionMutex, portMAX_DELAY);
+                connection = fresh;
+                standby = target;
+                armed = true;
+                publish();
+                xSemaphoreGive(connectionMutex);
+            }
+            fresh = WiFiClient();
+            wait = pdMS_TO_TICKS(connected ? CHECK_INTERVAL_MS : RETRY_INTERVAL_MS);
+        }
+        // want() wakes the task as soon as the relay changes
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+void StandbyRelay::want(const StreamEndpoint& endpoint) {
+    portENTER_CRITICAL(&lock);
+    bool changed = !sameRelay(endpoint, wanted);
+    if (changed) {
+        wanted = endpoint;
+        wantedGeneration++;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (changed && task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void StandbyRelay::publish() {
+    portENTER_CRITICAL(&lock);
+    strlcpy(armedRelay, armed ? standby.host : "", sizeof(armedRelay));
+    portEXIT_CRITICAL(&lock);
+}
+
+bool StandbyRelay::pickStandby(const StreamEndpoint& active, const StreamEndpoint& primary, StreamEndpoint& out) {
+    StreamEndpoint setting;
+    getConfigured(setting);
+
+    // The configured standby; once it has taken over, the primary stands by for it
+    if (setting.scheme == StreamEndpoint::HTTP) {
+        if (!sameRelay(setting, active)) {
+            out = setting;
+            return true;
+        }
+        if (primary.scheme == StreamEndpoint::HTTP && !sameRelay(primary, active)) {
+            out = primary;
+            return true;
+        }
+    }
+    // Discovered relays: the best one that is not streaming
+    return primary.scheme == StreamEndpoint::DISCOVER && RelayDirectory::select(out, &active);
+}
+
+bool StandbyRelay::sameRelay(const StreamEndpoint& a, const StreamEndpoint& b) {
+    if (a.scheme != b.scheme || a.port != b.port) {
+        return false;
+    }
+    if (a.resolved && b.resolved) {
+        return memcmp(a.address, b.address, sizeof(a.address)) == 0;
+    }
+    return strcmp(a.host, b.host) == 0;
+}
+
+bool StandbyRelay::isOpen(WiFiClient& client) {
+    if (!client.connected()) {
+        return false;
+    }
+    // connected() misses a FIN: peek for it (a relay sends nothing unasked)
+    uint8_t byte;
+    int result = recv(client.fd(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return result < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
+
+bool StandbyRelay::resolve(StreamEndpoint& endpoint) {
+    if (endpoint.resolved) {
+        return true;
+    }
+    IPAddress address;
+    if (WiFi.hostByName(endpoint.host, address) != 1) {
+        return false;
+    }
+    uint8_t bytes[4] = { address[0], address[1], address[2], address[3] };
+    endpoint.setAddress(bytes);
+    return true;
+}
@@ -0,0 +1,163 @@
+#ifndef STANDBYRELAY_H
+#define STANDBYRELAY_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include <freertos/semphr.h>
+#include "StreamEndpoint.h"
+
+class HTTPClient;
+class JsonWriter;
+
+/**
+ * StandbyRelay - A second relay kept warm for seamless failover
+ *
+ * With a standby URL set (POST /standby-url), or with dnssd:// (the next
+ * relay in RelayDirectory's ranking), a TCP connection is kept open to a
+ * second relay while the streaming task plays from the first. The
+ * connection carries no audio.
+ *
+ * The streaming task only names the relay it wants (maintain()). A low
+ * priority task of its own (begin()) resolves it, connects, and checks the
+ * connection every CHECK_INTERVAL_MS, so no lookup or connect ever pauses
+ * the read loop. Relays close idle connections after their keep-alive
+ * timeout; connected() does not notice that FIN, so the check peeks for it
+ * and the task reconnects. The standby costs a handshake every few seconds.
+ *
+ * Relays report where in their cached stream a session starts (X-RB-Stream,
+ * X-RB-Position), and the session counts the bytes it receives. When the
+ * active relay stalls for STALL_MS or drops the session, the streaming task
+ * sends its next request on the open connection and asks for the same
+ * stream at the byte it had reached. The new relay continues from exactly
+ * that byte. The reservoir keeps playing throughout, so there is neither a
+ * gap nor a repeat, and no new pre-buffer. Synchronized (framed) sessions
+ * are not handed over.
+ *
+ * configure(), getConfigured(), writeJson() and renderMetrics() may be
+ * called from any task; everything else belongs to the streaming task.
+ * The connection itself is only handed between the two tasks under a
+ * mutex, never while either is blocked on the network.
+ */
+class StandbyRelay {
+public:
+    static const uint32_t CHECK_INTERVAL_MS = 1000;    // Liveness peek while armed, no traffic
+    static const uint32_t RETRY_INTERVAL_MS = 10000;   // After the standby refused a connect
+    static const uint32_t CONNECT_TIMEOUT_MS = 1000;   // Standby task only
+    static const uint32_t STALL_MS = 500;              // No data from the active relay
+    static const uint32_t TASK_STACK_BYTES = 4096;
+    static const UBaseType_t TASK_PRIORITY = 1;        // Below the audio task on core 0
+
+    /**
+     * Create the task that opens and checks the standby connection
+     */
+    static void begin();
+
+    /**
+     * Standby relay from the settings (http:// only); NONE leaves only
+     * dnssd:// sessions with a standby
+     */
+    static void configure(const StreamEndpoint& endpoint);
+    static void getConfigured(StreamEndpoint& endpoint);
+
+    /**
+     * Start tracking the stream position of a session from its response headers
+     *
+     * Completes a pending takeover: counts it as aligned if the new relay
+     * resumed the same stream at the requested byte.
+     */
+    static void beginSession(const char* streamId, const char* position, const char* loopBytes);
+
+    /**
+     * Bytes of the session's stream stored into the reservoir
+     */
+    static void advance(size_t bytes);
+
+    /**
+     * Name the relay to keep a connection open to; no network I/O, cheap
+     * unless a check is due
+     *
+     * @param active Relay the session streams from, never its own standby
+     * @param primary Endpoint from the stream URL
+     */
+    static void maintain(const StreamEndpoint& active, const StreamEndpoint& primary);
+
+    static bool isArmed();
+
+    /**
+     * Hand the open standby connection to `client` for the next session
+     *
+     * The connection is checked once more first. HTTPClient reuses a client
+     * that reports connected() for the next request, so it must not be
+     * given one the relay has already closed.
+     *
+     * @param target Set to the standby relay
+     * @return false if there is no open standby connection
+     */
+    static bool takeOver(WiFiClient& client, StreamEndpoint& target);
+
+    /**
+     * Ask for the stream position reached so far (the request after takeOver())
+     */
+    static void addResumeHeaders(HTTPClient& http);
+
+    /**
+     * The request after takeOver() failed; the session starts over normally
+     */
+    static void abandonTakeover();
+
+    /**
+     * Drop the standby connection (streaming stopped)
+     */
+    static void end();
+
+    static void writeJson(JsonWriter& json);
+    static size_t renderMetrics(char* buffer, size_t size);
+
+private:
+    struct Counters {
+        uint32_t connects;             // Standby connections opened
+        uint32_t connectFailures;
+        uint32_t takeovers;            // Sessions handed to the standby
+        uint32_t aligned;              // ... that resumed at the exact byte
+        uint32_t unaligned;            // ... that could not (other stream, live decode)
+        uint32_t abandoned;            // ... whose request failed
+        uint32_t lastTakeoverMs;       // Stall to first response headers
+    };
+
+    static portMUX_TYPE lock;
+    static StreamEndpoint configured;
+    static Counters counters;
+    static char armedRelay[64];        // Host of the open standby, for other tasks
+
+    // Streaming task -> standby task, under `lock`
+    static StreamEndpoint wanted;      // NONE = no standby
+    static uint32_t wantedGeneration;
+    static uint32_t nextCheckMs;       // Streaming task only
+
+    // Owned by the standby task; taken by takeOver() under connectionMutex
+    static TaskHandle_t task;
+    static SemaphoreHandle_t connectionMutex;
+    static StreamEndpoint standby;     // Relay the connection is open to
+    static WiFiClient connection;
+    static std::atomic<bool> armed;
+
+    // Position of the active session in its relay's cached stream
+    static char streamId[24];
+    static uint32_t position;
+    static uint32_t loopBytes;         // 0 = position unknown
+    static bool takeoverPending;
+    static char resumeId[24];          // What the pending takeover asked for
+    static uint32_t resumePosition;
+    static uint32_t takeoverStartMs;
+
+    static void taskMain(void* parameter);
+    static void want(const StreamEndpoint& endpoint);
+    static void publish();
+    static bool pickStandby(const StreamEndpoint& active, const StreamEndpoint& primary, StreamEndpoint& out);
+    static bool sameRelay(const StreamEndpoint& a, const StreamEndpoint& b);
+    static bool isOpen(WiFiClient& client);
+    static bool resolve(StreamEndpoint& endpoint);
+};
+
+#endif // STANDBYRELAY_H
@@ -0,0 +1,248 @@
+#include "StatusPusher.h"
+#include "JsonWriter.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+static const char* TAG = "StatusPusher";
+
+portMUX_TYPE StatusPusher::rateLock = portMUX_INITIALIZER_UNLOCKED;
+
+StatusPusher::StatusPusher(AsyncWebSocket& webSocket) : socket(webSocket) {
+    frame = nullptr;
+    frameBytes = 0;
+    last = {};
+    lastNowPlaying[0] = '\0';
+    haveLast = false;
+    keyframeRequested = true;
+    intervalMs = DEFAULT_INTERVAL_MS;
+    defaultIntervalMs = DEFAULT_INTERVAL_MS;
+    for (size_t i = 0; i < MAX_CLIENTS; i++) {
+        clientRates[i].used = false;
+    }
+    lastPushTime = 0;
+    lastKeyframeTime = 0;
+    sequence = 0;
+    framesSent = 0;
+}
+
+StatusPusher::~StatusPusher() {
+    if (frame) {
+        heap_caps_free(frame);
+        frame = nullptr;
+    }
+}
+
+bool StatusPusher::begin(size_t maxFrameBytes, uint32_t interval) {
+    if (frame) {
+        ESP_LOGW(TAG, "StatusPusher already initialized");
+        return true;
+    }
+
+    frame = (char*)heap_caps_malloc(maxFrameBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!frame) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte frame buffer", maxFrameBytes);
+        return false;
+    }
+    frameBytes = maxFrameBytes;
+    setInterval(interval);
+
+    socket.onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                          void* arg, uint8_t* data, size_t length) {
+        onEvent(client, type, arg, data, length);
+    });
+
+    ESP_LOGI(TAG, "Status push: every %dms, %d byte frames", getInterval(), frameBytes);
+    return true;
+}
+
+bool StatusPusher::isDue() const {
+    return frame != nullptr && socket.count() > 0 && (millis() - lastPushTime) >= getInterval();
+}
+
+void StatusPusher::publish(const Status& status) {
+    if (!frame) {
+        return;
+    }
+
+    unsigned long now = millis();
+    lastPushTime = now;
+
+    bool full = !haveLast || keyframeRequested.exchange(false) ||
+                (now - lastKeyframeTime) >= KEYFRAME_INTERVAL_MS;
+    const char* nowPlaying = status.nowPlaying ? status.nowPlaying : "";
+
+    JsonWriter json(frame, frameBytes);
+    json.beginObject()
+        .field(JSON_KEY("type"), "status")
+        .field(JSON_KEY("seq"), sequence)
+        .field(JSON_KEY("full"), full);
+    size_t header = json.length();
+
+    if (full || status.wifiConnected != last.wifiConnected) {
+        json.field(JSON_KEY("wifi_connected"), status.wifiConnected);
+    }
+    if (full || status.streamingActive != last.streamingActive) {
+        json.field(JSON_KEY("streaming_active"), status.streamingActive);
+    }
+    if (full || status.rssi != last.rssi) {
+        json.field(JSON_KEY("rssi"), status.rssi);
+    }
+    if (full || status.bufferedMs != last.bufferedMs) {
+        json.field(JSON_KEY("buffered_ms"), status.bufferedMs);
+    }
+    if (full || status.underruns != last.underruns) {
+        json.field(JSON_KEY("underruns"), status.underruns);
+    }
+    if (full || status.overflows != last.overflows) {
+        json.field(JSON_KEY("overflows"), status.overflows);
+    }
+    if (full || status.reconnects != last.reconnects) {
+        json.field(JSON_KEY("reconnects"), status.reconnects);
+    }
+    if (full || status.freeHeapKb != last.freeHeapKb) {
+        json.field(JSON_KEY("free_heap_kb"), status.freeHeapKb);
+    }
+    if (full || strcmp(nowPlaying, lastNowPlaying) != 0) {
+        json.field(JSON_KEY("now_playing"), nowPlaying);
+    }
+
+    // Nothing changed: skip the frame entirely
+    if (json.length() == header) {
+        return;
+    }
+    json.endObject();
+    if (json.overflowed()) {
+        ESP_LOGW(TAG, "Status frame truncated (%d bytes)", frameBytes);
+        return;
+    }
+
+    // One shared message for every client
+    socket.textAll(frame, json.length());
+
+    last = status;
+    strlcpy(lastNowPlaying, nowPlaying, sizeof(lastNowPlaying));
+    last.nowPlaying = lastNowPlaying;
+    haveLast = true;
+    if (full) {
+        lastKeyframeTime = now;
+    }
+    sequence++;
+    framesSent++;
+}
+
+void StatusPusher::setInterval(uint32_t interval) {
+    portENTER_CRITICAL(&rateLock);
+    defaultIntervalMs = clampInterval(interval);
+    portEXIT_CRITICAL(&rateLock);
+    updateInterval();
+}
+
+// Private methods implementation
+
+void StatusPusher::onEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t length) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            // New client needs the whole state; everyone gets it on the next tick
+            keyframeRequested = true;
+            setClientRate(client->id(), 0, true);
+            ESP_LOGI(TAG, "Client #%u connected", client->id());
+            break;
+
+        case WS_EVT_DISCONNECT:
+            setClientRate(client->id(), 0, false);
+            ESP_LOGI(TAG, "Client #%u disconnected", client->id());
+            break;
+
+        case WS_EVT_DATA: {
+            // Only single-frame text messages carry commands
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if (info->final && info->index == 0 && info->len == length && info->opcode == WS_TEXT) {
+                handleMessage(client->id(), data, length);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void StatusPusher::handleMessage(uint32_t clientId, const uint8_t* data, size_t length) {
+    char message[64];
+    size_t copy = length < sizeof(message) - 1 ? length : sizeof(message) - 1;
+    memcpy(message, data, copy);
+    message[copy] = '\0';
+
+    // Expected: {"interval_ms":N}
+    const char* key = strstr(message, "\"interval_ms\"");
+    if (!key) {
+        return;
+    }
+    const char* colon = strchr(key, ':');
+    if (!colon) {
+        return;
+    }
+
+    uint32_t requested = strtoul(colon + 1, nullptr, 10);
+    if (requested > 0) {
+        setClientRate(clientId, clampInterval(requested), true);
+        ESP_LOGI(TAG, "Client #%u asked for %ums, pushing every %ums",
+                 clientId, clampInterval(requested), getInterval());
+    }
+}
+
+void StatusPusher::setClientRate(uint32_t clientId, uint32_t interval, bool connected) {
+    portENTER_CRITICAL(&rateLock);
+    ClientRate* entry = nullptr;
+    ClientRate* unused = nullptr;
+    for (size_t i = 0; i < MAX_CLIENTS; i++) {
+        if (clientRates[i].used && clientRates[i].clientId == clientId) {
+            entry = &clientRates[i];
+        } else if (!clientRates[i].used && !unused) {
+            unused = &clientRates[i];
+        }
+    }
+    if (!connected) {
+        if (entry) {
+            entry->used = false;
+        }
+    } else {
+        // A client beyond the table gets whatever rate the others agreed on
+        if (!entry) {
+            entry = unused;
+        }
+        if (entry) {
+            entry->clientId = clientId;
+            entry->intervalMs = interval;
+            entry->used = true;
+        }
+    }
+    portEXIT_CRITICAL(&rateLock);
+    updateInterval();
+}
+
+void StatusPusher::updateInterval() {
+    portENTER_CRITICAL(&rateLock);
+    uint32_t shortest = 0;
+    for (size_t i = 0; i < MAX_CLIENTS; i++) {
+        if (!clientRates[i].used) {
+            continue;
+        }
+        uint32_t interval = clientRates[i].intervalMs ? clientRates[i].intervalMs : defaultIntervalMs;
+        if (shortest == 0 || interval < shortest) {
+            shortest = interval;
+        }
+    }
+    intervalMs.store(shortest ? shortest : defaultIntervalMs, std::memory_order_relaxed);
+    portEXIT_CRITICAL(&rateLock);
+}
+
+uint32_t StatusPusher::clampInterval(uint32_t interval) {
+    if (interval < MIN_INTERVAL_MS) {
+        return MIN_INTERVAL_MS;
+    }
+    if (interval > MAX_INTERVAL_MS) {
+        return MAX_INTERVAL_MS;
+    }
+    return interval;
+}
@@ -0,0 +1,117 @@
+#ifndef STATUSPUSHER_H
+#define STATUSPUSHER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <ESPAsyncWebServer.h>
+
+/**
+ * StatusPusher - Live status frames over a WebSocket
+ *
+ * Samples are rendered once per interval into a buffer allocated at boot
+ * and broadcast to every connected client, so the cost per tick does not
+ * depend on how many dashboards are watching.
+ *
+ * Frames are delta-encoded JSON: a frame carries only the fields that
+ * changed since the previous one, and clients merge them into their copy
+ * of the state. A full frame ("full":true) is sent when a client connects
+ * and periodically after that, so late or lossy clients resynchronise.
+ *
+ * Clients may ask for a push interval by sending {"interval_ms":N}. Every
+ * client receives the same delta stream, so frames go out at the shortest
+ * interval any connected client asked for (the default for clients that
+ * did not ask); it relaxes again when that client disconnects.
+ */
+class StatusPusher {
+public:
+    /**
+     * Values pushed to clients
+     */
+    struct Status {
+        bool wifiConnected;            // Station connected
+        bool streamingActive;          // Playback running
+        int32_t rssi;                  // WiFi signal strength (dBm)
+        uint32_t bufferedMs;           // Audio queued in the reservoir
+        uint32_t underruns;            // Starvation episodes since boot
+        uint32_t overflows;            // Reservoir overflows since boot
+        uint32_t reconnects;           // Stream reconnects since boot
+        uint32_t freeHeapKb;           // Free internal heap (KB)
+        const char* nowPlaying;        // Current stream source
+    };
+
+    static const uint32_t DEFAULT_INTERVAL_MS = 500;
+    static const uint32_t MIN_INTERVAL_MS = 100;
+    static const uint32_t MAX_INTERVAL_MS = 10000;
+    static const uint32_t KEYFRAME_INTERVAL_MS = 10000;
+    static const size_t MAX_CLIENTS = 8;          // AsyncWebSocket's default limit
+
+private:
+    static const size_t NOW_PLAYING_MAX = 96;
+
+    // Interval each connected client asked for (0: the default)
+    struct ClientRate {
+        uint32_t clientId;
+        uint32_t intervalMs;
+        bool used;
+    };
+
+    AsyncWebSocket& socket;
+    char* frame;
+    size_t frameBytes;
+
+    // Last values sent, for delta encoding
+    Status last;
+    char lastNowPlaying[NOW_PLAYING_MAX];
+    bool haveLast;
+
+    std::atomic<bool> keyframeRequested;
+    std::atomic<uint32_t> intervalMs;          // Effective: shortest requested
+    uint32_t defaultIntervalMs;
+    ClientRate clientRates[MAX_CLIENTS];       // Guarded by rateLock (async_tcp vs loop)
+    static portMUX_TYPE rateLock;
+    unsigned long lastPushTime;
+    unsigned long lastKeyframeTime;
+    uint32_t sequence;
+    uint32_t framesSent;
+
+    void onEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t length);
+    void handleMessage(uint32_t clientId, const uint8_t* data, size_t length);
+    void setClientRate(uint32_t clientId, uint32_t interval, bool connected);
+    void updateInterval();
+    static uint32_t clampInterval(uint32_t interval);
+
+public:
+    explicit StatusPusher(AsyncWebSocket& webSocket);
+    ~StatusPusher();
+
+    /**
+     * Allocate the frame buffer and attach to the WebSocket's events
+     *
+     * @param maxFrameBytes Largest frame that can be rendered
+     * @param interval Push interval in milliseconds
+     * @return true if the frame buffer was allocated
+     */
+    bool begin(size_t maxFrameBytes, uint32_t interval = DEFAULT_INTERVAL_MS);
+
+    /**
+     * Check whether a frame should be published now (clients are connected
+     * and the interval has elapsed). Lets the caller skip sampling otherwise.
+     */
+    bool isDue() const;
+
+    /**
+     * Render the changes since the last frame and broadcast them
+     */
+    void publish(const Status& status);
+
+    /**
+     * Set the default push interval, used for clients that did not ask for
+     * one (clamped to MIN_INTERVAL_MS..MAX_INTERVAL_MS)
+     */
+    void setInterval(uint32_t interval);
+
+    uint32_t getInterval() const { return intervalMs.load(std::memory_order_relaxed); }
+    uint32_t getFramesSent() const { return framesSent; }
+};
+
+#endif // STATUSPUSHER_H
@@ -0,0 +1,197 @@
+#ifndef STREAMENDPOINT_H
+#define STREAMENDPOINT_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * StreamEndpoint - Where the station comes from, parsed once
+ *
+ * Config::settings.streamURL is parsed into this when it is loaded or
+ * changed, so reconnects reuse the host, port and path (and the resolved
+ * address) instead of rebuilding and re-parsing a URL each time.
+ *
+ *   http://host[:port][/path]   PCM stream from the relay (wav_server.py)
+ *   rtp://group[:port]          RTP multicast (wav_server.py --multicast)
+ *   dnssd://[_pcmradio._tcp]    Best relay advertising itself on the LAN
+ *                               (RelayDirectory)
+ *
+ * Only IPv4 is supported. A dotted-quad host is resolved by parse(); a
+ * name is resolved by the streaming task and kept until a connect fails.
+ */
+struct StreamEndpoint {
+    enum Scheme : uint8_t {
+        NONE,
+        HTTP,
+        RTP,
+        DISCOVER
+    };
+
+    static const uint16_t DEFAULT_HTTP_PORT = 80;
+    static const uint16_t DEFAULT_RTP_PORT = 5004;
+
+    Scheme scheme;
+    char host[64];
+    uint16_t port;
+    char path[128];                    // HTTP only, always starts with '/'
+    uint8_t address[4];                // Valid while `resolved`
+    bool resolved;
+    bool literal;                      // Host is a dotted quad: never needs DNS
+
+    StreamEndpoint() { clear(); }
+
+    void clear() {
+        scheme = NONE;
+        host[0] = '\0';
+        port = 0;
+        path[0] = '\0';
+        memset(address, 0, sizeof(address));
+        resolved = false;
+        literal = false;
+    }
+
+    /**
+     * @return false (and NONE) if `url` is not a supported stream URL
+     */
+    bool parse(const char* url) {
+        clear();
+        if (!url || !parseUrl(url)) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Record the address a host name resolved to
+     */
+    void setAddress(const uint8_t resolvedAddress[4]) {
+        memcpy(address, resolvedAddress, sizeof(address));
+        resolved = true;
+    }
+
+    /**
+     * Forget a resolved name (the host may have moved); literals are kept
+     */
+    void invalidate() {
+        resolved = literal;
+    }
+
+    /**
+     * Canonical URL (default ports omitted)
+     */
+    size_t format(char* out, size_t size) const {
+        int written;
+        if (scheme == HTTP) {
+            written = port == DEFAULT_HTTP_PORT
+                ? snprintf(out, size, "http://%s%s", host, path)
+                : snprintf(out, size, "http://%s:%u%s", host, (unsigned)port, path);
+        } else if (scheme == RTP) {
+            written = snprintf(out, size, "rtp://%s:%u", host, (unsigned)port);
+        } else if (scheme == DISCOVER) {
+            written = snprintf(out, size, "%s", "dnssd://");
+        } else {
+            written = snprintf(out, size, "%s", "");
+        }
+        return written < 0 ? 0 : ((size_t)written < size ? (size_t)written : size - 1);
+    }
+
+    /**
+     * Dotted quad of the resolved address ("" if not resolved)
+     */
+    size_t formatAddress(char* out, size_t size) const {
+        int written = resolved
+            ? snprintf(out, size, "%u.%u.%u.%u", address[0], address[1], address[2], address[3])
+            : snprintf(out, size, "%s", "");
+        return written < 0 ? 0 : ((size_t)written < size ? (size_t)written : size - 1);
+    }
+
+    static bool parseIPv4(const char* text, uint8_t out[4]) {
+        for (int i = 0; i < 4; i++) {
+            uint32_t value = 0;
+            size_t digits = 0;
+            for (; *text >= '0' && *text <= '9' && digits < 4; text++, digits++) {
+                value = value * 10 + (uint32_t)(*text - '0');
+            }
+            if (digits == 0 || digits > 3 || value > 255) {
+                return false;
+            }
+            out[i] = (uint8_t)value;
+            if (i < 3 && *text++ != '.') {
+                return false;
+            }
+        }
+        return *text == '\0';
+    }
+
+private:
+    bool parseUrl(const char* url) {
+        // Only the relay service type can be browsed for
+        if (strncmp(url, "dnssd://", 8) == 0) {
+            url += 8;
+            if (*url != '\0' && strcmp(url, "_pcmradio._tcp") != 0) {
+                return false;
+            }
+            scheme = DISCOVER;
+            return true;
+        }
+
+        Scheme parsed;
+        uint16_t defaultPort;
+        if (strncmp(url, "http://", 7) == 0) {
+            parsed = HTTP;
+            defaultPort = DEFAULT_HTTP_PORT;
+            url += 7;
+        } else if (strncmp(url, "rtp://", 6) == 0) {
+            parsed = RTP;
+            defaultPort = DEFAULT_RTP_PORT;
+            url += 6;
+        } else {
+            return false;
+        }
+
+        size_t hostLength = strcspn(url, ":/");
+        if (hostLength == 0 || hostLength >= sizeof(host)) {
+            return false;
+        }
+        memcpy(host, url, hostLength);
+        host[hostLength] = '\0';
+        url += hostLength;
+
+        port = defaultPort;
+        if (*url == ':') {
+            uint32_t value = 0;
+            size_t digits = 0;
+            for (url++; *url >= '0' && *url <= '9' && digits < 6; url++, digits++) {
+                value = value * 10 + (uint32_t)(*url - '0');
+            }
+            if (digits == 0 || value == 0 || value > 65535) {
+                return false;
+            }
+            port = (uint16_t)value;
+        }
+
+        if (parsed == HTTP) {
+            const char* rest = *url ? url : "/";
+            if (*rest != '/' || strlen(rest) >= sizeof(path)) {
+                return false;
+            }
+            strcpy(path, rest);
+        } else if (*url != '\0') {
+            return false;
+        }
+
+        literal = parseIPv4(host, address);
+        resolved = literal;
+        if (parsed == RTP && (!literal || address[0] < 224 || address[0] > 239)) {
+            return false;
+        }
+        scheme = parsed;
+        return true;
+    }
+};
+
+#endif // STREAMENDPOINT_H
@@ -0,0 +1,206 @@
+#ifndef SYNCPROTOCOL_H
+#define SYNCPROTOCOL_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * SyncProtocol - Wire formats for synchronized (multi-room) playback
+ *
+ * A relay started with --sync answers a stream request carrying the
+ * "X-RB-Sync: 1" header with a framed stream instead of bare PCM, and
+ * names its clock port in "X-RB-Clock-Port". Every frame carries the
+ * presentation time (PTS) of its first sample on the relay's clock;
+ * receivers estimate that clock with an NTP-style UDP exchange and play
+ * each sample at its PTS. Both formats are little-endian and written
+ * field by field, like TelemetryPacket.
+ *
+ * Frame header (20 bytes), followed by `length` bytes of PCM:
+ *   0  magic 'RBF1'     4  sequence        8  PTS (u64, relay us)
+ *   16 length
+ *
+ * Clock exchange (36 bytes): the receiver sends a request stamped with
+ * its own clock (t1); the relay echoes it with its receive (t2) and send
+ * (t3) times. With t4 the receiver's arrival time, the relay clock is
+ * ahead of the receiver's by ((t2 - t1) + (t3 - t4)) / 2.
+ *   0  magic 'RBC1'     4  type            5  reserved (3)
+ *   8  sequence         12 t1 (u64)        20 t2 (u64)
+ *   28 t3 (u64)
+ */
+struct SyncFrameHeader {
+    static const uint32_t MAGIC = 0x31464252;  // "RBF1" little-endian
+    static const size_t WIRE_SIZE = 20;
+    static const uint32_t MAX_LENGTH = 65536;  // Larger frames are treated as corruption
+
+    uint32_t sequence;                 // Chunk number on the relay's timeline
+    uint64_t ptsUs;                    // Relay time at which the first sample plays
+    uint32_t length;                   // PCM bytes following the header
+
+    size_t encode(uint8_t* out, size_t size) const {
+        if (size < WIRE_SIZE) {
+            return 0;
+        }
+        put32(out + 0, MAGIC);
+        put32(out + 4, sequence);
+        put64(out + 8, ptsUs);
+        put32(out + 16, length);
+        return WIRE_SIZE;
+    }
+
+    bool decode(const uint8_t* in, size_t size) {
+        if (size < WIRE_SIZE || get32(in + 0) != MAGIC) {
+            return false;
+        }
+        sequence = get32(in + 4);
+        ptsUs = get64(in + 8);
+        length = get32(in + 16);
+        return length <= MAX_LENGTH;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    static void put64(uint8_t* p, uint64_t v) {
+        put32(p, (uint32_t)v);
+        put32(p + 4, (uint32_t)(v >> 32));
+    }
+
+    static uint32_t get32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static uint64_t get64(const uint8_t* p) {
+        return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+    }
+};
+
+struct ClockSyncPacket {
+    static const uint32_t MAGIC = 0x31434252;  // "RBC1" little-endian
+    static const size_t WIRE_SIZE = 36;
+
+    // type
+    static const uint8_t REQUEST = 1;
+    static const uint8_t REPLY = 2;
+
+    uint8_t type;
+    uint32_t sequence;                 // Matches a reply to its request
+    uint64_t t1;                       // Receiver clock when the request was sent
+    uint64_t t2;                       // Relay clock when the request arrived
+    uint64_t t3;                       // Relay clock when the reply was sent
+
+    size_t encode(uint8_t* out, size_t size) const {
+        if (size < WIRE_SIZE) {
+            return 0;
+        }
+        memset(out, 0, WIRE_SIZE);
+        SyncFrameHeader::put32(out + 0, MAGIC);
+        out[4] = type;
+        SyncFrameHeader::put32(out + 8, sequence);
+        SyncFrameHeader::put64(out + 12, t1);
+        SyncFrameHeader::put64(out + 20, t2);
+        SyncFrameHeader::put64(out + 28, t3);
+        return WIRE_SIZE;
+    }
+
+    bool decode(const uint8_t* in, size_t size) {
+        if (size < WIRE_SIZE || SyncFrameHeader::get32(in + 0) != MAGIC) {
+            return false;
+        }
+        type = in[4];
+        sequence = SyncFrameHeader::get32(in + 8);
+        t1 = SyncFrameHeader::get64(in + 12);
+        t2 = SyncFrameHeader::get64(in + 20);
+        t3 = SyncFrameHeader::get64(in + 28);
+        return type == REQUEST || type == REPLY;
+    }
+};
+
+/**
+ * SyncFrameParser - Splits a framed byte stream into headers and PCM
+ *
+ * Feed it whatever the socket returned; each call to next() consumes some
+ * of the input and reports one event. Frame boundaries need not line up
+ * with reads.
+ */
+class SyncFrameParser {
+public:
+    enum EventType {
+        NONE,       // Input consumed, nothing complete yet
+        HEADER,     // event.header describes the PCM that follows
+        PAYLOAD,    // event.data/event.size are PCM bytes of the current frame
+        ERROR       // Not a framed stream (bad magic or length); stop reading
+    };
+
+    struct Event {
+        EventType type;
+        SyncFrameHeader header;
+        const uint8_t* data;
+        size_t size;
+    };
+
+    SyncFrameParser() { reset(); }
+
+    void reset() {
+        headerFill = 0;
+        payloadRemaining = 0;
+        failed = false;
+    }
+
+    /**
+     * Consume input up to the next event
+     *
+     * @return Bytes of `data` consumed (call again with the rest)
+     */
+    size_t next(const uint8_t* data, size_t size, Event& event) {
+        event.type = NONE;
+        event.data = nullptr;
+        event.size = 0;
+        if (failed) {
+            event.type = ERROR;
+            return size;
+        }
+
+        if (payloadRemaining > 0) {
+            size_t take = size < payloadRemaining ? size : payloadRemaining;
+            payloadRemaining -= take;
+            event.type = take ? PAYLOAD : NONE;
+            event.data = data;
+            event.size = take;
+            return take;
+        }
+
+        size_t take = SyncFrameHeader::WIRE_SIZE - headerFill;
+        if (take > size) {
+            take = size;
+        }
+        memcpy(headerBytes + headerFill, data, take);
+        headerFill += take;
+        if (headerFill < SyncFrameHeader::WIRE_SIZE) {
+            return take;
+        }
+
+        headerFill = 0;
+        if (!event.header.decode(headerBytes, sizeof(headerBytes))) {
+            failed = true;
+            event.type = ERROR;
+            return size;
+        }
+        payloadRemaining = event.header.length;
+        event.type = HEADER;
+        return take;
+    }
+
+private:
+    uint8_t headerBytes[SyncFrameHeader::WIRE_SIZE];
+    size_t headerFill;
+    size_t payloadRemaining;
+    bool failed;
+};
+
+#endif // SYNCPROTOCOL_H
@@ -0,0 +1,232 @@
+#include "TaskProfiler.h"
+#include "BufferPrintf.h"
+#include "JsonWriter.h"
+
+// Tasks worth sizing: our audio and relay tasks, the Arduino loop, the web
+// server (every handler runs on async_tcp) and the WiFi/lwIP tasks
+const char* const TaskProfiler::WATCHED_TASKS[] = {
+    "AudioPlayback",
+    "PCMStreaming",
+    "RelayClock",
+    "StandbyRelay",
+    "loopTask",
+    "async_tcp",
+    "wifi",
+    "tiT",
+    "arduino_events"
+};
+const size_t TaskProfiler::WATCHED_TASK_COUNT = sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0]);
+
+// Static member definitions
+portMUX_TYPE TaskProfiler::lock = portMUX_INITIALIZER_UNLOCKED;
+TaskProfiler::TaskSample TaskProfiler::samples[sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0])];
+uint32_t TaskProfiler::previousRunTime[sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0])];
+uint32_t TaskProfiler::previousIdleRunTime[2] = {0, 0};
+uint32_t TaskProfiler::previousTotalRunTime = 0;
+float TaskProfiler::coreLoad[2] = {-1.0f, -1.0f};
+uint32_t TaskProfiler::sampleIntervalMs = 1000;
+unsigned long TaskProfiler::lastSampleTime = 0;
+bool TaskProfiler::initialized = false;
+
+bool TaskProfiler::begin(uint32_t intervalMs) {
+    sampleIntervalMs = intervalMs;
+
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+        samples[i].name = WATCHED_TASKS[i];
+        samples[i].present = false;
+        samples[i].stackFreeBytes = 0;
+        samples[i].cpuPercent = -1.0f;
+        samples[i].priority = 0;
+        previousRunTime[i] = 0;
+    }
+
+    initialized = true;
+    Serial.printf("TaskProfiler: Sampling %u tasks every %ums (run-time stats: %s)\n",
+                  (unsigned)WATCHED_TASK_COUNT, (unsigned)sampleIntervalMs,
+                  hasRunTimeStats() ? "yes" : "no");
+
+    // Take a baseline so the first interval has something to diff against
+    sample();
+    lastSampleTime = millis();
+    return true;
+}
+
+void TaskProfiler::update() {
+    if (!initialized || (millis() - lastSampleTime) < sampleIntervalMs) {
+        return;
+    }
+    lastSampleTime = millis();
+    sample();
+}
+
+size_t TaskProfiler::getTaskCount() {
+    return WATCHED_TASK_COUNT;
+}
+
+TaskProfiler::TaskSample TaskProfiler::getTask(size_t index) {
+    portENTER_CRITICAL(&lock);
+    TaskSample task = samples[index < WATCHED_TASK_COUNT ? index : 0];
+    portEXIT_CRITICAL(&lock);
+    return task;
+}
+
+float TaskProfiler::getCoreLoad(int core) {
+    if (core != 0 && core != 1) {
+        return -1.0f;
+    }
+    portENTER_CRITICAL(&lock);
+    float load = coreLoad[core];
+    portEXIT_CRITICAL(&lock);
+    return load;
+}
+
+bool TaskProfiler::hasRunTimeStats() {
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void TaskProfiler::writeJson(JsonWriter& json) {
+    TaskSample tasks[sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0])];
+    float load[2];
+    portENTER_CRITICAL(&lock);
+    memcpy(tasks, samples, sizeof(tasks));
+    memcpy(load, coreLoad, sizeof(load));
+    portEXIT_CRITICAL(&lock);
+
+    json.beginArray(JSON_KEY("tasks"));
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+        const TaskSample& task = tasks[i];
+        if (!task.present) {
+            continue;
+        }
+        json.beginObject()
+            .field(JSON_KEY("name"), task.name)
+            .field(JSON_KEY("stack_free"), task.stackFreeBytes)
+            .field(JSON_KEY("cpu"), task.cpuPercent)
+            .field(JSON_KEY("priority"), task.priority)
+            .endObject();
+    }
+    json.endArray();
+
+    json.beginArray(JSON_KEY("core_load"))
+        .value(load[0])
+        .value(load[1])
+        .endArray();
+}
+
+size_t TaskProfiler::renderMetrics(char* buffer, size_t size) {
+    TaskSample tasks[sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0])];
+    float load[2];
+    portENTER_CRITICAL(&lock);
+    memcpy(tasks, samples, sizeof(tasks));
+    memcpy(load, coreLoad, sizeof(load));
+    portEXIT_CRITICAL(&lock);
+
+    size_t used = bufferPrintf(buffer, size, 0,
+        "# HELP radiobenziger_task_cpu_stats_available Whether the firmware was built with run-time stats\n"
+        "# TYPE radiobenziger_task_cpu_stats_available gauge\n"
+        "radiobenziger_task_cpu_stats_available %u\n"
+        "# HELP radiobenziger_task_stack_free_bytes Minimum free stack since task start\n"
+        "# TYPE radiobenziger_task_stack_free_bytes gauge\n",
+        hasRunTimeStats() ? 1u : 0u);
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+        if (tasks[i].present) {
+            used = bufferPrintf(buffer, size, used, "radiobenziger_task_stack_free_bytes{task=\"%s\"} %u\n",
+                                tasks[i].name, (unsigned)tasks[i].stackFreeBytes);
+        }
+    }
+
+    if (hasRunTimeStats()) {
+        used = bufferPrintf(buffer, size, used,
+            "# HELP radiobenziger_task_cpu_percent Share of one core used over the last sample interval\n"
+            "# TYPE radiobenziger_task_cpu_percent gauge\n");
+        for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+            if (tasks[i].present && tasks[i].cpuPercent >= 0.0f) {
+                used = bufferPrintf(buffer, size, used, "radiobenziger_task_cpu_percent{task=\"%s\"} %.2f\n",
+                                    tasks[i].name, tasks[i].cpuPercent);
+            }
+        }
+
+        used = bufferPrintf(buffer, size, used,
+            "# HELP radiobenziger_core_load_percent Non-idle time per core over the last sample interval\n"
+            "# TYPE radiobenziger_core_load_percent gauge\n");
+        for (int core = 0; core < 2; core++) {
+            if (load[core] >= 0.0f) {
+                used = bufferPrintf(buffer, size, used, "radiobenziger_core_load_percent{core=\"%d\"} %.2f\n",
+                                    core, load[core]);
+            }
+        }
+    }
+
+    return used;
+}
+
+// Private methods implementation
+
+void TaskProfiler::sample() {
+    // Work on a copy; readers on other tasks see only whole samples
+    TaskSample next[sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0])];
+    float nextLoad[2];
+    portENTER_CRITICAL(&lock);
+    memcpy(next, samples, sizeof(next));
+    memcpy(nextLoad, coreLoad, sizeof(nextLoad));
+    portEXIT_CRITICAL(&lock);
+
+    // Stack high-water marks are available without trace support
+    for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+        TaskHandle_t handle = xTaskGetHandle(WATCHED_TASKS[i]);
+        next[i].present = (handle != nullptr);
+        if (handle) {
+            next[i].stackFreeBytes = uxTaskGetStackHighWaterMark(handle) * sizeof(StackType_t);
+        }
+    }
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    // Static: ~1.5KB of status records would not fit comfortably on loopTask's stack
+    static TaskStatus_t statuses[MAX_SYSTEM_TASKS];
+    uint32_t totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(statuses, MAX_SYSTEM_TASKS, &totalRunTime);
+    if (count > 0) {
+        uint32_t totalDelta = totalRunTime - previousTotalRunTime;
+        bool haveBaseline = previousTotalRunTime != 0 && totalDelta > 0;
+        TaskHandle_t idleTasks[2] = {xTaskGetIdleTaskHandleForCore(0), xTaskGetIdleTaskHandleForCore(1)};
+
+        for (UBaseType_t t = 0; t < count; t++) {
+            const TaskStatus_t& status = statuses[t];
+
+            // One idle task per core, by handle rather than by name
+            int core = status.xHandle == idleTasks[0] ? 0 : status.xHandle == idleTasks[1] ? 1 : -1;
+            if (core >= 0) {
+                if (haveBaseline) {
+                    float idle = (float)(status.ulRunTimeCounter - previousIdleRunTime[core]) * 100.0f / totalDelta;
+                    nextLoad[core] = idle > 100.0f ? 0.0f : 100.0f - idle;
+                }
+                previousIdleRunTime[core] = status.ulRunTimeCounter;
+                continue;
+            }
+
+            for (size_t i = 0; i < WATCHED_TASK_COUNT; i++) {
+                if (strcmp(status.pcTaskName, WATCHED_TASKS[i]) != 0) {
+                    continue;
+                }
+                next[i].priority = status.uxCurrentPriority;
+                if (haveBaseline) {
+                    next[i].cpuPercent = (float)(status.ulRunTimeCounter - previousRunTime[i]) * 100.0f / totalDelta;
+                }
+                previousRunTime[i] = status.ulRunTimeCounter;
+                break;
+            }
+        }
+
+        previousTotalRunTime = totalRunTime;
+    }
+#endif
+
+    portENTER_CRITICAL(&lock);
+    memcpy(samples, next, sizeof(samples));
+    memcpy(coreLoad, nextLoad, sizeof(coreLoad));
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,62 @@
+#ifndef TASKPROFILER_H
+#define TASKPROFILER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class JsonWriter;
+
+/**
+ * TaskProfiler - Stack high-water marks and per-task CPU usage
+ *
+ * Periodically samples FreeRTOS run-time stats and stack high-water marks
+ * for the audio, streaming, relay, loop, web server and WiFi tasks, and
+ * derives per-core load from the idle tasks. Results are written into /status (JSON, as members
+ * of the enclosing object) and /metrics (Prometheus text).
+ *
+ * update() samples on loopTask; the readers copy the results under `lock`,
+ * so they may be called from web handlers. Without
+ * configGENERATE_RUN_TIME_STATS only stack sizes are sampled, and /metrics
+ * says so with radiobenziger_task_cpu_stats_available 0.
+ */
+class TaskProfiler {
+public:
+    struct TaskSample {
+        const char* name;              // Watched task name
+        bool present;                  // Task exists
+        uint32_t stackFreeBytes;       // Minimum free stack since task start
+        float cpuPercent;              // Share of one core over the last interval (-1 = unavailable)
+        uint32_t priority;             // Current priority
+    };
+
+    static bool begin(uint32_t sampleIntervalMs = 1000);
+    static void update();
+
+    static size_t getTaskCount();
+    static TaskSample getTask(size_t index);
+    static float getCoreLoad(int core);
+    static bool hasRunTimeStats();
+
+    static void writeJson(JsonWriter& json);
+    static size_t renderMetrics(char* buffer, size_t size);
+
+private:
+    static const size_t MAX_SYSTEM_TASKS = 32;
+    static const size_t WATCHED_TASK_COUNT;
+    static const char* const WATCHED_TASKS[];
+
+    static portMUX_TYPE lock;
+    static TaskSample samples[];       // Under lock
+    static uint32_t previousRunTime[];
+    static uint32_t previousIdleRunTime[2];
+    static uint32_t previousTotalRunTime;
+    static float coreLoad[2];          // Under lock
+    static uint32_t sampleIntervalMs;
+    static unsigned long lastSampleTime;
+    static bool initialized;
+
+    static void sample();
+};
+
+#endif // TASKPROFILER_H
@@ -0,0 +1,107 @@
+#include "TelemetryEmitter.h"
+
+// Static member definitions
+std::atomic<bool> TelemetryEmitter::configurePending(false);
+portMUX_TYPE TelemetryEmitter::requestLock = portMUX_INITIALIZER_UNLOCKED;
+char TelemetryEmitter::requestedHost[64] = "";
+uint16_t TelemetryEmitter::requestedPort = TelemetryEmitter::DEFAULT_PORT;
+uint32_t TelemetryEmitter::requestedIntervalMs = TelemetryEmitter::DEFAULT_INTERVAL_MS;
+WiFiUDP TelemetryEmitter::udp;
+char TelemetryEmitter::host[64] = "";
+uint16_t TelemetryEmitter::port = TelemetryEmitter::DEFAULT_PORT;
+IPAddress TelemetryEmitter::address;
+bool TelemetryEmitter::resolved = false;
+unsigned long TelemetryEmitter::lastResolveAttempt = 0;
+uint32_t TelemetryEmitter::intervalMs = TelemetryEmitter::DEFAULT_INTERVAL_MS;
+unsigned long TelemetryEmitter::lastSendTime = 0;
+uint32_t TelemetryEmitter::sequence = 0;
+uint32_t TelemetryEmitter::packetsSent = 0;
+uint32_t TelemetryEmitter::sendFailures = 0;
+
+void TelemetryEmitter::configure(const char* collectorHost, uint16_t collectorPort, uint32_t interval) {
+    portENTER_CRITICAL(&requestLock);
+    strlcpy(requestedHost, collectorHost ? collectorHost : "", sizeof(requestedHost));
+    requestedPort = collectorPort ? collectorPort : DEFAULT_PORT;
+    requestedIntervalMs = interval < MIN_INTERVAL_MS ? MIN_INTERVAL_MS : interval;
+    portEXIT_CRITICAL(&requestLock);
+    configurePending = true;
+}
+
+bool TelemetryEmitter::isEnabled() {
+    return host[0] != '\0';
+}
+
+bool TelemetryEmitter::isDue() {
+    if (configurePending.exchange(false)) {
+        applyConfiguration();
+    }
+    return isEnabled() && WiFi.status() == WL_CONNECTED && (millis() - lastSendTime) >= intervalMs;
+}
+
+bool TelemetryEmitter::send(TelemetryPacket& packet) {
+    lastSendTime = millis();
+    if (!resolve()) {
+        return false;
+    }
+
+    packet.version = TelemetryPacket::VERSION;
+    packet.sequence = sequence++;
+    packet.deviceId = (uint32_t)ESP.getEfuseMac();
+
+    uint8_t datagram[TelemetryPacket::WIRE_SIZE];
+    size_t length = packet.encode(datagram, sizeof(datagram));
+
+    if (!udp.beginPacket(address, port) || udp.write(datagram, length) != length || !udp.endPacket()) {
+        sendFailures++;
+        return false;
+    }
+
+    packetsSent++;
+    return true;
+}
+
+// Private methods implementation
+
+void TelemetryEmitter::applyConfiguration() {
+    portENTER_CRITICAL(&requestLock);
+    memcpy(host, requestedHost, sizeof(host));
+    port = requestedPort;
+    intervalMs = requestedIntervalMs;
+    portEXIT_CRITICAL(&requestLock);
+    resolved = false;
+    lastResolveAttempt = 0;
+
+    if (isEnabled()) {
+        Serial.printf("TelemetryEmitter: Sending to %s:%u every %ums\n", host, (unsigned)port, (unsigned)intervalMs);
+    } else {
+        Serial.println("TelemetryEmitter: Disabled (no collector configured)");
+    }
+}
+
+bool TelemetryEmitter::resolve() {
+    if (resolved) {
+        return true;
+    }
+
+    // Literal addresses need no lookup; hostnames are retried sparingly
+    // because the lookup blocks the caller
+    if (address.fromString(host)) {
+        resolved = true;
+        return true;
+    }
+
+    if (lastResolveAttempt != 0 && (millis() - lastResolveAttempt) < RESOLVE_RETRY_MS) {
+        return false;
+    }
+    lastResolveAttempt = millis();
+
+    if (WiFi.hostByName(host, address) == 1) {
+        Serial.printf("TelemetryEmitter: Resolved %s to %s\n", host, address.toString().c_str());
+        resolved = true;
+        return true;
+    }
+
+    Serial.printf("TelemetryEmitter: Could not resolve %s, retrying in %us\n", host,
+                  (unsigned)(RESOLVE_RETRY_MS / 1000));
+    return false;
+}
@@ -0,0 +1,84 @@
+#ifndef TELEMETRYEMITTER_H
+#define TELEMETRYEMITTER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <atomic>
+#include "TelemetryPacket.h"
+
+/**
+ * TelemetryEmitter - Periodic UDP status datagrams for fleet monitoring
+ *
+ * Sends a fixed-layout TelemetryPacket to a collector at a configurable
+ * interval. One small datagram per interval replaces HTTP scraping of
+ * /status, so a collector can watch dozens of receivers cheaply.
+ * tools/telemetry_collector.cpp decodes and aggregates the packets.
+ *
+ * The caller fills the measurement fields; the emitter stamps version,
+ * sequence and device id. Disabled while no collector host is configured.
+ *
+ * configure() may be called from any task (web handlers); it only posts the
+ * new collector, which the loop task picks up in its next isDue(). Everything
+ * else belongs to the loop task.
+ */
+class TelemetryEmitter {
+public:
+    static const uint16_t DEFAULT_PORT = 5600;
+    static const uint32_t DEFAULT_INTERVAL_MS = 5000;
+    static const uint32_t MIN_INTERVAL_MS = 250;
+
+    /**
+     * Set (or change) the collector; takes effect on the next isDue()
+     *
+     * @param collectorHost IP address or hostname ("" disables telemetry)
+     * @param collectorPort UDP port
+     * @param intervalMs Send interval (minimum MIN_INTERVAL_MS)
+     */
+    static void configure(const char* collectorHost, uint16_t collectorPort, uint32_t intervalMs);
+
+    static bool isEnabled();
+
+    /**
+     * Check whether a packet should be sent now (enabled, WiFi up, interval
+     * elapsed). Lets the caller skip sampling otherwise.
+     */
+    static bool isDue();
+
+    /**
+     * Stamp and send a packet
+     *
+     * @return true if the datagram was handed to the network stack
+     */
+    static bool send(TelemetryPacket& packet);
+
+    static uint32_t getPacketsSent() { return packetsSent; }
+    static uint32_t getSendFailures() { return sendFailures; }
+
+private:
+    static const uint32_t RESOLVE_RETRY_MS = 30000;
+
+    // Posted by configure(), applied by the loop task
+    static std::atomic<bool> configurePending;
+    static portMUX_TYPE requestLock;          // Guards the requested collector
+    static char requestedHost[64];
+    static uint16_t requestedPort;
+    static uint32_t requestedIntervalMs;
+
+    static WiFiUDP udp;
+    static char host[64];
+    static uint16_t port;
+    static IPAddress address;
+    static bool resolved;
+    static unsigned long lastResolveAttempt;
+    static uint32_t intervalMs;
+    static unsigned long lastSendTime;
+    static uint32_t sequence;
+    static uint32_t packetsSent;
+    static uint32_t sendFailures;
+
+    static void applyConfiguration();
+    static bool resolve();
+};
+
+#endif // TELEMETRYEMITTER_H
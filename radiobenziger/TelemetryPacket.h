@@ -0,0 +1,146 @@
+#ifndef TELEMETRYPACKET_H
+#define TELEMETRYPACKET_H
+
+// Shared between the firmware and host tools - standard headers only
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * TelemetryPacket - Compact status datagram for fleet monitoring
+ *
+ * Receivers send one of these over UDP at a fixed interval. The wire
+ * format is a fixed 104-byte little-endian layout written field by field
+ * by encode() and read back by decode(), so it does not depend on the
+ * compiler's struct packing or on the host's byte order.
+ *
+ * Wire layout (offsets in bytes):
+ *   0  magic 'RBT1'          4  version              5  flags
+ *   6  reserved (u16)        8  sequence             12 uptime (ms)
+ *   16 device id             20 I2S bytes (u64)      28 I2S writes (u64)
+ *   36 I2S overflows         40 network bytes (u64)  48 underruns
+ *   52 reservoir overflows   56 reconnects           60 buffered bytes
+ *   64 buffer capacity       68 free heap            72 min free heap
+ *   76 free PSRAM            80 RSSI (i8)            81 reserved (3)
+ *   84 device name (char[20], NUL-padded)
+ */
+struct TelemetryPacket {
+    static const uint32_t MAGIC = 0x31544252;  // "RBT1" little-endian
+    static const uint8_t VERSION = 1;
+    static const size_t WIRE_SIZE = 104;
+    static const size_t DEVICE_NAME_SIZE = 20;
+
+    // flags
+    static const uint8_t FLAG_WIFI_CONNECTED = 0x01;
+    static const uint8_t FLAG_STREAMING_ACTIVE = 0x02;
+    static const uint8_t FLAG_STREAMING_REQUESTED = 0x04;
+
+    uint8_t version;
+    uint8_t flags;
+    uint32_t sequence;                 // Increments per packet (loss detection)
+    uint32_t uptimeMs;                 // millis() at send time
+    uint32_t deviceId;                 // Low 32 bits of the factory MAC
+    uint64_t i2sBytes;                 // PCMStreamer bytes written
+    uint64_t i2sWrites;                // PCMStreamer write calls
+    uint32_t i2sOverflows;             // Partial I2S writes
+    uint64_t networkBytes;             // PCM bytes received from the relay
+    uint32_t underruns;                // Starvation episodes
+    uint32_t reservoirOverflows;       // Reservoir writes that did not fit
+    uint32_t reconnects;               // Stream reconnects
+    uint32_t bufferedBytes;            // Reservoir fill
+    uint32_t bufferCapacity;           // Reservoir size
+    uint32_t freeHeap;                 // Free internal heap
+    uint32_t minFreeHeap;              // Lowest free heap since boot
+    uint32_t freePsram;                // Free PSRAM
+    int8_t rssi;                       // WiFi RSSI (dBm, 0 = not connected)
+    char deviceName[DEVICE_NAME_SIZE]; // Configured device name (NUL-terminated)
+
+    /**
+     * Serialise into a WIRE_SIZE-byte buffer
+     *
+     * @return Number of bytes written (WIRE_SIZE), or 0 if the buffer is too small
+     */
+    size_t encode(uint8_t* out, size_t size) const {
+        if (size < WIRE_SIZE) {
+            return 0;
+        }
+        memset(out, 0, WIRE_SIZE);
+        put32(out + 0, MAGIC);
+        out[4] = version;
+        out[5] = flags;
+        put32(out + 8, sequence);
+        put32(out + 12, uptimeMs);
+        put32(out + 16, deviceId);
+        put64(out + 20, i2sBytes);
+        put64(out + 28, i2sWrites);
+        put32(out + 36, i2sOverflows);
+        put64(out + 40, networkBytes);
+        put32(out + 48, underruns);
+        put32(out + 52, reservoirOverflows);
+        put32(out + 56, reconnects);
+        put32(out + 60, bufferedBytes);
+        put32(out + 64, bufferCapacity);
+        put32(out + 68, freeHeap);
+        put32(out + 72, minFreeHeap);
+        put32(out + 76, freePsram);
+        out[80] = (uint8_t)rssi;
+        memcpy(out + 84, deviceName, DEVICE_NAME_SIZE);
+        out[84 + DEVICE_NAME_SIZE - 1] = '\0';
+        return WIRE_SIZE;
+    }
+
+    /**
+     * Parse a datagram
+     *
+     * @return true if it is a complete packet of a known version
+     */
+    bool decode(const uint8_t* in, size_t size) {
+        if (size < WIRE_SIZE || get32(in + 0) != MAGIC || in[4] != VERSION) {
+            return false;
+        }
+        version = in[4];
+        flags = in[5];
+        sequence = get32(in + 8);
+        uptimeMs = get32(in + 12);
+        deviceId = get32(in + 16);
+        i2sBytes = get64(in + 20);
+        i2sWrites = get64(in + 28);
+        i2sOverflows = get32(in + 36);
+        networkBytes = get64(in + 40);
+        underruns = get32(in + 48);
+        reservoirOverflows = get32(in + 52);
+        reconnects = get32(in + 56);
+        bufferedBytes = get32(in + 60);
+        bufferCapacity = get32(in + 64);
+        freeHeap = get32(in + 68);
+        minFreeHeap = get32(in + 72);
+        freePsram = get32(in + 76);
+        rssi = (int8_t)in[80];
+        memcpy(deviceName, in + 84, DEVICE_NAME_SIZE);
+        deviceName[DEVICE_NAME_SIZE - 1] = '\0';
+        return true;
+    }
+
+private:
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    static void put64(uint8_t* p, uint64_t v) {
+        put32(p, (uint32_t)v);
+        put32(p + 4, (uint32_t)(v >> 32));
+    }
+
+    static uint32_t get32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static uint64_t get64(const uint8_t* p) {
+        return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+    }
+};
+
+#endif // TELEMETRYPACKET_H
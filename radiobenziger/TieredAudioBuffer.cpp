@@ -0,0 +1,238 @@
+#include "TieredAudioBuffer.h"
+#include "AudioHot.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+static const char* TAG = "TieredAudioBuffer";
+
+TieredAudioBuffer::TieredAudioBuffer() {
+    reservoir = nullptr;
+    reservoirMask = 0;
+    writeIndex = 0;
+    readIndex = 0;
+    flushPending = false;
+    flushIndex = 0;
+    staging = nullptr;
+    stagingSlot = 0;
+    ownsStaging = false;
+}
+
+TieredAudioBuffer::~TieredAudioBuffer() {
+    end();
+}
+
+bool TieredAudioBuffer::begin(size_t chunkBytes, size_t stagingSlots,
+                              size_t internalReservoirBytes, size_t psramReservoirBytes,
+                              uint8_t* stagingStorage) {
+    if (isReady()) {
+        ESP_LOGW(TAG, "TieredAudioBuffer already initialized");
+        return true;
+    }
+
+    if (chunkBytes == 0 || stagingSlots == 0) {
+        ESP_LOGE(TAG, "Invalid layout: chunk=%d bytes, slots=%d", chunkBytes, stagingSlots);
+        return false;
+    }
+
+    // Staging ring must be DMA-capable internal RAM so I2S never reads from PSRAM
+    ownsStaging = (stagingStorage == nullptr);
+    staging = ownsStaging
+        ? (uint8_t*)heap_caps_malloc(chunkBytes * stagingSlots, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
+        : stagingStorage;
+    if (!staging) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte DMA staging ring", chunkBytes * stagingSlots);
+        return false;
+    }
+
+    // Reservoir goes to PSRAM when present, otherwise internal RAM
+    layout.reservoirInPSRAM = false;
+    if (psramReservoirBytes > 0 && heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0) {
+        size_t size = roundDownToPowerOfTwo(psramReservoirBytes);
+        reservoir = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (reservoir) {
+            layout.reservoirBytes = size;
+            layout.reservoirInPSRAM = true;
+        } else {
+            ESP_LOGW(TAG, "PSRAM reservoir allocation failed, falling back to internal RAM");
+        }
+    }
+
+    if (!reservoir) {
+        size_t size = roundDownToPowerOfTwo(internalReservoirBytes);
+        reservoir = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!reservoir) {
+            ESP_LOGE(TAG, "Failed to allocate %d byte reservoir", size);
+            if (ownsStaging) {
+                heap_caps_free(staging);
+            }
+            staging = nullptr;
+            return false;
+        }
+        layout.reservoirBytes = size;
+    }
+
+    layout.chunkBytes = chunkBytes;
+    layout.stagingSlots = stagingSlots;
+    reservoirMask = layout.reservoirBytes - 1;
+    stagingSlot = 0;
+    writeIndex = 0;
+    readIndex = 0;
+    flushPending = false;
+
+    printLayout();
+    return true;
+}
+
+void TieredAudioBuffer::end() {
+    if (reservoir) {
+        heap_caps_free(reservoir);
+        reservoir = nullptr;
+    }
+    if (staging) {
+        if (ownsStaging) {
+            heap_caps_free(staging);
+        }
+        staging = nullptr;
+    }
+    layout = Layout();
+    reservoirMask = 0;
+}
+
+size_t AUDIO_HOT_ATTR TieredAudioBuffer::write(const uint8_t* data, size_t size) {
+    if (!reservoir || !data || size == 0) {
+        return 0;
+    }
+
+    uint32_t head = writeIndex.load(std::memory_order_relaxed);
+    uint32_t tail = effectiveReadIndex();
+    size_t freeBytes = layout.reservoirBytes - (size_t)(head - tail);
+    if (size > freeBytes) {
+        size = freeBytes;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    // Copy in at most two pieces around the wrap point
+    size_t offset = head & reservoirMask;
+    size_t first = layout.reservoirBytes - offset;
+    if (first > size) {
+        first = size;
+    }
+    memcpy(reservoir + offset, data, first);
+    if (size > first) {
+        memcpy(reservoir, data + first, size - first);
+    }
+
+    writeIndex.store(head + size, std::memory_order_release);
+    return size;
+}
+
+const uint8_t* AUDIO_HOT_ATTR TieredAudioBuffer::fetch(size_t& size) {
+    size = 0;
+    if (!isReady()) {
+        return nullptr;
+    }
+
+    applyPendingFlush();
+
+    uint32_t tail = readIndex.load(std::memory_order_relaxed);
+    uint32_t head = writeIndex.load(std::memory_order_acquire);
+    if ((size_t)(head - tail) < layout.chunkBytes) {
+        return nullptr;
+    }
+
+    uint8_t* slot = staging + stagingSlot * layout.chunkBytes;
+    stagingSlot = (stagingSlot + 1) % layout.stagingSlots;
+
+    size_t offset = tail & reservoirMask;
+    size_t first = layout.reservoirBytes - offset;
+    if (first > layout.chunkBytes) {
+        first = layout.chunkBytes;
+    }
+    memcpy(slot, reservoir + offset, first);
+    if (layout.chunkBytes > first) {
+        memcpy(slot + first, reservoir, layout.chunkBytes - first);
+    }
+
+    readIndex.store(tail + layout.chunkBytes, std::memory_order_release);
+    size = layout.chunkBytes;
+    return slot;
+}
+
+size_t AUDIO_HOT_ATTR TieredAudioBuffer::discard(size_t size) {
+    if (!isReady()) {
+        return 0;
+    }
+
+    applyPendingFlush();
+
+    uint32_t tail = readIndex.load(std::memory_order_relaxed);
+    uint32_t head = writeIndex.load(std::memory_order_acquire);
+    size_t buffered = (head - tail) & ~(size_t)1;
+    if (size > buffered) {
+        size = buffered;
+    }
+    size &= ~(size_t)1;
+
+    readIndex.store(tail + size, std::memory_order_release);
+    return size;
+}
+
+void TieredAudioBuffer::clear() {
+    // Only the consumer moves readIndex; record where the flush ends and let
+    // the next fetch() skip ahead to it
+    flushIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+    flushPending.store(true, std::memory_order_release);
+}
+
+size_t AUDIO_HOT_ATTR TieredAudioBuffer::getBufferedBytes() const {
+    uint32_t tail = effectiveReadIndex();
+    uint32_t head = writeIndex.load(std::memory_order_acquire);
+    return head - tail;
+}
+
+void TieredAudioBuffer::printLayout() const {
+    ESP_LOGI(TAG, "=== TieredAudioBuffer Layout ===");
+    ESP_LOGI(TAG, "DMA staging ring: %d x %d bytes (internal)", layout.stagingSlots, layout.chunkBytes);
+    ESP_LOGI(TAG, "Reservoir: %d bytes (%s)", layout.reservoirBytes,
+             layout.reservoirInPSRAM ? "PSRAM" : "internal");
+    ESP_LOGI(TAG, "Free internal heap: %d bytes", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    ESP_LOGI(TAG, "================================");
+}
+
+// Private methods implementation
+
+size_t TieredAudioBuffer::roundDownToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return value == 0 ? 0 : result;
+}
+
+uint32_t AUDIO_HOT_ATTR TieredAudioBuffer::effectiveReadIndex() const {
+    uint32_t tail = readIndex.load(std::memory_order_acquire);
+
+    // A pending flush already frees the data it will discard, so the producer
+    // can refill while the consumer is idle
+    if (flushPending.load(std::memory_order_acquire)) {
+        uint32_t target = flushIndex.load(std::memory_order_relaxed);
+        if ((int32_t)(target - tail) > 0) {
+            return target;
+        }
+    }
+    return tail;
+}
+
+void AUDIO_HOT_ATTR TieredAudioBuffer::applyPendingFlush() {
+    if (!flushPending.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    uint32_t target = flushIndex.load(std::memory_order_relaxed);
+    uint32_t tail = readIndex.load(std::memory_order_relaxed);
+    if ((int32_t)(target - tail) > 0) {
+        readIndex.store(target, std::memory_order_release);
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef TIEREDAUDIOBUFFER_H
+#define TIEREDAUDIOBUFFER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * TieredAudioBuffer - Two-tier PCM buffer between the network and I2S
+ *
+ * The producer (streaming task) writes raw PCM bytes into a large jitter
+ * reservoir. The consumer (playback task) fetches fixed-size chunks, which
+ * are staged into a small ring of slots in internal DMA-capable RAM before
+ * being handed to the I2S driver.
+ *
+ * The reservoir is placed in PSRAM when the module has it, so PSRAM boards
+ * get several seconds of buffering without touching internal heap. Boards
+ * without PSRAM fall back to a smaller reservoir in internal RAM.
+ *
+ * Single producer / single consumer: write() must only be called from one
+ * task and fetch() from one other task. clear() may be called from any task.
+ */
+class TieredAudioBuffer {
+public:
+    /**
+     * Buffer layout, filled in by begin()
+     */
+    struct Layout {
+        size_t chunkBytes;             // Bytes returned by each fetch()
+        size_t stagingSlots;           // Number of chunk slots in the DMA-capable ring
+        size_t reservoirBytes;         // Reservoir capacity (power of two)
+        bool reservoirInPSRAM;         // True if the reservoir was allocated in PSRAM
+
+        Layout() :
+            chunkBytes(0),
+            stagingSlots(0),
+            reservoirBytes(0),
+            reservoirInPSRAM(false) {}
+    };
+
+private:
+    Layout layout;
+
+    // Reservoir (jitter buffer) - PSRAM when available
+    uint8_t* reservoir;
+    size_t reservoirMask;
+    std::atomic<uint32_t> writeIndex;  // Free-running, owned by producer
+    std::atomic<uint32_t> readIndex;   // Free-running, owned by consumer
+
+    // Deferred flush requested by clear(), applied by the consumer
+    std::atomic<bool> flushPending;
+    std::atomic<uint32_t> flushIndex;
+
+    // Staging ring in internal DMA-capable RAM
+    uint8_t* staging;
+    size_t stagingSlot;
+    bool ownsStaging;                  // False when staging memory was supplied by the caller
+
+    static size_t roundDownToPowerOfTwo(size_t value);
+    uint32_t effectiveReadIndex() const;
+    void applyPendingFlush();
+
+public:
+    TieredAudioBuffer();
+    ~TieredAudioBuffer();
+
+    /**
+     * Allocate both tiers
+     *
+     * @param chunkBytes Size of each chunk handed to I2S
+     * @param stagingSlots Number of chunk slots in the internal DMA-capable ring
+     * @param internalReservoirBytes Reservoir size when no PSRAM is present
+     * @param psramReservoirBytes Reservoir size when PSRAM is present
+     * @param stagingStorage Optional caller-owned DMA-capable memory of
+     *        chunkBytes * stagingSlots bytes (nullptr = allocate from heap)
+     * @return true if both tiers were allocated
+     */
+    bool begin(size_t chunkBytes, size_t stagingSlots,
+               size_t internalReservoirBytes, size_t psramReservoirBytes,
+               uint8_t* stagingStorage = nullptr);
+
+    /**
+     * Release both tiers
+     */
+    void end();
+
+    /**
+     * Append PCM bytes to the reservoir (producer side)
+     *
+     * @param data Pointer to PCM data
+     * @param size Size of data in bytes
+     * @return Number of bytes accepted (less than size if the reservoir is full)
+     */
+    size_t write(const uint8_t* data, size_t size);
+
+    /**
+     * Stage the next chunk into the DMA-capable ring (consumer side)
+     *
+     * @param size Set to the number of bytes in the returned chunk
+     * @return Pointer to the staged chunk, or nullptr if less than a full
+     *         chunk is buffered (underrun)
+     */
+    const uint8_t* fetch(size_t& size);
+
+    /**
+     * Drop up to `size` buffered bytes without playing them (consumer side)
+     *
+     * @return Number of bytes dropped (whole samples)
+     */
+    size_t discard(size_t size);
+
+    /**
+     * Stream position of the next byte write() will store (producer side).
+     * Positions are free-running byte counts that survive clear(); compare
+     * them by signed difference.
+     */
+    uint32_t getWritePosition() const { return writeIndex.load(std::memory_order_relaxed); }
+
+    /**
+     * Stream position of the next byte fetch() will return (consumer side)
+     */
+    uint32_t getReadPosition() const { return effectiveReadIndex(); }
+
+    /**
+     * Discard everything written so far. Safe to call from any task; data
+     * written after the call is kept.
+     */
+    void clear();
+
+    /**
+     * Get amount of data currently buffered in the reservoir
+     */
+    size_t getBufferedBytes() const;
+
+    /**
+     * Get free space in the reservoir
+     */
+    size_t getFreeBytes() const { return layout.reservoirBytes - getBufferedBytes(); }
+
+    /**
+     * Get reservoir capacity in bytes
+     */
+    size_t getCapacity() const { return layout.reservoirBytes; }
+
+    /**
+     * Get the layout chosen by begin()
+     */
+    const Layout& getLayout() const { return layout; }
+
+    /**
+     * Check whether begin() succeeded
+     */
+    bool isReady() const { return reservoir != nullptr && staging != nullptr; }
+
+    /**
+     * Print the buffer layout to Serial
+     */
+    void printLayout() const;
+};
+
+#endif // TIEREDAUDIOBUFFER_H
@@ -0,0 +1,123 @@
+// Generated by embed_web_assets.py from web/ - do not edit by hand
+#ifndef WEBASSETS_H
+#define WEBASSETS_H
+
+#include <Arduino.h>
+
+/**
+ * Pre-gzipped web UI asset stored in flash
+ */
+struct WebAsset {
+    const char* path;              // URL path
+    const char* contentType;       // MIME type of the uncompressed content
+    const uint8_t* data;           // Gzip-compressed content (PROGMEM)
+    size_t length;                 // Compressed length in bytes
+    const char* etag;              // Quoted content hash
+};
+
+// index.html: 4183 bytes, 1526 gzipped
+static const uint8_t WEB_ASSET_INDEX_HTML[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcd, 0x58, 0x5b, 0x6f, 0xdb, 0x36,
+    0x14, 0x7e, 0xf7, 0xaf, 0x38, 0xf3, 0x1e, 0x64, 0x63, 0xb6, 0x6c, 0xc7, 0x4d, 0x93, 0xf9, 0xa2,
+    0xa1, 0x49, 0x5b, 0xb4, 0x43, 0xd3, 0x04, 0x71, 0x86, 0x62, 0x4f, 0x01, 0x2d, 0x51, 0x36, 0x1b,
+    0x89, 0x14, 0x48, 0xca, 0x69, 0x9a, 0xe6, 0xbf, 0xef, 0x90, 0xa2, 0x64, 0xd9, 0x91, 0x9b, 0x01,
+    0x7b, 0x19, 0x0a, 0xd4, 0x12, 0x79, 0xee, 0xe7, 0x3b, 0x17, 0x65, 0xf6, 0xcb, 0xdb, 0xcb, 0xf3,
+    0x9b, 0xbf, 0xaf, 0xde, 0xc1, 0x5a, 0xa7, 0x49, 0xd0, 0x9a, 0x95, 0x3f, 0x94, 0x44, 0xf8, 0xa3,
+    0x99, 0x4e, 0x68, 0x70, 0x4d, 0x22, 0x26, 0xe0, 0x8c, 0xf2, 0xef, 0x6c, 0x45, 0x25, 0x5c, 0x9d,
+    0x5f, 0xc0, 0x42, 0x4b, 0x4a, 0x52, 0xc6, 0x57, 0xb3, 0x41, 0x41, 0xd3, 0x9a, 0xa5, 0x54, 0x13,
+    0xe0, 0x24, 0xa5, 0xf3, 0xf6, 0x86, 0xd1, 0xfb, 0x4c, 0x48, 0xdd, 0x86, 0x50, 0x70, 0x4d, 0xb9,
+    0x9e, 0xb7, 0xef, 0x59, 0xa4, 0xd7, 0xf3, 0x88, 0x6e, 0x58, 0x48, 0xfb, 0xf6, 0xa5, 0x07, 0x8c,
+    0x33, 0xcd, 0x48, 0xd2, 0x57, 0x21, 0x49, 0xe8, 0x7c, 0xd4, 0x46, 0x21, 0x4a, 0x3f, 0x18, 0x61,
+    0x4b, 0x11, 0x3d, 0xc0, 0x23, 0xc4, 0xc8, 0xdd, 0x8f, 0x51, 0x4f, 0xf2, 0x30, 0x81, 0x37, 0x12,
+    0x69, 0x7b, 0xa0, 0x08, 0x57, 0x7d, 0x45, 0x25, 0x8b, 0xa7, 0x90, 0x12, 0xb9, 0x62, 0x7c, 0x02,
+    0x47, 0xc3, 0xec, 0xdb, 0x14, 0x96, 0x24, 0xbc, 0x5b, 0x49, 0x91, 0xf3, 0x68, 0x02, 0xbf, 0xc6,
+    0x43, 0xf3, 0x6f, 0x0a, 0x4f, 0x2d, 0xdf, 0xd8, 0x40, 0x18, 0x47, 0xcb, 0x1f, 0x91, 0xe3, 0x5b,
+    0xa1, 0x7d, 0x02, 0xaf, 0x87, 0x96, 0xab, 0x94, 0x31, 0x04, 0x92, 0x6b, 0xb1, 0x2b, 0xe5, 0x7e,
+    0xcd, 0x34, 0x9d, 0x42, 0x46, 0xa2, 0x08, 0x5d, 0xad, 0xf4, 0x08, 0x19, 0x51, 0xd9, 0x97, 0x18,
+    0x95, 0x5c, 0x4d, 0x60, 0x64, 0x0f, 0x9f, 0x5a, 0xeb, 0x11, 0xca, 0x0f, 0x45, 0x22, 0x24, 0xaa,
+    0x1f, 0x8f, 0xc7, 0x53, 0xd0, 0xf4, 0x9b, 0xee, 0x93, 0x84, 0xad, 0x50, 0x7c, 0x88, 0x51, 0xa0,
+    0xd2, 0xda, 0xa3, 0x34, 0xd1, 0xb9, 0x42, 0xe2, 0x4a, 0xee, 0x68, 0xc7, 0x12, 0xf3, 0x06, 0xc3,
+    0x67, 0x7a, 0x8e, 0x0b, 0x35, 0xc6, 0x1d, 0x4e, 0x43, 0x4d, 0x23, 0x94, 0xb0, 0xe3, 0x72, 0xf4,
+    0x8a, 0x46, 0x11, 0x99, 0x56, 0x36, 0x8c, 0x8e, 0x8f, 0x4f, 0x8e, 0x5e, 0x59, 0x9e, 0x88, 0xa9,
+    0x83, 0x6c, 0xf1, 0x69, 0x74, 0x52, 0x67, 0x3b, 0x39, 0x1a, 0x85, 0x8e, 0xcd, 0x44, 0x4e, 0x8a,
+    0xc4, 0xd8, 0xda, 0xe4, 0x4b, 0x3d, 0xfc, 0x60, 0x63, 0xbd, 0xcc, 0xb5, 0x16, 0x7c, 0xdf, 0x35,
+    0x17, 0xb7, 0x92, 0xdc, 0x3a, 0x62, 0x53, 0xab, 0xd8, 0x77, 0x8a, 0x24, 0xaf, 0xb7, 0x51, 0x9d,
+    0x00, 0x17, 0x9c, 0x36, 0xfb, 0x1e, 0xe6, 0x52, 0x19, 0x0b, 0x33, 0xc1, 0xea, 0xb1, 0x94, 0x7a,
+    0xdf, 0xa3, 0xa3, 0x53, 0x72, 0xf2, 0xea, 0xb8, 0xf2, 0xc8, 0x65, 0xd1, 0x52, 0x8b, 0xec, 0x59,
+    0xd4, 0xc2, 0xf1, 0x71, 0x23, 0x31, 0xe3, 0xb1, 0xd8, 0x27, 0x1e, 0x9d, 0x90, 0xa3, 0xe5, 0x69,
+    0x93, 0x64, 0xaa, 0x35, 0xfa, 0xab, 0x2c, 0xc4, 0x76, 0xa3, 0xb2, 0x0d, 0xc5, 0xf1, 0x73, 0x94,
+    0x9e, 0xc6, 0xbf, 0xc7, 0xe4, 0x50, 0xaa, 0x67, 0x03, 0x57, 0x0e, 0xb3, 0x81, 0xab, 0x47, 0x53,
+    0x17, 0xf8, 0x13, 0xb1, 0x0d, 0x84, 0x09, 0x51, 0x6a, 0xde, 0xae, 0xc0, 0x6d, 0xaa, 0x67, 0x3d,
+    0x7a, 0xa1, 0x56, 0x91, 0xa0, 0x55, 0xb0, 0xb3, 0xc8, 0xd4, 0x64, 0xcc, 0xda, 0xa5, 0x20, 0x87,
+    0xca, 0x3a, 0x52, 0xda, 0xc1, 0x17, 0xf6, 0x9e, 0x4d, 0xc0, 0xf7, 0xfd, 0xd9, 0x00, 0x99, 0x82,
+    0x2d, 0xab, 0xb2, 0x32, 0x7f, 0xce, 0xbc, 0xd5, 0xdd, 0x28, 0x22, 0x61, 0x1b, 0xba, 0x27, 0xa0,
+    0x1d, 0x9c, 0xe5, 0x71, 0x4c, 0x25, 0xc5, 0xd8, 0xf4, 0x21, 0x55, 0xf0, 0x03, 0xfe, 0xe2, 0x18,
+    0x18, 0x99, 0x73, 0x65, 0x4e, 0x7e, 0xc0, 0xf5, 0x62, 0xf1, 0xd1, 0x3c, 0x45, 0x67, 0xa9, 0x93,
+    0xf7, 0x2c, 0x1a, 0x06, 0xb0, 0x26, 0x18, 0x0e, 0x8b, 0x5b, 0x05, 0xa6, 0x1f, 0x09, 0x1e, 0x26,
+    0x2c, 0xbc, 0x73, 0xef, 0x85, 0x75, 0x9d, 0x6e, 0x3b, 0x58, 0x58, 0x1c, 0x15, 0xef, 0xb3, 0x41,
+    0xc1, 0xda, 0x20, 0x43, 0x64, 0x3b, 0x22, 0x44, 0x56, 0x97, 0x80, 0xd8, 0x7a, 0x41, 0x80, 0x81,
+    0x54, 0x4d, 0xc0, 0x8a, 0xa2, 0x05, 0xc6, 0x6f, 0x67, 0x01, 0x3e, 0xd5, 0x58, 0x1b, 0xdc, 0x2b,
+    0x51, 0x66, 0x73, 0x3d, 0x0e, 0x0a, 0x6d, 0xb0, 0x70, 0xa7, 0x98, 0xde, 0x31, 0x5e, 0x64, 0x01,
+    0x76, 0x51, 0x29, 0xf8, 0x2a, 0x58, 0x50, 0xb9, 0xc1, 0x92, 0x32, 0x30, 0xb2, 0xef, 0x30, 0x53,
+    0x19, 0xe1, 0x45, 0xfe, 0xec, 0x55, 0x3b, 0xe8, 0xe3, 0x25, 0x9e, 0x05, 0xb3, 0x41, 0xb6, 0xc3,
+    0xfa, 0x5e, 0xc8, 0x94, 0xe8, 0x1a, 0xeb, 0xf8, 0xe8, 0xee, 0xc3, 0xf7, 0x1e, 0xd6, 0x6a, 0x7f,
+    0xc9, 0x74, 0x0f, 0x2e, 0x04, 0x17, 0xa0, 0x05, 0x3a, 0x8c, 0xd9, 0x12, 0xfb, 0xdc, 0x45, 0x16,
+    0x1b, 0x15, 0x87, 0xeb, 0x9c, 0xdf, 0x1d, 0xd6, 0x7b, 0x4d, 0x8d, 0x65, 0x82, 0x35, 0x33, 0xcb,
+    0xf2, 0x76, 0x5f, 0x40, 0x3d, 0x56, 0x05, 0x3c, 0x4d, 0x30, 0xfb, 0x36, 0xde, 0x41, 0x09, 0xbc,
+    0x92, 0x48, 0x85, 0x92, 0x65, 0x3a, 0x68, 0xc5, 0x39, 0x0f, 0x35, 0xc3, 0xec, 0xa8, 0x2a, 0x0f,
+    0x2c, 0xea, 0x41, 0x42, 0x96, 0x14, 0xe7, 0x8c, 0xb8, 0xeb, 0xd9, 0xa6, 0xd7, 0x85, 0xc7, 0x16,
+    0xc0, 0x86, 0x48, 0xa0, 0x09, 0xcc, 0x21, 0x12, 0x61, 0x9e, 0x62, 0xff, 0xf3, 0x31, 0x79, 0xef,
+    0x12, 0x6a, 0x1e, 0xcf, 0x1e, 0x3e, 0x46, 0xc8, 0xd9, 0x9d, 0x22, 0x1d, 0x4d, 0x7c, 0x9b, 0xab,
+    0xcf, 0x38, 0x07, 0x91, 0xda, 0x73, 0x85, 0xe1, 0xc1, 0x6f, 0xd0, 0x11, 0x77, 0xf0, 0x07, 0x78,
+    0x55, 0x81, 0x78, 0x30, 0x01, 0xaf, 0x5e, 0x31, 0x5e, 0x29, 0xc1, 0xa8, 0x3d, 0x2f, 0x06, 0x27,
+    0xca, 0xb0, 0xf6, 0x20, 0xbf, 0x37, 0xb1, 0x62, 0xcc, 0xe5, 0xb4, 0xf5, 0xb4, 0xb5, 0x5e, 0xd2,
+    0x18, 0xe3, 0xb2, 0xee, 0x14, 0x86, 0x4a, 0xaa, 0x73, 0xc9, 0x21, 0xa6, 0x3a, 0x5c, 0x77, 0xbc,
+    0x41, 0xa1, 0xdf, 0xeb, 0xe2, 0x0d, 0x80, 0xaf, 0xd7, 0x94, 0x77, 0x90, 0x38, 0x13, 0x5c, 0xa1,
+    0x79, 0x01, 0x94, 0xcf, 0xfe, 0x57, 0x25, 0x78, 0xa7, 0x5b, 0x27, 0x8b, 0x08, 0x8e, 0x73, 0x24,
+    0x79, 0xb4, 0x67, 0x50, 0x0b, 0x92, 0x67, 0xfa, 0x86, 0xd7, 0x03, 0xcf, 0x74, 0x07, 0xfc, 0x35,
+    0x94, 0xbe, 0x39, 0xbb, 0xad, 0x5c, 0x69, 0x3c, 0x34, 0xde, 0x9f, 0xef, 0x78, 0xff, 0xf6, 0x99,
+    0xf7, 0x7b, 0x9a, 0x8a, 0x36, 0x63, 0x74, 0x6d, 0x9b, 0x49, 0xa9, 0x51, 0x95, 0x6d, 0xed, 0x96,
+    0x60, 0x20, 0x36, 0xf4, 0xc0, 0xb1, 0xd1, 0xfa, 0xc6, 0x3e, 0x59, 0x95, 0x1f, 0x79, 0x71, 0xbc,
+    0x55, 0x77, 0x28, 0xa3, 0x5e, 0x51, 0x23, 0x5e, 0x77, 0x2f, 0x1f, 0x85, 0x16, 0x7b, 0x77, 0xbb,
+    0x16, 0x4a, 0xdb, 0xd4, 0x98, 0xcc, 0xd4, 0x2f, 0xcc, 0xf6, 0xf3, 0xa2, 0x02, 0x5b, 0x0b, 0xcd,
+    0xf2, 0xed, 0xd5, 0xad, 0x22, 0x69, 0x96, 0x50, 0x65, 0x34, 0x40, 0xf9, 0xdc, 0xa9, 0x54, 0x15,
+    0x34, 0xa9, 0xbd, 0x4e, 0x55, 0xd7, 0x7b, 0x51, 0x5f, 0x55, 0x3e, 0xfb, 0x3a, 0x1d, 0x23, 0x14,
+    0x72, 0x2b, 0x32, 0x27, 0xdb, 0x34, 0x62, 0xab, 0xb5, 0xb3, 0x77, 0x9d, 0x29, 0x89, 0xed, 0x07,
+    0xe3, 0x7b, 0xb5, 0xb8, 0x7e, 0x73, 0x61, 0xc3, 0x6b, 0x27, 0x33, 0x27, 0x89, 0xd7, 0x35, 0x9c,
+    0x5b, 0x9b, 0x1c, 0x2c, 0x8d, 0x80, 0xe2, 0xe8, 0xa9, 0x6b, 0x40, 0x3c, 0x18, 0xc0, 0x27, 0x93,
+    0x23, 0x03, 0x53, 0x0a, 0x29, 0x95, 0x2b, 0x84, 0x49, 0x2c, 0x45, 0x0a, 0x83, 0x7b, 0x1c, 0x27,
+    0x34, 0x41, 0x0c, 0xc6, 0xa8, 0x84, 0xaa, 0x96, 0xa9, 0x40, 0x33, 0x32, 0x30, 0x42, 0x8f, 0x4f,
+    0xd3, 0x3a, 0xfc, 0xcd, 0x84, 0x30, 0x52, 0x5c, 0x05, 0xb0, 0x18, 0x0a, 0x88, 0xde, 0xd6, 0x4a,
+    0x8d, 0x71, 0xcb, 0xdc, 0x75, 0x70, 0x3e, 0x0c, 0x66, 0x43, 0xf5, 0x0c, 0xcc, 0x0d, 0x87, 0xff,
+    0x06, 0xcc, 0x4f, 0xa5, 0x35, 0xfb, 0x98, 0xfc, 0x99, 0x3d, 0x07, 0x20, 0x6f, 0x4d, 0x78, 0x0e,
+    0xf9, 0xc6, 0xe3, 0x9f, 0x42, 0xde, 0x18, 0x75, 0x10, 0x21, 0x89, 0x25, 0x6b, 0x00, 0x87, 0xb7,
+    0x1d, 0xcc, 0x06, 0x09, 0x56, 0xed, 0xd2, 0x1d, 0xd5, 0x60, 0xb2, 0x33, 0xaf, 0x2b, 0xc2, 0xbc,
+    0x3c, 0xb3, 0x64, 0xe5, 0x10, 0xaf, 0xae, 0xa5, 0x52, 0xcc, 0xde, 0xe0, 0x50, 0xf7, 0x76, 0x5a,
+    0x9b, 0x8b, 0x67, 0x2d, 0xb9, 0x06, 0x05, 0x88, 0x8c, 0x39, 0x70, 0x7a, 0x0f, 0x5f, 0xe8, 0x72,
+    0x21, 0xc2, 0x3b, 0xaa, 0x31, 0x8b, 0x6a, 0x32, 0x18, 0x58, 0x89, 0x22, 0x24, 0x86, 0xd7, 0x2f,
+    0x4b, 0x13, 0x81, 0x54, 0x38, 0x7e, 0xaf, 0x7c, 0xc1, 0x11, 0x49, 0x8a, 0xac, 0x0c, 0x88, 0x4a,
+    0x25, 0x1d, 0xba, 0x41, 0x37, 0xcb, 0x44, 0x18, 0xf9, 0x16, 0x70, 0x48, 0xf1, 0xe7, 0xe2, 0xf2,
+    0xb3, 0x9f, 0x11, 0xa9, 0x68, 0x41, 0xe3, 0x1b, 0xf4, 0xba, 0xb6, 0x61, 0xd2, 0x6a, 0xe9, 0xfc,
+    0x38, 0x4f, 0x92, 0x6e, 0xd5, 0x25, 0x6b, 0x08, 0xb5, 0x28, 0xb7, 0xff, 0x5f, 0x2e, 0xbf, 0xa2,
+    0x17, 0x3e, 0x8e, 0x05, 0x5c, 0x9f, 0x3b, 0x89, 0x4d, 0x9c, 0x65, 0x76, 0xc2, 0xea, 0x10, 0xb6,
+    0x29, 0xaa, 0xcc, 0x0d, 0x13, 0xa1, 0x76, 0x8c, 0x45, 0x4d, 0x06, 0x2c, 0x37, 0x2c, 0xa5, 0x22,
+    0xd7, 0x9d, 0x5a, 0x80, 0x7a, 0xb8, 0x70, 0x0e, 0x87, 0xdd, 0xa9, 0xe1, 0xae, 0x85, 0x70, 0x67,
+    0xcf, 0xb1, 0x66, 0xd6, 0x46, 0x83, 0xc4, 0x15, 0xbc, 0x04, 0xd8, 0x23, 0x7e, 0xbf, 0xad, 0x85,
+    0xc9, 0xef, 0xd5, 0xe5, 0xe2, 0xc6, 0x7b, 0xfa, 0x2f, 0x23, 0x03, 0xf0, 0x7b, 0x4e, 0xea, 0xa2,
+    0x5d, 0xb8, 0x88, 0xa3, 0x61, 0x35, 0xbb, 0xdd, 0xcc, 0xc2, 0x7d, 0xc2, 0xd9, 0xdc, 0xdd, 0x33,
+    0x7a, 0xbb, 0x59, 0xed, 0xd9, 0x2c, 0xb2, 0xff, 0xa7, 0xc9, 0xb5, 0x5d, 0xce, 0xcd, 0x61, 0x37,
+    0x95, 0x9b, 0xa6, 0xe9, 0xe1, 0x91, 0xb3, 0xdd, 0x5b, 0xb0, 0x0c, 0x19, 0x26, 0x57, 0x7e, 0xb8,
+    0xb9, 0xf8, 0x54, 0x75, 0x68, 0xaf, 0x79, 0x1b, 0xb4, 0xcb, 0xe0, 0x83, 0xd2, 0x14, 0x97, 0x41,
+    0xb7, 0x46, 0xe2, 0xc9, 0x2c, 0x93, 0x34, 0xc0, 0x9a, 0x70, 0xbc, 0x16, 0xce, 0x18, 0x3b, 0x64,
+    0x61, 0xf1, 0x83, 0xb5, 0xa8, 0x07, 0x1c, 0xd1, 0x8b, 0xc8, 0xb1, 0xdd, 0x1a, 0x57, 0x29, 0x64,
+    0x28, 0xd6, 0x24, 0xdb, 0xb8, 0x0b, 0x17, 0x2b, 0x4f, 0xa6, 0xad, 0x9d, 0x7a, 0x9c, 0x9a, 0xef,
+    0x13, 0xb7, 0x4a, 0xe1, 0xda, 0x5a, 0x7c, 0x99, 0x0c, 0x8a, 0xbf, 0x1f, 0xfc, 0x03, 0x5c, 0xf6,
+    0x89, 0x1e, 0x57, 0x10, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    { "/", "text/html", WEB_ASSET_INDEX_HTML, sizeof(WEB_ASSET_INDEX_HTML), "\"802bb45b4c3b97a6\"" },
+};
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
+
+#endif // WEBASSETS_H
@@ -0,0 +1,151 @@
+#include "WebResponsePool.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+static const char* TAG = "WebResponsePool";
+
+/**
+ * Response that streams a pool slot and gives it back when destroyed
+ */
+class PooledResponse : public AsyncAbstractResponse {
+private:
+    WebResponsePool& pool;
+    char* buffer;
+    size_t sent;
+
+public:
+    PooledResponse(WebResponsePool& owner, char* slot, size_t length, int code, const char* contentType)
+        : pool(owner), buffer(slot), sent(0) {
+        _code = code;
+        _contentType = contentType;
+        _contentLength = length;
+    }
+
+    ~PooledResponse() {
+        pool.release(buffer);
+    }
+
+    bool _sourceValid() const override {
+        return buffer != nullptr;
+    }
+
+    size_t _fillBuffer(uint8_t* data, size_t maxLen) override {
+        size_t remaining = _contentLength - sent;
+        size_t toCopy = remaining < maxLen ? remaining : maxLen;
+        memcpy(data, buffer + sent, toCopy);
+        sent += toCopy;
+        return toCopy;
+    }
+};
+
+WebResponsePool::WebResponsePool() {
+    storage = nullptr;
+    slotBytes = 0;
+    slotCount = 0;
+    exhaustedCount = 0;
+    lastRenderHeapDelta = 0;
+    maxRenderHeapDelta = 0;
+    for (size_t i = 0; i < MAX_SLOTS; i++) {
+        inUse[i] = false;
+        heapAtAcquire[i] = 0;
+    }
+}
+
+WebResponsePool::~WebResponsePool() {
+    if (storage) {
+        heap_caps_free(storage);
+        storage = nullptr;
+    }
+}
+
+bool WebResponsePool::begin(size_t slots, size_t bytesPerSlot) {
+    if (storage) {
+        ESP_LOGW(TAG, "WebResponsePool already initialized");
+        return true;
+    }
+
+    if (slots == 0 || slots > MAX_SLOTS || bytesPerSlot == 0) {
+        ESP_LOGE(TAG, "Invalid pool: %d slots of %d bytes", slots, bytesPerSlot);
+        return false;
+    }
+
+    size_t total = slots * bytesPerSlot;
+    bool inPSRAM = false;
+    if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0) {
+        storage = (char*)heap_caps_malloc(total, MALLOC_CAP_SPIRAM);
+        inPSRAM = (storage != nullptr);
+    }
+    if (!storage) {
+        storage = (char*)heap_caps_malloc(total, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!storage) {
+        ESP_LOGE(TAG, "Failed to allocate %d bytes for response slots", total);
+        return false;
+    }
+
+    slotCount = slots;
+    slotBytes = bytesPerSlot;
+    ESP_LOGI(TAG, "Response pool: %d slots x %d bytes (%s)", slotCount, slotBytes,
+             inPSRAM ? "PSRAM" : "internal");
+    return true;
+}
+
+char* WebResponsePool::acquire(size_t& capacity) {
+    for (size_t i = 0; i < slotCount; i++) {
+        bool expected = false;
+        if (inUse[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            capacity = slotBytes;
+            heapAtAcquire[i] = ESP.getFreeHeap();
+            return storage + i * slotBytes;
+        }
+    }
+
+    exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+    capacity = 0;
+    return nullptr;
+}
+
+void WebResponsePool::release(char* buffer) {
+    size_t index = slotIndex(buffer);
+    if (index < slotCount) {
+        inUse[index].store(false, std::memory_order_release);
+    }
+}
+
+AsyncWebServerResponse* WebResponsePool::beginResponse(char* buffer, size_t length, int code, const char* contentType) {
+    // Heap taken between acquire() and now was spent rendering (other tasks
+    // allocating concurrently show up here too, so watch the trend)
+    size_t index = slotIndex(buffer);
+    if (index < slotCount) {
+        int32_t delta = (int32_t)heapAtAcquire[index] - (int32_t)ESP.getFreeHeap();
+        lastRenderHeapDelta.store(delta, std::memory_order_relaxed);
+        if (delta > maxRenderHeapDelta.load(std::memory_order_relaxed)) {
+            maxRenderHeapDelta.store(delta, std::memory_order_relaxed);
+        }
+    }
+
+    return new PooledResponse(*this, buffer, length, code, contentType);
+}
+
+void WebResponsePool::sendBusy(AsyncWebServerRequest* request) {
+    AsyncWebServerResponse* response = request->beginResponse(503, "text/plain", "Server busy");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
+}
+
+size_t WebResponsePool::slotIndex(const char* buffer) const {
+    if (!buffer || !storage || buffer < storage) {
+        return MAX_SLOTS;
+    }
+    return (buffer - storage) / slotBytes;
+}
+
+size_t WebResponsePool::getInUseCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < slotCount; i++) {
+        if (inUse[i].load(std::memory_order_relaxed)) {
+            count++;
+        }
+    }
+    return count;
+}
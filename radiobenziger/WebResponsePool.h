@@ -0,0 +1,121 @@
+#ifndef WEBRESPONSEPOOL_H
+#define WEBRESPONSEPOOL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <ESPAsyncWebServer.h>
+#include "JsonWriter.h"
+
+/**
+ * WebResponsePool - Fixed set of response buffers for the async web server
+ *
+ * Dynamic responses (/status, /metrics) are rendered into one of a small
+ * number of slots allocated once at boot. A slot stays owned by its response
+ * until the last byte has been handed to lwIP and the response is destroyed,
+ * so concurrent clients never share a buffer and the control plane's memory
+ * use is bounded no matter how many dashboards are open. When every slot is
+ * busy the caller answers 503 instead of allocating more.
+ *
+ * Slots live in PSRAM when available; lwIP copies out of them, so they do
+ * not need to be DMA-capable.
+ *
+ * The pool also records how much heap each render consumed (free heap at
+ * acquire() versus at beginResponse()), which should stay at zero.
+ */
+class WebResponsePool {
+public:
+    static const size_t MAX_SLOTS = 8;
+
+private:
+    char* storage;
+    size_t slotBytes;
+    size_t slotCount;
+    std::atomic<bool> inUse[MAX_SLOTS];
+    std::atomic<uint32_t> exhaustedCount;
+    uint32_t heapAtAcquire[MAX_SLOTS];
+    std::atomic<int32_t> lastRenderHeapDelta;
+    std::atomic<int32_t> maxRenderHeapDelta;
+
+    size_t slotIndex(const char* buffer) const;
+
+public:
+    WebResponsePool();
+    ~WebResponsePool();
+
+    /**
+     * Allocate all slots
+     *
+     * @param slots Number of responses that may be in flight at once (max MAX_SLOTS)
+     * @param bytesPerSlot Largest response body that can be rendered
+     * @return true if the slots were allocated
+     */
+    bool begin(size_t slots, size_t bytesPerSlot);
+
+    /**
+     * Claim a free slot
+     *
+     * @param capacity Set to the slot size in bytes
+     * @return Slot buffer, or nullptr if every slot is in use
+     */
+    char* acquire(size_t& capacity);
+
+    /**
+     * Return a slot obtained from acquire() without sending it
+     */
+    void release(char* buffer);
+
+    /**
+     * Wrap a rendered slot in a response. The response takes ownership of
+     * the slot and releases it when it is destroyed.
+     *
+     * @param buffer Slot returned by acquire()
+     * @param length Number of rendered bytes
+     * @param code HTTP status code
+     * @param contentType MIME type
+     */
+    AsyncWebServerResponse* beginResponse(char* buffer, size_t length, int code, const char* contentType);
+
+    /**
+     * Render a JSON response into a slot and send it
+     *
+     * @param request Request to answer
+     * @param code HTTP status code
+     * @param write Callable taking JsonWriter& that writes the whole document
+     */
+    template <typename Writer>
+    void sendJson(AsyncWebServerRequest* request, int code, Writer write) {
+        size_t capacity;
+        char* buffer = acquire(capacity);
+        if (!buffer) {
+            sendBusy(request);
+            return;
+        }
+
+        JsonWriter json(buffer, capacity);
+        write(json);
+        if (json.overflowed()) {
+            release(buffer);
+            request->send(500, "text/plain", "Response too large");
+            return;
+        }
+        request->send(beginResponse(buffer, json.length(), code, "application/json"));
+    }
+
+    /**
+     * Answer 503 with Retry-After (used when acquire() fails)
+     */
+    static void sendBusy(AsyncWebServerRequest* request);
+
+    size_t getSlotCount() const { return slotCount; }
+    size_t getSlotBytes() const { return slotBytes; }
+    size_t getInUseCount() const;
+    uint32_t getExhaustedCount() const { return exhaustedCount.load(std::memory_order_relaxed); }
+
+    /**
+     * Heap consumed while rendering into a slot (bytes, last and worst seen)
+     */
+    int32_t getLastRenderHeapDelta() const { return lastRenderHeapDelta.load(std::memory_order_relaxed); }
+    int32_t getMaxRenderHeapDelta() const { return maxRenderHeapDelta.load(std::memory_order_relaxed); }
+};
+
+#endif // WEBRESPONSEPOOL_H
@@ -5,8 +5,25 @@
 WiFiManager::Status WiFiManager::currentStatus = DISCONNECTED;
 unsigned long WiFiManager::lastConnectionAttempt = 0;
 unsigned long WiFiManager::connectionTimeout = 15000; // Increased timeout
+unsigned long WiFiManager::nextAttemptTime = 0;
+uint32_t WiFiManager::consecutiveFailures = 0;
 bool WiFiManager::configModeActive = false;
+bool WiFiManager::credentialsPending = false;
+char WiFiManager::pendingSSID[sizeof(Config::Settings::wifiSSID)] = "";
+char WiFiManager::pendingPassword[sizeof(Config::Settings::wifiPassword)] = "";
+std::atomic<uint32_t> WiFiManager::pendingEvents(0);
+std::atomic<uint8_t> WiFiManager::lastDisconnectReason(0);
+bool WiFiManager::releasing = false;
+const char* WiFiManager::attemptSSID = "";
+const char* WiFiManager::attemptPassword = "";
+std::atomic<uint32_t> WiFiManager::pendingRequests(0);
+portMUX_TYPE WiFiManager::requestLock = portMUX_INITIALIZER_UNLOCKED;
+char WiFiManager::requestedSSID[sizeof(Config::Settings::wifiSSID)] = "";
+char WiFiManager::requestedPassword[sizeof(Config::Settings::wifiPassword)] = "";
 const unsigned long WiFiManager::CONNECT_TIMEOUT_MS = 15000;
+const uint32_t WiFiManager::RETRY_BASE_MS = 500;
+const uint32_t WiFiManager::RETRY_MAX_MS = 8000;
+const uint32_t WiFiManager::RELEASE_TIMEOUT_MS = 1000;
 const char* WiFiManager::CONFIG_AP_SSID = "RadioBenziger-Config";
 
 bool WiFiManager::begin() {
@@ -14,14 +31,19 @@ bool WiFiManager::begin() {
     
     // Set WiFi mode to station
     WiFi.mode(WIFI_STA);
-    WiFi.setAutoReconnect(true);
-    WiFi.persistent(true); // Enable WiFi credential persistence
+    
+    // Reconnects are scheduled by update(); credentials live in Config, so the
+    // driver does not need to rewrite its own NVS copy on every attempt
+    WiFi.setAutoReconnect(false);
+    WiFi.persistent(false);
     
     // Set event handler
     WiFi.onEvent(onWiFiEvent);
     
     currentStatus = DISCONNECTED;
     configModeActive = false;
+    consecutiveFailures = 0;
+    nextAttemptTime = millis();
     
     Serial.println("WiFiManager: Initialized successfully");
     return true;
@@ -35,101 +57,27 @@ bool WiFiManager::connectToSaved() {
         return false;
     }
     
-    Serial.printf("WiFiManager: Connecting to saved WiFi: %s\n", Config::settings.wifiSSID);
-    
     // Stop any existing AP mode
-    if (configModeActive) {
-        stopConfigMode();
-        delay(1000); // Allow time for mode switch
-    }
-    
-    // Ensure we're in STA mode
-    WiFi.mode(WIFI_STA);
-    delay(100);
-    
-    currentStatus = CONNECTING;
-    lastConnectionAttempt = millis();
+    leaveConfigMode();
     
-    // Start connection
-    WiFi.begin(Config::settings.wifiSSID, Config::settings.wifiPassword);
-    
-    // Wait for connection with timeout
-    Serial.print("WiFiManager: Connecting");
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < CONNECT_TIMEOUT_MS) {
-        delay(500);
-        Serial.print(".");
-        
-        // Check every 2 seconds
-        if ((millis() - startTime) % 2000 == 0) {
-            Serial.printf(" [%d] ", WiFi.status());
-        }
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println();
-        Serial.printf("WiFiManager: Connected successfully! IP: %s\n", WiFi.localIP().toString().c_str());
-        currentStatus = CONNECTED;
-        return true;
-    } else {
-        Serial.println();
-        Serial.printf("WiFiManager: Connection failed. Status: %d\n", WiFi.status());
-        currentStatus = FAILED;
-        return false;
-    }
+    credentialsPending = false;
+    consecutiveFailures = 0;
+    startAttempt(Config::settings.wifiSSID, Config::settings.wifiPassword);
+    return true;
 }
 
 bool WiFiManager::connectToWiFi(const char* ssid, const char* password) {
-    Serial.printf("WiFiManager: Connecting to new WiFi: %s\n", ssid);
-    
-    // Stop config mode if active
-    if (configModeActive) {
-        stopConfigMode();
-        delay(1000);
-    }
-    
-    // Ensure we're in STA mode
-    WiFi.mode(WIFI_STA);
-    delay(100);
-    
-    currentStatus = CONNECTING;
-    lastConnectionAttempt = millis();
-    
-    // Start connection
-    WiFi.begin(ssid, password);
-    
-    // Wait for connection with timeout
-    Serial.print("WiFiManager: Connecting");
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < CONNECT_TIMEOUT_MS) {
-        delay(500);
-        Serial.print(".");
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println();
-        Serial.printf("WiFiManager: Connected successfully! IP: %s\n", WiFi.localIP().toString().c_str());
-        currentStatus = CONNECTED;
-        
-        // Save credentials if connection successful
-        strncpy(Config::settings.wifiSSID, ssid, sizeof(Config::settings.wifiSSID) - 1);
-        strncpy(Config::settings.wifiPassword, password, sizeof(Config::settings.wifiPassword) - 1);
-        Config::settings.wifiSSID[sizeof(Config::settings.wifiSSID) - 1] = '\0';
-        Config::settings.wifiPassword[sizeof(Config::settings.wifiPassword) - 1] = '\0';
-        
-        if (Config::save()) {
-            Serial.println("WiFiManager: Credentials saved successfully");
-        } else {
-            Serial.println("WiFiManager: WARNING - Failed to save credentials");
-        }
-        
-        return true;
-    } else {
-        Serial.println();
-        Serial.printf("WiFiManager: Connection failed. Status: %d\n", WiFi.status());
-        currentStatus = FAILED;
+    if (!ssid || ssid[0] == '\0') {
         return false;
     }
+    
+    // Applied by update(); a later request replaces one not yet applied
+    portENTER_CRITICAL(&requestLock);
+    strlcpy(requestedSSID, ssid, sizeof(requestedSSID));
+    strlcpy(requestedPassword, password ? password : "", sizeof(requestedPassword));
+    portEXIT_CRITICAL(&requestLock);
+    pendingRequests.fetch_or(REQUEST_CONNECT);
+    return true;
 }
 
 void WiFiManager::startConfigMode() {
@@ -137,10 +85,10 @@ void WiFiManager::startConfigMode() {
     
     // Disconnect from any existing WiFi
     WiFi.disconnect(true);
-    delay(1000);
     
     setupConfigAP();
     configModeActive = true;
+    credentialsPending = false;
     currentStatus = HOTSPOT_MODE;
     
     Serial.printf("WiFiManager: Access Point started: %s\n", CONFIG_AP_SSID);
@@ -148,21 +96,11 @@ void WiFiManager::startConfigMode() {
 }
 
 void WiFiManager::stopConfigMode() {
-    if (configModeActive) {
-        Serial.println("WiFiManager: Stopping configuration mode...");
-        WiFi.softAPdisconnect(true);
-        delay(500);
-        WiFi.mode(WIFI_STA);
-        delay(500);
-        configModeActive = false;
-        currentStatus = DISCONNECTED;
-        Serial.println("WiFiManager: Configuration mode stopped");
-    }
+    pendingRequests.fetch_or(REQUEST_STOP_CONFIG);
 }
 
 void WiFiManager::setupConfigAP() {
     WiFi.mode(WIFI_AP);
-    delay(100);
     
     // Start AP with no password for easy access
     bool result = WiFi.softAP(CONFIG_AP_SSID, "", 1, 0, 4);
@@ -175,33 +113,65 @@ void WiFiManager::setupConfigAP() {
 }
 
 void WiFiManager::update() {
-    static unsigned long lastReconnectAttempt = 0;
-    const unsigned long RECONNECT_INTERVAL = 30000; // Try reconnect every 30 seconds
+    applyRequests();
     
-    // Handle connection timeout
-    if (currentStatus == CONNECTING && (millis() - lastConnectionAttempt) > connectionTimeout) {
-        currentStatus = FAILED;
-        Serial.println("WiFiManager: Connection timeout");
+    uint32_t events = pendingEvents.exchange(0);
+    if (configModeActive) {
+        return;
     }
     
-    // Auto-reconnect logic if we have credentials and we're not in config mode
-    if (!configModeActive && currentStatus != CONNECTED && currentStatus != CONNECTING) {
-        if (Config::hasWiFiCredentials() && (millis() - lastReconnectAttempt) > RECONNECT_INTERVAL) {
-            Serial.println("WiFiManager: Attempting auto-reconnect...");
-            lastReconnectAttempt = millis();
-            connectToSaved();
-        }
-    }
+    unsigned long now = millis();
     
-    // Update status based on actual WiFi state
-    if (!configModeActive) {
-        if (WiFi.status() == WL_CONNECTED && currentStatus != CONNECTED) {
-            currentStatus = CONNECTED;
-            Serial.println("WiFiManager: Connection established");
-        } else if (WiFi.status() != WL_CONNECTED && currentStatus == CONNECTED) {
-            currentStatus = DISCONNECTED;
-            Serial.println("WiFiManager: Connection lost");
-        }
+    switch (currentStatus) {
+        case CONNECTING:
+            if (releasing) {
+                // The old association is down (or never reported going down)
+                if ((events & EVENT_DISCONNECTED) || now - lastConnectionAttempt > RELEASE_TIMEOUT_MS) {
+                    beginAttempt();
+                }
+            } else if ((events & EVENT_GOT_IP) && WiFi.status() == WL_CONNECTED) {
+                currentStatus = CONNECTED;
+                consecutiveFailures = 0;
+                Serial.printf("WiFiManager: Connected in %lu ms, IP: %s\n",
+                              now - lastConnectionAttempt, WiFi.localIP().toString().c_str());
+                commitPendingCredentials();
+            } else if (events & EVENT_DISCONNECTED) {
+                char why[40];
+                snprintf(why, sizeof(why), "Association failed (reason %u)", (unsigned)lastDisconnectReason.load());
+                scheduleRetry(why);
+            } else if (now - lastConnectionAttempt > connectionTimeout) {
+                WiFi.disconnect();
+                scheduleRetry("Connection timeout");
+            }
+            break;
+        
+        case CONNECTED:
+            // Both bits can be set if the link flapped between two updates
+            if ((events & EVENT_DISCONNECTED) && WiFi.status() != WL_CONNECTED) {
+                char why[40];
+                snprintf(why, sizeof(why), "Connection lost (reason %u)", (unsigned)lastDisconnectReason.load());
+                scheduleRetry(why);
+            }
+            break;
+        
+        case DISCONNECTED:
+        case FAILED:
+            if (events & EVENT_GOT_IP) {
+                // Associated without us asking (e.g. a late DHCP lease)
+                currentStatus = CONNECTED;
+                consecutiveFailures = 0;
+                Serial.println("WiFiManager: Connection established");
+            } else if ((long)(now - nextAttemptTime) >= 0) {
+                if (credentialsPending) {
+                    startAttempt(pendingSSID, pendingPassword);
+                } else if (Config::hasWiFiCredentials()) {
+                    startAttempt(Config::settings.wifiSSID, Config::settings.wifiPassword);
+                }
+            }
+            break;
+        
+        default:
+            break;
     }
 }
 
@@ -249,27 +219,125 @@ bool WiFiManager::getScannedEncryption(int index) {
     return WiFi.encryptionType(index) != WIFI_AUTH_OPEN;
 }
 
-void WiFiManager::onWiFiEvent(WiFiEvent_t event) {
+// Private methods implementation
+
+void WiFiManager::applyRequests() {
+    uint32_t requests = pendingRequests.exchange(0);
+    
+    if (requests & (REQUEST_STOP_CONFIG | REQUEST_CONNECT)) {
+        leaveConfigMode();
+    }
+    
+    if (requests & REQUEST_CONNECT) {
+        // Saved by update() once the network has given us an address
+        portENTER_CRITICAL(&requestLock);
+        memcpy(pendingSSID, requestedSSID, sizeof(pendingSSID));
+        memcpy(pendingPassword, requestedPassword, sizeof(pendingPassword));
+        portEXIT_CRITICAL(&requestLock);
+        credentialsPending = true;
+        
+        consecutiveFailures = 0;
+        startAttempt(pendingSSID, pendingPassword);
+    }
+}
+
+void WiFiManager::leaveConfigMode() {
+    if (configModeActive) {
+        Serial.println("WiFiManager: Stopping configuration mode...");
+        WiFi.softAPdisconnect(true);
+        WiFi.mode(WIFI_STA);
+        configModeActive = false;
+        currentStatus = DISCONNECTED;
+        
+        // Rejoin the saved network on the next update()
+        consecutiveFailures = 0;
+        nextAttemptTime = millis();
+        Serial.println("WiFiManager: Configuration mode stopped");
+    }
+}
+
+void WiFiManager::startAttempt(const char* ssid, const char* password) {
+    Serial.printf("WiFiManager: Connecting to %s (attempt %u)\n", ssid, (unsigned)consecutiveFailures + 1);
+    
+    // An association that is up or still being set up reports
+    // STA_DISCONNECTED when it is torn down. Clearing events cannot drop a
+    // report that has not arrived yet, and update() would take it for this
+    // attempt failing, so begin only once the old link has gone.
+    bool linkBusy = currentStatus == CONNECTING || WiFi.status() == WL_CONNECTED;
+    
+    WiFi.mode(WIFI_STA);
+    currentStatus = CONNECTING;
+    lastConnectionAttempt = millis();
+    attemptSSID = ssid;
+    attemptPassword = password;
+    
+    if (linkBusy) {
+        releasing = true;
+        WiFi.disconnect();
+        return;
+    }
+    beginAttempt();
+}
+
+void WiFiManager::beginAttempt() {
+    releasing = false;
+    lastConnectionAttempt = millis();
+    
+    // Nothing from an earlier association can still be on its way
+    pendingEvents.store(0);
+    WiFi.begin(attemptSSID, attemptPassword);
+}
+
+void WiFiManager::scheduleRetry(const char* why) {
+    consecutiveFailures++;
+    
+    // New credentials that never worked fall back to the saved network
+    if (credentialsPending) {
+        Serial.printf("WiFiManager: Could not join %s, keeping saved network\n", pendingSSID);
+        credentialsPending = false;
+    }
+    
+    // Equal jitter: half the backoff window is fixed, half random
+    uint32_t shift = consecutiveFailures - 1 < 8 ? consecutiveFailures - 1 : 8;
+    uint32_t window = RETRY_BASE_MS << shift;
+    if (window > RETRY_MAX_MS) {
+        window = RETRY_MAX_MS;
+    }
+    uint32_t delayMs = window / 2 + esp_random() % (window / 2 + 1);
+    
+    nextAttemptTime = millis() + delayMs;
+    currentStatus = FAILED;
+    Serial.printf("WiFiManager: %s, retrying in %u ms\n", why, (unsigned)delayMs);
+}
+
+void WiFiManager::commitPendingCredentials() {
+    if (!credentialsPending) {
+        return;
+    }
+    credentialsPending = false;
+    
+    // Written behind, outside the connect path and away from audio playback
+    Config::modify([](Config::Settings& settings) {
+        strlcpy(settings.wifiSSID, pendingSSID, sizeof(settings.wifiSSID));
+        strlcpy(settings.wifiPassword, pendingPassword, sizeof(settings.wifiPassword));
+    });
+    Serial.println("WiFiManager: Credentials queued for saving");
+}
+
+// Runs on the arduino_events task: record only, update() acts on it
+void WiFiManager::onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
     switch (event) {
         case ARDUINO_EVENT_WIFI_STA_CONNECTED:
             Serial.println("WiFiManager: Event - WiFi connected");
-            if (!configModeActive) {
-                currentStatus = CONNECTED;
-            }
             break;
         case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
-            Serial.println("WiFiManager: Event - WiFi disconnected");
-            if (currentStatus == CONNECTED && !configModeActive) {
-                currentStatus = DISCONNECTED;
-            }
+            lastDisconnectReason.store(info.wifi_sta_disconnected.reason);
+            pendingEvents.fetch_or(EVENT_DISCONNECTED);
             break;
         case ARDUINO_EVENT_WIFI_STA_GOT_IP:
-            Serial.printf("WiFiManager: Event - Got IP: %s\n", WiFi.localIP().toString().c_str());
-            if (!configModeActive) {
-                currentStatus = CONNECTED;
-            }
+            pendingEvents.fetch_or(EVENT_GOT_IP);
             break;
         default:
             break;
     }
-} 
\ No newline at end of file
+}
@@ -3,16 +3,34 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <atomic>
 #include "Config.h"
 
+/**
+ * WiFiManager - Non-blocking station/AP state machine
+ *
+ * Nothing here waits for the radio. connect*() and the mode switches only
+ * start an operation; onWiFiEvent (arduino_events task) records what the
+ * driver reported, and update() (loop task) advances the state from those
+ * events and from timeouts.
+ *
+ * connectToWiFi() and stopConfigMode() may be called from any task (web
+ * handlers): they post a request that the next update() carries out.
+ * Everything else belongs to the loop task.
+ *
+ * Lost links and failed attempts are retried with jittered exponential
+ * backoff (RETRY_BASE_MS doubling up to RETRY_MAX_MS), so a rebooted
+ * access point is rejoined within seconds of coming back, without a fleet
+ * of receivers retrying in lockstep.
+ */
 class WiFiManager {
 public:
     enum Status {
-        DISCONNECTED,
-        CONNECTING,
-        CONNECTED,
-        HOTSPOT_MODE,
-        FAILED
+        DISCONNECTED,   // Not associated; connects when credentials exist
+        CONNECTING,     // Association/DHCP in progress
+        CONNECTED,      // Station has an IP address
+        HOTSPOT_MODE,   // Configuration AP running
+        FAILED          // Last attempt failed; a retry is scheduled
     };
 
     static bool begin();
@@ -27,6 +45,8 @@ public:
     static Status getStatus();
     static void update();
     
+    static uint32_t getConsecutiveFailures() { return consecutiveFailures; }
+    
     // Network scanning
     static int scanNetworks();
     static String getScannedSSID(int index);
@@ -34,15 +54,51 @@ public:
     static bool getScannedEncryption(int index);
 
 private:
+    // Raised by onWiFiEvent, consumed by update()
+    enum EventBits : uint32_t {
+        EVENT_GOT_IP = 1u << 0,
+        EVENT_DISCONNECTED = 1u << 1
+    };
+    
+    // Raised by connectToWiFi()/stopConfigMode(), applied by update()
+    enum RequestBits : uint32_t {
+        REQUEST_CONNECT = 1u << 0,
+        REQUEST_STOP_CONFIG = 1u << 1
+    };
+    
     static Status currentStatus;
     static unsigned long lastConnectionAttempt;
     static unsigned long connectionTimeout;
+    static unsigned long nextAttemptTime;
+    static uint32_t consecutiveFailures;
     static bool configModeActive;
+    static bool credentialsPending;           // Save on success (connectToWiFi)
+    static char pendingSSID[sizeof(Config::Settings::wifiSSID)];
+    static char pendingPassword[sizeof(Config::Settings::wifiPassword)];
+    static std::atomic<uint32_t> pendingEvents;
+    static std::atomic<uint8_t> lastDisconnectReason;
+    static bool releasing;                    // Waiting for the old association to go down
+    static const char* attemptSSID;           // Network of the attempt in progress
+    static const char* attemptPassword;
+    static std::atomic<uint32_t> pendingRequests;
+    static portMUX_TYPE requestLock;          // Guards the requested credentials
+    static char requestedSSID[sizeof(Config::Settings::wifiSSID)];
+    static char requestedPassword[sizeof(Config::Settings::wifiPassword)];
+    
     static const unsigned long CONNECT_TIMEOUT_MS;
+    static const uint32_t RETRY_BASE_MS;
+    static const uint32_t RETRY_MAX_MS;
+    static const uint32_t RELEASE_TIMEOUT_MS;
     static const char* CONFIG_AP_SSID;
     
-    static void onWiFiEvent(WiFiEvent_t event);
+    static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
     static void setupConfigAP();
+    static void applyRequests();
+    static void leaveConfigMode();
+    static void startAttempt(const char* ssid, const char* password);
+    static void beginAttempt();
+    static void scheduleRetry(const char* why);
+    static void commitPendingCredentials();
 };
 
-#endif // WIFIMANAGER_H 
\ No newline at end of file
+#endif // WIFIMANAGER_H
@@ -1,70 +1,92 @@
 #include <WiFi.h>
-#include <WebServer.h>
+#include <ESPAsyncWebServer.h>
 #include <HTTPClient.h>
 #include <NetworkClientSecure.h>
 #include <Preferences.h>
 #include <EEPROM.h>
 #include <vector>
 #include <cmath>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include <esp_timer.h>
 
 #include "Config.h"
 #include "WiFiManager.h"
 #include "PCMStreamer.h"
+#include "TieredAudioBuffer.h"
+#include "AudioArena.h"
+#include "AudioHot.h"
+#include "TaskProfiler.h"
+#include "PipelineMetrics.h"
+#include "WebAssets.h"
+#include "WebResponsePool.h"
+#include "StatusPusher.h"
+#include "JsonWriter.h"
+#include "TelemetryEmitter.h"
+#include "BufferPrintf.h"
+#include "BootTimeline.h"
+#include "SyncProtocol.h"
+#include "PlayoutScheduler.h"
+#include "RelayClock.h"
+#include "RtpReceiver.h"
+#include "StreamEndpoint.h"
+#include "RelayDirectory.h"
+#include "StandbyRelay.h"
 
 // Global objects
 Config config;
 WiFiManager wifiManager;
-WebServer server(80);
-PCMStreamer* audioStreamer = nullptr;
+AsyncWebServer server(80);
+WebResponsePool responsePool;          // Short JSON replies
+WebResponsePool reportPool;            // /metrics and /status
+AsyncWebSocket statusSocket("/ws");
+StatusPusher statusPusher(statusSocket);
+PCMStreamer* audioStreamer = nullptr;  // Constructed in the audio arena
 
 // Connection state
-bool isConnected = false;
+std::atomic<bool> isConnected(false);        // Set from the arduino_events task
 bool audioInitialized = false;
+bool bootConnectPending = false;   // Boot-time association not resolved yet
+std::atomic<bool> autoStartPending(false);   // loop() starts streaming once the IP is acquired
 
 // Audio streaming parameters - Optimized for WiFi resilience
-const size_t AUDIO_BUFFER_QUEUE_SIZE = 20;     // Large buffer for WiFi interruptions (1 second total)
 const size_t AUDIO_CHUNK_SAMPLES = 1600;       // Larger chunks (50ms at 32kHz)
+const size_t AUDIO_CHUNK_BYTES = AUDIO_CHUNK_SAMPLES * sizeof(int16_t);
 const size_t AUDIO_CHUNK_DURATION_MS = 50;     // 50ms per chunk
+const size_t AUDIO_BYTES_PER_SECOND = 32000 * sizeof(int16_t);
+const size_t AUDIO_STAGING_SLOTS = 2;          // DMA-capable internal ring feeding I2S
+const size_t AUDIO_RESERVOIR_INTERNAL = 64 * 1024;  // ~1 second without PSRAM
+const size_t AUDIO_RESERVOIR_PSRAM = 512 * 1024;    // ~8 seconds when PSRAM is present
+const size_t AUDIO_PREBUFFER_MS = 750;         // Buffered audio required before playback starts
 const size_t HTTP_BUFFER_SIZE = 6400;          // Larger HTTP buffer (4x chunk size)
+const uint32_t AUDIO_TASK_STACK_BYTES = 12288;      // Increased stack size for Core 0 (was 8192)
+const uint32_t STREAMING_TASK_STACK_BYTES = 16384;  // Increased stack size for HTTP + pre-buffering
+const size_t WEB_RESPONSE_SLOTS = 4;           // Short JSON replies in flight at once
+const size_t WEB_RESPONSE_SLOT_BYTES = 2048;   // Settings echoes and errors, a few hundred bytes
+const size_t REPORT_RESPONSE_SLOTS = 1;        // /metrics and /status take turns
+const size_t REPORT_RESPONSE_SLOT_BYTES = 10240;  // /metrics: ~8.9 KB worst case (tools/metrics_budget.py), plus margin
+const size_t STATUS_FRAME_BYTES = 512;         // Largest /ws status frame
+const size_t CONFIG_COMMIT_HEADROOM_MS = 500;  // Buffered audio needed to ride out a flash write
+const uint32_t TELEMETRY_MAX_INTERVAL_MS = 86400000;   // Longest accepted POST /telemetry interval (1 day)
+const uint32_t WIFI_BOOT_ATTEMPTS = 5;         // Failed boot attempts (~20 s with backoff) before the config AP
+const uint32_t I2S_DMA_BUFFER_SAMPLES = 1024;  // Samples per I2S DMA buffer
+const uint32_t I2S_DMA_BUFFER_COUNT = 8;       // DMA buffers (~256ms queued in I2S)
 
-// PCM streaming configuration
-const char* PCM_SERVER_HOST = "192.168.1.189"; // Update with your server IP (find with: ip addr show)
-const int PCM_SERVER_PORT = 8080;
-const char* PCM_STREAM_PATH = "/stream";
+// Synchronized playback (relay started with --sync)
+const uint32_t SYNC_TOLERANCE_US = 1000;       // Largest playout error left uncorrected
+const size_t SYNC_PIECE_SAMPLES = 32;          // Calibration write size (1ms): bounds the output clock error
+const int64_t SYNC_BLOCKED_WRITE_US = 250;     // A piece this slow waited for a DMA buffer
+const uint32_t SYNC_CALIBRATION_MS = 250;      // Output clock re-measured this often
 
-// Audio buffer structure with fixed-size array (safer for FreeRTOS queues)
-struct AudioBuffer {
-    int16_t samples[AUDIO_CHUNK_SAMPLES]; // Fixed size: mono samples from server
-    size_t sampleCount;
-    bool isValid;
-    bool isSilence;
-    
-    AudioBuffer() : sampleCount(0), isValid(false), isSilence(true) {
-        memset(samples, 0, sizeof(samples));
-    }
-    
-    AudioBuffer(const int16_t* data, size_t count) : 
-        sampleCount(count), isValid(true), isSilence(false) {
-        memset(samples, 0, sizeof(samples));
-        if (count <= sizeof(samples)/sizeof(samples[0])) {
-            memcpy(samples, data, count * sizeof(int16_t));
-        }
-    }
-    
-    // Create silence buffer
-    static AudioBuffer createSilence() {
-        AudioBuffer buffer;
-        buffer.sampleCount = AUDIO_CHUNK_SAMPLES;
-        buffer.isValid = true;
-        buffer.isSilence = true;
-        memset(buffer.samples, 0, sizeof(buffer.samples));
-        return buffer;
-    }
-};
+// RTP multicast (stream URL rtp://group[:port], relay started with --multicast)
+const size_t RTP_PREBUFFER_MS = 300;           // Covers multicast held back until the next DTIM beacon
+const size_t RTP_HIGH_WATER_MS = 900;          // Above this the relay clock is outrunning the DAC: drop
+const uint32_t RTP_POLL_MS = 5;
+
+// Tiered audio buffer: PSRAM reservoir (when present) + DMA-capable staging ring
+TieredAudioBuffer audioBuffer;
 
 // Streaming control variables
 bool streamingActive = false;
@@ -74,79 +96,176 @@ SemaphoreHandle_t streamingMutex = nullptr;
 // Task handles
 TaskHandle_t audioTaskHandle = nullptr;
 TaskHandle_t streamingTaskHandle = nullptr;
-QueueHandle_t audioBufferQueue = nullptr;
 
-// Audio playback task (runs on Core 1) - consumes from buffer queue
-void audioTask(void* parameter) {
-    Serial.println("Audio playback task started on Core 1");
+// Stream endpoint, parsed from Config::settings.streamURL at boot and by
+// POST /stream-url. The streaming task works on its own copy and notices a
+// change by its generation.
+StreamEndpoint requestedEndpoint;
+uint32_t endpointGeneration = 0;
+portMUX_TYPE endpointLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Synchronized playback: frames carry presentation times on the relay clock
+bool syncSessionActive = false;
+PlayoutScheduler playoutScheduler;    // Streaming task adds frames, audio task plans
+SyncFrameParser frameParser;          // Streaming task only
+OutputClock outputClock;              // Audio task only
+uint64_t samplesOut = 0;              // Samples handed to I2S since the DMA ring was cleared
+
+// Silence lives in internal RAM so it can be handed to I2S directly
+static int16_t silenceChunk[AUDIO_CHUNK_SAMPLES] = {0};
+
+// Hand a new endpoint to the streaming task; a playing stream switches over
+static void setStreamEndpoint(const StreamEndpoint& endpoint) {
+    portENTER_CRITICAL(&endpointLock);
+    requestedEndpoint = endpoint;
+    endpointGeneration++;
+    portEXIT_CRITICAL(&endpointLock);
+    
+    if (streamingTaskHandle) {
+        xTaskNotifyGive(streamingTaskHandle);
+    }
+}
+
+static void getStreamEndpoint(StreamEndpoint& endpoint) {
+    portENTER_CRITICAL(&endpointLock);
+    endpoint = requestedEndpoint;
+    portEXIT_CRITICAL(&endpointLock);
+}
+
+// Copy the requested endpoint into `endpoint` if it changed since `generation`
+static bool takeStreamEndpoint(StreamEndpoint& endpoint, uint32_t& generation) {
+    bool changed = false;
+    portENTER_CRITICAL(&endpointLock);
+    if (endpointGeneration != generation) {
+        endpoint = requestedEndpoint;
+        generation = endpointGeneration;
+        changed = true;
+    }
+    portEXIT_CRITICAL(&endpointLock);
+    return changed;
+}
+
+static bool streamEndpointChanged(uint32_t generation) {
+    portENTER_CRITICAL(&endpointLock);
+    bool changed = endpointGeneration != generation;
+    portEXIT_CRITICAL(&endpointLock);
+    return changed;
+}
+
+// Convert a duration to a byte count of 32kHz mono 16-bit PCM
+static size_t audioBytesForMs(size_t ms) {
+    return (AUDIO_BYTES_PER_SECOND * ms) / 1000;
+}
+
+// Hand PCM to I2S. With `calibrate`, write in small pieces: a piece that has
+// to wait for DMA space returns just as a buffer is released, which tells
+// the output clock when that piece will be heard.
+static size_t AUDIO_HOT_ATTR writeOutput(const uint8_t* data, size_t size, bool calibrate) {
+    if (!calibrate) {
+        size_t written = audioStreamer->write(data, size);
+        samplesOut += written / sizeof(int16_t);
+        return written;
+    }
     
-    // Static vector for reuse (prevents stack overflow)
-    static std::vector<int16_t> sampleVector;
-    sampleVector.reserve(AUDIO_CHUNK_SAMPLES);
+    size_t done = 0;
+    while (done < size) {
+        size_t piece = min(SYNC_PIECE_SAMPLES * sizeof(int16_t), size - done);
+        int64_t started = esp_timer_get_time();
+        size_t written = audioStreamer->write(data + done, piece);
+        int64_t returned = esp_timer_get_time();
+        if (written == 0) {
+            break;
+        }
+        if (returned - started > SYNC_BLOCKED_WRITE_US) {
+            outputClock.addObservation(samplesOut, returned);
+        }
+        samplesOut += written / sizeof(int16_t);
+        done += written;
+    }
+    return done;
+}
+
+// Audio playback task - consumes chunks from the tiered buffer
+void AUDIO_HOT_ATTR audioTask(void* parameter) {
+    Serial.println("Audio playback task started on Core 0");
     
-    // Silence detection
-    uint32_t silenceCount = 0;
-    const uint32_t MAX_SILENCE_BEFORE_MUTE = 4; // 4 buffers (200ms) of silence before muting
+    bool starved = false;
+    bool firstAudioPlayed = false;
+    uint32_t lastCalibrationMs = 0;
     
     while (true) {
         bool audioWritten = false;
         
-        if (audioInitialized && audioStreamer && audioStreamer->isReady()) {
-            // Try to get audio buffer from queue
-            AudioBuffer buffer;
-            if (audioBufferQueue != nullptr && xQueueReceive(audioBufferQueue, &buffer, pdMS_TO_TICKS(50)) == pdTRUE) {
-                if (buffer.isValid && buffer.sampleCount > 0) {
-                    // Check if this is silence or valid audio
-                    if (buffer.isSilence || !streamingActive) {
-                        silenceCount++;
-                        // Only output silence if we haven't been silent too long
-                        if (silenceCount <= MAX_SILENCE_BEFORE_MUTE) {
-                            sampleVector.clear();
-                            sampleVector.assign(buffer.samples, buffer.samples + buffer.sampleCount);
-                            audioStreamer->writeSamples(sampleVector);
-                            audioWritten = true;
-                        }
-                    } else {
-                        // Valid audio data
-                        silenceCount = 0;
-                        sampleVector.clear();
-                        sampleVector.assign(buffer.samples, buffer.samples + buffer.sampleCount);
-                        
-                        size_t bytesWritten = audioStreamer->writeSamples(sampleVector);
-                        if (bytesWritten > 0) {
-                            audioWritten = true;
-                            // Successfully played buffer
-                            static uint32_t bufferCount = 0;
-                            bufferCount++;
-                            if (bufferCount % 20 == 0) { // Print every second (20 * 50ms)
-                                UBaseType_t queueCount = uxQueueMessagesWaiting(audioBufferQueue);
-                                Serial.printf("Played %u buffers, queue: %u/%u (streaming: %s)\n", 
-                                            bufferCount, queueCount, AUDIO_BUFFER_QUEUE_SIZE, streamingActive ? "yes" : "no");
-                            }
-                        } else {
-                            Serial.println("Warning: Audio write failed");
-                        }
+        if (audioInitialized && audioStreamer && audioStreamer->isReady() && streamingActive) {
+            // Synchronized stream: line the next sample up with its presentation time
+            bool calibrate = false;
+            if (syncSessionActive) {
+                calibrate = !outputClock.isValid() || millis() - lastCalibrationMs >= SYNC_CALIBRATION_MS;
+                if (calibrate) {
+                    lastCalibrationMs = millis();
+                }
+                
+                int64_t offsetUs;
+                if (!outputClock.isValid()) {
+                    // Output latency not measured yet: fill the DMA ring with silence until it is
+                    writeOutput(reinterpret_cast<const uint8_t*>(silenceChunk), sizeof(silenceChunk), true);
+                    continue;
+                }
+                if (RelayClock::getOffset(offsetUs)) {
+                    PlayoutScheduler::Plan plan = playoutScheduler.plan(audioBuffer.getReadPosition(),
+                                                                        outputClock.playTimeUs(samplesOut),
+                                                                        offsetUs, sizeof(silenceChunk));
+                    if (plan.action == PlayoutScheduler::Plan::SILENCE) {
+                        // Early: hold the audio back, then plan again
+                        writeOutput(reinterpret_cast<const uint8_t*>(silenceChunk), plan.bytes, calibrate);
+                        continue;
+                    }
+                    if (plan.action == PlayoutScheduler::Plan::SKIP && audioBuffer.discard(plan.bytes) > 0) {
+                        // Late: trim, then plan again (an empty buffer falls through to the underrun path)
+                        continue;
                     }
                 }
-            } else {
-                // No buffer available - only send silence if we're actively streaming and queue is empty
-                if (streamingActive && streamingRequested) {
-                    UBaseType_t queueCount = uxQueueMessagesWaiting(audioBufferQueue);
-                    if (queueCount == 0) {
-                        // Only send silence if queue is truly empty
-                        AudioBuffer silenceBuffer = AudioBuffer::createSilence();
-                        sampleVector.clear();
-                        sampleVector.assign(silenceBuffer.samples, silenceBuffer.samples + silenceBuffer.sampleCount);
-                        audioStreamer->writeSamples(sampleVector);
-                        audioWritten = true;
-                        silenceCount++;
-                        
-                        static uint32_t underrunCount = 0;
-                        underrunCount++;
-                        if (underrunCount % 10 == 0) {
-                            Serial.printf("Buffer underrun: %u occurrences\n", underrunCount);
-                        }
+                // No relay clock yet: play as it comes
+            }
+            
+            size_t chunkBytes = 0;
+            const uint8_t* chunk = audioBuffer.fetch(chunkBytes);
+            
+            if (chunk) {
+                starved = false;
+                size_t bytesWritten = writeOutput(chunk, chunkBytes, calibrate);
+                if (bytesWritten > 0) {
+                    audioWritten = true;
+                    if (!firstAudioPlayed) {
+                        firstAudioPlayed = true;
+                        BootTimeline::mark(BootTimeline::FIRST_AUDIO);
                     }
+                    // Successfully played chunk
+                    static uint32_t bufferCount = 0;
+                    bufferCount++;
+                    if (bufferCount % 20 == 0) { // Print every second (20 * 50ms)
+                        size_t buffered = audioBuffer.getBufferedBytes();
+                        Serial.printf("Played %u buffers, buffered: %u ms (streaming: %s)\n", 
+                                    bufferCount, (unsigned)(buffered * 1000 / AUDIO_BYTES_PER_SECOND),
+                                    streamingActive ? "yes" : "no");
+                    }
+                } else {
+                    Serial.println("Warning: Audio write failed");
+                }
+            } else if (streamingRequested) {
+                // Reservoir ran dry - keep I2S fed with silence until data arrives
+                writeOutput(reinterpret_cast<const uint8_t*>(silenceChunk), sizeof(silenceChunk), calibrate);
+                audioWritten = true;
+                PipelineMetrics::recordSilence(AUDIO_CHUNK_SAMPLES);
+                if (!starved) {
+                    starved = true;
+                    PipelineMetrics::recordUnderrun();
+                }
+                
+                static uint32_t underrunCount = 0;
+                underrunCount++;
+                if (underrunCount % 10 == 0) {
+                    Serial.printf("Buffer underrun: %u occurrences\n", underrunCount);
                 }
             }
         }
@@ -159,193 +278,407 @@ void audioTask(void* parameter) {
             if (audioStreamer && audioStreamer->isReady()) {
                 audioStreamer->clearBuffers();
             }
+            // The DMA ring underruns from here on; measure it again next time
+            outputClock.reset();
+            playoutScheduler.resetConsumer();
+            samplesOut = 0;
             vTaskDelay(pdMS_TO_TICKS(100));
         } else {
-            // Small delay for timing
+            // i2s_write blocks while the DMA ring is full, so this only yields
             vTaskDelay(pdMS_TO_TICKS(5));
         }
     }
 }
 
-// PCM streaming task (runs on Core 0) - fetches data from server
+// Buffer bytes read from the relay. A synchronized stream carries frame
+// headers between PCM payloads: the payload goes to the reservoir and each
+// header's PTS to the playout scheduler, keyed by where its first sample
+// was stored. Returns false if the framing is broken.
+static bool storeStreamData(const uint8_t* data, size_t size, bool framed) {
+    while (size > 0) {
+        const uint8_t* pcm = data;
+        size_t pcmBytes = size;
+        
+        if (framed) {
+            SyncFrameParser::Event event;
+            size_t used = frameParser.next(data, size, event);
+            data += used;
+            size -= used;
+            if (event.type == SyncFrameParser::ERROR) {
+                Serial.println("❌ Malformed frame in synchronized stream");
+                return false;
+            }
+            if (event.type == SyncFrameParser::HEADER) {
+                playoutScheduler.addFrame(audioBuffer.getWritePosition(), (int64_t)event.header.ptsUs);
+            }
+            if (event.type != SyncFrameParser::PAYLOAD) {
+                continue;
+            }
+            pcm = event.data;
+            pcmBytes = event.size;
+        } else {
+            size = 0;
+        }
+        
+        size_t buffered = audioBuffer.write(pcm, pcmBytes);
+        if (buffered < pcmBytes) {
+            PipelineMetrics::recordOverflow(pcmBytes - buffered);
+            Serial.println("Failed to buffer audio data");
+        }
+    }
+    return true;
+}
+
+// Resolve the endpoint's host name, once: the address is kept until a
+// connect fails
+static bool resolveStreamEndpoint(StreamEndpoint& endpoint) {
+    if (endpoint.resolved) {
+        return true;
+    }
+    
+    IPAddress address;
+    if (WiFi.hostByName(endpoint.host, address) != 1) {
+        Serial.printf("❌ Could not resolve %s\n", endpoint.host);
+        return false;
+    }
+    uint8_t bytes[4] = { address[0], address[1], address[2], address[3] };
+    endpoint.setAddress(bytes);
+    Serial.printf("Resolved %s to %u.%u.%u.%u\n", endpoint.host, bytes[0], bytes[1], bytes[2], bytes[3]);
+    return true;
+}
+
+// Mark the discovered relay in `relay` as failed and select the next one.
+// Returns true if a different relay can take over straight away.
+static bool failOverRelay(StreamEndpoint& relay) {
+    StreamEndpoint failed = relay;
+    RelayDirectory::recordFailure(failed);
+    return RelayDirectory::select(relay) &&
+           (relay.port != failed.port || memcmp(relay.address, failed.address, sizeof(relay.address)) != 0);
+}
+
+// RTP multicast session: join the group, pre-buffer, then play until
+// streaming stops, the group goes quiet or the endpoint changes. There is
+// no flow control to the relay, so audio over the high-water mark is
+// dropped instead of letting the latency grow. Returns true if any audio
+// arrived.
+static bool receiveMulticast(const StreamEndpoint& endpoint, uint32_t generation) {
+    if (!RtpReceiver::begin(endpoint.host, endpoint.port)) {
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        return false;
+    }
+    
+    const size_t prebufferBytes = min(audioBytesForMs(RTP_PREBUFFER_MS), audioBuffer.getCapacity() / 2);
+    const size_t highWaterBytes = min(audioBytesForMs(RTP_HIGH_WATER_MS), audioBuffer.getCapacity() * 7 / 8);
+    bool receiving = false;
+    Serial.printf("Pre-buffering %u ms of multicast audio...\n", (unsigned)RTP_PREBUFFER_MS);
+    
+    while (streamingRequested && WiFi.status() == WL_CONNECTED &&
+           RtpReceiver::getIdleMs() < RtpReceiver::IDLE_TIMEOUT_MS && !streamEndpointChanged(generation)) {
+        if (RtpReceiver::poll(audioBuffer, audioBuffer.getBufferedBytes() < highWaterBytes) > 0 && !receiving) {
+            receiving = true;
+            BootTimeline::mark(BootTimeline::STREAM_CONNECTED);
+        }
+        if (!streamingActive && audioBuffer.getBufferedBytes() >= prebufferBytes) {
+            streamingActive = true;
+            Serial.println("🎵 Audio playback started!");
+        }
+        vTaskDelay(pdMS_TO_TICKS(RTP_POLL_MS));
+    }
+    
+    RtpReceiver::end();
+    Serial.println("Multicast stream ended");
+    return receiving;
+}
+
+// PCM streaming task (runs on Core 1) - fetches data from server
 void streamingTask(void* parameter) {
-    Serial.println("PCM streaming task started on Core 0");
+    Serial.println("PCM streaming task started on Core 1");
     
     HTTPClient http;
     WiFiClient client;
     
+    // Buffer for reading HTTP data (static to save stack space)
+    static uint8_t httpBuffer[HTTP_BUFFER_SIZE];
+    
+    // Set once a session has been established, so later attempts count as reconnects
+    bool hadSession = false;
+    
+    // Endpoint being streamed from; `switching` while a session ended only
+    // because it changed, so playback carries on from the reservoir
+    StreamEndpoint endpoint;
+    uint32_t generation = 0;
+    bool switching = false;
+    
+    // dnssd:// sessions go to the best relay RelayDirectory knows of
+    StreamEndpoint relay;
+    
+    // Set when the standby relay took over: the next session goes to it, on
+    // the connection already open, at the stream position reached
+    StreamEndpoint handover;
+    bool takingOver = false;
+    
     while (true) {
-        if (streamingRequested && WiFi.status() == WL_CONNECTED) {
-            Serial.println("Starting PCM stream connection...");
+        if (!streamingRequested) {
+            hadSession = false;
+        }
+        bool changed = takeStreamEndpoint(endpoint, generation);
+        if (changed) {
+            char url[sizeof(Config::Settings::streamURL)];
+            endpoint.format(url, sizeof(url));
+            Serial.printf("Stream endpoint: %s\n", endpoint.scheme != StreamEndpoint::NONE ? url : "(none)");
+            RelayDirectory::setEnabled(endpoint.scheme == StreamEndpoint::DISCOVER);
+        }
+        bool ready = streamingRequested && WiFi.status() == WL_CONNECTED;
+        bool discovered = endpoint.scheme == StreamEndpoint::DISCOVER;
+        if (!discovered || !RelayDirectory::select(relay)) {
+            relay.clear();
+        }
+        bool resume = takingOver && !changed && ready && endpoint.scheme != StreamEndpoint::RTP;
+        if (takingOver && !resume) {
+            client.stop();
+            StandbyRelay::abandonTakeover();
+        }
+        takingOver = false;
+        StreamEndpoint& target = resume ? handover : (discovered ? relay : endpoint);
+        
+        if (ready && endpoint.scheme == StreamEndpoint::RTP) {
+            if (hadSession && !switching) {
+                PipelineMetrics::recordReconnect();
+            }
+            if (receiveMulticast(endpoint, generation)) {
+                hadSession = true;
+            }
+            switching = streamingRequested && streamEndpointChanged(generation);
+            if (!switching) {
+                streamingActive = false;
+                vTaskDelay(pdMS_TO_TICKS(1000));
+            }
+        } else if (ready && target.scheme == StreamEndpoint::HTTP) {
+            Serial.printf("Starting PCM stream connection to %s:%u...\n", target.host, (unsigned)target.port);
+            if (hadSession && !switching) {
+                PipelineMetrics::recordReconnect();
+            }
             
             // Configure HTTP client with better settings for streaming
-            String url = String("http://") + PCM_SERVER_HOST + ":" + PCM_SERVER_PORT + PCM_STREAM_PATH;
-            http.begin(client, url);
+            http.begin(client, target.host, target.port, target.path);
             http.setTimeout(30000); // 30 second timeout for streaming
             http.addHeader("User-Agent", "ESP32-RadioBenziger/1.0");
             http.addHeader("Connection", "keep-alive");
             http.addHeader("Cache-Control", "no-cache");
             
-            // Start HTTP request
-            int httpResponseCode = http.GET();
+            // Offer synchronized playback; relays without --sync ignore it.
+            // HTTP/1.0 keeps the body free of chunked transfer coding, which
+            // would otherwise be mixed into the PCM (and the frame headers).
+            // The stream id and start position let a standby relay resume the
+            // stream where this one leaves it (StandbyRelay)
+            static const char* responseHeaders[] = {
+                "X-RB-Sync", "X-RB-Clock-Port", "X-RB-Stream", "X-RB-Position", "X-RB-Loop-Bytes"
+            };
+            http.useHTTP10(true);
+            http.addHeader("X-RB-Sync", "1");
+            http.collectHeaders(responseHeaders, 5);
+            if (resume) {
+                StandbyRelay::addResumeHeaders(http);
+            }
+            
+            // Connect to the cached address: HTTPClient would look the host
+            // name up again on every connect, and reuses an open connection
+            // (as the standby's is after a takeover)
+            int httpResponseCode = HTTPC_ERROR_CONNECTION_REFUSED;
+            uint32_t connectStart = millis();
+            if (resolveStreamEndpoint(target) &&
+                (resume || client.connect(IPAddress(target.address[0], target.address[1],
+                                                    target.address[2], target.address[3]), target.port))) {
+                httpResponseCode = http.GET();
+            }
+            
+            // Set when a discovered relay failed and another one can take over
+            bool failover = false;
+            // Set when the standby relay takes the session over
+            bool handOver = false;
             
             if (httpResponseCode == 200) {
                 Serial.println("✅ Connected to PCM stream");
+                hadSession = true;
+                StandbyRelay::beginSession(http.header("X-RB-Stream").c_str(), http.header("X-RB-Position").c_str(),
+                                           http.header("X-RB-Loop-Bytes").c_str());
+                if (discovered) {
+                    RelayDirectory::recordConnect(target, millis() - connectStart);
+                }
+                BootTimeline::mark(BootTimeline::STREAM_CONNECTED);
+                
+                bool framed = http.header("X-RB-Sync") == "1";
+                uint16_t clockPort = http.header("X-RB-Clock-Port").toInt();
                 
                 // Get stream
                 WiFiClient* stream = http.getStreamPtr();
-                if (stream) {
-                    Serial.println("Pre-buffering audio data...");
-                    
-                    // Pre-buffer some data before starting audio playback
-                    int preBufferCount = 0;
-                    static uint8_t preBuffer[HTTP_BUFFER_SIZE];  // Static to save stack space
-                    int16_t* preBufferPCM = (int16_t*)preBuffer;
+                if (stream && framed) {
+                    // Playback is timed by the frames' PTS, so there is nothing to pre-buffer
+                    Serial.printf("🔗 Synchronized stream (relay clock on UDP %u)\n", (unsigned)clockPort);
+                    frameParser.reset();
+                    playoutScheduler.beginSession();
+                    char address[16];
+                    target.formatAddress(address, sizeof(address));
+                    RelayClock::start(address, clockPort);
+                    syncSessionActive = true;
+                } else if (stream) {
+                    // Pre-buffer before starting audio playback
+                    const size_t prebufferBytes = min(audioBytesForMs(AUDIO_PREBUFFER_MS),
+                                                      audioBuffer.getCapacity() * 3 / 4);
+                    Serial.printf("Pre-buffering %u ms of audio...\n", (unsigned)AUDIO_PREBUFFER_MS);
                     
-                    while (preBufferCount < 8 && streamingRequested && stream->connected()) {
-                        int bytesRead = stream->readBytes(preBuffer, HTTP_BUFFER_SIZE);
+                    int waitCycles = 0;
+                    size_t filled = 0;
+                    uint32_t fillStart = millis();
+                    while (audioBuffer.getBufferedBytes() < prebufferBytes && 
+                           streamingRequested && stream->connected() && waitCycles < 500 && // Max ~5 seconds idle
+                           !streamEndpointChanged(generation)) {
+                        size_t toRead = min(HTTP_BUFFER_SIZE, audioBuffer.getFreeBytes());
+                        uint32_t readStart = micros();
+                        int bytesRead = stream->readBytes(httpBuffer, toRead);
+                        PipelineMetrics::recordReadLatency(micros() - readStart);
                         if (bytesRead > 0) {
-                            size_t sampleCount = bytesRead / sizeof(int16_t);
-                            size_t offset = 0;
-                            
-                            while (offset < sampleCount && preBufferCount < 8) {
-                                size_t chunkSize = (sampleCount - offset) > AUDIO_CHUNK_SAMPLES ? 
-                                                  AUDIO_CHUNK_SAMPLES : (sampleCount - offset);
-                                
-                                AudioBuffer buffer;
-                                buffer.sampleCount = chunkSize;
-                                buffer.isValid = true;
-                                buffer.isSilence = false;
-                                memcpy(buffer.samples, &preBufferPCM[offset], chunkSize * sizeof(int16_t));
-                                
-                                if (audioBufferQueue != nullptr) {
-                                    xQueueSend(audioBufferQueue, &buffer, pdMS_TO_TICKS(100));
-                                    preBufferCount++;
-                                }
-                                
-                                offset += chunkSize;
-                            }
+                            PipelineMetrics::recordBytesIn(bytesRead);
+                            audioBuffer.write(httpBuffer, bytesRead);
+                            StandbyRelay::advance(bytesRead);
+                            filled += bytesRead;
                         } else {
                             vTaskDelay(pdMS_TO_TICKS(10));
+                            waitCycles++;
                         }
                     }
                     
-                    Serial.printf("Pre-buffered %d audio buffers\n", preBufferCount);
+                    Serial.printf("✅ Pre-buffered %u bytes, starting audio playback\n", 
+                                (unsigned)audioBuffer.getBufferedBytes());
                     
-                    // Wait for queue to fill up before starting audio playback
-                    Serial.println("Waiting for queue to fill before starting audio...");
-                    int waitCycles = 0;
-                    while (waitCycles < 50 && streamingRequested) { // Max 5 seconds wait
-                        UBaseType_t queueCount = uxQueueMessagesWaiting(audioBufferQueue);
-                        Serial.printf("Queue fill status: %u/20 buffers\n", queueCount);
-                        
-                        if (queueCount >= 15) {
-                            Serial.printf("✅ Queue sufficiently filled (%u/20), starting audio playback\n", queueCount);
-                            break;
-                        }
-                        
-                        vTaskDelay(pdMS_TO_TICKS(100)); // Wait 100ms between checks
-                        waitCycles++;
+                    // Fill rate ranks the relay: how soon the next pre-buffer plays
+                    uint32_t fillMs = millis() - fillStart;
+                    if (discovered && audioBuffer.getBufferedBytes() >= prebufferBytes && filled > 0) {
+                        RelayDirectory::recordThroughput(target, (uint32_t)((uint64_t)filled * 1000 / (fillMs ? fillMs : 1)));
                     }
-                    
+                }
+                
+                if (stream) {
                     streamingActive = true;
                     Serial.println("🎵 Audio playback started!");
                     
-                    // Buffer for reading HTTP data (static to save stack space)
-                    static uint8_t httpBuffer[HTTP_BUFFER_SIZE];
-                    int16_t* pcmBuffer = (int16_t*)httpBuffer;
-                    
-                    while (streamingRequested && stream->connected()) {
-                        // Intelligent flow control - only read when queue has space
-                        while (streamingRequested && stream->connected()) {
-                            // Check queue space before reading HTTP data
-                            UBaseType_t queueSpace = uxQueueSpacesAvailable(audioBufferQueue);
-                            UBaseType_t queueCount = uxQueueMessagesWaiting(audioBufferQueue);
-                            
-                            // Only read if we have space for at least 2 buffers
-                            if (queueSpace < 2) {
-                                // Queue nearly full, wait for consumption
-                                vTaskDelay(pdMS_TO_TICKS(10));
-                                continue;
-                            }
-                            
-                            int bytesRead = stream->readBytes(httpBuffer, HTTP_BUFFER_SIZE);
-                            
-                            if (bytesRead > 0) {
-                                // Convert bytes to sample count (16-bit samples)
-                                size_t sampleCount = bytesRead / sizeof(int16_t);
-                                
-                                // Process data in chunks that match our buffer size
-                                size_t offset = 0;
-                                while (offset < sampleCount && streamingRequested) {
-                                    size_t chunkSize = (sampleCount - offset) > AUDIO_CHUNK_SAMPLES ? 
-                                                      AUDIO_CHUNK_SAMPLES : (sampleCount - offset);
-                                    
-                                    // Create buffer for this chunk
-                                    AudioBuffer buffer;
-                                    buffer.sampleCount = chunkSize;
-                                    buffer.isValid = true;
-                                    buffer.isSilence = false;
-                                    
-                                    // Copy chunk data
-                                    memcpy(buffer.samples, &pcmBuffer[offset], chunkSize * sizeof(int16_t));
-                                    
-                                    // Send to audio playback queue
-                                    if (audioBufferQueue != nullptr) {
-                                        // Add buffer (we already checked space above)
-                                        if (xQueueSend(audioBufferQueue, &buffer, pdMS_TO_TICKS(10)) != pdTRUE) {
-                                            Serial.println("Failed to queue audio buffer");
-                                        }
-                                    }
-                                    
-                                    offset += chunkSize;
-                                }
-                                
-                                // Adaptive flow control based on queue level
-                                if (queueCount < 5) {
-                                    // Queue has space, continue reading more data
-                                    continue;
-                                } else {
-                                    // Queue getting full, let it drain a bit
-                                    vTaskDelay(pdMS_TO_TICKS(5));
+                    uint32_t lastDataMs = millis();
+                    while (streamingRequested && stream->connected() && !streamEndpointChanged(generation)) {
+                        if (!framed) {
+                            StandbyRelay::maintain(target, endpoint);
+                        }
+                        
+                        // Flow control - only read when the reservoir can take a full HTTP buffer
+                        if (audioBuffer.getFreeBytes() < HTTP_BUFFER_SIZE) {
+                            lastDataMs = millis();
+                            vTaskDelay(pdMS_TO_TICKS(10));
+                            continue;
+                        }
+                        
+                        // With a standby ready, never block in a read: a stall must
+                        // be noticed while the reservoir still covers the takeover
+                        size_t toRead = HTTP_BUFFER_SIZE;
+                        if (!framed && StandbyRelay::isArmed()) {
+                            int available = stream->available();
+                            if (available <= 0) {
+                                if (millis() - lastDataMs >= StandbyRelay::STALL_MS) {
+                                    Serial.printf("PCM stream stalled for %u ms\n", (unsigned)(millis() - lastDataMs));
                                     break;
                                 }
-                            } else {
-                                // No data available, wait a bit
                                 vTaskDelay(pdMS_TO_TICKS(10));
+                                continue;
+                            }
+                            toRead = min((size_t)available, HTTP_BUFFER_SIZE);
+                        }
+                        
+                        uint32_t readStart = micros();
+                        int bytesRead = stream->readBytes(httpBuffer, toRead);
+                        PipelineMetrics::recordReadLatency(micros() - readStart);
+                        
+                        if (bytesRead > 0) {
+                            lastDataMs = millis();
+                            PipelineMetrics::recordBytesIn(bytesRead);
+                            if (!storeStreamData(httpBuffer, bytesRead, framed)) {
                                 break;
                             }
+                            if (!framed) {
+                                StandbyRelay::advance(bytesRead);
+                            }
+                        } else {
+                            // No data available, wait a bit
+                            vTaskDelay(pdMS_TO_TICKS(10));
                         }
                     }
                     
-                    streamingActive = false;
-                    Serial.println("PCM stream disconnected");
+                    // A new endpoint takes over the reservoir as it is
+                    switching = streamingRequested && streamEndpointChanged(generation);
+                    
+                    // A stalled or dropped relay hands over to the warm standby.
+                    // Otherwise a discovered relay is skipped for a while and the
+                    // next one is connected. Either way the reservoir keeps playing
+                    handOver = !switching && streamingRequested && !framed && StandbyRelay::isArmed();
+                    if (!switching && streamingRequested && discovered) {
+                        if (handOver) {
+                            RelayDirectory::recordFailure(target);
+                        } else {
+                            failover = failOverRelay(relay);
+                        }
+                    }
+                    if (!switching && !failover && !handOver) {
+                        streamingActive = false;
+                    }
+                    if (syncSessionActive) {
+                        syncSessionActive = false;
+                        RelayClock::stop();
+                    }
+                    Serial.println(switching ? "PCM stream switching endpoint"
+                                   : handOver ? "PCM stream handing over to the standby relay"
+                                   : failover ? "PCM stream failing over to the next relay"
+                                   : "PCM stream disconnected");
                 }
             } else {
                 Serial.printf("❌ HTTP request failed: %d\n", httpResponseCode);
-                
-                // Send silence buffers when connection fails to prevent noise
-                for (int i = 0; i < 5; i++) {
-                    if (!streamingRequested) break;
-                    
-                    AudioBuffer silenceBuffer = AudioBuffer::createSilence();
-                    if (audioBufferQueue != nullptr) {
-                        xQueueSend(audioBufferQueue, &silenceBuffer, 0);
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(AUDIO_CHUNK_DURATION_MS));
+                // The host may have moved: look it up again next time
+                endpoint.invalidate();
+                switching = false;
+                if (resume) {
+                    StandbyRelay::abandonTakeover();
+                }
+                if (discovered && resume) {
+                    RelayDirectory::recordFailure(target);
+                } else if (discovered) {
+                    failover = failOverRelay(relay);
+                }
+                if (!failover) {
+                    streamingActive = false;
+                    vTaskDelay(pdMS_TO_TICKS(3000)); // Wait 3 seconds before retry
                 }
-                
-                vTaskDelay(pdMS_TO_TICKS(3000)); // Wait 3 seconds before retry
             }
             
             http.end();
+            
+            // Only now: ending the request closes the client it used
+            takingOver = handOver && StandbyRelay::takeOver(client, handover);
+            if (handOver && !takingOver) {
+                streamingActive = false;
+            }
+            
+            // Small delay between connection attempts
+            if (!switching && !failover && !takingOver) {
+                vTaskDelay(pdMS_TO_TICKS(1000));
+            }
         } else {
-            // Not streaming, wait longer
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            if (ready && endpoint.scheme == StreamEndpoint::NONE) {
+                Serial.println("No stream URL set (POST /stream-url)");
+            } else if (ready && discovered) {
+                Serial.println("Waiting for a relay to answer DNS-SD...");
+            }
+            switching = false;
+            streamingActive = false;
+            StandbyRelay::end();
+            // Idle until a stream is requested or the network comes up
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
         }
-        
-        // Small delay between connection attempts
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
 }
 
@@ -356,12 +689,12 @@ void startPCMStreaming() {
             streamingRequested = true;
             Serial.println("PCM streaming requested");
             
-            // Clear audio buffer queue
-            if (audioBufferQueue != nullptr) {
-                AudioBuffer buffer;
-                while (xQueueReceive(audioBufferQueue, &buffer, 0) == pdTRUE) {
-                    // Clear all queued buffers
-                }
+            // Drop any stale audio from a previous session
+            audioBuffer.clear();
+            
+            // Connect now rather than at the streaming task's next poll
+            if (streamingTaskHandle) {
+                xTaskNotifyGive(streamingTaskHandle);
             }
         }
         xSemaphoreGive(streamingMutex);
@@ -370,19 +703,17 @@ void startPCMStreaming() {
 
 // Stop PCM streaming
 void stopPCMStreaming() {
+    // An explicit stop also cancels a pending boot auto-start
+    autoStartPending = false;
+    
     if (xSemaphoreTake(streamingMutex, portMAX_DELAY) == pdTRUE) {
         if (streamingRequested) {
             streamingRequested = false;
             streamingActive = false;
             Serial.println("PCM streaming stopped");
             
-            // Clear audio buffer queue
-            if (audioBufferQueue != nullptr) {
-                AudioBuffer buffer;
-                while (xQueueReceive(audioBufferQueue, &buffer, 0) == pdTRUE) {
-                    // Clear all queued buffers
-                }
-            }
+            // Drop buffered audio
+            audioBuffer.clear();
             
             if (audioStreamer) {
                 audioStreamer->clearBuffers();
@@ -392,108 +723,119 @@ void stopPCMStreaming() {
     }
 }
 
-void setup() {
-    Serial.begin(115200);
-    Serial.println("Radio Benziger PCM Streaming System");
+// Serve a pre-gzipped asset straight from flash (no body copies)
+void serveWebAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+    const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    bool notModified = ifNoneMatch && ifNoneMatch->value() == asset.etag;
     
-    // Initialize configuration
-    config.begin();
+    AsyncWebServerResponse* response = notModified
+        ? request->beginResponse(304)
+        : request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
     
-    // Initialize WiFi
-    wifiManager.begin();
-    
-    if (config.hasWiFiCredentials()) {
-        Serial.println("Connecting to WiFi...");
-        WiFiManager::connectToWiFi(config.settings.wifiSSID, config.settings.wifiPassword);
-        
-        // Wait for connection
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
-        }
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            isConnected = true;
-            Serial.println();
-            Serial.println("WiFi connected!");
-            Serial.print("IP address: ");
-            Serial.println(WiFi.localIP());
-        } else {
-            Serial.println();
-            Serial.println("WiFi connection failed, starting AP mode");
-            wifiManager.startConfigMode();
-        }
-    } else {
-        Serial.println("No WiFi credentials found, starting AP mode");
-        wifiManager.startConfigMode();
+    // "no-cache" lets browsers keep the page but revalidate it, so a
+    // reflashed UI shows up immediately while repeat loads cost a 304
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    if (!notModified) {
+        response->addHeader("Content-Encoding", "gzip");
     }
-    
-    // Initialize audio system
+    request->send(response);
+}
+
+// Whole-string unsigned decimal within [minimum, maximum]; toInt() would
+// accept "80abc" and wrap negative or oversized values
+static bool parseFormNumber(const String& text, uint32_t minimum, uint32_t maximum, uint32_t& value) {
+    const char* digits = text.c_str();
+    if (digits[0] < '0' || digits[0] > '9' || text.length() > 10) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long long parsed = strtoull(digits, &end, 10);
+    if (*end != '\0' || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    value = (uint32_t)parsed;
+    return true;
+}
+
+// Audio subsystem: buffers, I2S and the playback/streaming tasks. Needs
+// nothing from the network, so it runs before WiFi has associated.
+bool startAudioSubsystem() {
+    // Initialize audio system - all long-lived audio memory comes from the boot arena
     Serial.println("Initializing audio system...");
     
     // Create mutex for streaming control
-    streamingMutex = xSemaphoreCreateMutex();
+    streamingMutex = AudioArena::createMutex("streamingMutex");
     if (streamingMutex == nullptr) {
         Serial.println("❌ Failed to create streaming mutex");
-        return;
+        return false;
     }
     
-    // Create audio buffer queue
-    audioBufferQueue = xQueueCreate(AUDIO_BUFFER_QUEUE_SIZE, sizeof(AudioBuffer));
-    if (audioBufferQueue == nullptr) {
-        Serial.println("❌ Failed to create audio buffer queue");
-        return;
+    // Allocate the tiered audio buffer: staging ring from the arena, reservoir
+    // in PSRAM when present (otherwise a one-off internal allocation at boot)
+    uint8_t* stagingStorage = (uint8_t*)AudioArena::allocate(AUDIO_CHUNK_BYTES * AUDIO_STAGING_SLOTS,
+                                                             4, "stagingRing");
+    if (!stagingStorage || !audioBuffer.begin(AUDIO_CHUNK_BYTES, AUDIO_STAGING_SLOTS,
+                                              AUDIO_RESERVOIR_INTERNAL, AUDIO_RESERVOIR_PSRAM,
+                                              stagingStorage)) {
+        Serial.println("❌ Failed to allocate audio buffer");
+        return false;
     }
+    AudioArena::recordExternal("reservoir", audioBuffer.getCapacity(),
+                               audioBuffer.getLayout().reservoirInPSRAM ? "PSRAM" : "internal heap");
+    Serial.printf("✅ Audio buffer: %u ms reservoir in %s\n",
+                  (unsigned)(audioBuffer.getCapacity() * 1000 / AUDIO_BYTES_PER_SECOND),
+                  audioBuffer.getLayout().reservoirInPSRAM ? "PSRAM" : "internal RAM");
     
     // Create audio config with safe buffer settings
     PCMStreamer::AudioConfig audioConfig;
     audioConfig.sampleRate = 32000;
     audioConfig.bitsPerSample = 16;
     audioConfig.channels = 1;        // Mono audio for single speaker
-    audioConfig.bufferSize = 1024;   // Larger buffer for stability
-    audioConfig.bufferCount = 8;     // More buffers for smoother playback
+    audioConfig.bufferSize = I2S_DMA_BUFFER_SAMPLES;   // Larger buffer for stability
+    audioConfig.bufferCount = I2S_DMA_BUFFER_COUNT;    // More buffers for smoother playback
     audioConfig.useAPLL = false;
     
     PCMStreamer::PinConfig pinConfig; // Uses default pins (BCLK=25, LRCK=26, DIN=27)
     
-    audioStreamer = new PCMStreamer(audioConfig, pinConfig, I2S_NUM_0);
+    audioStreamer = AudioArena::create<PCMStreamer>("PCMStreamer", audioConfig, pinConfig, I2S_NUM_0);
     
-    if (audioStreamer->begin()) {
+    if (audioStreamer && audioStreamer->begin()) {
         audioInitialized = true;
+        
+        // Synchronized playback: a released DMA buffer plays after all the others
+        outputClock.begin(audioConfig.sampleRate, (I2S_DMA_BUFFER_COUNT - 1) * I2S_DMA_BUFFER_SAMPLES);
+        playoutScheduler.configure(AUDIO_BYTES_PER_SECOND, SYNC_TOLERANCE_US);
         Serial.println("✅ Audio system initialized successfully");
         audioStreamer->printDiagnostics();
         
         // Create audio playback task (Core 0) - can handle more congestion
-        BaseType_t result = xTaskCreatePinnedToCore(
+        audioTaskHandle = AudioArena::createTask(
             audioTask,          // Task function
             "AudioPlayback",    // Task name
-            12288,             // Increased stack size for Core 0 (was 8192)
+            AUDIO_TASK_STACK_BYTES,
             nullptr,           // Parameters
             2,                 // Priority (higher than default)
-            &audioTaskHandle,  // Task handle
             0                  // Core 0 (more congested, but audio is more resilient)
         );
         
-        if (result == pdPASS) {
-            Serial.println("✅ Audio playback task created successfully on Core 0 (12KB stack)");
+        if (audioTaskHandle != nullptr) {
+            Serial.println("✅ Audio playback task created successfully on Core 0 (12KB static stack)");
         } else {
             Serial.println("❌ Failed to create audio playback task");
         }
         
         // Create PCM streaming task (Core 1) - prioritize HTTP streaming
-        BaseType_t streamingResult = xTaskCreatePinnedToCore(
+        streamingTaskHandle = AudioArena::createTask(
             streamingTask,         // Task function
             "PCMStreaming",        // Task name
-            16384,                // Increased stack size for HTTP + pre-buffering
+            STREAMING_TASK_STACK_BYTES,
             nullptr,              // Parameters
             3,                    // Higher priority than audio for HTTP streaming
-            &streamingTaskHandle, // Task handle
             1                     // Core 1 (less congested, prioritize HTTP)
         );
         
-        if (streamingResult == pdPASS) {
+        if (streamingTaskHandle != nullptr) {
             Serial.println("✅ PCM streaming task created successfully on Core 1 (prioritized)");
         } else {
             Serial.println("❌ Failed to create PCM streaming task");
@@ -502,108 +844,431 @@ void setup() {
         Serial.println("❌ Failed to initialize audio system");
     }
     
-    // Setup web server routes
-    server.on("/", HTTP_GET, []() {
-        String html = "<!DOCTYPE html><html><head>";
-        html += "<title>Radio Benziger PCM Streaming</title>";
-        html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-        html += "<style>";
-        html += "body { font-family: Arial, sans-serif; margin: 20px; background: #f0f0f0; }";
-        html += ".container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; }";
-        html += "h1 { color: #333; text-align: center; }";
-        html += ".status { padding: 10px; margin: 10px 0; border-radius: 5px; }";
-        html += ".connected { background: #d4edda; color: #155724; }";
-        html += ".disconnected { background: #f8d7da; color: #721c24; }";
-        html += ".controls { text-align: center; margin: 20px 0; }";
-        html += "button { padding: 10px 20px; margin: 5px; font-size: 16px; border: none; border-radius: 5px; cursor: pointer; }";
-        html += ".start { background: #28a745; color: white; }";
-        html += ".stop { background: #dc3545; color: white; }";
-        html += ".info { background: #17a2b8; color: white; }";
-        html += ".settings { margin: 20px 0; padding: 15px; background: #f8f9fa; border-radius: 5px; }";
-        html += "</style></head><body>";
-        html += "<div class='container'>";
-        html += "<h1>Radio Benziger PCM Streaming</h1>";
+    return audioInitialized;
+}
+
+// Station events (arduino_events task): track the link; loop() does the auto-start
+void onNetworkEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            isConnected = true;
+            BootTimeline::mark(BootTimeline::IP_ACQUIRED);
+            if (streamingRequested && streamingTaskHandle) {
+                // Reconnect without waiting for the streaming task's next poll
+                xTaskNotifyGive(streamingTaskHandle);
+            }
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            isConnected = false;
+            break;
+        default:
+            break;
+    }
+}
+
+// WiFi associates in the background; onNetworkEvent picks up the result
+void startNetwork() {
+    wifiManager.begin();
+    WiFi.onEvent(onNetworkEvent);
+    autoStartPending = audioInitialized && config.settings.autoStart;
+    
+    if (config.hasWiFiCredentials()) {
+        WiFiManager::connectToSaved();
+        bootConnectPending = true;
+    } else {
+        Serial.println("No WiFi credentials found, starting AP mode");
+        wifiManager.startConfigMode();
+    }
+}
+
+void startWebServer() {
+    // Response buffers for the dynamic routes, allocated once; without them
+    // those routes answer 503
+    if (!responsePool.begin(WEB_RESPONSE_SLOTS, WEB_RESPONSE_SLOT_BYTES) ||
+        !reportPool.begin(REPORT_RESPONSE_SLOTS, REPORT_RESPONSE_SLOT_BYTES)) {
+        Serial.println("Web: Failed to allocate response buffers");
+    }
+    
+    // Setup web server routes (handlers run on the AsyncTCP task, not in loop())
+    // Static UI: pre-gzipped in flash (see embed_web_assets.py), live values come from /status
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+            serveWebAsset(request, *asset);
+        });
+    }
+    
+    server.on("/start-stream", HTTP_POST, [](AsyncWebServerRequest* request) {
+        startPCMStreaming();
+        responsePool.sendJson(request, 200, [](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "success")
+                .field(JSON_KEY("message"), "PCM streaming started")
+                .endObject();
+        });
+    });
+    
+    server.on("/stop-stream", HTTP_POST, [](AsyncWebServerRequest* request) {
+        stopPCMStreaming();
+        responsePool.sendJson(request, 200, [](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "success")
+                .field(JSON_KEY("message"), "PCM streaming stopped")
+                .endObject();
+        });
+    });
+    
+    server.on("/status", HTTP_GET, [](AsyncWebServerRequest* request) {
+        // Every task and 8 discovered relays come to ~5.5 KB
+        reportPool.sendJson(request, 200, [](JsonWriter& json) {
+            uint32_t bufferedBytes = audioBuffer.getBufferedBytes();
+            StreamEndpoint endpoint;
+            getStreamEndpoint(endpoint);
+            char url[sizeof(Config::Settings::streamURL)];
+            endpoint.format(url, sizeof(url));
+            json.beginObject()
+                .field(JSON_KEY("wifi_connected"), isConnected.load())
+                .field(JSON_KEY("audio_initialized"), audioInitialized)
+                .field(JSON_KEY("streaming_requested"), streamingRequested)
+                .field(JSON_KEY("streaming_active"), streamingActive)
+                .field(JSON_KEY("stream_url"), url)
+                .field(JSON_KEY("server_host"), endpoint.host)
+                .field(JSON_KEY("server_port"), (int32_t)endpoint.port)
+                .field(JSON_KEY("free_heap"), (uint32_t)ESP.getFreeHeap())
+                .field(JSON_KEY("free_psram"), (uint32_t)ESP.getFreePsram())
+                .field(JSON_KEY("buffered_bytes"), bufferedBytes)
+                .field(JSON_KEY("buffered_ms"), (uint32_t)(bufferedBytes * 1000 / AUDIO_BYTES_PER_SECOND))
+                .field(JSON_KEY("chunk_samples"), (uint32_t)AUDIO_CHUNK_SAMPLES)
+                .field(JSON_KEY("chunk_ms"), (uint32_t)AUDIO_CHUNK_DURATION_MS)
+                .field(JSON_KEY("reservoir_ms"), (uint32_t)(audioBuffer.getCapacity() * 1000 / AUDIO_BYTES_PER_SECOND))
+                .field(JSON_KEY("reservoir_psram"), audioBuffer.getLayout().reservoirInPSRAM);
+            TaskProfiler::writeJson(json);
+            BootTimeline::writeJson(json);
+            
+            const PlayoutScheduler::Stats& sync = playoutScheduler.getStats();
+            json.beginObject(JSON_KEY("sync"))
+                .field(JSON_KEY("active"), syncSessionActive)
+                .field(JSON_KEY("locked"), sync.locked)
+                .field(JSON_KEY("output_clock"), outputClock.isValid())
+                .field(JSON_KEY("last_error_us"), sync.lastErrorUs)
+                .field(JSON_KEY("corrections"), sync.corrections)
+                .field(JSON_KEY("skipped_bytes"), sync.skippedBytes)
+                .field(JSON_KEY("silence_bytes"), sync.silenceBytes);
+            RelayClock::writeJson(json);
+            json.endObject();
+            RtpReceiver::writeJson(json);
+            RelayDirectory::writeJson(json);
+            StandbyRelay::writeJson(json);
+            json.endObject();
+        });
+    });
+    
+    // Stream endpoint: url=http://host[:port]/path, rtp://group[:port] or dnssd://.
+    // Applies at once; a playing stream switches over without emptying the
+    // reservoir, and the URL is saved like any other setting
+    server.on("/stream-url", HTTP_POST, [](AsyncWebServerRequest* request) {
+        StreamEndpoint endpoint;
+        if (!request->hasParam("url", true) || !endpoint.parse(request->getParam("url", true)->value().c_str())) {
+            responsePool.sendJson(request, 400, [](JsonWriter& json) {
+                json.beginObject()
+                    .field(JSON_KEY("status"), "error")
+                    .field(JSON_KEY("message"), "Expected url=http://host[:port]/path, rtp://group[:port] or dnssd://")
+                    .endObject();
+            });
+            return;
+        }
+        char url[sizeof(Config::Settings::streamURL)];
+        endpoint.format(url, sizeof(url));
+        config.modify([&url](Config::Settings& settings) {
+            memcpy(settings.streamURL, url, sizeof(settings.streamURL));
+        });
+        setStreamEndpoint(endpoint);
         
-        html += "<div class='status " + String(isConnected ? "connected" : "disconnected") + "'>";
-        html += "WiFi: " + String(isConnected ? "Connected" : "Disconnected");
-        html += "</div>";
+        responsePool.sendJson(request, 200, [&url](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "success")
+                .field(JSON_KEY("stream_url"), url)
+                .endObject();
+        });
+    });
+    
+    // Standby relay for seamless failover: url=http://host[:port]/path, or
+    // url= (empty) for none
+    server.on("/standby-url", HTTP_POST, [](AsyncWebServerRequest* request) {
+        StreamEndpoint endpoint;
+        const char* url = request->hasParam("url", true) ? request->getParam("url", true)->value().c_str() : nullptr;
+        if (!url || (url[0] != '\0' && (!endpoint.parse(url) || endpoint.scheme != StreamEndpoint::HTTP))) {
+            responsePool.sendJson(request, 400, [](JsonWriter& json) {
+                json.beginObject()
+                    .field(JSON_KEY("status"), "error")
+                    .field(JSON_KEY("message"), "Expected url=http://host[:port]/path, or url= for none")
+                    .endObject();
+            });
+            return;
+        }
+        char standbyURL[sizeof(Config::Settings::standbyURL)];
+        endpoint.format(standbyURL, sizeof(standbyURL));
+        config.modify([&standbyURL](Config::Settings& settings) {
+            memcpy(settings.standbyURL, standbyURL, sizeof(settings.standbyURL));
+        });
+        StandbyRelay::configure(endpoint);
         
-        html += "<div class='status " + String(streamingActive ? "connected" : "disconnected") + "'>";
-        html += "PCM Stream: " + String(streamingActive ? "Active" : "Inactive");
-        html += "</div>";
+        responsePool.sendJson(request, 200, [&standbyURL](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "success")
+                .field(JSON_KEY("standby_url"), standbyURL)
+                .endObject();
+        });
+    });
+    
+    // Fleet telemetry collector: host ("" disables), port, interval_ms
+    server.on("/telemetry", HTTP_POST, [](AsyncWebServerRequest* request) {
+        // Unchanged fields keep their current values
+        char host[sizeof(Config::Settings::telemetryHost)];
+        uint16_t port;
+        uint32_t intervalMs;
+        config.copy(host, config.settings.telemetryHost, sizeof(host));
+        config.copy(&port, &config.settings.telemetryPort, sizeof(port));
+        config.copy(&intervalMs, &config.settings.telemetryIntervalMs, sizeof(intervalMs));
         
-        html += "<div class='controls'>";
-        html += "<button class='start' onclick='startStream()'>Start Stream</button>";
-        html += "<button class='stop' onclick='stopStream()'>Stop Stream</button>";
-        html += "<button class='info' onclick='getStatus()'>Status</button>";
-        html += "</div>";
+        bool valid = true;
+        if (request->hasParam("host", true)) {
+            const String& value = request->getParam("host", true)->value();
+            valid = value.length() < sizeof(host);
+            strlcpy(host, value.c_str(), sizeof(host));
+        }
+        if (request->hasParam("port", true)) {
+            uint32_t value = 0;
+            valid = valid && parseFormNumber(request->getParam("port", true)->value(), 1, 65535, value);
+            port = (uint16_t)value;
+        }
+        if (request->hasParam("interval_ms", true)) {
+            valid = valid && parseFormNumber(request->getParam("interval_ms", true)->value(),
+                                             TelemetryEmitter::MIN_INTERVAL_MS, TELEMETRY_MAX_INTERVAL_MS,
+                                             intervalMs);
+        }
+        if (!valid) {
+            responsePool.sendJson(request, 400, [](JsonWriter& json) {
+                json.beginObject()
+                    .field(JSON_KEY("status"), "error")
+                    .field(JSON_KEY("message"), "Expected host (up to 63 characters), port=1-65535, interval_ms=250-86400000")
+                    .endObject();
+            });
+            return;
+        }
+        config.modify([&](Config::Settings& settings) {
+            memcpy(settings.telemetryHost, host, sizeof(settings.telemetryHost));
+            settings.telemetryPort = port;
+            settings.telemetryIntervalMs = intervalMs;
+        });
+        TelemetryEmitter::configure(host, port, intervalMs);
         
-        html += "<div class='settings'>";
-        html += "<h3>Stream Settings</h3>";
-        html += "<p><strong>Server:</strong> " + String(PCM_SERVER_HOST) + ":" + String(PCM_SERVER_PORT) + "</p>";
-        html += "<p><strong>Format:</strong> 32kHz, 16-bit, Mono to Stereo</p>";
-        html += "<p><strong>Buffer:</strong> " + String(AUDIO_CHUNK_SAMPLES) + " samples (25ms)</p>";
-        html += "<p><strong>Queue:</strong> " + String(AUDIO_BUFFER_QUEUE_SIZE) + " buffers</p>";
-        html += "</div>";
+        responsePool.sendJson(request, 200, [&](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "success")
+                .field(JSON_KEY("enabled"), host[0] != '\0')
+                .field(JSON_KEY("host"), host)
+                .field(JSON_KEY("port"), (uint32_t)port)
+                .field(JSON_KEY("interval_ms"), intervalMs)
+                .endObject();
+        });
+    });
+    
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+        size_t capacity;
+        char* metrics = reportPool.acquire(capacity);
+        if (!metrics) {
+            WebResponsePool::sendBusy(request);
+            return;
+        }
         
-        html += "<div id='status-info'></div>";
-        html += "</div>";
+        PipelineMetrics::Gauges gauges;
+        gauges.bufferedBytes = audioBuffer.getBufferedBytes();
+        gauges.bufferCapacity = audioBuffer.getCapacity();
+        gauges.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+        gauges.freeHeap = ESP.getFreeHeap();
+        gauges.minFreeHeap = ESP.getMinFreeHeap();
+        gauges.freePsram = ESP.getFreePsram();
+        gauges.streamingActive = streamingActive;
         
-        html += "<script>";
-        html += "function startStream() {";
-        html += "  fetch('/start-stream', {method: 'POST'})";
-        html += "    .then(response => response.text())";
-        html += "    .then(data => { alert(data); setTimeout(() => location.reload(), 1000); });";
-        html += "}";
-        html += "function stopStream() {";
-        html += "  fetch('/stop-stream', {method: 'POST'})";
-        html += "    .then(response => response.text())";
-        html += "    .then(data => { alert(data); setTimeout(() => location.reload(), 1000); });";
-        html += "}";
-        html += "function getStatus() {";
-        html += "  fetch('/status')";
-        html += "    .then(response => response.json())";
-        html += "    .then(data => {";
-        html += "      document.getElementById('status-info').innerHTML = ";
-        html += "        '<div class=\"settings\"><h3>System Status</h3><pre>' + ";
-        html += "        JSON.stringify(data, null, 2) + '</pre></div>';";
-        html += "    });";
-        html += "}";
-        html += "</script></body></html>";
+        size_t length = PipelineMetrics::render(metrics, capacity, gauges, audioStreamer);
+        length += TaskProfiler::renderMetrics(metrics + length, capacity - length);
+        length += BootTimeline::renderMetrics(metrics + length, capacity - length);
+        length += RtpReceiver::renderMetrics(metrics + length, capacity - length);
+        length += StandbyRelay::renderMetrics(metrics + length, capacity - length);
+        length = bufferPrintf(metrics, capacity, length,
+            "# HELP radiobenziger_http_busy_total Requests refused because every response slot was in use\n"
+            "# TYPE radiobenziger_http_busy_total counter\n"
+            "radiobenziger_http_busy_total{pool=\"json\"} %u\n"
+            "radiobenziger_http_busy_total{pool=\"report\"} %u\n"
+            "# HELP radiobenziger_http_render_heap_bytes Heap consumed while rendering a response\n"
+            "# TYPE radiobenziger_http_render_heap_bytes gauge\n"
+            "radiobenziger_http_render_heap_bytes{pool=\"json\",stat=\"last\"} %d\n"
+            "radiobenziger_http_render_heap_bytes{pool=\"json\",stat=\"max\"} %d\n"
+            "radiobenziger_http_render_heap_bytes{pool=\"report\",stat=\"last\"} %d\n"
+            "radiobenziger_http_render_heap_bytes{pool=\"report\",stat=\"max\"} %d\n",
+            (unsigned)responsePool.getExhaustedCount(),
+            (unsigned)reportPool.getExhaustedCount(),
+            (int)responsePool.getLastRenderHeapDelta(),
+            (int)responsePool.getMaxRenderHeapDelta(),
+            (int)reportPool.getLastRenderHeapDelta(),
+            (int)reportPool.getMaxRenderHeapDelta());
         
-        server.send(200, "text/html", html);
-    });
-    
-    server.on("/start-stream", HTTP_POST, []() {
-        startPCMStreaming();
-        server.send(200, "text/plain", "PCM streaming started");
+        // bufferPrintf stops at the slot's last byte; never serve a cut-off scrape
+        if (length >= capacity - 1) {
+            reportPool.release(metrics);
+            Serial.printf("Metrics: Output reached the %u-byte response slot, raise REPORT_RESPONSE_SLOT_BYTES\n",
+                          (unsigned)capacity);
+            request->send(500, "text/plain", "Response too large");
+            return;
+        }
+        request->send(reportPool.beginResponse(metrics, length, 200, "text/plain; version=0.0.4"));
     });
     
-    server.on("/stop-stream", HTTP_POST, []() {
-        stopPCMStreaming();
-        server.send(200, "text/plain", "PCM streaming stopped");
-    });
+    // Live status push; replaces client polling of /status
+    statusPusher.begin(STATUS_FRAME_BYTES);
+    server.addHandler(&statusSocket);
     
-    server.on("/status", HTTP_GET, []() {
-        String json = "{";
-        json += "\"wifi_connected\":" + String(isConnected ? "true" : "false") + ",";
-        json += "\"audio_initialized\":" + String(audioInitialized ? "true" : "false") + ",";
-        json += "\"streaming_requested\":" + String(streamingRequested ? "true" : "false") + ",";
-        json += "\"streaming_active\":" + String(streamingActive ? "true" : "false") + ",";
-        json += "\"server_host\":\"" + String(PCM_SERVER_HOST) + "\",";
-        json += "\"server_port\":" + String(PCM_SERVER_PORT) + ",";
-        json += "\"free_heap\":" + String(ESP.getFreeHeap()) + ",";
-        json += "\"queue_count\":" + String(audioBufferQueue ? uxQueueMessagesWaiting(audioBufferQueue) : 0);
-        json += "}";
-        server.send(200, "application/json", json);
+    server.onNotFound([](AsyncWebServerRequest* request) {
+        responsePool.sendJson(request, 404, [](JsonWriter& json) {
+            json.beginObject()
+                .field(JSON_KEY("status"), "error")
+                .field(JSON_KEY("message"), "Not found")
+                .endObject();
+        });
     });
     
     server.begin();
     Serial.println("✅ Web server started on port 80");
+}
+
+void setup() {
+    Serial.begin(115200);
+    BootTimeline::mark(BootTimeline::SETUP_START);
+    Serial.println("Radio Benziger PCM Streaming System");
+    
+    // Initialize configuration
+    config.begin();
+    StreamEndpoint endpoint;
+    if (endpoint.parse(config.settings.streamURL)) {
+        setStreamEndpoint(endpoint);
+    } else {
+        Serial.printf("❌ Unusable stream URL \"%s\" (POST /stream-url to set one)\n", config.settings.streamURL);
+    }
+    if (endpoint.parse(config.settings.standbyURL)) {
+        StandbyRelay::configure(endpoint);
+    }
+    TelemetryEmitter::configure(config.settings.telemetryHost, config.settings.telemetryPort,
+                                config.settings.telemetryIntervalMs);
+    
+    // Boot stages run in parallel: audio is up before WiFi has associated,
+    // and streaming starts from the GOT_IP event
+    if (startAudioSubsystem()) {
+        BootTimeline::mark(BootTimeline::AUDIO_READY);
+    }
+    
+    // Relay clock exchanges for synchronized streams (own task, idle until used)
+    RelayClock::begin();
+    
+    // Standby relay connections are opened off the streaming task
+    StandbyRelay::begin();
+    
+    // Both tasks above take their stacks from the arena too
+    AudioArena::printLayout();
+    
+    startNetwork();
+    
+    // Start sampling stack usage and CPU load of the audio, relay, loop, web and WiFi tasks
+    TaskProfiler::begin();
+    
+    startWebServer();
+    BootTimeline::mark(BootTimeline::WEB_READY);
     Serial.println("Ready for PCM streaming!");
 }
 
 void loop() {
-    server.handleClient();
-    delay(10);
+    // HTTP is served from AsyncTCP callbacks; loop() only does housekeeping
+    TaskProfiler::update();
+    
+    // Advance the WiFi state machine (events, timeouts, scheduled reconnects)
+    WiFiManager::update();
+    
+    // DNS-SD queries for dnssd:// stream URLs
+    RelayDirectory::update();
+    
+    // Boot auto-start: streamingMutex may block, so not from the event task
+    if (isConnected && autoStartPending.exchange(false)) {
+        Serial.println("Auto-starting PCM stream");
+        startPCMStreaming();
+    }
+    
+    // Boot-time association never completed: fall back to the configuration AP
+    if (bootConnectPending) {
+        if (WiFiManager::getStatus() == WiFiManager::CONNECTED) {
+            bootConnectPending = false;
+        } else if (WiFiManager::getConsecutiveFailures() >= WIFI_BOOT_ATTEMPTS) {
+            bootConnectPending = false;
+            Serial.println("WiFi connection failed, starting AP mode");
+            wifiManager.startConfigMode();
+        }
+    }
+    
+    // Commit queued config changes only while a flash stall cannot starve playback
+    bool audioQuiet = !streamingActive ||
+                      audioBuffer.getBufferedBytes() >= audioBytesForMs(CONFIG_COMMIT_HEADROOM_MS);
+    Config::update(audioQuiet);
+    
+    if (statusPusher.isDue()) {
+        static char nowPlaying[96];
+        StreamEndpoint endpoint;
+        getStreamEndpoint(endpoint);
+        endpoint.format(nowPlaying, sizeof(nowPlaying));
+        
+        PipelineMetrics::Totals totals = PipelineMetrics::getTotals();
+        StatusPusher::Status status;
+        status.wifiConnected = WiFi.status() == WL_CONNECTED;
+        status.streamingActive = streamingActive;
+        status.rssi = status.wifiConnected ? WiFi.RSSI() : 0;
+        status.bufferedMs = audioBuffer.getBufferedBytes() * 1000 / AUDIO_BYTES_PER_SECOND;
+        status.underruns = totals.underruns;
+        status.overflows = totals.overflows;
+        status.reconnects = totals.reconnects;
+        status.freeHeapKb = ESP.getFreeHeap() / 1024;
+        status.nowPlaying = streamingRequested ? nowPlaying : "";
+        statusPusher.publish(status);
+    }
+    statusSocket.cleanupClients();
+    
+    if (TelemetryEmitter::isDue()) {
+        TelemetryPacket packet = {};
+        PipelineMetrics::Totals totals = PipelineMetrics::getTotals();
+        if (audioStreamer) {
+            PCMStreamer::StatsSnapshot i2sStats = audioStreamer->getStatsSnapshot();
+            packet.i2sBytes = i2sStats.totalBytesWritten;
+            packet.i2sWrites = i2sStats.totalPacketsProcessed;
+            packet.i2sOverflows = i2sStats.bufferOverflows;
+        }
+        packet.flags = (WiFi.status() == WL_CONNECTED ? TelemetryPacket::FLAG_WIFI_CONNECTED : 0) |
+                       (streamingActive ? TelemetryPacket::FLAG_STREAMING_ACTIVE : 0) |
+                       (streamingRequested ? TelemetryPacket::FLAG_STREAMING_REQUESTED : 0);
+        packet.uptimeMs = millis();
+        packet.networkBytes = totals.bytesIn;
+        packet.underruns = totals.underruns;
+        packet.reservoirOverflows = totals.overflows;
+        packet.reconnects = totals.reconnects;
+        packet.bufferedBytes = audioBuffer.getBufferedBytes();
+        packet.bufferCapacity = audioBuffer.getCapacity();
+        packet.freeHeap = ESP.getFreeHeap();
+        packet.minFreeHeap = ESP.getMinFreeHeap();
+        packet.freePsram = ESP.getFreePsram();
+        packet.rssi = WiFi.RSSI();
+        char deviceName[sizeof(Config::Settings::deviceName)];
+        config.copy(deviceName, config.settings.deviceName, sizeof(deviceName));
+        strlcpy(packet.deviceName, deviceName, sizeof(packet.deviceName));
+        TelemetryEmitter::send(packet);
+    }
+    
+    // Short enough to honour the minimum push interval
+    delay(20);
 }
\ No newline at end of file
@@ -0,0 +1,628 @@
+#!/usr/bin/env python3
+"""
+Shared PCM fan-out for the relay servers
+
+One ffmpeg transcoder per source publishes fixed-size PCM chunks into a
+broadcast ring; every connected receiver is only a cursor into that ring.
+Relay CPU therefore scales with the number of stations, not listeners.
+
+The transcoder never waits for readers. A client that falls more than a
+ring's worth behind is skipped forward to just behind live instead of
+holding anyone else back. New clients start a short backlog behind live,
+so their pre-buffer fills immediately.
+
+Station/Subscription use a transcoder thread and blocking reads (for the
+http.server based relays); AsyncStation/AsyncSubscription do the same on an
+asyncio event loop with an asyncio subprocess and awaitable reads, so an
+ASGI server never blocks its loop or parks a worker thread per listener.
+
+Pacer and send_queue_bytes are the optional real-time pacing mode: instead
+of writing as fast as a receiver reads, a server emits at the audio clock
+with a fixed lead, so relay-to-speaker latency stays bounded.
+
+Used by mp3_stream_server.py, simple_direct_stream.py and wav_server.py.
+"""
+
+import asyncio
+import logging
+import struct
+import subprocess
+import threading
+import time
+from typing import List, Optional, Tuple
+
+try:
+    import fcntl
+    import termios
+    SIOCOUTQ = termios.TIOCOUTQ   # Same request number for sockets on Linux
+except (ImportError, AttributeError):
+    fcntl = None
+
+logger = logging.getLogger(__name__)
+
+# ESP32 receiver format: 32kHz, 16-bit, mono
+SAMPLE_RATE = 32000
+BYTES_PER_SECOND = SAMPLE_RATE * 2
+CHUNK_SIZE = 3200                 # 100ms of audio
+STEREO_TO_MONO = 'pan=mono|c0=0.5*c0+0.5*c1'
+
+# Pacing lead: covers the receiver's 750ms pre-buffer plus network jitter
+DEFAULT_LEAD_SECONDS = 1.0
+
+
+def pcm_transcode_cmd(source: str, realtime: bool = False, input_args: Optional[List[str]] = None,
+                      audio_filter: Optional[str] = None) -> List[str]:
+    """
+    Build the ffmpeg command that decodes `source` to raw receiver PCM on stdout
+
+    realtime: read the input at its native rate (-re). Needed for files, which
+    would otherwise decode as fast as the pipe drains and lap every listener;
+    live streams already arrive in real time.
+    """
+    cmd = ['ffmpeg']
+    if realtime:
+        cmd.append('-re')
+    cmd += input_args or []
+    cmd += ['-i', source,
+            '-f', 's16le',
+            '-acodec', 'pcm_s16le',
+            '-ar', str(SAMPLE_RATE),
+            '-ac', '1']
+    if audio_filter:
+        cmd += ['-af', audio_filter]
+    cmd += ['-loglevel', 'error',  # Suppress verbose output
+            '-']
+    return cmd
+
+
+def send_queue_bytes(sock) -> Optional[int]:
+    """Bytes written to `sock` that the kernel still holds (unsent or unacked); None if unknown"""
+    if fcntl is None or sock is None:
+        return None
+    try:
+        return struct.unpack('i', fcntl.ioctl(sock.fileno(), SIOCOUTQ, b'\0' * 4))[0]
+    except (OSError, ValueError):
+        return None
+
+
+class Pacer:
+    """
+    Real-time send clock for one listener
+
+    The client may run at most `lead_seconds` of audio ahead of its playback
+    clock (time since its first byte). The first send fills the receiver's
+    pre-buffer; after that data leaves at the audio rate, so socket buffers
+    never fill with seconds of audio. A client that drained everything (a
+    network stall) has its clock re-anchored instead of being flooded to
+    catch up, so its latency stays at the lead.
+    """
+
+    def __init__(self, lead_seconds: float = DEFAULT_LEAD_SECONDS,
+                 bytes_per_second: int = BYTES_PER_SECOND):
+        self.lead_seconds = lead_seconds
+        self.bytes_per_second = bytes_per_second
+        self.bytes_sent = 0
+        self.reanchors = 0
+        self._epoch: Optional[float] = None   # Monotonic time at which byte 0 was due
+
+    def delay(self, nbytes: int) -> float:
+        """Seconds to wait before sending `nbytes` more"""
+        now = time.monotonic()
+        if self._epoch is None:
+            self._epoch = now
+        elif self.ahead_seconds(now) < 0:
+            self._epoch = now - self.bytes_sent / self.bytes_per_second
+            self.reanchors += 1
+        due = self._epoch + (self.bytes_sent + nbytes) / self.bytes_per_second - self.lead_seconds
+        return max(due - now, 0.0)
+
+    def sent(self, nbytes: int):
+        self.bytes_sent += nbytes
+
+    def ahead_seconds(self, now: Optional[float] = None) -> float:
+        """Audio sent beyond the playback clock: an upper bound on what is queued for the client"""
+        if self._epoch is None:
+            return 0.0
+        elapsed = (time.monotonic() if now is None else now) - self._epoch
+        return self.bytes_sent / self.bytes_per_second - elapsed
+
+
+class _RingSlots:
+    """Chunk storage and cursor arithmetic shared by the thread and asyncio rings"""
+
+    def __init__(self, slots: int, chunk_seconds: float):
+        self._slots: List[Optional[bytes]] = [None] * slots
+        self._next_seq = 0        # Sequence number of the next chunk published
+        self._closed = False
+        self._chunk_seconds = chunk_seconds
+        # (first seq, monotonic time it was published) per transcoder process
+        self._timeline: List[Tuple[int, float]] = []
+        self._new_source = True
+
+    def _source_restarted(self):
+        # A restarted ffmpeg publishes from its own start time, not the old run's
+        self._new_source = True
+
+    def _put(self, chunk: bytes):
+        if self._new_source:
+            self._new_source = False
+            start = time.monotonic()
+            if self._timeline:
+                # Never earlier than where the previous process left off
+                start = max(start, self._chunk_time(self._next_seq))
+            self._timeline.append((self._next_seq, start))
+            # Keep only the processes that still have chunks in the ring
+            oldest = max(self._next_seq + 1 - len(self._slots), 0)
+            while len(self._timeline) > 1 and self._timeline[1][0] <= oldest:
+                self._timeline.pop(0)
+        self._slots[self._next_seq % len(self._slots)] = chunk
+        self._next_seq += 1
+
+    def _chunk_time(self, seq: int) -> Optional[float]:
+        if not self._timeline:
+            return None
+        first, start = self._timeline[0]
+        for run_first, run_start in self._timeline:
+            if run_first <= seq:
+                first, start = run_first, run_start
+        return start + (seq - first) * self._chunk_seconds
+
+    def _live_cursor(self, backlog_chunks: int) -> int:
+        return max(self._next_seq - min(backlog_chunks, len(self._slots)), 0)
+
+    def _take(self, cursor: int, max_chunks: int, backlog_chunks: int):
+        """Chunks from `cursor` on; (data, next_cursor, skipped), data None/b'' if none"""
+        if cursor >= self._next_seq:
+            return (None if self._closed else b''), cursor, 0
+
+        # Lapped by the writer: jump to just behind live
+        skipped = 0
+        oldest = max(self._next_seq - len(self._slots), 0)
+        if cursor < oldest:
+            resume = max(self._live_cursor(backlog_chunks), oldest)
+            skipped = resume - cursor
+            cursor = resume
+
+        end = min(self._next_seq, cursor + max_chunks)
+        data = b''.join(self._slots[seq % len(self._slots)] for seq in range(cursor, end))
+        return data, end, skipped
+
+
+class BroadcastRing(_RingSlots):
+    """Last `slots` chunks of one transcoder run, addressed by sequence number"""
+
+    def __init__(self, slots: int, chunk_seconds: float):
+        super().__init__(slots, chunk_seconds)
+        self._cond = threading.Condition()
+
+    def publish(self, chunk: bytes):
+        with self._cond:
+            self._put(chunk)
+            self._cond.notify_all()
+
+    def close(self):
+        """Source ended: readers drain what is left, then see end of stream"""
+        with self._cond:
+            self._closed = True
+            self._cond.notify_all()
+
+    def source_restarted(self):
+        """The next chunk comes from a new transcoder process"""
+        with self._cond:
+            self._source_restarted()
+
+    def live_cursor(self, backlog_chunks: int) -> int:
+        with self._cond:
+            return self._live_cursor(backlog_chunks)
+
+    def chunk_time(self, seq: int) -> Optional[float]:
+        """Monotonic time chunk `seq` is due; None before the first chunk"""
+        with self._cond:
+            return self._chunk_time(seq)
+
+    def read(self, cursor: int, max_chunks: int, backlog_chunks: int, timeout: Optional[float]):
+        """
+        Wait for chunks at `cursor`
+
+        Returns (data, next_cursor, skipped_chunks). data is b'' on timeout and
+        None once the ring is closed and fully drained.
+        """
+        with self._cond:
+            if cursor >= self._next_seq and not self._closed:
+                self._cond.wait_for(lambda: cursor < self._next_seq or self._closed, timeout)
+            return self._take(cursor, max_chunks, backlog_chunks)
+
+
+class Subscription:
+    """One listener's cursor into a station's ring (use as a context manager)"""
+
+    def __init__(self, station: 'Station', ring: BroadcastRing, cursor: int):
+        self._station = station
+        self._ring = ring
+        self._cursor = cursor
+        self.bytes_read = 0
+        self.chunks_skipped = 0
+        self._closed = False
+
+    def read(self, max_chunks: int = 1, timeout: Optional[float] = None) -> Optional[bytes]:
+        """
+        Next chunk(s) of audio; b'' if `timeout` expired first, None at end of stream
+        """
+        data, self._cursor, skipped = self._ring.read(self._cursor, max_chunks,
+                                                      self._station.backlog_chunks, timeout)
+        if skipped:
+            self.chunks_skipped += skipped
+            self._station.note_skip(skipped)
+        if data:
+            self.bytes_read += len(data)
+        return data
+
+    def close(self):
+        if not self._closed:
+            self._closed = True
+            self._station.unsubscribe()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+        return False
+
+
+class _StationBase:
+    """
+    One source, one transcoder, any number of listeners
+
+    The transcoder starts with the first subscriber and stops once nobody has
+    listened for `idle_timeout` seconds. With restart=True an ffmpeg exit
+    (end of file, dropped upstream) starts a new run after `restart_delay`;
+    otherwise listeners see end of stream and the next subscriber starts over.
+    """
+
+    def __init__(self, name: str, ffmpeg_cmd: List[str], restart: bool = True,
+                 chunk_size: int = CHUNK_SIZE, ring_seconds: float = 30.0,
+                 backlog_seconds: float = 1.0, idle_timeout: float = 10.0,
+                 restart_delay: float = 1.0):
+        self.name = name
+        self.ffmpeg_cmd = ffmpeg_cmd
+        self.restart = restart
+        self.chunk_size = chunk_size
+        self.ring_slots = max(int(ring_seconds * BYTES_PER_SECOND / chunk_size), 2)
+        self.backlog_chunks = max(int(backlog_seconds * BYTES_PER_SECOND / chunk_size), 1)
+        self.idle_timeout = idle_timeout
+        self.restart_delay = restart_delay
+
+        self._running = False
+        self._listeners = 0
+        self._idle_since = time.monotonic()
+
+        # Statistics
+        self.transcoder_starts = 0
+        self.bytes_published = 0
+        self.chunks_skipped = 0
+
+    @property
+    def listeners(self) -> int:
+        return self._listeners
+
+    @property
+    def running(self) -> bool:
+        return self._running
+
+    def status(self) -> dict:
+        return {
+            'name': self.name,
+            'running': self._running,
+            'listeners': self._listeners,
+            'transcoder_starts': self.transcoder_starts,
+            'bytes_published': self.bytes_published,
+            'chunks_skipped': self.chunks_skipped,
+        }
+
+    def _log_skip(self, chunks: int):
+        logger.warning(f"[{self.name}] Slow listener skipped forward {chunks * self.chunk_size / BYTES_PER_SECOND:.1f}s")
+
+
+class Station(_StationBase):
+    """Station fed by a transcoder thread; for threaded servers (blocking reads)"""
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self._lock = threading.Lock()
+        self._ring = BroadcastRing(self.ring_slots, self.chunk_size / BYTES_PER_SECOND)
+        self._process: Optional[subprocess.Popen] = None
+
+    def subscribe(self) -> Subscription:
+        with self._lock:
+            self._listeners += 1
+            if not self._running:
+                self._start_locked()
+            ring = self._ring
+            listeners = self._listeners
+        logger.info(f"[{self.name}] Listener joined ({listeners} active)")
+        return Subscription(self, ring, ring.live_cursor(self.backlog_chunks))
+
+    def unsubscribe(self):
+        with self._lock:
+            self._listeners -= 1
+            if self._listeners == 0:
+                self._idle_since = time.monotonic()
+            listeners = self._listeners
+        logger.info(f"[{self.name}] Listener left ({listeners} active)")
+
+    def note_skip(self, chunks: int):
+        with self._lock:
+            self.chunks_skipped += chunks
+        self._log_skip(chunks)
+
+    def stop(self):
+        """Stop the transcoder now (listeners see end of stream)"""
+        with self._lock:
+            self._running = False
+            process = self._process
+        if process and process.poll() is None:
+            process.terminate()
+
+    # Transcoder
+
+    def _start_locked(self):
+        # Each run gets a fresh ring so late readers of a finished run end cleanly
+        self._ring = BroadcastRing(self.ring_slots, self.chunk_size / BYTES_PER_SECOND)
+        self._running = True
+        self.transcoder_starts += 1
+        thread = threading.Thread(target=self._run, args=(self._ring,),
+                                  name=f"transcoder-{self.name}", daemon=True)
+        thread.start()
+
+    def _should_stop(self) -> bool:
+        with self._lock:
+            if not self._running:
+                return True
+            if self._listeners == 0 and time.monotonic() - self._idle_since > self.idle_timeout:
+                self._running = False
+                return True
+            return False
+
+    def _run(self, ring: BroadcastRing):
+        logger.info(f"[{self.name}] Transcoder started")
+        try:
+            while True:
+                process = subprocess.Popen(self.ffmpeg_cmd, stdout=subprocess.PIPE,
+                                           stderr=subprocess.DEVNULL, bufsize=0)
+                with self._lock:
+                    self._process = process
+                try:
+                    while not self._should_stop():
+                        chunk = self._read_chunk(process)
+                        if not chunk:
+                            break
+                        ring.publish(chunk)
+                        self.bytes_published += len(chunk)
+                finally:
+                    if process.poll() is None:
+                        process.terminate()
+                    process.wait()
+
+                if not self._running:
+                    break
+                if not self.restart:
+                    with self._lock:
+                        self._running = False
+                    break
+                logger.info(f"[{self.name}] Source ended, restarting transcoder")
+                ring.source_restarted()
+                time.sleep(self.restart_delay)
+                if self._should_stop():
+                    break
+        except Exception as e:
+            logger.error(f"[{self.name}] Transcoder failed: {e}")
+            with self._lock:
+                self._running = False
+        finally:
+            ring.close()
+            logger.info(f"[{self.name}] Transcoder stopped")
+
+    def _read_chunk(self, process: subprocess.Popen) -> bytes:
+        # Pipe reads can return short; publish whole chunks only
+        chunk = b''
+        while len(chunk) < self.chunk_size:
+            data = process.stdout.read(self.chunk_size - len(chunk))
+            if not data:
+                break
+            chunk += data
+        return chunk
+
+
+# asyncio variants
+
+
+class AsyncBroadcastRing(_RingSlots):
+    """BroadcastRing for one event loop: readers await an Event, no locks or threads"""
+
+    def __init__(self, slots: int, chunk_seconds: float):
+        super().__init__(slots, chunk_seconds)
+        self._changed = asyncio.Event()
+
+    def _wake(self):
+        # Release everyone waiting on this generation; later waiters get a fresh Event
+        self._changed.set()
+        self._changed = asyncio.Event()
+
+    def publish(self, chunk: bytes):
+        self._put(chunk)
+        self._wake()
+
+    def close(self):
+        self._closed = True
+        self._wake()
+
+    def source_restarted(self):
+        self._source_restarted()
+
+    def live_cursor(self, backlog_chunks: int) -> int:
+        return self._live_cursor(backlog_chunks)
+
+    def chunk_time(self, seq: int) -> Optional[float]:
+        return self._chunk_time(seq)
+
+    async def read(self, cursor: int, max_chunks: int, backlog_chunks: int, timeout: Optional[float]):
+        """Same contract as BroadcastRing.read, awaited instead of blocking"""
+        if cursor >= self._next_seq and not self._closed:
+            try:
+                await asyncio.wait_for(self._changed.wait(), timeout)
+            except asyncio.TimeoutError:
+                pass
+        return self._take(cursor, max_chunks, backlog_chunks)
+
+
+class AsyncSubscription:
+    """One listener's cursor into an AsyncStation's ring (use with `async with`)"""
+
+    def __init__(self, station: 'AsyncStation', ring: AsyncBroadcastRing, cursor: int):
+        self._station = station
+        self._ring = ring
+        self._cursor = cursor
+        self.bytes_read = 0
+        self.chunks_skipped = 0
+        self._closed = False
+
+    async def read(self, max_chunks: int = 1, timeout: Optional[float] = None) -> Optional[bytes]:
+        """
+        Next chunk(s) of audio; b'' if `timeout` expired first, None at end of stream
+
+        The cursor only advances when the caller comes back for more, so a
+        client whose socket is backed up holds back nobody but itself.
+        """
+        data, self._cursor, skipped = await self._ring.read(self._cursor, max_chunks,
+                                                            self._station.backlog_chunks, timeout)
+        if skipped:
+            self.chunks_skipped += skipped
+            self._station.note_skip(skipped)
+        if data:
+            self.bytes_read += len(data)
+        return data
+
+    @property
+    def position(self) -> int:
+        """Sequence number of the next chunk read() returns"""
+        return self._cursor
+
+    def chunk_time(self, seq: int) -> Optional[float]:
+        """
+        Monotonic time at which chunk `seq` of this run is due on the shared
+        timeline (real-time sources publish one chunk per chunk duration)
+
+        Each transcoder process starts its own stretch of the timeline when
+        its first chunk is published, so chunks after an ffmpeg restart are
+        not due in the past.
+        """
+        return self._ring.chunk_time(seq)
+
+    def close(self):
+        if not self._closed:
+            self._closed = True
+            self._station.unsubscribe()
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        self.close()
+        return False
+
+
+class AsyncStation(_StationBase):
+    """Station fed by an asyncio subprocess; all methods run on the event loop"""
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self._ring: Optional[AsyncBroadcastRing] = None
+        self._process: Optional[asyncio.subprocess.Process] = None
+        self._task: Optional[asyncio.Task] = None
+
+    def subscribe(self) -> AsyncSubscription:
+        self._listeners += 1
+        if not self._running:
+            self._start()
+        logger.info(f"[{self.name}] Listener joined ({self._listeners} active)")
+        return AsyncSubscription(self, self._ring, self._ring.live_cursor(self.backlog_chunks))
+
+    def unsubscribe(self):
+        self._listeners -= 1
+        if self._listeners == 0:
+            self._idle_since = time.monotonic()
+        logger.info(f"[{self.name}] Listener left ({self._listeners} active)")
+
+    def note_skip(self, chunks: int):
+        self.chunks_skipped += chunks
+        self._log_skip(chunks)
+
+    def stop(self):
+        """Stop the transcoder now (listeners see end of stream)"""
+        self._running = False
+        if self._process and self._process.returncode is None:
+            self._process.terminate()
+
+    # Transcoder
+
+    def _start(self):
+        self._ring = AsyncBroadcastRing(self.ring_slots, self.chunk_size / BYTES_PER_SECOND)
+        self._running = True
+        self.transcoder_starts += 1
+        self._task = asyncio.get_running_loop().create_task(self._run(self._ring))
+
+    def _should_stop(self) -> bool:
+        if not self._running:
+            return True
+        if self._listeners == 0 and time.monotonic() - self._idle_since > self.idle_timeout:
+            self._running = False
+            return True
+        return False
+
+    async def _run(self, ring: AsyncBroadcastRing):
+        logger.info(f"[{self.name}] Transcoder started")
+        try:
+            while True:
+                process = await asyncio.create_subprocess_exec(*self.ffmpeg_cmd,
+                                                               stdout=asyncio.subprocess.PIPE,
+                                                               stderr=asyncio.subprocess.DEVNULL)
+                self._process = process
+                try:
+                    while not self._should_stop():
+                        chunk = await self._read_chunk(process)
+                        if not chunk:
+                            break
+                        ring.publish(chunk)
+                        self.bytes_published += len(chunk)
+                finally:
+                    if process.returncode is None:
+                        try:
+                            process.terminate()
+                        except ProcessLookupError:
+                            pass
+                    await process.wait()
+
+                if not self._running:
+                    break
+                if not self.restart:
+                    self._running = False
+                    break
+                logger.info(f"[{self.name}] Source ended, restarting transcoder")
+                ring.source_restarted()
+                await asyncio.sleep(self.restart_delay)
+                if self._should_stop():
+                    break
+        except Exception as e:
+            logger.error(f"[{self.name}] Transcoder failed: {e}")
+            self._running = False
+        finally:
+            ring.close()
+            logger.info(f"[{self.name}] Transcoder stopped")
+
+    async def _read_chunk(self, process: asyncio.subprocess.Process) -> bytes:
+        # Publish whole chunks only; a short read means the source ended
+        try:
+            return await process.stdout.readexactly(self.chunk_size)
+        except asyncio.IncompleteReadError as e:
+            return e.partial
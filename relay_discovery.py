@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+DNS-SD advertisement of the relay
+
+Receivers with the stream URL dnssd:// browse the local network for
+_pcmradio._tcp services (RFC 6763 over multicast DNS, RFC 6762) and stream
+from the best relay that answers; see radiobenziger/RelayDirectory. This is
+a minimal responder for that one service, with no dependencies beyond the
+standard library: it answers PTR, SRV, TXT and A questions about itself,
+announces itself on start and says goodbye (TTL 0) on stop.
+
+TXT keys:
+  txtvers=1
+  path=/stream     stream path on the relay's HTTP port
+  sync=1           present with --sync (timestamped streams offered)
+
+Queries from a port other than 5353 are legacy unicast queries (RFC 6762
+section 6.7, e.g. `dig -p 5353 @224.0.0.251`) and are answered directly.
+
+Used by wav_server.py (--advertise).
+"""
+
+import asyncio
+import logging
+import socket
+import struct
+from typing import Dict, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+MDNS_GROUP = "224.0.0.251"
+MDNS_PORT = 5353
+SERVICE_TYPE = "_pcmradio._tcp.local"
+SERVICES_META = "_services._dns-sd._udp.local"
+HEADER = struct.Struct('!HHHHHH')      # ID, flags, question/answer/authority/additional counts
+QUESTION = struct.Struct('!HH')
+RECORD = struct.Struct('!HHIH')        # Type, class, TTL, data length
+TYPE_A, TYPE_PTR, TYPE_TXT, TYPE_SRV, TYPE_ANY = 1, 12, 16, 33, 255
+CLASS_IN = 1
+CACHE_FLUSH = 0x8000                   # Record class bit: unique record
+UNICAST_RESPONSE = 0x8000              # Question class bit: answer by unicast
+RESPONSE_FLAGS = 0x8400                # Response, authoritative
+HOST_TTL = 120                         # SRV and A (RFC 6762 section 10)
+OTHER_TTL = 4500                       # PTR and TXT
+LEGACY_TTL = 10                        # Cap for legacy unicast answers
+ANNOUNCE_COUNT = 2
+ANNOUNCE_INTERVAL = 1.0
+
+
+def encode_name(name: str, first_label: Optional[str] = None) -> bytes:
+    """Uncompressed wire name; `first_label` may contain dots (instance names)"""
+    labels = ([first_label] if first_label is not None else []) + [l for l in name.split('.') if l]
+    out = b''
+    for label in labels:
+        data = label.encode('utf-8')[:63]
+        out += bytes([len(data)]) + data
+    return out + b'\0'
+
+
+def decode_name(packet: bytes, offset: int) -> Tuple[Tuple[str, ...], int]:
+    """(lower-case labels, offset after the name), following compression pointers"""
+    labels: List[str] = []
+    end = None
+    for _ in range(128):                               # Bounds pointer loops
+        length = packet[offset]
+        if length & 0xC0 == 0xC0:
+            if end is None:
+                end = offset + 2
+            offset = ((length & 0x3F) << 8) | packet[offset + 1]
+        elif length == 0:
+            return tuple(labels), end if end is not None else offset + 1
+        else:
+            labels.append(packet[offset + 1:offset + 1 + length].decode('utf-8', 'replace').lower())
+            offset += 1 + length
+    raise ValueError("name too long")
+
+
+def local_address() -> str:
+    """Address of the interface that reaches the mDNS group (no packet is sent)"""
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as probe:
+        try:
+            probe.connect((MDNS_GROUP, MDNS_PORT))
+            return probe.getsockname()[0]
+        except OSError:
+            return "127.0.0.1"
+
+
+class ServiceAdvertiser(asyncio.DatagramProtocol):
+    """Answers multicast DNS questions about one _pcmradio._tcp instance"""
+
+    def __init__(self, name: str, port: int, address: str, txt: Dict[str, str]):
+        self.name = name
+        self.port = port
+        self.address = address
+        self.txt = txt
+        hostname = ''.join(c if c.isalnum() or c == '-' else '-' for c in socket.gethostname().split('.')[0])
+        self.hostname = f"{hostname or 'relay'}.local"
+        self.transport: Optional[asyncio.DatagramTransport] = None
+        self.questions = 0
+        self.answers = 0
+        # Lower-case label tuples this responder is authoritative for
+        self.service_key = tuple(SERVICE_TYPE.lower().split('.'))
+        self.instance_key = (name.lower(),) + self.service_key
+        self.host_key = tuple(self.hostname.lower().split('.'))
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data: bytes, addr: Tuple[str, int]):
+        try:
+            query_id, flags, qdcount, _, _, _ = HEADER.unpack_from(data)
+            if flags & 0x8000:
+                return                                 # A response, not a query
+            offset = HEADER.size
+            wanted = set()
+            unicast = False
+            raw_questions = []
+            for _ in range(qdcount):
+                start = offset
+                labels, offset = decode_name(data, offset)
+                qtype, qclass = QUESTION.unpack_from(data, offset)
+                offset += QUESTION.size
+                raw_questions.append(data[start:offset])
+                found = self.match(labels, qtype)
+                if found:
+                    wanted |= found
+                    unicast = unicast or bool(qclass & UNICAST_RESPONSE)
+        except (struct.error, IndexError, ValueError):
+            return
+        if not wanted:
+            return
+        self.questions += 1
+
+        # Legacy resolvers get their ID and questions back, unicast
+        legacy = addr[1] != MDNS_PORT
+        if legacy:
+            packet = self.response(wanted, ttl_cap=LEGACY_TTL, query_id=query_id, questions=raw_questions)
+            self.transport.sendto(packet, addr)
+        else:
+            self.transport.sendto(self.response(wanted), addr if unicast else (MDNS_GROUP, MDNS_PORT))
+        self.answers += 1
+
+    def match(self, labels: Tuple[str, ...], qtype: int) -> set:
+        """Record types ('ptr', 'srv', 'txt', 'a') that answer a question"""
+        if labels == self.service_key and qtype in (TYPE_PTR, TYPE_ANY):
+            return {'ptr'}
+        if labels == tuple(SERVICES_META.split('.')) and qtype in (TYPE_PTR, TYPE_ANY):
+            return {'meta'}
+        if labels == self.instance_key:
+            return {'srv', 'txt'} if qtype == TYPE_ANY else \
+                {'srv'} if qtype == TYPE_SRV else {'txt'} if qtype == TYPE_TXT else set()
+        if labels == self.host_key and qtype in (TYPE_A, TYPE_ANY):
+            return {'a'}
+        return set()
+
+    def response(self, wanted: set, ttl_cap: Optional[int] = None, query_id: int = 0,
+                 questions: Optional[List[bytes]] = None, goodbye: bool = False) -> bytes:
+        """Answers for `wanted`, with the rest of the service as additional records"""
+        instance = encode_name(SERVICE_TYPE, self.name)
+        host = encode_name(self.hostname)
+        # Unique records carry the cache-flush bit, except to legacy resolvers
+        unique = CLASS_IN if questions is not None else CLASS_IN | CACHE_FLUSH
+        txt = b''.join(bytes([len(item)]) + item for item in
+                       (f"{k}={v}".encode('utf-8')[:255] for k, v in self.txt.items())) or b'\0'
+        records = {
+            'meta': (encode_name(SERVICES_META), TYPE_PTR, CLASS_IN, OTHER_TTL, encode_name(SERVICE_TYPE)),
+            'ptr': (encode_name(SERVICE_TYPE), TYPE_PTR, CLASS_IN, OTHER_TTL, instance),
+            'srv': (instance, TYPE_SRV, unique, HOST_TTL, struct.pack('!HHH', 0, 0, self.port) + host),
+            'txt': (instance, TYPE_TXT, unique, OTHER_TTL, txt),
+            'a': (host, TYPE_A, unique, HOST_TTL, socket.inet_aton(self.address)),
+        }
+        order = ['meta', 'ptr', 'srv', 'txt', 'a']
+        answers = [k for k in order if k in wanted]
+        # A browser needs all of it to connect; the meta query needs nothing else
+        additional = [k for k in order[1:] if k not in wanted] if wanted - {'meta'} else []
+
+        def encode(key: str) -> bytes:
+            name, rtype, rclass, ttl, rdata = records[key]
+            ttl = 0 if goodbye else min(ttl, ttl_cap) if ttl_cap else ttl
+            return name + RECORD.pack(rtype, rclass, ttl, len(rdata)) + rdata
+
+        questions = questions or []
+        return (HEADER.pack(query_id, RESPONSE_FLAGS, len(questions), len(answers), 0, len(additional))
+                + b''.join(questions) + b''.join(encode(k) for k in answers + additional))
+
+    async def announce(self):
+        for i in range(ANNOUNCE_COUNT):
+            if i:
+                await asyncio.sleep(ANNOUNCE_INTERVAL)
+            if not self.transport:
+                return
+            try:
+                self.transport.sendto(self.response({'ptr', 'srv', 'txt', 'a'}), (MDNS_GROUP, MDNS_PORT))
+            except OSError as e:
+                logger.warning(f"Could not announce {self.name}: {e}")
+                return
+
+    def goodbye(self):
+        """Tell caches to drop the service now rather than when it expires"""
+        if self.transport:
+            self.transport.sendto(self.response({'ptr', 'srv', 'txt', 'a'}, goodbye=True),
+                                  (MDNS_GROUP, MDNS_PORT))
+            self.transport.close()
+            self.transport = None
+
+    def status(self) -> dict:
+        return {
+            "name": self.name,
+            "service": SERVICE_TYPE,
+            "host": self.hostname,
+            "address": self.address,
+            "port": self.port,
+            "txt": self.txt,
+            "questions": self.questions,
+            "answers": self.answers,
+        }
+
+
+async def start_advertiser(name: str, port: int, path: str = "/stream", sync: bool = False,
+                           address: Optional[str] = None) -> ServiceAdvertiser:
+    """Join the mDNS group on port 5353 (shared with any system responder) and announce"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.bind(("", MDNS_PORT))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 255)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    try:
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP,
+                        socket.inet_aton(MDNS_GROUP) + socket.inet_aton("0.0.0.0"))
+    except OSError as e:
+        logger.warning(f"Could not join {MDNS_GROUP}: {e} (answering unicast queries only)")
+
+    txt = {"txtvers": "1", "path": path}
+    if sync:
+        txt["sync"] = "1"
+    advertiser = ServiceAdvertiser(name, port, address or local_address(), txt)
+    await asyncio.get_running_loop().create_datagram_endpoint(lambda: advertiser, sock=sock)
+    asyncio.get_running_loop().create_task(advertiser.announce())
+    logger.info(f"Advertising \"{name}.{SERVICE_TYPE}\" at {advertiser.address}:{port}{path}")
+    return advertiser
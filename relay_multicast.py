@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+RTP multicast sender for the relay
+
+One stream for every receiver: the station is multicast as RTP (RFC 3550)
+so WiFi airtime stays the same however many receivers join. Each packet
+carries 20 ms of device-format PCM (32 kHz mono s16le) with dynamic payload
+type 96; the receiver side is radiobenziger/RtpReceiver.
+
+Packets are sent at the audio clock from a monotonic schedule. If the
+sender falls behind (event loop stall) it re-anchors rather than bursting
+the backlog onto the air.
+
+With forward error correction (`fec` > 0) every group of that many audio
+packets is followed by one XOR parity packet (payload type 97, same SSRC,
+own sequence numbers), from which a receiver rebuilds any single lost
+packet of the group; see radiobenziger/RtpFec.h for the layout.
+
+Used by wav_server.py (--multicast).
+"""
+
+import asyncio
+import logging
+import random
+import socket
+import struct
+import time
+from typing import Callable, Optional, Tuple
+
+from relay_broadcast import BYTES_PER_SECOND
+
+logger = logging.getLogger(__name__)
+
+RTP = struct.Struct('!BBHII')
+RTP_VERSION = 2
+PAYLOAD_TYPE = 96                 # Dynamic: L16 little-endian, 32 kHz mono
+FEC = struct.Struct('!HBxH2xI')   # Base sequence, count, length XOR, timestamp XOR
+FEC_PAYLOAD_TYPE = 97
+MAX_FEC_GROUP = 8                 # Half the receiver's reorder window
+PACKET_BYTES = 1280               # 20 ms; fits one 802.11 frame with headers
+PACKET_SECONDS = PACKET_BYTES / BYTES_PER_SECOND
+DEFAULT_MULTICAST_PORT = 5004
+DEFAULT_TTL = 1                   # Stay on the local network
+# Behind schedule by more than this: skip ahead instead of catching up
+MAX_BACKLOG_SECONDS = 0.2
+
+
+def parse_group(spec: str) -> Tuple[str, int]:
+    """'239.72.66.1' or '239.72.66.1:5004' -> (group, port)"""
+    group, _, port = spec.partition(':')
+    if socket.inet_aton(group)[0] not in range(224, 240):
+        raise ValueError(f"{group} is not an IPv4 multicast group")
+    return group, int(port) if port else DEFAULT_MULTICAST_PORT
+
+
+def encode_rtp(sequence: int, timestamp: int, ssrc: int, payload: bytes, marker: bool = False,
+               payload_type: int = PAYLOAD_TYPE) -> bytes:
+    return RTP.pack(RTP_VERSION << 6, (0x80 if marker else 0) | payload_type,
+                    sequence & 0xFFFF, timestamp & 0xFFFFFFFF, ssrc) + payload
+
+
+class ParityGroup:
+    """XOR of a group of audio packets: payloads, lengths and timestamps"""
+
+    def __init__(self, count: int):
+        self.count = count
+        self.reset()
+
+    def reset(self):
+        self.members = 0
+        self.base = 0
+        self.length_xor = 0
+        self.timestamp_xor = 0
+        self.payload_xor = 0
+        self.max_length = 0
+
+    def add(self, sequence: int, timestamp: int, payload: bytes) -> Optional[bytes]:
+        """Add an audio packet; returns the parity payload when the group is complete"""
+        if self.members == 0:
+            self.base = sequence & 0xFFFF
+        self.length_xor ^= len(payload)
+        self.timestamp_xor ^= timestamp & 0xFFFFFFFF
+        # Little-endian ints: shorter payloads are zero-padded at the end
+        self.payload_xor ^= int.from_bytes(payload, 'little')
+        self.max_length = max(self.max_length, len(payload))
+        self.members += 1
+        if self.members < self.count:
+            return None
+        parity = (FEC.pack(self.base, self.count, self.length_xor, self.timestamp_xor) +
+                  self.payload_xor.to_bytes(self.max_length, 'little'))
+        self.reset()
+        return parity
+
+
+class MulticastSender:
+    """Paces PCM from a source callback onto a multicast group as RTP"""
+
+    def __init__(self, group: str, port: int, ttl: int = DEFAULT_TTL, interface: Optional[str] = None,
+                 fec: int = 0):
+        if fec and not 2 <= fec <= MAX_FEC_GROUP:
+            raise ValueError(f"FEC group must be 2-{MAX_FEC_GROUP} packets")
+        self.group = group
+        self.port = port
+        self.ssrc = random.getrandbits(32)
+        self.sequence = random.getrandbits(16)
+        self.timestamp = random.getrandbits(32)
+        self.parity = ParityGroup(fec) if fec else None
+        self.parity_sequence = random.getrandbits(16)
+        self.packets = 0
+        self.parity_packets = 0
+        self.bytes = 0
+        self.gaps = 0          # Source had nothing (not cached yet)
+        self.reanchors = 0
+
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, ttl)
+        self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+        if interface:
+            self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(interface))
+        self.sock.setblocking(False)
+
+    def status(self) -> dict:
+        return {
+            "group": self.group,
+            "port": self.port,
+            "ssrc": self.ssrc,
+            "packets": self.packets,
+            "bytes": self.bytes,
+            "fec_group": self.parity.count if self.parity else 0,
+            "parity_packets": self.parity_packets,
+            "gaps": self.gaps,
+            "reanchors": self.reanchors,
+        }
+
+    async def run(self, source: Callable[[int], Optional[bytes]]):
+        """
+        Send until cancelled. `source(nbytes)` returns the next `nbytes` of
+        PCM, or None to send nothing this period. The RTP timestamp still
+        advances, and receivers play the skipped time as silence (pauses
+        over 320 ms are skipped: their playout has run dry by then).
+        """
+        logger.info(f"Multicasting RTP to {self.group}:{self.port} (ssrc {self.ssrc:08x})")
+        epoch = time.monotonic()
+        n = 0
+        marker = True
+        try:
+            while True:
+                due = epoch + n * PACKET_SECONDS
+                now = time.monotonic()
+                if now - due > MAX_BACKLOG_SECONDS:
+                    epoch = now - n * PACKET_SECONDS
+                    self.reanchors += 1
+                elif due > now:
+                    await asyncio.sleep(due - now)
+
+                payload = source(PACKET_BYTES)
+                if payload:
+                    self._send(encode_rtp(self.sequence, self.timestamp, self.ssrc, payload, marker))
+                    self.packets += 1
+                    self.bytes += len(payload)
+                    marker = False
+                    # Parity goes out right behind the last packet of its group
+                    parity = self.parity.add(self.sequence, self.timestamp, payload) if self.parity else None
+                    if parity:
+                        self._send(encode_rtp(self.parity_sequence, self.timestamp, self.ssrc, parity,
+                                              payload_type=FEC_PAYLOAD_TYPE))
+                        self.parity_sequence += 1
+                        self.parity_packets += 1
+                    self.sequence += 1
+                else:
+                    # First packet after a gap is marked, as for talkspurts;
+                    # a part-filled parity group is abandoned
+                    self.gaps += 1
+                    marker = True
+                    if self.parity:
+                        self.parity.reset()
+                self.timestamp += PACKET_BYTES // 2
+                n += 1
+        finally:
+            self.sock.close()
+
+    def _send(self, packet: bytes):
+        try:
+            self.sock.sendto(packet, (self.group, self.port))
+        except (BlockingIOError, OSError) as e:
+            # Lost like any other WiFi multicast packet; receivers conceal it
+            logger.debug(f"Multicast send failed: {e}")
+
+
+if __name__ == '__main__':
+    # Standalone: multicast a device-format PCM file (e.g. from pcm_cache/) in a loop
+    import argparse
+    from pcm_cache import PcmLoop
+    parser = argparse.ArgumentParser(description="Multicast a device-format PCM file as RTP")
+    parser.add_argument("pcm_file", help="Raw PCM (32 kHz, 16-bit little-endian, mono)")
+    parser.add_argument("--group", default=f"239.72.66.1:{DEFAULT_MULTICAST_PORT}", help="Group[:port]")
+    parser.add_argument("--ttl", type=int, default=DEFAULT_TTL)
+    parser.add_argument("--fec", type=int, default=0, help="Parity packet per this many audio packets (0 = off)")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+    pcm = PcmLoop(args.pcm_file)
+    position = 0
+
+    def next_chunk(nbytes: int) -> bytes:
+        global position
+        chunk, position = pcm.read(position, nbytes)
+        return chunk
+
+    group, port = parse_group(args.group)
+    try:
+        asyncio.run(MulticastSender(group, port, args.ttl, fec=args.fec).run(next_chunk))
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Synchronized (multi-room) playback support for the relay
+
+Receivers that send "X-RB-Sync: 1" get a framed stream: every PCM chunk is
+preceded by a 20-byte header carrying its presentation time (PTS) on the
+relay's monotonic clock. A small UDP service answers NTP-style clock
+requests so each receiver can map relay time onto its own clock and play
+every chunk at the same moment as its neighbours.
+
+Wire formats mirror radiobenziger/SyncProtocol.h (little-endian):
+  frame header: magic 'RBF1', sequence u32, PTS u64 (us), length u32
+  clock packet: magic 'RBC1', type u8, 3 reserved, sequence u32, t1, t2, t3 (u64 us)
+
+Used by wav_server.py.
+"""
+
+import asyncio
+import logging
+import struct
+import time
+from typing import Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+FRAME = struct.Struct('<IIQI')
+FRAME_MAGIC = 0x31464252          # "RBF1"
+CLOCK = struct.Struct('<IB3xIQQQ')
+CLOCK_MAGIC = 0x31434252          # "RBC1"
+CLOCK_REQUEST = 1
+CLOCK_REPLY = 2
+
+DEFAULT_CLOCK_PORT = 5601
+# Audio is due this long after it enters the shared timeline: covers the
+# network and the clock exchange, and fits the receiver's 1s internal-RAM
+# reservoir with room to spare
+SYNC_DELAY_SECONDS = 0.5
+# Frames due sooner than this are not worth sending; the receiver would drop them
+MIN_SEND_AHEAD_SECONDS = 0.05
+
+SYNC_HEADERS = {'X-RB-Sync': '1'}
+
+
+def relay_clock_us() -> int:
+    """The clock PTS values and clock replies are expressed in"""
+    return time.monotonic_ns() // 1000
+
+
+def to_clock_us(monotonic_seconds: float) -> int:
+    return int(monotonic_seconds * 1_000_000)
+
+
+def encode_frame(sequence: int, pts_us: int, payload: bytes) -> bytes:
+    return FRAME.pack(FRAME_MAGIC, sequence & 0xFFFFFFFF, pts_us, len(payload)) + payload
+
+
+def wants_sync(headers) -> bool:
+    """Whether a stream request asked for framed, timestamped audio"""
+    return headers.get('x-rb-sync') == '1'
+
+
+class ClockServer(asyncio.DatagramProtocol):
+    """Answers clock requests with the relay's receive and send times"""
+
+    def __init__(self):
+        self.transport: Optional[asyncio.DatagramTransport] = None
+        self.requests = 0
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data: bytes, addr: Tuple[str, int]):
+        t2 = relay_clock_us()
+        if len(data) < CLOCK.size:
+            return
+        magic, kind, sequence, t1, _, _ = CLOCK.unpack_from(data)
+        if magic != CLOCK_MAGIC or kind != CLOCK_REQUEST:
+            return
+        self.requests += 1
+        reply = CLOCK.pack(CLOCK_MAGIC, CLOCK_REPLY, sequence, t1, t2, relay_clock_us())
+        self.transport.sendto(reply, addr)
+
+
+async def start_clock_server(host: str, port: int) -> ClockServer:
+    loop = asyncio.get_running_loop()
+    _, protocol = await loop.create_datagram_endpoint(ClockServer, local_addr=(host, port))
+    logger.info(f"Relay clock on UDP {host}:{port}")
+    return protocol
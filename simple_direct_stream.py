@@ -2,19 +2,34 @@
 """
 Simple Direct Streaming Server
 Downloads from Icecast radio and streams directly via FFmpeg (like MP3 server)
+
+One ffmpeg decode is shared by every connected receiver (see relay_broadcast.py)
 """
 
+import logging
 import subprocess
-import threading
 import time
 from http.server import HTTPServer, BaseHTTPRequestHandler
 from socketserver import ThreadingMixIn
 import requests
-import tempfile
-import os
+
+from relay_broadcast import CHUNK_SIZE, DEFAULT_LEAD_SECONDS, Pacer, Station, pcm_transcode_cmd, send_queue_bytes
+
+RADIO_URL = "https://icecast.octosignals.com/benziger"
+
+# Single decode of the radio stream, started by the first receiver and
+# stopped shortly after the last one leaves. ffmpeg exits are restarted.
+station = Station('benziger', pcm_transcode_cmd(RADIO_URL, input_args=[
+    '-user_agent', 'VLC/3.0.16',
+    '-reconnect', '1',
+    '-reconnect_at_eof', '1',
+    '-reconnect_streamed', '1',
+    '-reconnect_delay_max', '2',
+]))
 
 class ThreadedHTTPServer(ThreadingMixIn, HTTPServer):
     daemon_threads = True
+    pace_lead = None   # Seconds of lead when pacing (--pace), None to send as fast as read
 
 class DirectStreamHandler(BaseHTTPRequestHandler):
     
@@ -39,71 +54,55 @@ class DirectStreamHandler(BaseHTTPRequestHandler):
             self.send_header('Connection', 'keep-alive')
             self.end_headers()
             
-            # Use the exact same FFmpeg approach as the working MP3 server
-            # But instead of reading from file, read from the radio stream URL
-            radio_url = "https://icecast.octosignals.com/benziger"
-            
-            ffmpeg_cmd = [
-                'ffmpeg',
-                '-user_agent', 'VLC/3.0.16',
-                '-reconnect', '1',
-                '-reconnect_at_eof', '1',
-                '-reconnect_streamed', '1',
-                '-reconnect_delay_max', '2',
-                '-i', radio_url,
-                '-f', 's16le',
-                '-acodec', 'pcm_s16le',
-                '-ar', '32000',
-                '-ac', '1',
-                '-loglevel', 'error',  # Suppress verbose output
-                '-'
-            ]
-            
-            # Start ffmpeg process
-            process = subprocess.Popen(
-                ffmpeg_cmd,
-                stdout=subprocess.PIPE,
-                stderr=subprocess.PIPE,
-                bufsize=0
-            )
-            
-            # Stream PCM data in chunks - ESP32 controls the rate
-            chunk_size = 3200  # 100ms of audio at 32kHz mono 16-bit
-            
+            # Join the shared decode; a receiver that falls behind is skipped forward
             start_time = time.time()
             chunks_sent = 0
             
-            while True:
-                chunk = process.stdout.read(chunk_size)
-                if not chunk:
-                    print(f"Stream ended for {client_ip}, restarting...")
-                    break
-                
-                try:
-                    self.wfile.write(chunk)
-                    self.wfile.flush()
-                    chunks_sent += 1
+            # With --pace, at most the lead ahead of the receiver's clock
+            pacer = Pacer(self.server.pace_lead) if self.server.pace_lead else None
+            
+            with station.subscribe() as subscription:
+                while True:
+                    if pacer:
+                        wait = pacer.delay(CHUNK_SIZE)
+                        if wait:
+                            time.sleep(wait)
+                    chunk = subscription.read()
+                    if chunk is None:
+                        print(f"Stream ended for {client_ip}")
+                        break
                     
-                    # Log progress every 10 seconds of audio
-                    if chunks_sent % 100 == 0:  # Every 10 seconds (100 * 0.1s)
-                        elapsed = time.time() - start_time
-                        audio_seconds = chunks_sent / 10.0
-                        rate = audio_seconds / elapsed if elapsed > 0 else 0
-                        print(f"Streaming to {client_ip}: {audio_seconds:.1f}s audio sent, {elapsed:.1f}s elapsed (rate: {rate:.1f}x)")
+                    try:
+                        self.wfile.write(chunk)
+                        self.wfile.flush()
+                        chunks_sent += 1
+                        if pacer:
+                            pacer.sent(len(chunk))
                         
-                except (BrokenPipeError, ConnectionResetError):
-                    print(f"Client {client_ip} disconnected")
-                    break
-            
-            # Clean up process
-            process.terminate()
-            process.wait()
+                        # Log progress every 10 seconds of audio
+                        if chunks_sent % 100 == 0:  # Every 10 seconds (100 * 0.1s)
+                            elapsed = time.time() - start_time
+                            audio_seconds = chunks_sent / 10.0
+                            rate = audio_seconds / elapsed if elapsed > 0 else 0
+                            print(f"Streaming to {client_ip}: {audio_seconds:.1f}s audio sent, {elapsed:.1f}s elapsed (rate: {rate:.1f}x, skipped: {subscription.chunks_skipped} chunks, {self.describe_queue(pacer)})")
+                            
+                    except (BrokenPipeError, ConnectionResetError):
+                        print(f"Client {client_ip} disconnected")
+                        break
             
         except Exception as e:
             print(f"Error streaming to {client_ip}: {e}")
         finally:
             print(f"Direct stream ended for {client_ip}")
     
+    def describe_queue(self, pacer) -> str:
+        """Audio queued towards this client: send-buffer bytes, and lead when pacing"""
+        queued = send_queue_bytes(self.connection)
+        text = f"send queue: {queued} B" if queued is not None else "send queue: n/a"
+        if pacer:
+            text += f", ahead: {pacer.ahead_seconds():.2f}s"
+        return text
+    
     def serve_info_page(self):
         """Serve information page"""
         html = f"""
@@ -123,10 +122,11 @@ class DirectStreamHandler(BaseHTTPRequestHandler):
                 <h1>🎵 Direct Radio Streaming Server</h1>
                 <div class="status">
                     <h3>Server Status: Running</h3>
-                    <p><strong>Radio Source:</strong> https://icecast.octosignals.com/benziger</p>
+                    <p><strong>Radio Source:</strong> {RADIO_URL}</p>
                     <p><strong>Stream URL:</strong> <a href="/stream">http://localhost:8080/stream</a></p>
                     <p><strong>Format:</strong> PCM 32kHz, 16-bit, mono</p>
                     <p><strong>Method:</strong> Direct FFmpeg streaming</p>
+                    <p><strong>Listeners:</strong> {station.listeners} (one shared decode)</p>
                 </div>
                 <div class="info">
                     <h3>ESP32 Configuration</h3>
@@ -163,7 +163,7 @@ def check_dependencies():
 def test_connection():
     """Test connection to radio stream"""
     try:
-        response = requests.get("https://icecast.octosignals.com/benziger", 
+        response = requests.get(RADIO_URL, 
                               headers={'User-Agent': 'VLC/3.0.16'}, 
                               timeout=10, 
                               stream=True)
@@ -175,16 +175,29 @@ def test_connection():
         return False
 
 def main():
+    import argparse
+    
+    parser = argparse.ArgumentParser(description="Direct Radio Streaming Server for ESP32")
+    parser.add_argument("--pace", action="store_true",
+                        help="Send at the audio clock instead of as fast as each receiver reads")
+    parser.add_argument("--lead-ms", type=int, default=int(DEFAULT_LEAD_SECONDS * 1000),
+                        help="Audio a paced receiver may be sent ahead of playback (default: %(default)s)")
+    args = parser.parse_args()
+    
     print("Direct Radio Streaming Server for ESP32")
     print("=" * 40)
-    print("Radio Source: https://icecast.octosignals.com/benziger")
+    print(f"Radio Source: {RADIO_URL}")
     print("Server starting on port 8080")
     print("Format: PCM 32kHz, 16-bit, mono")
     print("Stream URL: http://localhost:8080/stream")
     print("Web Interface: http://localhost:8080/")
-    print("Method: Direct FFmpeg streaming (like MP3 server)")
+    print("Method: Direct FFmpeg streaming, one decode shared by all receivers")
+    if args.pace:
+        print(f"Pacing: {args.lead_ms} ms lead")
     print("=" * 40)
     
+    logging.basicConfig(level=logging.INFO)
+    
     # Check dependencies
     if not check_dependencies():
         print("Error: ffmpeg is required but not found")
@@ -198,6 +211,8 @@ def main():
     
     # Start server
     server = ThreadedHTTPServer(('0.0.0.0', 8080), DirectStreamHandler)
+    if args.pace:
+        server.pace_lead = args.lead_ms / 1000.0
     
     print("Server running on http://0.0.0.0:8080")
     print("Press Ctrl+C to stop")
@@ -0,0 +1,163 @@
+/**
+ * config_migration_check - Legacy settings import, checked on the host
+ *
+ * Firmware before the settings blob stored one NVS key per field. On the
+ * first boot of newer firmware Config imports those keys with
+ * importLegacySettings() (ConfigSettings.h) and then removes every key in
+ * LEGACY_SETTING_KEYS. This runs the same import against an in-memory
+ * stand-in for Preferences and checks that:
+ *
+ *   - every stored field, telemetry included, arrives in the settings
+ *   - every key that is removed afterwards was read first
+ *   - missing keys leave the defaults in place
+ *
+ * Build:
+ *   g++ -std=c++17 -O2 -Wall -o config_migration_check tools/config_migration_check.cpp
+ *
+ * Usage:
+ *   ./config_migration_check
+ *
+ * Exits non-zero on the first failed check.
+ */
+
+#include "../radiobenziger/ConfigSettings.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+
+namespace {
+
+// The subset of Preferences that importLegacySettings() uses
+class FakePreferences {
+public:
+    std::map<std::string, std::string> strings;
+    std::map<std::string, uint32_t> numbers;
+    std::set<std::string> read;
+
+    size_t getString(const char* key, char* value, size_t maxLen) {
+        read.insert(key);
+        auto it = strings.find(key);
+        if (it == strings.end() || maxLen == 0) {
+            return 0;
+        }
+        size_t length = it->second.size() < maxLen - 1 ? it->second.size() : maxLen - 1;
+        memcpy(value, it->second.data(), length);
+        value[length] = '\0';
+        return length + 1;
+    }
+    bool getBool(const char* key, bool defaultValue) {
+        read.insert(key);
+        auto it = numbers.find(key);
+        return it == numbers.end() ? defaultValue : it->second != 0;
+    }
+    uint16_t getUShort(const char* key, uint16_t defaultValue) {
+        read.insert(key);
+        auto it = numbers.find(key);
+        return it == numbers.end() ? defaultValue : (uint16_t)it->second;
+    }
+    uint32_t getUInt(const char* key, uint32_t defaultValue) {
+        read.insert(key);
+        auto it = numbers.find(key);
+        return it == numbers.end() ? defaultValue : it->second;
+    }
+};
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    printf("  %-52s %s\n", what, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+ConfigSettings defaults() {
+    ConfigSettings settings;
+    memset(&settings, 0, sizeof(settings));
+    strcpy(settings.streamURL, "http://relay:8080/stream");
+    strcpy(settings.deviceName, "Radio Benziger");
+    settings.autoStart = true;
+    settings.telemetryPort = 5600;
+    settings.telemetryIntervalMs = 5000;
+    return settings;
+}
+
+}  // namespace
+
+int main() {
+    printf("Every legacy key stored:\n");
+    FakePreferences full;
+    full.strings["wifiSSID"] = "home";
+    full.strings["wifiPassword"] = "secret";
+    full.strings["streamURL"] = "http://10.0.0.2:8080/stream";
+    full.strings["deviceName"] = "Kitchen";
+    full.numbers["autoStart"] = 0;
+    full.strings["telemHost"] = "10.0.0.9";
+    full.numbers["telemPort"] = 5700;
+    full.numbers["telemInterval"] = 2000;
+
+    ConfigSettings settings = defaults();
+    importLegacySettings(full, settings);
+    check(strcmp(settings.wifiSSID, "home") == 0, "wifiSSID");
+    check(strcmp(settings.wifiPassword, "secret") == 0, "wifiPassword");
+    check(strcmp(settings.streamURL, "http://10.0.0.2:8080/stream") == 0, "streamURL");
+    check(strcmp(settings.deviceName, "Kitchen") == 0, "deviceName");
+    check(!settings.autoStart, "autoStart");
+    check(strcmp(settings.telemetryHost, "10.0.0.9") == 0, "telemHost");
+    check(settings.telemetryPort == 5700, "telemPort");
+    check(settings.telemetryIntervalMs == 2000, "telemInterval");
+    check(settings.standbyURL[0] == '\0', "standbyURL (newer than the keys) stays empty");
+
+    bool allRead = true;
+    for (size_t i = 0; i < LEGACY_SETTING_KEY_COUNT; i++) {
+        if (!full.read.count(LEGACY_SETTING_KEYS[i])) {
+            printf("    %s is removed without being imported\n", LEGACY_SETTING_KEYS[i]);
+            allRead = false;
+        }
+    }
+    check(allRead, "every removed key was imported first");
+
+    bool allListed = true;
+    for (const std::string& key : full.read) {
+        bool listed = false;
+        for (size_t i = 0; i < LEGACY_SETTING_KEY_COUNT; i++) {
+            listed = listed || key == LEGACY_SETTING_KEYS[i];
+        }
+        if (!listed) {
+            printf("    %s is imported but left behind\n", key.c_str());
+            allListed = false;
+        }
+    }
+    check(allListed, "every imported key is removed");
+
+    printf("Only WiFi credentials stored:\n");
+    FakePreferences partial;
+    partial.strings["wifiSSID"] = "home";
+    settings = defaults();
+    importLegacySettings(partial, settings);
+    ConfigSettings expected = defaults();
+    check(strcmp(settings.wifiSSID, "home") == 0, "wifiSSID");
+    check(strcmp(settings.streamURL, expected.streamURL) == 0, "streamURL keeps the default");
+    check(settings.autoStart == expected.autoStart, "autoStart keeps the default");
+    check(settings.telemetryHost[0] == '\0', "telemetry stays disabled");
+    check(settings.telemetryPort == expected.telemetryPort, "telemPort keeps the default");
+    check(settings.telemetryIntervalMs == expected.telemetryIntervalMs, "telemInterval keeps the default");
+
+    printf("Over-long values:\n");
+    FakePreferences longValues;
+    longValues.strings["telemHost"] = std::string(200, 'h');
+    settings = defaults();
+    importLegacySettings(longValues, settings);
+    check(strlen(settings.telemetryHost) == sizeof(settings.telemetryHost) - 1, "telemHost is truncated, terminated");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("All checks passed\n");
+    return EXIT_SUCCESS;
+}
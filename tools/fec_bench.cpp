@@ -0,0 +1,246 @@
+/**
+ * fec_bench - CPU cost and loss recovery of the RTP multicast parity
+ *
+ * Uses the firmware's own RtpFec.h and RtpProtocol.h. For each group size
+ * it times the relay-side encoder and the receiver-side rebuild of one
+ * lost packet per group (addParity() + recover(), which includes the
+ * jitter buffer lookups and the push of the rebuilt packet), then streams
+ * a simulated broadcast with random loss through the jitter buffer and
+ * decoder and counts losses that were recovered and those left for the
+ * concealer.
+ *
+ * Host numbers are a relative guide; scale by roughly the clock ratio for
+ * the ESP32 (the XOR loop is memory-bound on both).
+ *
+ * Build:
+ *   g++ -std=c++17 -O2 -Wall -o fec_bench tools/fec_bench.cpp
+ *
+ * Usage:
+ *   ./fec_bench [--groups 20000] [--loss 0.05] [--burst 1] [--seconds 600]
+ *
+ * --burst is the mean loss run length (1 = isolated single losses); WiFi
+ * multicast losses tend to come in short bursts, which parity per group
+ * cannot repair.
+ */
+
+#include "../radiobenziger/RtpProtocol.h"
+#include "../radiobenziger/RtpFec.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace {
+
+const size_t PACKET_BYTES = 1280;              // 20 ms, as relay_multicast.py
+const uint32_t PACKET_SAMPLES = PACKET_BYTES / 2;
+const int64_t PACKET_US = 20000;
+const uint32_t SSRC = 0x5EED0001;
+
+struct Options {
+    int groups = 20000;
+    double loss = 0.05;
+    double burst = 1.0;
+    int seconds = 600;
+};
+
+double nowSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+RtpHeader audioHeader(uint16_t sequence, uint32_t timestamp) {
+    RtpHeader header;
+    header.payloadType = RtpHeader::PAYLOAD_TYPE_PCM;
+    header.marker = false;
+    header.sequence = sequence;
+    header.timestamp = timestamp;
+    header.ssrc = SSRC;
+    return header;
+}
+
+void fillPayload(uint8_t* payload, uint16_t sequence) {
+    for (size_t i = 0; i < PACKET_BYTES; i++) {
+        payload[i] = (uint8_t)(sequence * 31 + i * 7);
+    }
+}
+
+/**
+ * Encoder cost: parity payloads built per second of CPU
+ */
+void benchEncode(uint8_t count, int groups) {
+    FecEncoder encoder(count);
+    uint8_t payload[PACKET_BYTES];
+    uint8_t parity[FecHeader::WIRE_SIZE + RtpJitterBuffer::MAX_PAYLOAD];
+    fillPayload(payload, 1);
+
+    size_t produced = 0;
+    uint16_t sequence = 0;
+    double start = nowSeconds();
+    for (int g = 0; g < groups; g++) {
+        for (uint8_t k = 0; k < count; k++, sequence++) {
+            payload[0] = (uint8_t)sequence;
+            produced += encoder.add(sequence, sequence * PACKET_SAMPLES, payload, PACKET_BYTES,
+                                    parity, sizeof(parity));
+        }
+    }
+    double elapsed = nowSeconds() - start;
+    double usPerGroup = elapsed * 1e6 / groups;
+    printf("  encode   %6.2f us/group  %7.0f MB/s  (%zu parity bytes)\n",
+           usPerGroup, groups * count * PACKET_BYTES / elapsed / 1e6, produced);
+}
+
+/**
+ * Decoder cost: one packet lost in every group, rebuilt from the parity
+ */
+void benchRecover(uint8_t count, int groups) {
+    std::unique_ptr<RtpJitterBuffer> jitter(new RtpJitterBuffer());
+    std::unique_ptr<FecDecoder> decoder(new FecDecoder());
+    FecEncoder encoder(count);
+    uint8_t payload[PACKET_BYTES];
+    uint8_t parity[FecHeader::WIRE_SIZE + RtpJitterBuffer::MAX_PAYLOAD];
+    std::mt19937 rng(1);
+
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    int64_t now = 0;
+    double recoverSeconds = 0;
+    RtpJitterBuffer::Output out;
+    for (int g = 0; g < groups; g++) {
+        uint8_t lost = (uint8_t)(rng() % count);
+        size_t paritySize = 0;
+        for (uint8_t k = 0; k < count; k++, sequence++, timestamp += PACKET_SAMPLES, now += PACKET_US) {
+            fillPayload(payload, sequence);
+            paritySize = encoder.add(sequence, timestamp, payload, PACKET_BYTES, parity, sizeof(parity));
+            if (k != lost) {
+                jitter->push(audioHeader(sequence, timestamp), payload, PACKET_BYTES, now);
+            }
+        }
+
+        RtpHeader rtp = audioHeader((uint16_t)g, timestamp - PACKET_SAMPLES);
+        rtp.payloadType = FecHeader::PAYLOAD_TYPE;
+        double start = nowSeconds();
+        decoder->addParity(rtp, parity, paritySize);
+        decoder->recover(*jitter, SSRC, now);
+        recoverSeconds += nowSeconds() - start;
+
+        while (jitter->pop(now + RtpJitterBuffer::MAX_HOLD_US * 2, out)) {
+        }
+    }
+
+    uint32_t recovered = decoder->getStats().recovered;
+    printf("  recover  %6.2f us/group  %7.0f MB/s  (%u/%d rebuilt)\n",
+           recoverSeconds * 1e6 / groups, groups * count * PACKET_BYTES / recoverSeconds / 1e6,
+           (unsigned)recovered, groups);
+}
+
+/**
+ * Simulated broadcast with Gilbert-model loss (mean run length `burst`)
+ */
+void simulate(uint8_t count, const Options& options) {
+    std::unique_ptr<RtpJitterBuffer> jitter(new RtpJitterBuffer());
+    std::unique_ptr<FecDecoder> decoder(new FecDecoder());
+    std::unique_ptr<FecEncoder> encoder(count ? new FecEncoder(count) : nullptr);
+    uint8_t payload[PACKET_BYTES];
+    uint8_t parity[FecHeader::WIRE_SIZE + RtpJitterBuffer::MAX_PAYLOAD];
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int64_t> arrivalJitter(0, 3000);
+
+    // Two-state channel: enter a loss run with p, leave it with r
+    double r = 1.0 / options.burst;
+    double p = options.loss * r / (1.0 - options.loss);
+    bool losing = false;
+    auto delivered = [&]() {
+        losing = losing ? uniform(rng) >= r : uniform(rng) < p;
+        return !losing;
+    };
+
+    if (count) {
+        jitter->setMinHoldUs((count - 1) * PACKET_US + RtpJitterBuffer::MIN_HOLD_US / 2);
+    }
+
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+    uint32_t parityPackets = 0;
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    RtpJitterBuffer::Output out;
+    int64_t packets = (int64_t)options.seconds * 1000000 / PACKET_US;
+    for (int64_t n = 0; n < packets; n++, sequence++, timestamp += PACKET_SAMPLES) {
+        int64_t now = n * PACKET_US + arrivalJitter(rng);
+        fillPayload(payload, sequence);
+        sent++;
+        if (delivered()) {
+            jitter->push(audioHeader(sequence, timestamp), payload, PACKET_BYTES, now);
+        } else {
+            dropped++;
+        }
+
+        size_t paritySize = encoder
+            ? encoder->add(sequence, timestamp, payload, PACKET_BYTES, parity, sizeof(parity)) : 0;
+        if (paritySize) {
+            parityPackets++;
+            if (delivered()) {
+                RtpHeader rtp = audioHeader((uint16_t)parityPackets, timestamp);
+                rtp.payloadType = FecHeader::PAYLOAD_TYPE;
+                decoder->addParity(rtp, parity, paritySize);
+            }
+        }
+
+        decoder->recover(*jitter, SSRC, now);
+        while (jitter->pop(now, out)) {
+        }
+    }
+
+    const RtpJitterBuffer::Stats& stats = jitter->getStats();
+    double overhead = sent ? 100.0 * parityPackets / sent : 0.0;
+    printf("  %-7s  overhead %4.1f%%  dropped %5u  recovered %5u  unrecoverable %5u  (%.2f%% of audio)\n",
+           count ? "stream" : "no FEC", overhead, (unsigned)dropped, (unsigned)stats.recovered,
+           (unsigned)stats.lost, sent ? 100.0 * stats.lost / sent : 0.0);
+}
+
+void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--groups N] [--loss FRACTION] [--burst MEAN_RUN] [--seconds N]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(argv[i], "--groups") && value) {
+            options.groups = atoi(value);
+        } else if (!strcmp(argv[i], "--loss") && value) {
+            options.loss = atof(value);
+        } else if (!strcmp(argv[i], "--burst") && value) {
+            options.burst = atof(value);
+        } else if (!strcmp(argv[i], "--seconds") && value) {
+            options.seconds = atoi(value);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (options.groups <= 0 || options.loss <= 0 || options.loss >= 1 || options.burst < 1
+            || options.seconds <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("Loss %.1f%%, mean run %.1f packets, %d s of %zu-byte packets\n\n",
+           options.loss * 100, options.burst, options.seconds, PACKET_BYTES);
+    simulate(0, options);
+    for (uint8_t count : {2, 4, 8}) {
+        printf("\nGroup of %u:\n", (unsigned)count);
+        benchEncode(count, options.groups);
+        benchRecover(count, options.groups);
+        simulate(count, options);
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Report where the audio hot path was linked, from a GNU ld map file.
+
+Each function the playback path runs for every audio chunk is looked up in
+the map and classified by the memory it executes from:
+
+    IRAM   internal instruction RAM, never stalls on the flash cache
+    ROM    mask ROM (newlib/ESP-IDF helpers resolved via PROVIDE)
+    flash  cached external flash, can stall while WiFi/NVS evicts the cache
+    -      not found (inlined, optimised away or renamed)
+
+Usage:
+    python3 tools/iram_report.py build/radiobenziger.ino.map
+    python3 tools/iram_report.py --strict build/radiobenziger.ino.map
+
+With --strict the exit status is 1 when any of our own hot-path functions
+is still in flash (useful after AUDIO_IRAM=1 ./build.sh).
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+# Our own hot-path functions (tagged AUDIO_HOT_ATTR in radiobenziger/). A
+# name matches every overload; an entry with "(" matches only the demangled
+# signatures that start with it, for overloads that are not all tagged.
+OWN_HOT_PATH = [
+    "audioTask",
+    "PCMStreamer::write(unsigned char const*",     # Not the std::vector wrapper
+    "PCMStreamer::beginStatsUpdate",
+    "PCMStreamer::endStatsUpdate",
+    "TieredAudioBuffer::write",
+    "TieredAudioBuffer::fetch",
+    "TieredAudioBuffer::getBufferedBytes",
+    "TieredAudioBuffer::effectiveReadIndex",
+    "TieredAudioBuffer::applyPendingFlush",
+    "TieredAudioBuffer::discard",
+    "writeOutput",
+    "PipelineMetrics::recordBytesIn",
+    "PipelineMetrics::recordReadLatency",
+    "PipelineMetrics::recordSilence",
+    "PipelineMetrics::recordUnderrun",
+    "PipelineMetrics::recordOverflow",
+    "RelayClock::getOffset",
+]
+
+# Per-chunk sync code in PlayoutScheduler.h, forced inline (PLAYOUT_HOT) into
+# audioTask/writeOutput; expected "-", an out-of-line copy would be a regression
+OWN_INLINE_HOT_PATH = [
+    "PlayoutScheduler::plan",
+    "OutputClock::addObservation",
+    "OutputClock::playTimeUs",
+    "ClockEstimator::getOffsetUs",
+]
+
+# Core/IDF functions the hot path calls; reported for context only
+LIBRARY_HOT_PATH = [
+    "i2s_write",
+    "esp_timer_get_time",
+    "memcpy",
+    "memset",
+]
+
+# ESP32 (classic) address map, used when a symbol has no output section
+ADDRESS_REGIONS = [
+    (0x40000000, 0x40070000, "ROM"),
+    (0x40070000, 0x400C0000, "IRAM"),
+    (0x400C2000, 0x40C00000, "flash"),
+    (0x3F400000, 0x3F800000, "flash"),
+    (0x3FF90000, 0x3FFA0000, "ROM"),
+    (0x3FFAE000, 0x40000000, "DRAM"),
+]
+
+HEX = r"0x[0-9a-fA-F]+"
+OUTPUT_SECTION_RE = re.compile(r"^(\.[^\s]+)(?:\s+(" + HEX + r")\s+(" + HEX + r"))?\s*$")
+INPUT_SECTION_RE = re.compile(r"^ (\.[^\s]+|COMMON)(?:\s+(" + HEX + r")\s+(" + HEX + r")\s+(.+))?\s*$")
+CONTINUATION_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(.+)$")
+SYMBOL_RE = re.compile(r"^\s+(" + HEX + r")\s+([A-Za-z_.$][^\s=]*)\s*$")
+PROVIDE_RE = re.compile(r"PROVIDE \(([A-Za-z_.$][\w.$]*) = (" + HEX + r")\)")
+
+
+def region_for(output_section, address):
+    """Classify by output section name, falling back to the address map."""
+    if output_section:
+        if output_section.startswith(".iram0"):
+            return "IRAM"
+        if output_section.startswith(".dram0"):
+            return "DRAM"
+        if output_section.startswith(".flash"):
+            return "flash"
+    for start, end, name in ADDRESS_REGIONS:
+        if start <= address < end:
+            return name
+    return "other"
+
+
+def parse_map(path):
+    """Return {symbol: (output_section, address, size)} for every defined symbol."""
+    symbols = {}
+    output_section = None
+    pending_input = None          # Input section whose address is on the next line
+    input_size = 0
+    in_memory_map = False
+
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_memory_map:
+                if line.startswith("Linker script and memory map"):
+                    in_memory_map = True
+                continue
+
+            provide = PROVIDE_RE.search(line)
+            if provide:
+                name, address = provide.group(1), int(provide.group(2), 16)
+                symbols.setdefault(name, (None, address, 0))
+                continue
+
+            if line.startswith("."):
+                match = OUTPUT_SECTION_RE.match(line)
+                if match:
+                    output_section = match.group(1)
+                    pending_input = None
+                continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if match:
+                if match.group(2):
+                    input_size = int(match.group(3), 16)
+                    record_section_symbol(symbols, output_section, match.group(1),
+                                          int(match.group(2), 16), input_size)
+                    pending_input = None
+                else:
+                    pending_input = match.group(1)
+                continue
+
+            match = CONTINUATION_RE.match(line)
+            if match and pending_input:
+                input_size = int(match.group(2), 16)
+                record_section_symbol(symbols, output_section, pending_input,
+                                      int(match.group(1), 16), input_size)
+                pending_input = None
+                continue
+
+            match = SYMBOL_RE.match(line)
+            if match and output_section:
+                address = int(match.group(1), 16)
+                symbols[match.group(2)] = (output_section, address, input_size)
+
+    return symbols
+
+
+def record_section_symbol(symbols, output_section, input_section, address, size):
+    """-ffunction-sections names input sections after the function they hold."""
+    for prefix in (".text.", ".iram1."):
+        if input_section.startswith(prefix):
+            name = input_section[len(prefix):]
+            if name and not name.isdigit() and address:
+                symbols.setdefault(name, (output_section, address, size))
+            return
+
+
+def demangle(names):
+    """Map mangled names to their demangled form (identity if c++filt is missing)."""
+    names = list(names)
+    tool = shutil.which("c++filt") or shutil.which("xtensa-esp32-elf-c++filt")
+    if not tool or not names:
+        return {name: name for name in names}
+    result = subprocess.run([tool], input="\n".join(names), capture_output=True, text=True)
+    demangled = result.stdout.split("\n")
+    if result.returncode != 0 or len(demangled) < len(names):
+        return {name: name for name in names}
+    return dict(zip(names, demangled))
+
+
+def base_name(demangled):
+    """'Foo::bar(int) const' -> 'Foo::bar'"""
+    return demangled.split("(", 1)[0].strip()
+
+
+def lookup(wanted, by_base, names):
+    """Mangled symbols for a hot-path entry: a bare name or a signature prefix"""
+    candidates = by_base.get(base_name(wanted), [])
+    if "(" not in wanted:
+        return candidates
+    return [mangled for mangled in candidates if names[mangled].startswith(wanted)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report IRAM/flash placement of the audio hot path")
+    parser.add_argument("map_file", help="GNU ld map file (e.g. build/radiobenziger.ino.map)")
+    parser.add_argument("--strict", action="store_true",
+                        help="exit 1 if any of our own hot-path functions is in flash")
+    parser.add_argument("--symbol", action="append", default=[],
+                        help="additional function or signature prefix to check (may be repeated)")
+    args = parser.parse_args()
+
+    try:
+        symbols = parse_map(args.map_file)
+    except OSError as e:
+        print(f"iram_report: cannot read {args.map_file}: {e}", file=sys.stderr)
+        return 2
+
+    names = demangle(symbols.keys())
+    by_base = {}
+    for mangled, demangled in names.items():
+        by_base.setdefault(base_name(demangled), []).append(mangled)
+
+    own = OWN_HOT_PATH + OWN_INLINE_HOT_PATH + args.symbol
+    in_flash = []
+    print(f"{'Function':<40} {'Region':<6} {'Section':<16} {'Address':<11} {'Size':>6}")
+    for wanted in own + LIBRARY_HOT_PATH:
+        matches = lookup(wanted, by_base, names)
+        if not matches:
+            print(f"{wanted:<40} -")
+            continue
+        for mangled in sorted(set(matches)):
+            section, address, size = symbols[mangled]
+            region = region_for(section, address)
+            print(f"{wanted:<40} {region:<6} {section or '(abs)':<16} 0x{address:08x}  {size:>6}")
+            if wanted in own and region == "flash":
+                in_flash.append(wanted)
+
+    print()
+    print(f"{len(set(in_flash))} of {len(own)} hot-path functions execute from flash")
+    return 1 if args.strict and in_flash else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
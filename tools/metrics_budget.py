@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""
+Check that the largest possible /metrics body fits one web response slot.
+
+/metrics is rendered into a WebResponsePool slot of REPORT_RESPONSE_SLOT_BYTES
+(radiobenziger.ino); a body that does not fit is answered with 500. This
+reads the /metrics handler, follows each renderer it calls into
+radiobenziger/*.cpp and adds up every bufferPrintf() format string with
+each conversion at its widest:
+
+    %u %lu %x      10 digits (32-bit on the ESP32)
+    %d             11 (sign)
+    %llu %lld      20
+    %.Nf           sign, 20 integer digits, point, N decimals
+    %s             NAME_BYTES (task, milestone and label names)
+
+Format strings inside a for loop count once per iteration; the bound is
+read from the loop condition and taken from the sources: a number, a
+`NAME = N` constant, an enumerator (its position in the enum, as for
+`MILESTONE_COUNT`) or `NAME = sizeof(ARRAY) / sizeof(ARRAY[0])` (the
+elements of ARRAY's initializer, as for `WATCHED_TASK_COUNT`). LOOP_BOUNDS
+is left for bounds none of these cover. An unknown bound is an error, so a
+new loop cannot slip past the check.
+
+Usage:
+    python3 tools/metrics_budget.py [radiobenziger/]
+
+The exit status is 1 when the worst case does not fit, or does not leave
+MARGIN_PERCENT of the slot free.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+NAME_BYTES = 24
+MARGIN_PERCENT = 10
+
+# Bounds the sources do not spell out in a form read below
+LOOP_BOUNDS = {}
+
+CONVERSION = re.compile(r"%[-+ #0]*\d*(?:\.(\d+))?(hh|h|ll|l|z)?([diuxXfsc%])")
+
+
+def strip_comments(source):
+    source = re.sub(r"/\*.*?\*/", "", source, flags=re.S)
+    return re.sub(r"//[^\n]*", "", source)
+
+
+def literal_end(text, i):
+    """Index after the string or character literal starting at text[i]"""
+    quote = text[i]
+    i += 1
+    while text[i] != quote:
+        i += 2 if text[i] == "\\" else 1
+    return i + 1
+
+
+def matching(text, i, open_char, close_char):
+    """Index of the bracket closing text[i], skipping literals"""
+    depth = 0
+    while i < len(text):
+        c = text[i]
+        if c in "\"'":
+            i = literal_end(text, i)
+            continue
+        if c == open_char:
+            depth += 1
+        elif c == close_char:
+            depth -= 1
+            if depth == 0:
+                return i
+        i += 1
+    raise ValueError("unbalanced " + open_char)
+
+
+def literals(text):
+    out = []
+    i = 0
+    while i < len(text):
+        if text[i] in "\"'":
+            end = literal_end(text, i)
+            if text[i] == '"':
+                out.append(text[i + 1:end - 1])
+            i = end
+        else:
+            i += 1
+    return out
+
+
+def split_top_level(body):
+    """Non-empty items of an initializer list, ignoring commas in literals and brackets"""
+    items = []
+    depth = 0
+    current = ""
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c in "\"'":
+            end = literal_end(body, i)
+            current += body[i:end]
+            i = end
+            continue
+        if c in "({[":
+            depth += 1
+        elif c in ")}]":
+            depth -= 1
+        if c == "," and depth == 0:
+            items.append(current)
+            current = ""
+        else:
+            current += c
+        i += 1
+    items.append(current)
+    return [item for item in items if item.strip()]
+
+
+def widest(fmt):
+    """Length of a printf format string with every conversion at full width"""
+    text = bytes(fmt, "utf-8").decode("unicode_escape")
+
+    def width(match):
+        precision, length, kind = match.groups()
+        if kind == "%":
+            return 1
+        if kind == "s":
+            return NAME_BYTES
+        if kind == "c":
+            return 1
+        if kind == "f":
+            return 1 + 20 + 1 + int(precision if precision is not None else 6)
+        if length == "ll":
+            return 20
+        return 11 if kind == "d" or kind == "i" else 10
+
+    total = 0
+    last = 0
+    for match in CONVERSION.finditer(text):
+        total += match.start() - last + width(match)
+        last = match.end()
+    return total + len(text) - last
+
+
+class Sources:
+    def __init__(self, directory):
+        self.directory = directory
+        self.text = {}
+        for name in sorted(os.listdir(directory)):
+            if name.endswith((".cpp", ".h", ".ino")):
+                with open(os.path.join(directory, name), encoding="utf-8") as f:
+                    self.text[name] = strip_comments(f.read())
+        self.constants = dict(LOOP_BOUNDS)
+        for source in self.text.values():
+            for name, value in re.findall(r"\b([A-Z][A-Z0-9_]*)\s*=\s*(\d+)\s*[;,]", source):
+                self.constants.setdefault(name, int(value))
+        for source in self.text.values():
+            self.read_enums(source)
+            self.read_array_counts(source)
+
+    def read_enums(self, source):
+        """Enumerators by position; `= N` restarts the count"""
+        for body in re.findall(r"\benum\s+(?:class\s+)?\w*\s*(?::\s*\w+\s*)?\{([^}]*)\}", source):
+            value = 0
+            for item in body.split(","):
+                match = re.match(r"\s*([A-Za-z_]\w*)\s*(?:=\s*(\d+))?\s*$", item)
+                if not match:
+                    continue
+                if match.group(2) is not None:
+                    value = int(match.group(2))
+                self.constants.setdefault(match.group(1), value)
+                value += 1
+
+    def read_array_counts(self, source):
+        """NAME = sizeof(ARRAY) / sizeof(ARRAY[0]): the elements of ARRAY's initializer"""
+        pattern = r"\b(?:\w+::)?([A-Z][A-Z0-9_]*)\s*=\s*sizeof\s*\(\s*(\w+)\s*\)\s*/\s*sizeof\s*\(\s*\2\s*\[\s*0\s*\]\s*\)"
+        for name, array in re.findall(pattern, source):
+            for text in self.text.values():
+                match = re.search(r"\b(?:\w+::)?" + re.escape(array) + r"\s*\[\s*\]\s*=\s*\{", text)
+                if match:
+                    start = match.end() - 1
+                    body = text[start + 1:matching(text, start, "{", "}")]
+                    self.constants.setdefault(name, len(split_top_level(body)))
+                    break
+
+    def bound(self, condition, where):
+        match = re.search(r"<\s*(?:\w+::)?(\w+)\s*$", condition.strip())
+        if match:
+            value = match.group(1)
+            if value.isdigit():
+                return int(value)
+            if value in self.constants:
+                return self.constants[value]
+        raise ValueError(f"{where}: cannot bound loop 'for ({condition.strip()})', add it to LOOP_BOUNDS")
+
+    def function_body(self, qualified):
+        pattern = re.compile(r"\b" + re.escape(qualified) + r"\s*\([^;{]*\)\s*(?:const\s*)?\{")
+        for name, source in self.text.items():
+            match = pattern.search(source)
+            if match:
+                start = match.end() - 1
+                return name, source[start:matching(source, start, "{", "}") + 1]
+        raise ValueError(f"renderer {qualified} not found in {self.directory}")
+
+    def printf_bytes(self, body, where):
+        """Worst case of every bufferPrintf() in a body, loops multiplied out"""
+        total = 0
+        # Multiplier of each enclosing brace; a for loop's braces carry its bound
+        stack = [1]
+        pending = None
+        i = 0
+        while i < len(body):
+            c = body[i]
+            if c in "\"'":
+                i = literal_end(body, i)
+                continue
+            if body.startswith("for", i) and re.match(r"for\s*\(", body[i:]) and not (body[i - 1].isalnum() or body[i - 1] == "_"):
+                open_paren = body.index("(", i)
+                close_paren = matching(body, open_paren, "(", ")")
+                parts = body[open_paren + 1:close_paren].split(";")
+                pending = self.bound(parts[1], where)
+                i = close_paren + 1
+                continue
+            if c == "{":
+                stack.append(stack[-1] * (pending or 1))
+                pending = None
+            elif c == "}":
+                stack.pop()
+            elif body.startswith("bufferPrintf", i) and re.match(r"bufferPrintf\s*\(", body[i:]):
+                open_paren = body.index("(", i)
+                close_paren = matching(body, open_paren, "(", ")")
+                size = sum(widest(fmt) for fmt in literals(body[open_paren:close_paren]))
+                # An unbraced loop body is the single statement that follows
+                total += size * stack[-1] * (pending or 1)
+                pending = None
+                i = close_paren + 1
+                continue
+            i += 1
+        return total
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check the worst-case /metrics body against the response slot")
+    parser.add_argument("sketch_dir", nargs="?",
+                        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "radiobenziger"))
+    args = parser.parse_args()
+
+    try:
+        sources = Sources(args.sketch_dir)
+        sketch = sources.text["radiobenziger.ino"]
+        slot = int(re.search(r"REPORT_RESPONSE_SLOT_BYTES\s*=\s*(\d+)", sketch).group(1))
+        start = sketch.index('server.on("/metrics"')
+        handler = sketch[start:matching(sketch, sketch.index("{", start), "{", "}") + 1]
+
+        rows = []
+        for renderer in re.findall(r"\b(\w+::\w+)\s*\(\s*metrics\b", handler):
+            where, body = sources.function_body(renderer)
+            rows.append((renderer, sources.printf_bytes(body, where)))
+        rows.append(("/metrics handler", sources.printf_bytes(handler, "radiobenziger.ino")))
+    except (OSError, KeyError, ValueError, AttributeError) as e:
+        print(f"metrics_budget: {e}", file=sys.stderr)
+        return 1
+
+    total = sum(size for _, size in rows)
+    for name, size in rows:
+        print(f"  {name:<36} {size:6d}")
+    print(f"  {'worst case':<36} {total:6d} of {slot} bytes ({total * 100 // slot}%)")
+
+    limit = slot * (100 - MARGIN_PERCENT) // 100
+    if total > limit:
+        print(f"metrics_budget: worst-case /metrics ({total} bytes) exceeds {100 - MARGIN_PERCENT}% of "
+              f"REPORT_RESPONSE_SLOT_BYTES ({slot}); raise it", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,522 @@
+/**
+ * sync_receiver_sim - Simulated receivers for synchronized playback
+ *
+ * Runs several receivers in one process against a relay started with
+ * --sync (wav_server.py), using the firmware's own SyncProtocol.h and
+ * PlayoutScheduler.h. Each receiver has its own clock (random boot offset
+ * and crystal skew), does the UDP clock exchange, reads the framed stream
+ * and drives a simulated I2S DMA ring the way audioTask does: blocking
+ * writes, calibration pieces, silence inserts and trims.
+ *
+ * Every report interval it samples, at one instant, which stream sample
+ * each receiver is playing and prints how far that is from the relay
+ * clock (positive = late) and the spread between receivers.
+ *
+ * Build:
+ *   g++ -std=c++17 -O2 -Wall -o sync_receiver_sim tools/sync_receiver_sim.cpp
+ *
+ * Usage:
+ *   python3 wav_server.py --file music.wav --sync &
+ *   ./sync_receiver_sim [--host 127.0.0.1] [--port 8080] [--receivers 3]
+ *                       [--seconds 20] [--skew-ppm 40] [--jitter-us 300]
+ *
+ * Exits non-zero if the spread after the settling time exceeds
+ * --max-spread-us (default 2000).
+ */
+
+#include "../radiobenziger/SyncProtocol.h"
+#include "../radiobenziger/PlayoutScheduler.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Receiver format and the firmware's playback constants (radiobenziger.ino)
+const uint32_t SAMPLE_RATE = 32000;
+const uint32_t BYTES_PER_SECOND = SAMPLE_RATE * 2;
+const uint32_t CHUNK_SAMPLES = 1600;
+const uint32_t DMA_BUFFER_SAMPLES = 1024;
+const uint32_t DMA_BUFFER_COUNT = 8;
+const uint32_t PIECE_SAMPLES = 32;
+const uint32_t CALIBRATION_MS = 250;
+const uint32_t RESERVOIR_BYTES = 64 * 1024;
+const uint32_t READ_BYTES = 6400;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    int receivers = 3;
+    int seconds = 20;
+    double skewPpm = 40.0;
+    int64_t jitterUs = 300;
+    uint32_t toleranceUs = PlayoutScheduler::DEFAULT_TOLERANCE_US;
+    int64_t maxSpreadUs = 2000;
+    int settleSeconds = 5;
+    int reportMs = 1000;
+};
+
+// True (host) time; the relay's clock is the same CLOCK_MONOTONIC
+int64_t hostNowUs() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class Receiver {
+public:
+    Receiver(int id, const Options& options, double skewPpm, int64_t bootOffsetUs, uint32_t seed) :
+        id(id), options(options), skewPpm(skewPpm), bootOffsetUs(bootOffsetUs), rng(seed) {
+        hostEpochUs = hostNowUs();
+        outputClock.begin(SAMPLE_RATE, (DMA_BUFFER_COUNT - 1) * DMA_BUFFER_SAMPLES);
+        scheduler.configure(BYTES_PER_SECOND, options.toleranceUs);
+        reservoir.resize(RESERVOIR_BYTES);
+    }
+
+    ~Receiver() {
+        if (tcp >= 0) close(tcp);
+        if (udp >= 0) close(udp);
+    }
+
+    bool connectStream() {
+        tcp = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = relayAddress(options.port);
+        if (connect(tcp, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            perror("connect");
+            return false;
+        }
+
+        // HTTP/1.0 like the firmware: the body arrives without chunked coding
+        std::string request = "GET /stream HTTP/1.0\r\nHost: " + options.host +
+                              "\r\nUser-Agent: sync_receiver_sim\r\nX-RB-Sync: 1\r\n\r\n";
+        send(tcp, request.data(), request.size(), 0);
+
+        std::string head;
+        char c;
+        while (head.find("\r\n\r\n") == std::string::npos && recv(tcp, &c, 1, 0) == 1) {
+            head += c;
+        }
+        std::string lower = head;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (lower.find(" 200") == std::string::npos || lower.find("x-rb-sync: 1") == std::string::npos) {
+            fprintf(stderr, "rx%d: relay did not offer a synchronized stream (is it running with --sync?)\n", id);
+            return false;
+        }
+        size_t portAt = lower.find("x-rb-clock-port:");
+        uint16_t clockPort = portAt == std::string::npos ? 0 : (uint16_t)atoi(lower.c_str() + portAt + 16);
+
+        fcntl(tcp, F_SETFL, O_NONBLOCK);
+        udp = socket(AF_INET, SOCK_DGRAM, 0);
+        fcntl(udp, F_SETFL, O_NONBLOCK);
+        clockAddress = relayAddress(clockPort);
+        return clockPort != 0;
+    }
+
+    void poll() {
+        pollClock();
+        pollStream();
+        pollOutput();
+    }
+
+    /**
+     * Relay time minus the PTS of the sample playing at host time `hostUs`
+     * (positive = late); false while silence is playing
+     */
+    bool playbackError(int64_t hostUs, double& errorUs) const {
+        if (!i2sStarted) {
+            return false;
+        }
+        double played = (double)(deviceTime(hostUs) - i2sStartUs) * SAMPLE_RATE / 1e6;
+        for (const Segment& segment : segments) {
+            if (played >= segment.start && played < segment.start + segment.count) {
+                if (segment.ptsUs < 0) {
+                    return false;
+                }
+                double pts = segment.ptsUs + (played - segment.start) * 1e6 / SAMPLE_RATE;
+                errorUs = hostUs - pts;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    double getSkewPpm() const { return skewPpm; }
+    const PlayoutScheduler::Stats& getStats() const { return scheduler.getStats(); }
+
+private:
+    // A run of samples handed to the DMA ring: PTS of the first, -1 for silence
+    struct Segment {
+        uint64_t start;
+        uint64_t count;
+        int64_t ptsUs;
+    };
+
+    // Where received frames were stored, to label what is played
+    struct FrameRecord {
+        uint32_t position;
+        uint32_t length;
+        int64_t ptsUs;
+    };
+
+    // One audioTask write, fed to the DMA ring as space frees up
+    struct Item {
+        std::vector<int16_t> samples;
+        uint64_t done = 0;
+        bool calibrate = false;
+        bool pieceWaited = false;
+    };
+
+    int id;
+    Options options;
+    double skewPpm;
+    int64_t bootOffsetUs;
+    int64_t hostEpochUs;
+    std::mt19937 rng;
+
+    int tcp = -1;
+    int udp = -1;
+    sockaddr_in clockAddress = {};
+
+    ClockEstimator estimator;
+    OutputClock outputClock;
+    PlayoutScheduler scheduler;
+    SyncFrameParser parser;
+
+    std::vector<uint8_t> reservoir;
+    uint32_t writePosition = 0;
+    uint32_t readPosition = 0;
+    std::deque<FrameRecord> frames;
+
+    uint32_t clockSequence = 0;
+    uint32_t exchanges = 0;
+    int64_t lastExchangeUs = 0;
+    int64_t pendingT1 = -1;
+
+    bool i2sStarted = false;
+    int64_t i2sStartUs = 0;
+    uint64_t written = 0;
+    std::deque<Segment> segments;
+    std::unique_ptr<Item> item;
+    int64_t lastCalibrationUs = 0;
+
+    sockaddr_in relayAddress(uint16_t port) const {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        hostent* entry = gethostbyname(options.host.c_str());
+        if (entry) {
+            memcpy(&addr.sin_addr, entry->h_addr_list[0], sizeof(addr.sin_addr));
+        }
+        return addr;
+    }
+
+    // This receiver's esp_timer: its own boot time and crystal error
+    int64_t deviceTime(int64_t hostUs) const {
+        double elapsed = (double)(hostUs - hostEpochUs);
+        return bootOffsetUs + (int64_t)(elapsed * (1.0 + skewPpm * 1e-6));
+    }
+
+    int64_t deviceNow() const { return deviceTime(hostNowUs()); }
+
+    // Task wake-up latency on the device
+    int64_t wakeLatency() {
+        return std::uniform_int_distribution<int64_t>(0, options.jitterUs)(rng);
+    }
+
+    void pollClock() {
+        uint8_t datagram[ClockSyncPacket::WIRE_SIZE];
+        ssize_t length;
+        while ((length = recv(udp, datagram, sizeof(datagram), 0)) > 0) {
+            int64_t t4 = deviceNow() + wakeLatency();
+            ClockSyncPacket reply;
+            if (reply.decode(datagram, length) && reply.type == ClockSyncPacket::REPLY &&
+                reply.sequence == clockSequence && (int64_t)reply.t1 == pendingT1) {
+                estimator.addSample((int64_t)reply.t1, (int64_t)reply.t2, (int64_t)reply.t3, t4);
+                exchanges++;
+                pendingT1 = -1;
+            }
+        }
+
+        // Same schedule as RelayClock: a burst, then a steady interval
+        int64_t now = deviceNow();
+        int64_t interval = exchanges < 8 ? 100000 : 500000;
+        if (now - lastExchangeUs < interval) {
+            return;
+        }
+        lastExchangeUs = now;
+
+        ClockSyncPacket request = {};
+        request.type = ClockSyncPacket::REQUEST;
+        request.sequence = ++clockSequence;
+        request.t1 = (uint64_t)now;
+        pendingT1 = now;
+        request.encode(datagram, sizeof(datagram));
+        sendto(udp, datagram, sizeof(datagram), 0, (sockaddr*)&clockAddress, sizeof(clockAddress));
+    }
+
+    void pollStream() {
+        // Flow control as in the streaming task
+        static uint8_t buffer[READ_BYTES];
+        while (RESERVOIR_BYTES - (writePosition - readPosition) >= READ_BYTES) {
+            ssize_t length = recv(tcp, buffer, sizeof(buffer), 0);
+            if (length <= 0) {
+                return;
+            }
+            const uint8_t* data = buffer;
+            size_t size = length;
+            while (size > 0) {
+                SyncFrameParser::Event event;
+                size_t used = parser.next(data, size, event);
+                data += used;
+                size -= used;
+                if (event.type == SyncFrameParser::HEADER) {
+                    scheduler.addFrame(writePosition, (int64_t)event.header.ptsUs);
+                    frames.push_back({ writePosition, event.header.length, (int64_t)event.header.ptsUs });
+                } else if (event.type == SyncFrameParser::PAYLOAD) {
+                    for (size_t i = 0; i < event.size; i++) {
+                        reservoir[(writePosition + i) % RESERVOIR_BYTES] = event.data[i];
+                    }
+                    writePosition += event.size;
+                } else if (event.type == SyncFrameParser::ERROR) {
+                    fprintf(stderr, "rx%d: malformed frame\n", id);
+                    exit(1);
+                }
+            }
+        }
+    }
+
+    int64_t ptsAt(uint32_t position) {
+        while (frames.size() > 1 && (int32_t)(position - frames[1].position) >= 0) {
+            frames.pop_front();
+        }
+        if (frames.empty() || (int32_t)(position - frames[0].position) < 0) {
+            return -1;
+        }
+        return frames[0].ptsUs + (int64_t)(position - frames[0].position) * 1000000 / BYTES_PER_SECOND;
+    }
+
+    void queueSilence(uint32_t samples, bool calibrate) {
+        item.reset(new Item());
+        item->samples.assign(samples, 0);
+        item->calibrate = calibrate;
+        segments.push_back({ written, samples, -1 });
+    }
+
+    // One pass of audioTask's decision logic; leaves an item to write
+    void nextItem() {
+        int64_t now = deviceNow();
+        bool calibrate = !outputClock.isValid() || now - lastCalibrationUs >= CALIBRATION_MS * 1000;
+        if (calibrate) {
+            lastCalibrationUs = now;
+        }
+
+        if (!outputClock.isValid()) {
+            queueSilence(CHUNK_SAMPLES, true);
+            return;
+        }
+        while (estimator.isValid()) {
+            PlayoutScheduler::Plan plan = scheduler.plan(readPosition, outputClock.playTimeUs(written),
+                                                         estimator.getOffsetUs(), CHUNK_SAMPLES * 2);
+            if (plan.action == PlayoutScheduler::Plan::SILENCE) {
+                queueSilence(plan.bytes / 2, calibrate);
+                return;
+            }
+            if (plan.action != PlayoutScheduler::Plan::SKIP) {
+                break;
+            }
+            uint32_t buffered = (writePosition - readPosition) & ~1u;
+            uint32_t skip = std::min(plan.bytes, buffered);
+            if (skip == 0) {
+                break;
+            }
+            readPosition += skip;
+        }
+
+        if (writePosition - readPosition < CHUNK_SAMPLES * 2) {
+            queueSilence(CHUNK_SAMPLES, calibrate);  // Underrun
+            return;
+        }
+        item.reset(new Item());
+        item->samples.resize(CHUNK_SAMPLES);
+        for (uint32_t i = 0; i < CHUNK_SAMPLES * 2; i++) {
+            ((uint8_t*)item->samples.data())[i] = reservoir[(readPosition + i) % RESERVOIR_BYTES];
+        }
+        item->calibrate = calibrate;
+        segments.push_back({ written, CHUNK_SAMPLES, ptsAt(readPosition) });
+        readPosition += CHUNK_SAMPLES * 2;
+    }
+
+    // The DMA ring: buffers are released as the (device-clocked) I2S plays
+    // them; the writer may fill up to the end of the last released buffer
+    void pollOutput() {
+        int64_t now = deviceNow();
+        if (!i2sStarted) {
+            i2sStarted = true;
+            i2sStartUs = now;
+        }
+        uint64_t played = (uint64_t)((now - i2sStartUs) * (int64_t)SAMPLE_RATE / 1000000);
+        if (written < played) {
+            segments.push_back({ written, played - written, -1 });  // DMA underran: zeros
+            written = played;
+        }
+        uint64_t limit = (played / DMA_BUFFER_SAMPLES + DMA_BUFFER_COUNT) * DMA_BUFFER_SAMPLES;
+
+        while (true) {
+            if (!item) {
+                nextItem();
+            }
+            uint64_t remaining = item->samples.size() - item->done;
+            uint64_t want = item->calibrate ? std::min<uint64_t>(PIECE_SAMPLES, remaining) : remaining;
+            uint64_t room = limit > written ? limit - written : 0;
+            if (want > room) {
+                // The write blocks here until the next buffer is released
+                written += item->calibrate ? 0 : room;
+                item->done += item->calibrate ? 0 : room;
+                item->pieceWaited = true;
+                break;
+            }
+
+            if (item->calibrate && item->pieceWaited) {
+                outputClock.addObservation(written, now + wakeLatency());
+            }
+            item->pieceWaited = false;
+            written += want;
+            item->done += want;
+            if (item->done == item->samples.size()) {
+                item.reset();
+            }
+        }
+
+        while (segments.size() > 2 && segments[1].start + segments[1].count < played) {
+            segments.pop_front();
+        }
+    }
+};
+
+void usage() {
+    printf("Usage: sync_receiver_sim [--host H] [--port P] [--receivers N] [--seconds S]\n"
+           "                         [--skew-ppm X] [--jitter-us J] [--tolerance-us T]\n"
+           "                         [--max-spread-us M] [--settle-seconds S]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            usage();
+            return 2;
+        }
+        if (arg == "--host") options.host = value;
+        else if (arg == "--port") options.port = (uint16_t)atoi(value);
+        else if (arg == "--receivers") options.receivers = atoi(value);
+        else if (arg == "--seconds") options.seconds = atoi(value);
+        else if (arg == "--skew-ppm") options.skewPpm = atof(value);
+        else if (arg == "--jitter-us") options.jitterUs = atoll(value);
+        else if (arg == "--tolerance-us") options.toleranceUs = (uint32_t)atoi(value);
+        else if (arg == "--max-spread-us") options.maxSpreadUs = atoll(value);
+        else if (arg == "--settle-seconds") options.settleSeconds = atoi(value);
+        else {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+
+    // Skews spread evenly over +/- skew-ppm; boot times up to a minute apart
+    std::vector<std::unique_ptr<Receiver>> receivers;
+    std::mt19937 rng(12345);
+    for (int i = 0; i < options.receivers; i++) {
+        double skew = options.receivers > 1 ? -options.skewPpm + 2.0 * options.skewPpm * i / (options.receivers - 1) : 0.0;
+        int64_t boot = std::uniform_int_distribution<int64_t>(1000000, 60000000)(rng);
+        receivers.emplace_back(new Receiver(i, options, skew, boot, rng()));
+        if (!receivers.back()->connectStream()) {
+            return 1;
+        }
+        // Stagger joins like receivers powered on one after another
+        for (int64_t until = hostNowUs() + 300000; hostNowUs() < until;) {
+            for (auto& receiver : receivers) receiver->poll();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    printf("%6s", "t(s)");
+    for (auto& receiver : receivers) {
+        char label[32];
+        snprintf(label, sizeof(label), "rx%d(%+.0fppm)", (int)(&receiver - &receivers[0]), receiver->getSkewPpm());
+        printf(" %14s", label);
+    }
+    printf(" %10s\n", "spread");
+
+    int64_t start = hostNowUs();
+    int64_t nextReport = start + options.reportMs * 1000;
+    int64_t worstSpread = 0;
+    int reports = 0;
+    bool incomplete = false;
+    while (hostNowUs() - start < (int64_t)options.seconds * 1000000) {
+        for (auto& receiver : receivers) receiver->poll();
+
+        int64_t now = hostNowUs();
+        if (now >= nextReport) {
+            nextReport += options.reportMs * 1000;
+            double low = 1e18, high = -1e18;
+            bool all = true;
+            printf("%6.1f", (now - start) / 1e6);
+            for (auto& receiver : receivers) {
+                double error;
+                if (receiver->playbackError(now, error)) {
+                    printf(" %12.0fus", error);
+                    low = std::min(low, error);
+                    high = std::max(high, error);
+                } else {
+                    printf(" %14s", "silence");
+                    all = false;
+                }
+            }
+            bool settled = now - start >= (int64_t)options.settleSeconds * 1000000;
+            if (all) {
+                printf(" %8.0fus%s\n", high - low, settled ? "" : " (settling)");
+            } else {
+                printf(" %10s\n", "-");
+            }
+            if (settled) {
+                reports++;
+                if (all) {
+                    worstSpread = std::max(worstSpread, (int64_t)(high - low));
+                } else {
+                    incomplete = true;
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    printf("\nCorrections per receiver:");
+    for (auto& receiver : receivers) {
+        const PlayoutScheduler::Stats& stats = receiver->getStats();
+        printf(" [%u: %u B skipped, %u B silence]", stats.corrections, stats.skippedBytes, stats.silenceBytes);
+    }
+    printf("\nWorst spread after %ds: %lld us over %d reports%s\n", options.settleSeconds,
+           (long long)worstSpread, reports, incomplete ? " (some receivers silent)" : "");
+    return (worstSpread <= options.maxSpreadUs && !incomplete && reports > 0) ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+/**
+ * telemetry_collector - Decode and aggregate receiver UDP telemetry
+ *
+ * Listens for TelemetryPacket datagrams (see radiobenziger/TelemetryPacket.h)
+ * and prints a per-device summary table: packet loss from sequence gaps,
+ * late or duplicate datagrams, reboots, network/I2S throughput, buffer
+ * fill, underruns, heap and RSSI.
+ *
+ * Build:
+ *   g++ -std=c++17 -O2 -Wall -o telemetry_collector tools/telemetry_collector.cpp
+ *
+ * Usage:
+ *   ./telemetry_collector [--port 5600] [--report-ms 5000] [--count N]
+ *   ./telemetry_collector --emit 127.0.0.1:5600 [--count N] [--interval-ms 100]
+ *
+ * --emit sends synthetic packets, so the collector can be tested on
+ * localhost without a device:
+ *   ./telemetry_collector --count 20 --report-ms 1000 &
+ *   ./telemetry_collector --emit 127.0.0.1:5600 --count 20
+ */
+
+#include "../radiobenziger/TelemetryPacket.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct DeviceState {
+    TelemetryPacket last;
+    std::string address;
+    uint64_t packets = 0;
+    uint64_t lost = 0;
+    uint64_t late = 0;                 // Behind the newest packet: reordered or duplicated
+    uint32_t reboots = 0;
+    double networkKbps = 0.0;
+    double i2sKbps = 0.0;
+};
+
+uint64_t nowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// How far behind the newest packet a datagram may arrive and still count as late
+const int32_t REORDER_WINDOW = 64;
+
+void update(DeviceState& device, const TelemetryPacket& packet, bool first) {
+    device.packets++;
+    if (first) {
+        device.last = packet;
+        return;
+    }
+
+    // Signed, so wraps work and older datagrams give a negative gap
+    int32_t gap = (int32_t)(packet.sequence - device.last.sequence);
+    bool uptimeBack = packet.uptimeMs < device.last.uptimeMs;
+
+    // A reboot restarts both uptime and the sequence at 0
+    if (uptimeBack && (packet.sequence == 0 || gap < -REORDER_WINDOW)) {
+        device.reboots++;
+        device.lost += packet.sequence;
+        device.last = packet;
+        return;
+    }
+    if (gap <= 0) {
+        // Reordered or duplicated; the newest packet stays the reference
+        device.late++;
+        return;
+    }
+
+    device.lost += (uint32_t)gap - 1;
+    uint32_t elapsedMs = packet.uptimeMs - device.last.uptimeMs;
+    if (!uptimeBack && elapsedMs > 0) {
+        device.networkKbps = (packet.networkBytes - device.last.networkBytes) * 8.0 / elapsedMs;
+        device.i2sKbps = (packet.i2sBytes - device.last.i2sBytes) * 8.0 / elapsedMs;
+    }
+    device.last = packet;
+}
+
+void report(const std::map<uint32_t, DeviceState>& devices) {
+    printf("\n%-10s %-20s %-15s %7s %5s %5s %4s %9s %9s %6s %6s %6s %5s\n",
+           "device", "name", "address", "packets", "lost", "late", "boot", "net kbps", "i2s kbps",
+           "buf %", "under", "heapK", "rssi");
+    for (const auto& entry : devices) {
+        const DeviceState& device = entry.second;
+        const TelemetryPacket& p = device.last;
+        double fill = p.bufferCapacity ? 100.0 * p.bufferedBytes / p.bufferCapacity : 0.0;
+        printf("%08x   %-20s %-15s %7llu %5llu %5llu %4u %9.1f %9.1f %6.1f %6u %6u %5d%s\n",
+               entry.first, p.deviceName, device.address.c_str(),
+               (unsigned long long)device.packets, (unsigned long long)device.lost,
+               (unsigned long long)device.late, device.reboots,
+               device.networkKbps, device.i2sKbps, fill, p.underruns, p.freeHeap / 1024, p.rssi,
+               (p.flags & TelemetryPacket::FLAG_STREAMING_ACTIVE) ? "" : "  (idle)");
+    }
+    fflush(stdout);
+}
+
+int collect(uint16_t port, uint32_t reportMs, uint64_t count) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    sockaddr_in bindAddress{};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    bindAddress.sin_port = htons(port);
+    if (bind(sock, (sockaddr*)&bindAddress, sizeof(bindAddress)) < 0) {
+        perror("bind");
+        close(sock);
+        return 1;
+    }
+
+    // Wake up for periodic reports even when nothing arrives
+    timeval timeout{};
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 200 * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    printf("Listening for telemetry on UDP port %u\n", port);
+
+    std::map<uint32_t, DeviceState> devices;
+    uint64_t received = 0;
+    uint64_t rejected = 0;
+    uint64_t lastReport = nowMs();
+
+    while (count == 0 || received < count) {
+        uint8_t datagram[512];
+        sockaddr_in from{};
+        socklen_t fromLength = sizeof(from);
+        ssize_t length = recvfrom(sock, datagram, sizeof(datagram), 0, (sockaddr*)&from, &fromLength);
+
+        if (length > 0) {
+            TelemetryPacket packet;
+            if (packet.decode(datagram, (size_t)length)) {
+                auto inserted = devices.emplace(packet.deviceId, DeviceState());
+                DeviceState& device = inserted.first->second;
+                device.address = inet_ntoa(from.sin_addr);
+                update(device, packet, inserted.second);
+                received++;
+            } else {
+                rejected++;
+            }
+        }
+
+        if (nowMs() - lastReport >= reportMs) {
+            lastReport = nowMs();
+            report(devices);
+        }
+    }
+
+    report(devices);
+    printf("\nReceived %llu packets from %zu devices (%llu rejected)\n",
+           (unsigned long long)received, devices.size(), (unsigned long long)rejected);
+    close(sock);
+    return 0;
+}
+
+int emit(const std::string& target, uint64_t count, uint32_t intervalMs) {
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos) {
+        fprintf(stderr, "--emit expects HOST:PORT\n");
+        return 1;
+    }
+
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons((uint16_t)atoi(target.c_str() + colon + 1));
+    if (inet_pton(AF_INET, target.substr(0, colon).c_str(), &destination.sin_addr) != 1) {
+        fprintf(stderr, "Invalid address: %s\n", target.c_str());
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    // Simulated receiver playing 32kHz/16-bit mono (64000 bytes/s)
+    TelemetryPacket packet{};
+    packet.version = TelemetryPacket::VERSION;
+    packet.deviceId = 0x00c0ffee;
+    packet.bufferCapacity = 512 * 1024;
+    packet.freeHeap = 140 * 1024;
+    packet.minFreeHeap = 120 * 1024;
+    packet.rssi = -60;
+    strncpy(packet.deviceName, "simulated", sizeof(packet.deviceName) - 1);
+
+    for (uint64_t i = 0; count == 0 || i < count; i++) {
+        packet.sequence = (uint32_t)i;
+        packet.uptimeMs = (uint32_t)(i * intervalMs);
+        packet.flags = TelemetryPacket::FLAG_WIFI_CONNECTED | TelemetryPacket::FLAG_STREAMING_ACTIVE;
+        packet.networkBytes = i * intervalMs * 64;
+        packet.i2sBytes = i * intervalMs * 64;
+        packet.i2sWrites = i * intervalMs / 50;
+        packet.bufferedBytes = 48000 + (i % 8) * 1000;
+
+        uint8_t datagram[TelemetryPacket::WIRE_SIZE];
+        size_t length = packet.encode(datagram, sizeof(datagram));
+        if (sendto(sock, datagram, length, 0, (sockaddr*)&destination, sizeof(destination)) < 0) {
+            perror("sendto");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    close(sock);
+    return 0;
+}
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--port N] [--report-ms N] [--count N]\n"
+            "       %s --emit HOST:PORT [--count N] [--interval-ms N]\n",
+            program, program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint16_t port = 5600;
+    uint32_t reportMs = 5000;
+    uint32_t intervalMs = 100;
+    uint64_t count = 0;
+    std::string emitTarget;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) {
+            port = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--report-ms" && hasValue) {
+            reportMs = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--count" && hasValue) {
+            count = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--emit" && hasValue) {
+            emitTarget = argv[++i];
+        } else if (arg == "--interval-ms" && hasValue) {
+            intervalMs = (uint32_t)atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!emitTarget.empty()) {
+        return emit(emitTarget, count, intervalMs);
+    }
+    return collect(port, reportMs, count);
+}
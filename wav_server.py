@@ -2,20 +2,55 @@
 """
 Simple WAV Streaming Server for ESP32
 Serves raw PCM data from WAV files directly to ESP32
+
+Each loaded file is converted once into a content-addressed PCM cache
+(see pcm_cache.py) and served from a shared memory map, looping by offset
+wrap. Until its conversion finishes, a file is played from one live ffmpeg
+decode shared by every connected receiver (see relay_broadcast.py).
+
+With --pace, every client is sent audio at the real-time clock with a fixed
+lead instead of as fast as it reads, and /status reports how much audio is
+queued towards each client.
+
+With --sync, receivers that ask for it ("X-RB-Sync: 1") get a framed stream
+stamped with presentation times on the relay clock, plus a UDP clock
+service, so receivers in different rooms play in step (see relay_sync.py).
+Synchronized streams follow one shared timeline per file: every receiver
+that joins is sent the audio due now, not the start of the file.
+
+Unframed streams served from the cache carry the cache entry's id and the
+byte position they start at (X-RB-Stream, X-RB-Position). A receiver that
+loses one relay asks another for the same stream at the position it had
+reached, and relays with the same file continue from that exact byte, so a
+standby relay takes over without a gap or a repeat.
+
+With --advertise, the relay answers DNS-SD browses for _pcmradio._tcp, so
+receivers set to dnssd:// find it without a configured address (see
+relay_discovery.py).
 """
 
 import asyncio
+import itertools
 import logging
 import os
 import subprocess
 import sys
+import time
 import wave
-from typing import Optional
+from typing import Dict, Optional
 
 from fastapi import FastAPI, Request, Response
 from fastapi.responses import StreamingResponse
 import uvicorn
 
+from pcm_cache import PcmCache
+from relay_broadcast import (BYTES_PER_SECOND, CHUNK_SIZE, DEFAULT_LEAD_SECONDS, STEREO_TO_MONO,
+                             AsyncStation, Pacer, pcm_transcode_cmd, send_queue_bytes)
+from relay_discovery import ServiceAdvertiser, start_advertiser
+from relay_multicast import DEFAULT_TTL, MAX_FEC_GROUP, MulticastSender, parse_group
+from relay_sync import (DEFAULT_CLOCK_PORT, MIN_SEND_AHEAD_SECONDS, SYNC_DELAY_SECONDS, ClockServer,
+                        encode_frame, start_clock_server, to_clock_us, wants_sync)
+
 # Configure logging
 logging.basicConfig(level=logging.INFO)
 logger = logging.getLogger(__name__)
@@ -25,6 +60,33 @@ app = FastAPI(title="WAV Streaming Server", version="1.0.0")
 # Global variables
 current_wav_file: Optional[str] = None
 clients_count = 0
+stations: Dict[str, AsyncStation] = {}   # One shared transcoder per file
+pcm_cache: Optional[PcmCache] = None     # Created in main() (--cache-dir)
+cached_pcm: Dict[str, str] = {}          # Source file -> cached PCM, once converted
+cache_tasks: Dict[str, asyncio.Task] = {}
+pace_lead: Optional[float] = None        # Seconds of lead with --pace, None to send as fast as read
+clients: Dict[int, dict] = {}            # Active streams, for /status
+client_ids = itertools.count(1)
+sync_clock_port: Optional[int] = None    # UDP clock port with --sync
+clock_server: Optional[ClockServer] = None
+sync_epochs: Dict[str, float] = {}       # Cached file -> monotonic start of its shared timeline
+multicast_group: Optional[tuple] = None  # (group, port, ttl, fec) with --multicast
+multicast_sender: Optional[MulticastSender] = None
+multicast_feed = {"path": None, "pcm": None, "offset": 0}
+STREAM_ID_CHARS = 16                     # Of the cache digest, for X-RB-Stream
+advertisement: Optional[dict] = None     # start_advertiser() arguments with --advertise
+advertiser: Optional[ServiceAdvertiser] = None
+
+def get_station(wav_file: str) -> AsyncStation:
+    """Shared looping decode of a file, created on first use"""
+    station = stations.get(wav_file)
+    if station is None:
+        # Same conversion as convert_to_esp32_format, paced at real time
+        station = AsyncStation(os.path.basename(wav_file),
+                               pcm_transcode_cmd(wav_file, realtime=True, audio_filter=STEREO_TO_MONO),
+                               restart=True, restart_delay=0.0)
+        stations[wav_file] = station
+    return station
 
 def get_wav_info(wav_file: str) -> dict:
     """Get information about a WAV file"""
@@ -71,73 +133,181 @@ def convert_to_esp32_format(wav_file: str, output_file: str) -> bool:
         logger.error(f"Error converting WAV file: {e}")
         return False
 
-async def stream_pcm_data_direct(wav_file: str, chunk_size: int = 3200):
-    """Stream PCM data directly from FFmpeg (like MP3 server)"""
-    global clients_count
+# Up to 400ms per send, so a client that fell behind catches up in fewer writes
+CATCH_UP_CHUNKS = 4
+
+def schedule_cache(wav_file: str):
+    """Convert a file into the PCM cache in the background (once per file)"""
+    if pcm_cache is None or wav_file in cached_pcm or wav_file in cache_tasks:
+        return
     
+    async def convert():
+        try:
+            # Hashing and ffmpeg both block, so they run off the event loop
+            loop = asyncio.get_running_loop()
+            path = await loop.run_in_executor(None, pcm_cache.ensure, wav_file, convert_to_esp32_format)
+            if path:
+                cached_pcm[wav_file] = path
+                logger.info(f"{wav_file} now served from cache")
+        finally:
+            cache_tasks.pop(wav_file, None)
+    
+    cache_tasks[wav_file] = asyncio.get_running_loop().create_task(convert())
+
+def client_transport(request: Request):
+    """The connection's asyncio transport, or None if the server does not expose it"""
+    # Not part of ASGI: uvicorn's receive() is a method of its request cycle,
+    # which holds the transport
+    cycle = getattr(request.receive, '__self__', None)
+    return getattr(cycle, 'transport', None)
+
+def client_status(client: dict) -> dict:
+    """One stream's progress and the audio queued towards it"""
+    status = {
+        "id": client["id"],
+        "ip": client["ip"],
+        "source": client["source"],
+        "sync": client["sync"],
+        "bytes_sent": client["bytes_sent"],
+    }
+    
+    # Bytes the relay has accepted but the network has not delivered:
+    # asyncio's write buffer plus the kernel send queue (Linux only)
+    transport = client["transport"]
+    if transport is not None and not transport.is_closing():
+        queued = transport.get_write_buffer_size()
+        kernel = send_queue_bytes(transport.get_extra_info('socket'))
+        status["write_buffer_bytes"] = queued
+        if kernel is not None:
+            status["send_queue_bytes"] = kernel
+            queued += kernel
+        status["queued_seconds"] = round(queued / BYTES_PER_SECOND, 3)
+    
+    pacer = client["pacer"]
+    if pacer:
+        status["ahead_seconds"] = round(pacer.ahead_seconds(), 3)
+        status["reanchors"] = pacer.reanchors
+    return status
+
+async def pace(client: dict, nbytes: int):
+    """With --pace, wait until `nbytes` more keeps the client within its lead"""
+    pacer = client["pacer"]
+    if pacer:
+        wait = pacer.delay(nbytes)
+        if wait:
+            await asyncio.sleep(wait)
+
+def sent(client: dict, nbytes: int):
+    client["bytes_sent"] += nbytes
+    if client["pacer"]:
+        client["pacer"].sent(nbytes)
+
+def end_stream(client: dict):
+    global clients_count
+    clients.pop(client["id"], None)
+    clients_count -= 1
+    logger.info(f"Client disconnected. Active clients: {clients_count}")
+
+async def stream_cached_frames(pcm, pcm_path: str, client: dict):
+    """Synchronized: frames of the file's shared timeline, each sent SYNC_DELAY before its PTS"""
+    epoch = sync_epochs.setdefault(pcm_path, time.monotonic())
+    chunk_seconds = CHUNK_SIZE / BYTES_PER_SECOND
+    seq = None
+    while True:
+        now = time.monotonic()
+        # Join (or after a stall, rejoin) at the audio due now
+        if seq is None or epoch + seq * chunk_seconds + SYNC_DELAY_SECONDS - now < MIN_SEND_AHEAD_SECONDS:
+            seq = int((now - epoch) / chunk_seconds) + 1
+        due = epoch + seq * chunk_seconds
+        if due > now:
+            await asyncio.sleep(due - now)
+        chunk, _ = pcm.read(seq * CHUNK_SIZE, CHUNK_SIZE)
+        yield encode_frame(seq, to_clock_us(due + SYNC_DELAY_SECONDS), chunk)
+        sent(client, len(chunk))
+        seq += 1
+
+def resume_position(headers, stream_id: str, size: int) -> int:
+    """Byte to start a cached stream at: where the receiver left the same stream on another relay"""
+    if headers.get('x-rb-stream') != stream_id:
+        return 0
     try:
-        logger.info(f"Starting direct PCM stream from: {wav_file}")
-        
-        # Use same FFmpeg command as MP3 server for consistency
-        ffmpeg_cmd = [
-            'ffmpeg',
-            '-i', wav_file,
-            '-f', 's16le',
-            '-acodec', 'pcm_s16le',
-            '-ar', '32000',
-            '-ac', '1',
-            '-af', 'pan=mono|c0=0.5*c0+0.5*c1',  # Proper stereo to mono mix
-            '-loglevel', 'error',  # Suppress verbose output
-            '-'  # Output to stdout
-        ]
-        
-        # Start ffmpeg process
-        process = subprocess.Popen(
-            ffmpeg_cmd,
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            bufsize=0
-        )
+        return int(headers.get('x-rb-position', '0')) % size
+    except ValueError:
+        return 0
+
+async def stream_cached_pcm(pcm_path: str, client: dict, start: int = 0):
+    """Stream a cached file from its shared memory map, looping without a gap"""
+    try:
+        logger.info(f"Starting cached PCM stream from: {pcm_path}")
+        pcm = pcm_cache.open(pcm_path)
+        if client["sync"]:
+            async for frame in stream_cached_frames(pcm, pcm_path, client):
+                yield frame
+            return
         
-        bytes_sent = 0
+        offset = start
+        # Paced sends are one chunk each, so the lead is held to a chunk
+        send_size = CHUNK_SIZE if client["pacer"] else CHUNK_SIZE * CATCH_UP_CHUNKS
+        while True:
+            await pace(client, send_size)
+            # No decoder: each send is a slice of the page cache. The read
+            # wraps at the end of the file, so the loop point is seamless.
+            chunk, offset = pcm.read(offset, send_size)
+            yield chunk
+            sent(client, len(chunk))
+            # Unpaced, the client's socket sets the rate (ESP32 flow control);
+            # give other clients a turn even when this one never blocks
+            await asyncio.sleep(0)
+            
+    except Exception as e:
+        logger.error(f"Error streaming cached PCM: {e}")
+    finally:
+        end_stream(client)
+
+def multicast_chunk(nbytes: int) -> Optional[bytes]:
+    """Next slice of the current file for the multicast sender; None until it is cached"""
+    pcm_path = cached_pcm.get(current_wav_file) if current_wav_file else None
+    if pcm_path is None:
+        if current_wav_file:
+            schedule_cache(current_wav_file)
+        return None
+    # A newly loaded file starts from its beginning
+    if pcm_path != multicast_feed["path"]:
+        multicast_feed.update(path=pcm_path, pcm=pcm_cache.open(pcm_path), offset=0)
+    chunk, multicast_feed["offset"] = multicast_feed["pcm"].read(multicast_feed["offset"], nbytes)
+    return chunk
+
+async def stream_pcm_data_direct(wav_file: str, client: dict):
+    """Stream PCM data from the file's shared decode (loops for continuous playback)"""
+    try:
+        logger.info(f"Starting direct PCM stream from: {wav_file}")
         
-        try:
+        # Everything here runs on the event loop: the ffmpeg pipe is read by the
+        # station's asyncio subprocess and the ring wait is awaited. Each yield
+        # returns only once Starlette has handed the chunk to this client's
+        # transport, so a backed-up client just stops advancing its own cursor.
+        max_chunks = 1 if client["pacer"] or client["sync"] else CATCH_UP_CHUNKS
+        async with get_station(wav_file).subscribe() as subscription:
             while True:
-                chunk = process.stdout.read(chunk_size)
-                if not chunk:
-                    # Loop back for continuous playback
-                    process.terminate()
-                    process.wait()
-                    
-                    # Restart FFmpeg process
-                    process = subprocess.Popen(
-                        ffmpeg_cmd,
-                        stdout=subprocess.PIPE,
-                        stderr=subprocess.PIPE,
-                        bufsize=0
-                    )
-                    chunk = process.stdout.read(chunk_size)
-                    if not chunk:
-                        break
-                
-                yield chunk
-                bytes_sent += len(chunk)
-                
-                # No artificial delay - let ESP32 control the rate
-                
-        except Exception as e:
-            logger.error(f"Error in streaming loop: {e}")
-        finally:
-            # Clean up process
-            if process.poll() is None:
-                process.terminate()
-                process.wait()
+                await pace(client, CHUNK_SIZE)
+                chunk = await subscription.read(max_chunks=max_chunks)
+                if chunk is None:
+                    break
+                if client["sync"]:
+                    # Chunks are due when published; backlog already due is not sent
+                    seq = subscription.position - 1
+                    pts = subscription.chunk_time(seq) + SYNC_DELAY_SECONDS
+                    if pts - time.monotonic() < MIN_SEND_AHEAD_SECONDS:
+                        continue
+                    yield encode_frame(seq, to_clock_us(pts), chunk)
+                else:
+                    yield chunk
+                sent(client, len(chunk))
                 
     except Exception as e:
         logger.error(f"Error streaming PCM data: {e}")
     finally:
-        clients_count -= 1
-        logger.info(f"Client disconnected. Active clients: {clients_count}")
+        end_stream(client)
 
 @app.get("/")
 async def root():
@@ -172,18 +342,60 @@ async def stream_wav(request: Request):
             media_type="text/plain"
         )
     
+    # Synchronized streams are timed by PTS rather than by the pacer
+    sync = sync_clock_port is not None and wants_sync(request.headers)
+    if sync:
+        # One timeline per file: wait for the cache rather than start on the live decode
+        schedule_cache(current_wav_file)
+        task = cache_tasks.get(current_wav_file)
+        if task:
+            await asyncio.wait([task], timeout=60)
+    
     clients_count += 1
     logger.info(f"ESP32 client connected. Active clients: {clients_count}")
     
-    # Use direct streaming (no pre-conversion) like MP3 server
+    client = {
+        "id": next(client_ids),
+        "ip": client_ip,
+        "transport": client_transport(request),
+        "pacer": Pacer(pace_lead) if pace_lead and not sync else None,
+        "sync": sync,
+        "bytes_sent": 0,
+    }
+    
+    headers = {
+        "Cache-Control": "no-cache",
+        "Connection": "keep-alive",
+        "Access-Control-Allow-Origin": "*"
+    }
+    if sync:
+        headers["X-RB-Sync"] = "1"
+        headers["X-RB-Clock-Port"] = str(sync_clock_port)
+    
+    # Cached files cost no decode; otherwise join the live shared decode
+    pcm_path = cached_pcm.get(current_wav_file)
+    if pcm_path and os.path.exists(pcm_path):
+        client["source"] = "cache"
+        start = 0
+        if not sync:
+            # Content-addressed, so relays with the same file agree on id and bytes
+            size = pcm_cache.open(pcm_path).size
+            stream_id = os.path.basename(pcm_path)[:STREAM_ID_CHARS]
+            start = resume_position(request.headers, stream_id, size)
+            headers.update({"X-RB-Stream": stream_id, "X-RB-Position": str(start), "X-RB-Loop-Bytes": str(size)})
+            if start:
+                logger.info(f"Resuming stream {stream_id} at byte {start}")
+        body = stream_cached_pcm(pcm_path, client, start)
+    else:
+        schedule_cache(current_wav_file)
+        client["source"] = "live"
+        body = stream_pcm_data_direct(current_wav_file, client)
+    clients[client["id"]] = client
+    
     return StreamingResponse(
-        stream_pcm_data_direct(current_wav_file),
+        body,
         media_type="application/octet-stream",
-        headers={
-            "Cache-Control": "no-cache",
-            "Connection": "keep-alive",
-            "Access-Control-Allow-Origin": "*"
-        }
+        headers=headers
     )
 
 @app.get("/load/{filename}")
@@ -208,6 +420,7 @@ async def load_wav_file(filename: str):
     
     current_wav_file = filename
     wav_info = get_wav_info(filename)
+    schedule_cache(filename)
     
     logger.info(f"Loaded WAV file: {filename}")
     logger.info(f"  Channels: {wav_info.get('channels', 'unknown')}")
@@ -216,7 +429,8 @@ async def load_wav_file(filename: str):
     
     return {
         "message": f"Loaded {filename}",
-        "file_info": wav_info
+        "file_info": wav_info,
+        "cached": filename in cached_pcm
     }
 
 @app.get("/status")
@@ -228,34 +442,137 @@ async def get_status():
         "server": "WAV Streaming Server",
         "current_file": current_wav_file,
         "active_clients": clients_count,
-        "file_exists": current_wav_file and os.path.exists(current_wav_file)
+        "file_exists": current_wav_file and os.path.exists(current_wav_file),
+        "pace_lead_seconds": pace_lead,
+        "clients": [client_status(client) for client in clients.values()],
+        "stations": [station.status() for station in stations.values()]
     }
     
     if current_wav_file and os.path.exists(current_wav_file):
         status["file_info"] = get_wav_info(current_wav_file)
         
-        # Check if PCM version exists
-        pcm_file = current_wav_file.replace('.wav', '.pcm').replace('.mp3', '.pcm')
-        status["pcm_ready"] = os.path.exists(pcm_file)
-        if status["pcm_ready"]:
+        # Served from the PCM cache once converted
+        pcm_file = cached_pcm.get(current_wav_file)
+        status["pcm_ready"] = pcm_file is not None
+        status["pcm_converting"] = current_wav_file in cache_tasks
+        if pcm_file:
             status["pcm_size"] = os.path.getsize(pcm_file)
     
+    if pcm_cache:
+        status["cache"] = pcm_cache.status()
+    
+    if clock_server:
+        status["sync"] = {
+            "clock_port": sync_clock_port,
+            "clock_requests": clock_server.requests,
+            "delay_seconds": SYNC_DELAY_SECONDS
+        }
+    
+    if multicast_sender:
+        status["multicast"] = multicast_sender.status()
+    if advertiser:
+        status["advertised"] = advertiser.status()
+    
     return status
 
+@app.on_event("startup")
+async def cache_initial_file():
+    """Start converting the --file given on the command line"""
+    if current_wav_file:
+        schedule_cache(current_wav_file)
+
+@app.on_event("startup")
+async def start_sync_clock():
+    """Answer receivers' clock requests (--sync)"""
+    global clock_server
+    if sync_clock_port is not None:
+        clock_server = await start_clock_server("0.0.0.0", sync_clock_port)
+
+@app.on_event("startup")
+async def start_multicast():
+    """Multicast the current file as RTP (--multicast)"""
+    global multicast_sender
+    if multicast_group:
+        group, port, ttl, fec = multicast_group
+        multicast_sender = MulticastSender(group, port, ttl, fec=fec)
+        asyncio.get_running_loop().create_task(multicast_sender.run(multicast_chunk))
+
+@app.on_event("startup")
+async def start_advertising():
+    """Answer DNS-SD browses for the relay (--advertise)"""
+    global advertiser
+    if advertisement:
+        try:
+            advertiser = await start_advertiser(**advertisement)
+        except OSError as e:
+            logger.error(f"Could not advertise the relay: {e}")
+
+@app.on_event("shutdown")
+async def stop_advertising():
+    if advertiser:
+        advertiser.goodbye()
+
 def main():
     """Main entry point"""
     import argparse
+    global current_wav_file
     
     parser = argparse.ArgumentParser(description="WAV Streaming Server for ESP32")
     parser.add_argument("--file", "-f", help="WAV file to load on startup")
     parser.add_argument("--port", "-p", type=int, default=8080, help="Port to run on")
     parser.add_argument("--host", default="0.0.0.0", help="Host to bind to")
+    parser.add_argument("--cache-dir", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "pcm_cache"),
+                        help="Directory for converted device-format PCM")
+    parser.add_argument("--pace", action="store_true",
+                        help="Send at the audio clock instead of as fast as each receiver reads")
+    parser.add_argument("--lead-ms", type=int, default=int(DEFAULT_LEAD_SECONDS * 1000),
+                        help="Audio a paced receiver may be sent ahead of playback (default: %(default)s)")
+    
+    parser.add_argument("--sync", action="store_true",
+                        help="Offer timestamped streams and a UDP clock for synchronized multi-room playback")
+    parser.add_argument("--clock-port", type=int, default=DEFAULT_CLOCK_PORT,
+                        help="UDP port of the relay clock with --sync (default: %(default)s)")
+    
+    parser.add_argument("--multicast", metavar="GROUP[:PORT]",
+                        help="Also multicast the current file as RTP, e.g. 239.72.66.1:5004")
+    parser.add_argument("--multicast-ttl", type=int, default=DEFAULT_TTL,
+                        help="Multicast hop limit (default: %(default)s, local network only)")
+    parser.add_argument("--multicast-fec", type=int, default=0, metavar="N",
+                        help="Send an XOR parity packet after every N multicast packets, "
+                             "so receivers rebuild single losses (2-8, 0 = off)")
+    
+    parser.add_argument("--advertise", action="store_true",
+                        help="Advertise the relay over DNS-SD (_pcmradio._tcp) for receivers set to dnssd://")
+    parser.add_argument("--advertise-name", default=None,
+                        help="DNS-SD instance name (default: 'PCM relay on <hostname>')")
+    parser.add_argument("--advertise-address", default=None,
+                        help="IPv4 address to advertise (default: the interface that reaches the LAN)")
     
     args = parser.parse_args()
     
+    global pcm_cache, pace_lead, sync_clock_port, multicast_group, advertisement
+    pcm_cache = PcmCache(args.cache_dir)
+    if args.pace:
+        pace_lead = args.lead_ms / 1000.0
+        logger.info(f"Pacing clients at real time with {args.lead_ms} ms lead")
+    if args.sync:
+        sync_clock_port = args.clock_port
+    if args.multicast:
+        try:
+            multicast_group = parse_group(args.multicast) + (args.multicast_ttl, args.multicast_fec)
+            if args.multicast_fec and not 2 <= args.multicast_fec <= MAX_FEC_GROUP:
+                raise ValueError(f"--multicast-fec must be 2-{MAX_FEC_GROUP}")
+        except (ValueError, OSError) as e:
+            logger.error(f"Invalid --multicast setting: {e}")
+            sys.exit(1)
+    if args.advertise:
+        import socket
+        address = args.advertise_address or (args.host if args.host not in ("0.0.0.0", "") else None)
+        advertisement = dict(name=args.advertise_name or f"PCM relay on {socket.gethostname().split('.')[0]}",
+                             port=args.port, path="/stream", sync=args.sync, address=address)
+    
     # Load initial file if specified
     if args.file:
-        global current_wav_file
         if os.path.exists(args.file):
             current_wav_file = args.file
             logger.info(f"Initial file loaded: {args.file}")